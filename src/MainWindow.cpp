@@ -3,6 +3,8 @@
 #include "ui/BackupCard.h"
 #include "ui/SettingsDialog.h"
 #include "utils/Logger.h"
+#include "utils/IoThrottle.h"
+#include "backup/Manifest.h"
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
@@ -21,16 +23,22 @@
 #include <QTableWidgetItem>
 #include <QHeaderView>
 #include <QPointer>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QDebug>
 #include <QApplication> // 追加: QApplicationクラスをインクルード
+#include <algorithm>
 
 // MainWindowのコンストラクタで背景関連の初期化を削除
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
-      backupEngine(new BackupEngine(this)),
+      jobScheduler(new BackupJobScheduler(this)),
+      restoreEngine(new RestoreEngine(this)),
+      backupVerifier(new BackupVerifier(this)),
+      backupScrubber(new BackupScrubber(this)),
       isRunningBatchBackup(false),
-      currentBackupIndex(0),
       totalBackupsInQueue(0),
+      finishedBackupsInQueue(0),
       logDialog(nullptr),
       currentViewMode(CardView),
       isAutomaticBackup(false) // 追加
@@ -48,6 +56,9 @@ MainWindow::MainWindow(QWidget *parent)
         configDir.mkpath(".");
     }
 
+    // ログは設定と同じフォルダにも残し、次回起動後も確認できるようにする
+    Logger::instance().setLogFile(configDir.filePath("backup.log"));
+
     // 設定マネージャーを作成
     configManager = new ConfigManager(configPath, this);
     configManager->loadConfig();
@@ -59,6 +70,10 @@ MainWindow::MainWindow(QWidget *parent)
     backupScheduler = new BackupScheduler(this);
     connect(backupScheduler, &BackupScheduler::backupTimerTriggered,
             this, &MainWindow::handleScheduledBackup);
+    connect(backupScheduler, &BackupScheduler::verifyTimerTriggered,
+            this, &MainWindow::handleScheduledVerify);
+    connect(backupScheduler, &BackupScheduler::scrubTimerTriggered,
+            this, &MainWindow::handleScheduledScrub);
 
     // バックアップリストを読み込む
     loadBackupConfigs();
@@ -67,13 +82,34 @@ MainWindow::MainWindow(QWidget *parent)
     loadSchedulerSettings();
 
     // シグナル/スロット接続
-    connect(backupEngine, &BackupEngine::backupProgress, this, &MainWindow::updateBackupProgress);
-    connect(backupEngine, &BackupEngine::backupCompleted, this, &MainWindow::backupComplete);
+    connect(jobScheduler, &BackupJobScheduler::jobStarted, this, &MainWindow::onJobStarted);
+    connect(jobScheduler, &BackupJobScheduler::jobProgress, this, &MainWindow::onJobProgress);
+    connect(jobScheduler, &BackupJobScheduler::jobFinished, this, &MainWindow::onJobFinished);
+    connect(jobScheduler, &BackupJobScheduler::allJobsFinished, this, &MainWindow::onAllJobsFinished);
+    connect(jobScheduler, &BackupJobScheduler::jobLogMessage, this, &MainWindow::onJobLogMessage);
+    connect(jobScheduler, &BackupJobScheduler::jobError, this, [this](int index, const QString &message)
+            {
+        onJobLogMessage(index, message);
+        statusBar()->showMessage(message, 10000); });
 
     // 新しいシグナル接続 - ファイル単位のログ記録用
-    connect(backupEngine, &BackupEngine::fileProcessed, this, &MainWindow::onFileProcessed);
-    connect(backupEngine, &BackupEngine::directoryProcessed, this, &MainWindow::onDirectoryProcessed);
-    connect(backupEngine, &BackupEngine::backupLogMessage, this, &MainWindow::onBackupLogMessage);
+    connect(jobScheduler, &BackupJobScheduler::jobFileProcessed, this, [this](int, const QString &filePath, bool success)
+            { onFileProcessed(filePath, success); });
+    connect(jobScheduler, &BackupJobScheduler::jobDirectoryProcessed, this, [this](int, const QString &dirPath, bool created)
+            { onDirectoryProcessed(dirPath, created); });
+
+    // 復元のログもバックアップと同じログに残す
+    connect(restoreEngine, &RestoreEngine::restoreLogMessage, this, &MainWindow::onBackupLogMessage);
+    connect(restoreEngine, &RestoreEngine::restoreError, this, [this](const QString &message)
+            { QMessageBox::warning(this, tr("復元"), message); });
+    connect(restoreEngine, &RestoreEngine::restoreProgress, this, [this](int progress)
+            { statusBar()->showMessage(tr("復元中... %1%").arg(progress)); });
+
+    connect(backupVerifier, &BackupVerifier::verifyLogMessage, this, &MainWindow::onBackupLogMessage);
+    connect(backupVerifier, &BackupVerifier::verifyProgress, this, [this](int progress)
+            { statusBar()->showMessage(tr("検証中... %1%").arg(progress)); });
+
+    connect(backupScrubber, &BackupScrubber::scrubLogMessage, this, &MainWindow::onBackupLogMessage);
 }
 
 MainWindow::~MainWindow()
@@ -211,6 +247,15 @@ void MainWindow::showSettingsDialog()
     dialog.setScheduledTime(backupScheduler->scheduledTime());
     dialog.setPeriodicBackupEnabled(backupScheduler->isPeriodicBackupEnabled());
     dialog.setPeriodicInterval(backupScheduler->periodicInterval());
+    dialog.setVerifyScheduleEnabled(backupScheduler->isVerifyScheduleEnabled());
+    dialog.setVerifyInterval(backupScheduler->verifyInterval());
+    dialog.setScrubEnabled(backupScheduler->isScrubEnabled());
+    dialog.setScrubInterval(backupScheduler->scrubInterval());
+    dialog.setScrubSliceMinutes(backupScheduler->scrubSliceMinutes());
+    dialog.setScrubRateLimit(backupScheduler->scrubRateLimit());
+    dialog.setMaxConcurrentJobs(jobScheduler->maxConcurrentJobs());
+    dialog.setJobsPerSsd(jobScheduler->jobsPerSsd());
+    dialog.setIoLimits(globalIoLimits());
 
     // 次回予定されているバックアップ時間を表示
     dialog.setNextBackupTime(backupScheduler->nextBackupTime());
@@ -222,6 +267,15 @@ void MainWindow::showSettingsDialog()
         backupScheduler->setScheduledTime(dialog.scheduledTime());
         backupScheduler->setPeriodicBackupEnabled(dialog.isPeriodicBackupEnabled());
         backupScheduler->setPeriodicInterval(dialog.periodicInterval());
+        backupScheduler->setVerifyScheduleEnabled(dialog.isVerifyScheduleEnabled());
+        backupScheduler->setVerifyInterval(dialog.verifyInterval());
+        backupScheduler->setScrubInterval(dialog.scrubInterval());
+        backupScheduler->setScrubSliceMinutes(dialog.scrubSliceMinutes());
+        backupScheduler->setScrubRateLimit(dialog.scrubRateLimit());
+        backupScheduler->setScrubEnabled(dialog.isScrubEnabled());
+        jobScheduler->setMaxConcurrentJobs(dialog.maxConcurrentJobs());
+        jobScheduler->setJobsPerSsd(dialog.jobsPerSsd());
+        setGlobalIoLimits(dialog.ioLimits());
 
         // 設定を保存
         saveSchedulerSettings();
@@ -261,6 +315,96 @@ void MainWindow::handleScheduledBackup()
     runAllBackups();
 }
 
+void MainWindow::handleScheduledVerify()
+{
+    // バックアップ中は保存先が書き換わっていくので、次の機会に回す
+    if (jobScheduler->isRunning() || restoreEngine->isRunning() || backupVerifier->isRunning())
+    {
+        addLogEntry(tr("定期検証を延期します: バックアップまたは復元が実行中です"));
+        backupScheduler->setLastVerifyTime(QDateTime());
+        return;
+    }
+
+    addLogEntry(tr("定期検証（%1日ごと）を実行します").arg(backupScheduler->verifyInterval()));
+    int failed = 0;
+    for (const BackupConfig &config : configManager->backupConfigs())
+    {
+        if (config.verifyMode() == BackupConfig::VerifyNone)
+            continue;
+        if (!backupVerifier->verify(BackupVerifier::requestFor(config)))
+        {
+            failed++;
+            addLogEntry(tr("検証で不一致が見つかりました: %1").arg(config.name()));
+        }
+    }
+    saveSchedulerSettings();
+    statusBar()->showMessage(failed == 0 ? tr("定期検証が完了しました") : tr("定期検証で %1 件のバックアップに不一致が見つかりました").arg(failed), 10000);
+}
+
+void MainWindow::handleScheduledScrub()
+{
+    // 点検は急がないので、ほかの処理が動いていれば今回は見送る
+    if (jobScheduler->isRunning() || restoreEngine->isRunning() || backupVerifier->isRunning() || backupScrubber->isRunning())
+    {
+        return;
+    }
+
+    // 一番長く点検していないバックアップを1つだけ進める（複数あれば順番に回る）
+    const QList<BackupConfig> configs = configManager->backupConfigs();
+    QList<int> order;
+    for (int i = 0; i < configs.size(); ++i)
+    {
+        order.append(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&configs](int a, int b)
+                     {
+        const QDateTime lastA = configs[a].scrubState().lastRun;
+        const QDateTime lastB = configs[b].scrubState().lastRun;
+        return lastA.isValid() != lastB.isValid() ? !lastA.isValid() : lastA < lastB; });
+
+    for (int index : order)
+    {
+        BackupConfig config = configs[index];
+        const QString backupRoot = BackupScrubber::backupRootFor(config);
+        if (backupRoot.isEmpty() || !QFileInfo::exists(manifestFilePath(backupRoot)))
+        {
+            continue;
+        }
+
+        BackupScrubber::Options options;
+        options.rateLimitMBps = backupScheduler->scrubRateLimit();
+        options.sliceMs = static_cast<qint64>(backupScheduler->scrubSliceMinutes()) * 60 * 1000;
+
+        addLogEntry(tr("保存先の定期点検: %1").arg(config.name()));
+        BackupConfig::ScrubState state = config.scrubState();
+        if (!backupScrubber->runSlice(backupRoot, state, options))
+        {
+            continue;
+        }
+
+        // 点検中に設定が編集・削除されていたら結果は捨てる
+        if (index >= configManager->backupConfigs().size() || configManager->backupConfigs()[index].destinationPath() != config.destinationPath())
+        {
+            return;
+        }
+        config = configManager->backupConfigs()[index];
+        config.setScrubState(state);
+        configManager->updateBackupConfig(index, config);
+        saveBackupConfigs();
+        if (index < backupCards.size())
+        {
+            backupCards[index]->setScrubState(state);
+        }
+
+        const int problems = backupScrubber->lastResult().problems();
+        if (problems > 0)
+        {
+            statusBar()->showMessage(tr("保存先の点検で壊れたファイルが %1 個見つかりました: %2").arg(problems).arg(config.name()), 10000);
+        }
+        return;
+    }
+}
+
 void MainWindow::loadSchedulerSettings()
 {
     // 設定マネージャーからスケジュール設定を読み込む
@@ -296,6 +440,50 @@ void MainWindow::loadSchedulerSettings()
             backupScheduler->setPeriodicInterval(schedulerConfig["periodicInterval"].toInt());
         }
 
+        // 定期検証設定
+        if (schedulerConfig.contains("verifyInterval"))
+        {
+            backupScheduler->setVerifyInterval(schedulerConfig["verifyInterval"].toInt());
+        }
+        if (schedulerConfig.contains("lastVerifyTime"))
+        {
+            backupScheduler->setLastVerifyTime(QDateTime::fromString(schedulerConfig["lastVerifyTime"].toString(), Qt::ISODate));
+        }
+        backupScheduler->setVerifyScheduleEnabled(schedulerConfig["verifyEnabled"].toBool());
+
+        // 定期点検設定
+        if (schedulerConfig.contains("scrubInterval"))
+        {
+            backupScheduler->setScrubInterval(schedulerConfig["scrubInterval"].toInt());
+        }
+        if (schedulerConfig.contains("scrubSliceMinutes"))
+        {
+            backupScheduler->setScrubSliceMinutes(schedulerConfig["scrubSliceMinutes"].toInt());
+        }
+        if (schedulerConfig.contains("scrubRateLimit"))
+        {
+            backupScheduler->setScrubRateLimit(schedulerConfig["scrubRateLimit"].toInt());
+        }
+        backupScheduler->setScrubEnabled(schedulerConfig["scrubEnabled"].toBool());
+
+        // 同時実行数
+        if (schedulerConfig.contains("maxConcurrentJobs"))
+        {
+            jobScheduler->setMaxConcurrentJobs(schedulerConfig["maxConcurrentJobs"].toInt());
+        }
+        if (schedulerConfig.contains("jobsPerSsd"))
+        {
+            jobScheduler->setJobsPerSsd(schedulerConfig["jobsPerSsd"].toInt());
+        }
+
+        // 全体の速さの上限
+        BackupConfig::IoLimits ioLimits;
+        ioLimits.readMBps = schedulerConfig["ioReadLimit"].toInt();
+        ioLimits.writeMBps = schedulerConfig["ioWriteLimit"].toInt();
+        ioLimits.iops = schedulerConfig["ioIopsLimit"].toInt();
+        ioLimits.adaptive = schedulerConfig["ioAdaptive"].toBool();
+        setGlobalIoLimits(ioLimits);
+
         // より詳細なデバッグ情報を追加
         qDebug() << "スケジューラ設定を読み込み中:";
         qDebug() << "  定時バックアップ有効:" << schedulerConfig["scheduleEnabled"].toBool();
@@ -305,6 +493,28 @@ void MainWindow::loadSchedulerSettings()
     }
 }
 
+BackupConfig::IoLimits MainWindow::globalIoLimits() const
+{
+    const IoThrottle::Limits throttleLimits = IoThrottle::global().limits();
+    BackupConfig::IoLimits limits;
+    limits.readMBps = throttleLimits.readMBps;
+    limits.writeMBps = throttleLimits.writeMBps;
+    limits.iops = throttleLimits.iops;
+    limits.adaptive = throttleLimits.adaptive;
+    return limits;
+}
+
+void MainWindow::setGlobalIoLimits(const BackupConfig::IoLimits &limits)
+{
+    IoThrottle::Limits throttleLimits;
+    throttleLimits.readMBps = limits.readMBps;
+    throttleLimits.writeMBps = limits.writeMBps;
+    throttleLimits.iops = limits.iops;
+    throttleLimits.adaptive = limits.adaptive;
+    // 実行中のバックアップにも次の読み書きから効く
+    IoThrottle::global().setLimits(throttleLimits);
+}
+
 void MainWindow::saveSchedulerSettings()
 {
     // スケジュール設定を構築
@@ -313,6 +523,23 @@ void MainWindow::saveSchedulerSettings()
     schedulerConfig["scheduledTime"] = backupScheduler->scheduledTime().toString("hh:mm");
     schedulerConfig["periodicEnabled"] = backupScheduler->isPeriodicBackupEnabled();
     schedulerConfig["periodicInterval"] = backupScheduler->periodicInterval();
+    schedulerConfig["verifyEnabled"] = backupScheduler->isVerifyScheduleEnabled();
+    schedulerConfig["verifyInterval"] = backupScheduler->verifyInterval();
+    if (backupScheduler->lastVerifyTime().isValid())
+    {
+        schedulerConfig["lastVerifyTime"] = backupScheduler->lastVerifyTime().toString(Qt::ISODate);
+    }
+    schedulerConfig["scrubEnabled"] = backupScheduler->isScrubEnabled();
+    schedulerConfig["scrubInterval"] = backupScheduler->scrubInterval();
+    schedulerConfig["scrubSliceMinutes"] = backupScheduler->scrubSliceMinutes();
+    schedulerConfig["scrubRateLimit"] = backupScheduler->scrubRateLimit();
+    schedulerConfig["maxConcurrentJobs"] = jobScheduler->maxConcurrentJobs();
+    schedulerConfig["jobsPerSsd"] = jobScheduler->jobsPerSsd();
+    const BackupConfig::IoLimits ioLimits = globalIoLimits();
+    schedulerConfig["ioReadLimit"] = ioLimits.readMBps;
+    schedulerConfig["ioWriteLimit"] = ioLimits.writeMBps;
+    schedulerConfig["ioIopsLimit"] = ioLimits.iops;
+    schedulerConfig["ioAdaptive"] = ioLimits.adaptive;
 
     // 設定マネージャーに保存
     QJsonObject config = configManager->getConfig();
@@ -399,6 +626,8 @@ void MainWindow::addBackupCard(const BackupConfig &config)
         connect(card, &BackupCard::runBackup, this, &MainWindow::runBackup);
         connect(card, &BackupCard::editBackup, this, &MainWindow::editBackup); // 追加: 編集機能接続
         connect(card, &BackupCard::removeBackup, this, &MainWindow::removeBackup);
+        connect(card, &BackupCard::restoreBackup, this, &MainWindow::restoreBackup);
+        connect(card, &BackupCard::verifyBackup, this, &MainWindow::verifyBackup);
 
         backupCards.append(card);
 
@@ -454,23 +683,133 @@ void MainWindow::showBackupDialog()
 
 void MainWindow::runBackup(const BackupConfig &config)
 {
-    // 既に実行中のバックアップがあれば何もしない
-    if (backupEngine->isRunning())
+    // 同じ設定が実行中・予約済みなら何もしない（ほかの設定とは同時に実行できる）
+    const int index = configManager->findConfigIndex(config);
+    if (index < 0)
+    {
+        // 削除・変更された設定のカードから来た要求は実行しない
+        statusBar()->showMessage(tr("バックアップ設定が見つかりません"));
+        addLogEntry(QString("バックアップ要求を無視: 設定が見つかりません: %1").arg(config.name()));
+        return;
+    }
+    if (restoreEngine->isRunning() || backupVerifier->isRunning())
+    {
+        statusBar()->showMessage(tr("復元または検証が実行中です"));
+        return;
+    }
+    if (jobScheduler->isJobActive(index))
     {
         statusBar()->showMessage("バックアップが実行中です");
         addLogEntry("バックアップ要求を無視: 既に実行中のバックアップがあります");
         return;
     }
 
+    // 定期点検はバックアップより後回しにする（読みかけのファイルは次回読み直す）
+    if (backupScrubber->isRunning())
+    {
+        backupScrubber->stop();
+    }
+
     addLogEntry(QString("バックアップ開始: %1 → %2").arg(config.sourcePath()).arg(config.destinationPath()));
 
-    // startBackupの代わりにrunBackupを使用して設定情報を渡す
-    backupEngine->runBackup(config);
+    // 設定情報を渡して予約する（ほかのディスクを使う実行中のバックアップがあれば並行して始まる）
+    jobScheduler->enqueue(index, config);
 
     // ステータスバーメッセージを設定
     statusBar()->showMessage("バックアップ実行中...");
 }
 
+void MainWindow::restoreBackup(int index)
+{
+    if (index < 0 || index >= configManager->backupConfigs().size())
+        return;
+
+    // 同じ保存先を読み書きしないよう、バックアップとは同時に実行しない
+    if (jobScheduler->isRunning() || restoreEngine->isRunning() || backupVerifier->isRunning())
+    {
+        statusBar()->showMessage(tr("バックアップまたは復元が実行中です"));
+        return;
+    }
+
+    const BackupConfig config = configManager->backupConfigs()[index];
+    RestoreEngine::Request request;
+    request.backupRoot = RestoreEngine::defaultBackupRoot(config);
+    if (request.backupRoot.isEmpty())
+    {
+        QMessageBox::information(this, tr("復元"), tr("復元できるバックアップがありません。"));
+        return;
+    }
+
+    // すべてを戻すか、バックアップの中から選んだファイルだけを戻すか
+    QMessageBox question(QMessageBox::Question, tr("復元"),
+                         tr("%1 から復元します。\n復元する範囲を選んでください。").arg(request.backupRoot),
+                         QMessageBox::Cancel, this);
+    QPushButton *allButton = question.addButton(tr("すべて"), QMessageBox::AcceptRole);
+    QPushButton *selectButton = question.addButton(tr("ファイルを選択..."), QMessageBox::ActionRole);
+    question.exec();
+    if (question.clickedButton() == selectButton)
+    {
+        const QDir backupDir(request.backupRoot);
+        for (const QString &file : QFileDialog::getOpenFileNames(this, tr("復元するファイルを選択"), request.backupRoot))
+        {
+            const QString relativePath = backupDir.relativeFilePath(file);
+            if (!relativePath.startsWith(".."))
+            {
+                request.paths.append(relativePath);
+            }
+        }
+        if (request.paths.isEmpty())
+            return;
+    }
+    else if (question.clickedButton() != allButton)
+    {
+        return;
+    }
+
+    request.targetRoot = QFileDialog::getExistingDirectory(this, tr("復元先のフォルダを選択"), config.sourcePath());
+    if (request.targetRoot.isEmpty())
+        return;
+
+    addLogEntry(tr("復元開始: %1 → %2").arg(request.backupRoot, request.targetRoot));
+    if (restoreEngine->runRestore(request))
+    {
+        statusBar()->showMessage(tr("復元が完了しました"), 5000);
+    }
+    else
+    {
+        statusBar()->showMessage(tr("復元できなかったファイルがあります（ログを確認してください）"), 5000);
+    }
+}
+
+void MainWindow::verifyBackup(int index)
+{
+    if (index < 0 || index >= configManager->backupConfigs().size())
+        return;
+
+    if (jobScheduler->isRunning() || restoreEngine->isRunning() || backupVerifier->isRunning())
+    {
+        statusBar()->showMessage(tr("バックアップまたは復元が実行中です"));
+        return;
+    }
+
+    const BackupConfig config = configManager->backupConfigs()[index];
+    addLogEntry(tr("検証開始: %1").arg(config.name()));
+    if (backupVerifier->verify(BackupVerifier::requestFor(config)))
+    {
+        statusBar()->showMessage(tr("検証が完了しました: 保存先はバックアップ元と一致しています"), 5000);
+        return;
+    }
+
+    const BackupVerifier::Statistics statistics = backupVerifier->lastStatistics();
+    if (statistics.mismatches.isEmpty())
+    {
+        statusBar()->showMessage(tr("検証を完了できませんでした（ログを確認してください）"), 5000);
+        return;
+    }
+    statusBar()->showMessage(tr("検証で %1 件の不一致が見つかりました").arg(statistics.mismatches.size()), 5000);
+    QMessageBox::warning(this, tr("検証"), statistics.toLogLines(10).join("\n"));
+}
+
 // removeBackupメソッドの更新
 void MainWindow::removeBackup(int index)
 {
@@ -482,6 +821,12 @@ void MainWindow::removeBackup(int index)
 
     if (reply == QMessageBox::Yes)
     {
+        // 実行中のバックアップは設定の番号で追っているので、その間は並びを変えない
+        if (jobScheduler->isRunning())
+        {
+            QMessageBox::information(this, tr("削除"), tr("バックアップの実行中は削除できません。終わってからもう一度お試しください。"));
+            return;
+        }
         configManager->removeBackupConfig(index);
 
         // 設定を保存して表示を更新
@@ -498,79 +843,88 @@ void MainWindow::removeBackup(int index)
     }
 }
 
-void MainWindow::updateBackupProgress(int progress)
+void MainWindow::onJobStarted(int index, const BackupConfig &config)
+{
+    qDebug() << "バックアップ実行: " << config.name() << " (実行中 " << jobScheduler->runningJobs()
+             << " / 待機 " << jobScheduler->pendingJobs() << ")";
+
+    if (index >= 0 && index < backupCards.size())
+    {
+        // startProgress()ではなくsetProgress()を使用
+        backupCards[index]->setProgress(0); // 進捗を0%から開始
+    }
+}
+
+void MainWindow::onJobProgress(int index, int progress)
 {
-    // 進捗をタイトルバーに表示
+    // 進捗をタイトルバーに表示（同時に複数動くので、終わった数と実行中の数を出す）
     if (isRunningBatchBackup)
     {
-        setWindowTitle(QString("%1 - バックアップ中 %2/%3 (%4%)").arg(tr("しらふか・バックアップ"), QString::number(currentBackupIndex), QString::number(totalBackupsInQueue), QString::number(progress)));
+        setWindowTitle(QString("%1 - バックアップ中 %2/%3 (実行中 %4)").arg(tr("しらふか・バックアップ"), QString::number(finishedBackupsInQueue), QString::number(totalBackupsInQueue), QString::number(jobScheduler->runningJobs())));
     }
 
-    // 進捗バーの更新
-    if (isRunningBatchBackup && currentBackupIndex - 1 < backupCards.size())
+    // 進捗バーの更新（ジョブの番号は設定の番号なので、対応するカードに出す）
+    if (index >= 0 && index < backupCards.size())
     {
-        BackupCard *card = backupCards[currentBackupIndex - 1];
-        card->setProgress(progress);
+        backupCards[index]->setProgress(progress);
     }
 }
 
-// バックアップ完了時のステータス更新処理を改善
-void MainWindow::backupComplete()
+void MainWindow::onJobFinished(int index, const RunStatistics &statistics)
 {
-    // バッチバックアップ実行中の場合
-    if (isRunningBatchBackup)
+    if (index >= 0 && index < backupCards.size() && !statistics.stopped && !statistics.failed)
+    {
+        backupCards[index]->setProgress(100);
+    }
+
+    if (statistics.failed)
     {
-        qDebug() << "バックアップ完了 - 次のバックアップを開始します";
+        // 理由は jobError でも表示しているが、完了の表示で上書きしないようにここでも出す
+        addLogEntry(QString("バックアップに失敗しました: %1").arg(statistics.errorString));
+    }
 
-        // 次のバックアップを処理
-        processNextBackup();
+    if (isRunningBatchBackup)
+    {
+        finishedBackupsInQueue++;
+        qDebug() << "バックアップ完了: " << finishedBackupsInQueue << "/" << totalBackupsInQueue;
+    }
+    else if (statistics.failed)
+    {
+        statusBar()->showMessage(tr("バックアップに失敗しました: %1").arg(statistics.errorString), 10000);
+    }
+    else if (statistics.stopped)
+    {
+        statusBar()->showMessage(tr("バックアップを中止しました（次回は続きから再開します）"), 5000);
+        addLogEntry("バックアップを中止しました");
     }
     else
     {
         // 単体バックアップ完了メッセージ
         statusBar()->showMessage(tr("バックアップが完了しました"), 5000);
         addLogEntry("バックアップが完了しました");
-
-        // ウィンドウタイトルを元に戻す
-        setWindowTitle(tr("しらふか・バックアップ"));
     }
 }
 
-// processNextBackupメソッド内のカード進捗表示部分を修正
-void MainWindow::processNextBackup()
+// バックアップ完了時のステータス更新処理を改善
+void MainWindow::onAllJobsFinished()
 {
-    qDebug() << "processNextBackup called, queue size: " << backupQueue.size();
-    if (backupQueue.isEmpty())
-    {
-        // すべてのバックアップが完了
-        isRunningBatchBackup = false;
-        statusBar()->showMessage(tr("すべてのバックアップが完了しました"), 5000);
-
-        // 自動バックアップフラグをリセット
-        isAutomaticBackup = false;
+    // ウィンドウタイトルを元に戻す
+    setWindowTitle(tr("しらふか・バックアップ"));
 
-        QMessageBox::information(this, tr("バックアップ完了"), tr("すべてのバックアップが完了しました。"));
-        qDebug() << "すべてのバックアップが完了しました";
+    if (!isRunningBatchBackup)
+    {
         return;
     }
 
-    // キューから次のバックアップ設定を取得
-    BackupConfig config = backupQueue.dequeue();
-    currentBackupIndex++;
+    // すべてのバックアップが完了
+    isRunningBatchBackup = false;
+    statusBar()->showMessage(tr("すべてのバックアップが完了しました"), 5000);
 
-    qDebug() << "バックアップ実行: " << config.name() << " (" << currentBackupIndex
-             << "/" << totalBackupsInQueue << ")";
+    // 自動バックアップフラグをリセット
+    isAutomaticBackup = false;
 
-    // 設定を直接渡して、セーブデータモードを尊重
-    backupEngine->runBackup(config);
-
-    // カードの進捗表示を更新（オプション）
-    int cardIndex = configManager->findConfigIndex(config);
-    if (cardIndex >= 0 && cardIndex < backupCards.size())
-    {
-        // startProgress()ではなくsetProgress()を使用
-        backupCards[cardIndex]->setProgress(0); // 進捗を0%から開始
-    }
+    QMessageBox::information(this, tr("バックアップ完了"), tr("すべてのバックアップが完了しました。"));
+    qDebug() << "すべてのバックアップが完了しました";
 }
 
 // MainWindow.cppでのaddBackupボタンの処理部分
@@ -656,6 +1010,19 @@ void MainWindow::onBackupLogMessage(const QString &message)
     addLogEntry(message);
 }
 
+void MainWindow::onJobLogMessage(int index, const QString &message)
+{
+    // 複数のバックアップのログが混ざるので、どの設定のものかを付ける
+    if (index >= 0 && index < configManager->backupConfigs().size())
+    {
+        addLogEntry(QString("[%1] %2").arg(configManager->backupConfigs()[index].name(), message));
+    }
+    else
+    {
+        addLogEntry(message);
+    }
+}
+
 void MainWindow::clearBackupCards()
 {
     qDebug() << "Clearing all backup cards...";
@@ -816,7 +1183,12 @@ void MainWindow::showTableContextMenu(const QPoint &pos)
 
     QMenu contextMenu(this);
     QAction *runAction = contextMenu.addAction(tr("バックアップ実行"));
+    // 実行中・予約済みのものだけ中止できる（書き終えたところまでは次回に引き継ぐ）
+    QAction *stopAction = contextMenu.addAction(tr("バックアップ中止"));
+    stopAction->setEnabled(jobScheduler->isJobActive(index));
     QAction *editAction = contextMenu.addAction(tr("編集")); // 追加: 編集アクション
+    QAction *restoreAction = contextMenu.addAction(tr("復元"));
+    QAction *verifyAction = contextMenu.addAction(tr("検証"));
     QAction *removeAction = contextMenu.addAction(tr("削除"));
 
     QAction *selectedAction = contextMenu.exec(backupTableWidget->mapToGlobal(pos));
@@ -824,10 +1196,23 @@ void MainWindow::showTableContextMenu(const QPoint &pos)
     {
         runBackup(configManager->backupConfigs()[index]);
     }
+    else if (selectedAction == stopAction)
+    {
+        addLogEntry(QString("バックアップ中止を要求: %1").arg(configManager->backupConfigs()[index].name()));
+        jobScheduler->stopJob(index);
+    }
     else if (selectedAction == editAction) // 追加: 編集アクション処理
     {
         editBackup(index);
     }
+    else if (selectedAction == restoreAction)
+    {
+        restoreBackup(index);
+    }
+    else if (selectedAction == verifyAction)
+    {
+        verifyBackup(index);
+    }
     else if (selectedAction == removeAction)
     {
         removeBackup(index);
@@ -847,6 +1232,14 @@ void MainWindow::runAllBackups()
         return;
     }
 
+    // 同じ保存先を読み書きしないよう、復元・検証とは同時に実行しない
+    if (restoreEngine->isRunning() || backupVerifier->isRunning())
+    {
+        statusBar()->showMessage(tr("復元または検証が実行中です"));
+        addLogEntry("一括バックアップ要求を無視: 復元または検証が実行中です");
+        return;
+    }
+
     // バックアップ設定のリストを取得
     QVector<BackupConfig> configs = configManager->backupConfigs();
     if (configs.isEmpty())
@@ -858,23 +1251,34 @@ void MainWindow::runAllBackups()
 
     qDebug() << "バックアップ設定数: " << configs.size();
 
-    // キューをクリアして設定を追加
-    backupQueue.clear();
-    for (const BackupConfig &config : configs)
-    {
-        backupQueue.enqueue(config);
-    }
-
     // カウンターを初期化
-    totalBackupsInQueue = backupQueue.size();
-    currentBackupIndex = 0;
+    totalBackupsInQueue = 0;
+    finishedBackupsInQueue = 0;
     isRunningBatchBackup = true;
 
     // ステータスバー表示の更新
-    statusBar()->showMessage(tr("一括バックアップを開始します..."));
+    statusBar()->showMessage(tr("一括バックアップを開始します（同時に %1 件まで）...").arg(jobScheduler->maxConcurrentJobs()));
 
-    // 最初のバックアップを開始
-    processNextBackup();
+    // 定期点検はバックアップより後回しにする
+    if (backupScrubber->isRunning())
+    {
+        backupScrubber->stop();
+    }
+
+    // すべて予約する。別々のディスクを使う設定は並行して、同じディスクを使う設定は順に実行される
+    for (int i = 0; i < configs.size(); ++i)
+    {
+        // スケジュールによる実行は、ほかのアプリの邪魔をしないよう設定の優先度で動かす
+        if (jobScheduler->enqueue(i, configs[i], isAutomaticBackup))
+        {
+            totalBackupsInQueue++;
+        }
+    }
+    if (totalBackupsInQueue == 0)
+    {
+        isRunningBatchBackup = false;
+        statusBar()->showMessage(tr("バックアップが既に実行中です"));
+    }
 }
 
 // 追加: 編集機能の実装
@@ -899,7 +1303,14 @@ void MainWindow::editBackup(int index)
         {
             // 更新された設定を取得
             BackupConfig updatedConfig = dialog.getBackupConfig();
+            // 保存先が同じなら点検の続きと結果を引き継ぐ
+            if (updatedConfig.destinationPath() == config.destinationPath())
+            {
+                updatedConfig.setScrubState(config.scrubState());
+            }
             configManager->updateBackupConfig(index, updatedConfig);
+            // 実行中・予約中なら速さの上限だけはすぐに反映する
+            jobScheduler->setJobIoLimits(index, updatedConfig.ioLimits());
             saveBackupConfigs();
             loadBackupConfigs();
             addLogEntry(QString("バックアップ設定 '%1' を更新しました").arg(updatedConfig.name()));
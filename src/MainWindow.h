@@ -18,6 +18,10 @@
 #include <QBrush>
 
 #include "backup/BackupEngine.h"
+#include "backup/BackupJobScheduler.h"
+#include "backup/RestoreEngine.h"
+#include "backup/BackupVerifier.h"
+#include "backup/BackupScrubber.h"
 #include "config/ConfigManager.h"
 #include "models/BackupConfig.h"
 #include "ui/BackupCard.h"
@@ -37,14 +41,20 @@ public slots:
 
 private slots:
     void showBackupDialog();
-    void updateBackupProgress(int progress);
-    void backupComplete();
+    void onJobStarted(int index, const BackupConfig &config);
+    void onJobProgress(int index, int progress);
+    void onJobFinished(int index, const RunStatistics &statistics);
+    void onAllJobsFinished();
     void runBackup(const BackupConfig &config);
     void removeBackup(int index);
     void editBackup(int index); // 追加: 編集スロット
+    void restoreBackup(int index);
+    void verifyBackup(int index);
     void runAllBackups();
     void showSettingsDialog();
     void handleScheduledBackup();
+    void handleScheduledVerify();
+    void handleScheduledScrub();
     void showLogDialog();
     void switchToCardView();
     void switchToListView();
@@ -57,6 +67,7 @@ private slots:
     void onFileProcessed(const QString &filePath, bool success);
     void onDirectoryProcessed(const QString &dirPath, bool created);
     void onBackupLogMessage(const QString &message);
+    void onJobLogMessage(int index, const QString &message);
 
 protected:
     // paintEvent を削除（背景描画に使用していたため）
@@ -77,12 +88,17 @@ private:
     void addBackupCard(const BackupConfig &config);
     void updateTableView();
     void clearBackupCards();
-    void processNextBackup();
     void loadSchedulerSettings();
     void saveSchedulerSettings();
+    // すべてのバックアップをあわせた速さの上限（IoThrottle::global）
+    BackupConfig::IoLimits globalIoLimits() const;
+    void setGlobalIoLimits(const BackupConfig::IoLimits &limits);
     void switchViewMode(ViewMode mode);
 
-    BackupEngine *backupEngine;
+    BackupJobScheduler *jobScheduler; // バックアップの実行（設定の番号をジョブの番号にする）
+    RestoreEngine *restoreEngine;
+    BackupVerifier *backupVerifier;
+    BackupScrubber *backupScrubber;
     ConfigManager *configManager;
     BackupScheduler *backupScheduler;
 
@@ -104,10 +120,9 @@ private:
     // バックアップ管理
     QList<BackupCard *> backupCards;
 
-    // 一括バックアップのキュー管理
-    QQueue<BackupConfig> backupQueue;
+    // 一括バックアップの進み具合
     int totalBackupsInQueue;
-    int currentBackupIndex;
+    int finishedBackupsInQueue;
     bool isRunningBatchBackup;
 
     // ログダイアログ
@@ -1,5 +1,6 @@
 #include "BackupEngine.h"
 #include "BackupTask.h"
+#include "DurabilityFlusher.h"
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -8,11 +9,88 @@
 #include <QRegularExpression>    // QRegExp から QRegularExpression に変更
 #include <QJsonArray>            // 追加: QJsonArrayのヘッダー
 #include "../utils/FileSystem.h" // FileSystemを追加
+#include "../utils/CopyBackend.h"
+#include "../utils/BufferPool.h"
+#include "../utils/TreeWalker.h"
+#include "../utils/DirectoryHandleCache.h"
+#include "../utils/FileIndex.h"
+#include "../utils/RunArena.h"
+#include "../utils/FileRemover.h"
+#include "../utils/HardLinker.h"
+#include "../utils/DeviceInfo.h"
+#include "../utils/IoThrottle.h"
+#include "Manifest.h"
+#include "ManifestDiff.h"
+#include "CheckpointJournal.h"
+#include "SnapshotStore.h"
+#include "SnapshotPruner.h"
+#include "RetentionPolicy.h"
 #include <QApplication>          // 追加: QApplicationのヘッダー
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+#include <QSet>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace
+{
+    // コピーパイプラインから返ってくる1ファイル分の結果（パスは必要になったときに索引から作る）
+    struct CopyResult
+    {
+        quint32 file;
+        bool success;
+        QString errorString;
+    };
+
+    // バックエンドのスレッドから届く結果の受け口。完了コールバックはこれへのポインタと
+    // ファイル番号だけを持つので、std::function に収まり1件ごとのヒープ確保が起きない
+    struct CopyResultSink
+    {
+        explicit CopyResultSink(std::pmr::memory_resource *resource)
+            : results(resource)
+        {
+        }
+
+        QMutex mutex;
+        std::pmr::vector<CopyResult> results;
+    };
+
+    // 途中経過を書き出す間隔（どちらかに達したら書く）
+    const qint64 kCheckpointIntervalMs = 5000;
+    const int kCheckpointBatch = 1000;
+
+    // 前回の途中経過から再開してよいかを比べる、この実行の条件
+    CheckpointJournal::Header makeCheckpointHeader(const QString &sourceRoot, const BackupConfig &config, const QString &baseManifestPath)
+    {
+        CheckpointJournal::Header header;
+        header.sourcePath = sourceRoot;
+        header.updateMode = config.updateMode();
+        const QFileInfo manifest(baseManifestPath);
+        if (!baseManifestPath.isEmpty() && manifest.exists())
+        {
+            header.baseManifestSize = manifest.size();
+            header.baseManifestMtimeMs = manifest.lastModified().toMSecsSinceEpoch();
+        }
+        header.startedMs = QDateTime::currentMSecsSinceEpoch();
+        return header;
+    }
+}
 
 BackupEngine::BackupEngine(QObject *parent)
-    : QObject(parent), m_currentTask(nullptr)
+    : QObject(parent), m_currentTask(nullptr), m_running(false), m_stopRequested(false), m_priorityClass(ThreadPriority::Normal)
 {
+    // io_uring（256 KiB）とスレッドプール（1 MiB）のどちらのバッファもここから借りる
+    BufferPool::Options poolOptions;
+    poolOptions.sizeClasses = {256 * 1024, 1024 * 1024};
+    m_bufferPool.reset(new BufferPool(poolOptions));
+
+    m_pruner.reset(new SnapshotPruner());
+    connect(m_pruner.get(), &SnapshotPruner::logMessage, this, &BackupEngine::backupLogMessage);
+
+    m_throttle.reset(new IoThrottle(IoThrottle::Limits(), &IoThrottle::global()));
 }
 
 BackupEngine::~BackupEngine()
@@ -47,12 +125,47 @@ void BackupEngine::stopBackup()
     if (m_currentTask)
     {
         m_currentTask->stop();
+        return;
+    }
+    // 実行中のときだけ受け付ける（終わった後の要求が次の実行に残らないように）。
+    // 速さの上限で待っているワーカーも待たずに書き終えさせる（次の runBackup の始めに戻す）
+    if (m_running)
+    {
+        m_stopRequested = true;
+        m_throttle->setBypass(true);
     }
 }
 
 bool BackupEngine::isRunning() const
 {
-    return m_currentTask != nullptr && m_currentTask->isRunning();
+    return m_running || (m_currentTask != nullptr && m_currentTask->isRunning());
+}
+
+void BackupEngine::setPriorityClass(ThreadPriority::Class cls)
+{
+    m_priorityClass = cls;
+}
+
+void BackupEngine::setIoLimits(const BackupConfig::IoLimits &limits)
+{
+    IoThrottle::Limits throttleLimits;
+    throttleLimits.readMBps = limits.readMBps;
+    throttleLimits.writeMBps = limits.writeMBps;
+    throttleLimits.iops = limits.iops;
+    throttleLimits.adaptive = limits.adaptive;
+    m_throttle->setLimits(throttleLimits);
+}
+
+void BackupEngine::failRun(const QString &message)
+{
+    m_lastStatistics.failed = true;
+    m_lastStatistics.errorString = message;
+    emit backupError(message);
+}
+
+RunStatistics BackupEngine::lastRunStatistics() const
+{
+    return m_lastStatistics;
 }
 
 void BackupEngine::onBackupProgressUpdated(int progress)
@@ -79,6 +192,29 @@ void BackupEngine::onBackupFinished()
 
 void BackupEngine::runBackup(const BackupConfig &config)
 {
+    // 途中で戻る箇所が多いので、抜けるときに必ず実行中を解除する。
+    // 中止の要求は入るときに消す（前の実行が終わる間際に届いた要求を持ち越さない）
+    struct RunningGuard
+    {
+        BackupEngine *engine;
+        explicit RunningGuard(BackupEngine *owner) : engine(owner)
+        {
+            engine->m_stopRequested = false;
+            engine->m_throttle->setBypass(false);
+            engine->m_running = true;
+        }
+        ~RunningGuard() { engine->m_running = false; }
+    } runningGuard(this);
+    m_lastStatistics = RunStatistics();
+    m_lastStatistics.configName = config.name();
+
+    // コピーのワーカーは優先度を引き継ぐので、スレッドを作る前に下げておく
+    QString priorityDescription;
+    if (!ThreadPriority::applyToCurrentThread(m_priorityClass, &priorityDescription))
+    {
+        emit backupLogMessage(tr("優先度を一部変更できませんでした: %1").arg(priorityDescription));
+    }
+
     // バックアップ開始を記録
     emit backupProgress(0);
 
@@ -90,7 +226,7 @@ void BackupEngine::runBackup(const BackupConfig &config)
     QDir sourceDir(sourcePath);
     if (!sourceDir.exists())
     {
-        emit backupError(tr("バックアップ元フォルダが存在しません: %1").arg(sourcePath));
+        failRun(tr("バックアップ元フォルダが存在しません: %1").arg(sourcePath));
         return;
     }
 
@@ -100,7 +236,7 @@ void BackupEngine::runBackup(const BackupConfig &config)
         // 保存先フォルダがなければ作成
         if (!destDir.mkpath("."))
         {
-            emit backupError(tr("バックアップ先フォルダを作成できませんでした: %1").arg(destPath));
+            failRun(tr("バックアップ先フォルダを作成できませんでした: %1").arg(destPath));
             return;
         }
     }
@@ -146,6 +282,8 @@ void BackupEngine::runBackup(const BackupConfig &config)
             emit backupLogMessage(tr("セーブデータフォルダが見つかりませんでした"));
             emit backupLogMessage(tr("バックアップ元: %1").arg(sourcePath));
             emit backupLogMessage(tr("バックアップを中断します"));
+            m_lastStatistics.failed = true;
+            m_lastStatistics.errorString = tr("セーブデータフォルダが見つかりませんでした");
             emit backupProgress(100);
             emit backupComplete();
             return;
@@ -175,6 +313,8 @@ void BackupEngine::runBackup(const BackupConfig &config)
         // コピー完了後にも応答性を維持
         QApplication::processEvents();
 
+        syncDestination(config, nullptr);
+
         if (success)
         {
             emit backupLogMessage(tr("すべてのセーブデータのバックアップが完了しました"));
@@ -184,6 +324,8 @@ void BackupEngine::runBackup(const BackupConfig &config)
         {
             emit backupLogMessage(tr("一部のセーブデータのバックアップに失敗しました"));
             emit backupLogMessage(tr("詳細はログを確認してください"));
+            m_lastStatistics.failed = true;
+            m_lastStatistics.errorString = tr("一部のセーブデータのバックアップに失敗しました");
         }
 
         emit backupProgress(100);
@@ -197,52 +339,459 @@ void BackupEngine::runBackup(const BackupConfig &config)
     QStringList excludedFolders = config.excludedFolders();
     QStringList excludedExtensions = config.excludedExtensions();
 
-    // ファイルリストを取得
-    QFileInfoList fileList = getFileList(sourceDir, excludedFiles, excludedFolders, excludedExtensions);
+    RunStatistics statistics;
+    statistics.configName = config.name();
+    statistics.priorityClass = priorityDescription;
+    QElapsedTimer runTimer;
+    runTimer.start();
 
-    // 総ファイル数
-    int totalFiles = fileList.size();
-    int copiedFiles = 0;
+    // ファイル一覧やコピー結果など実行中に増える一方のデータはアリーナに置き、
+    // 実行の終わりにまとめて解放する（このアリーナを使うものより先に宣言する）
+    RunArena arena;
+
+    // ファイルリストを取得
+    FileIndex fileIndex(&arena);
+    buildFileIndex(sourceDir, excludedFiles, excludedFolders, excludedExtensions, fileIndex);
+    statistics.scanMs = runTimer.elapsed();
+    statistics.indexBytes = fileIndex.memoryUsage();
+    statistics.scannedFiles = fileIndex.fileCount();
+    const QString sourceRoot = sourceDir.absolutePath();
 
-    if (totalFiles == 0)
+    if (fileIndex.fileCount() == 0)
     {
+        statistics.totalMs = runTimer.elapsed();
+        m_lastStatistics = statistics;
         emit backupProgress(100);
         emit backupComplete();
         return;
     }
+    if (m_stopRequested)
+    {
+        statistics.stopped = true;
+        statistics.totalMs = runTimer.elapsed();
+        m_lastStatistics = statistics;
+        emit backupLogMessage(tr("バックアップを中止しました"));
+        return;
+    }
+
+    // スナップショットでは実行ごとに新しい世代を作り、そこへ書き込む。
+    // 比べる相手は最新の世代のマニフェストで、変わっていないファイルはその世代からリンクする
+    const bool snapshot = config.updateMode() == BackupConfig::UpdateSnapshot;
+    SnapshotStore snapshots(destPath);
+    SnapshotStore::Snapshot previousSnapshot;
+    QString targetRoot = destPath;
+    QString previousManifestPath = manifestFilePath(destPath);
+    if (snapshot)
+    {
+        previousSnapshot = snapshots.latest();
+        previousManifestPath = previousSnapshot.name.isEmpty() ? QString() : manifestFilePath(previousSnapshot.path);
+    }
+
+    // 前回の実行が途中で止まっていれば、同じ条件で始めたものに限り続きから始める
+    const CheckpointJournal::Header checkpointHeader = makeCheckpointHeader(sourceRoot, config, previousManifestPath);
+    std::unique_ptr<CheckpointJournal> checkpoint;
+    if (snapshot)
+    {
+        // 中断された世代のうち最新のものは、途中経過が残っていれば続きを書く。
+        // ほかの中断された世代と、前回削除しきれなかった世代はバックグラウンドで消す
+        const QStringList partials = snapshots.partialSnapshots();
+        for (int i = partials.size() - 1; i >= 0; --i)
+        {
+            const QString &partial = partials.at(i);
+            if (i == partials.size() - 1)
+            {
+                std::unique_ptr<CheckpointJournal> journal(new CheckpointJournal(CheckpointJournal::filePath(partial)));
+                if (journal->load() && journal->header().matches(checkpointHeader))
+                {
+                    targetRoot = partial;
+                    checkpoint = std::move(journal);
+                    continue;
+                }
+            }
+            emit backupLogMessage(tr("中断された世代を削除します: %1").arg(partial));
+            const QString retired = snapshots.retire(partial);
+            if (!retired.isEmpty())
+            {
+                m_pruner->remove(retired);
+            }
+        }
+        for (const QString &retired : snapshots.retiredSnapshots())
+        {
+            m_pruner->remove(retired);
+        }
+        if (!checkpoint)
+        {
+            targetRoot = snapshots.begin(QDateTime::currentDateTime());
+        }
+        if (targetRoot.isEmpty())
+        {
+            failRun(tr("スナップショットを作成できませんでした: %1").arg(snapshots.errorString()));
+            return;
+        }
+        // 削除と並行して動くので、その間は削除の速さを抑えてもらう
+        m_pruner->setBackupActive(true);
+        statistics.snapshotName = QFileInfo(targetRoot).completeBaseName();
+        if (checkpoint)
+        {
+            emit backupLogMessage(tr("中断された世代の続きを作成します: %1").arg(statistics.snapshotName));
+        }
+        else
+        {
+            emit backupLogMessage(tr("新しい世代を作成します: %1").arg(statistics.snapshotName));
+        }
+    }
+    const QString manifestPath = manifestFilePath(targetRoot);
+    bool resuming = checkpoint != nullptr;
+    if (!checkpoint)
+    {
+        checkpoint.reset(new CheckpointJournal(CheckpointJournal::filePath(targetRoot)));
+        // スナップショットの新しい世代には途中経過はない
+        if (!snapshot && checkpoint->load())
+        {
+            resuming = checkpoint->header().matches(checkpointHeader);
+            if (!resuming)
+            {
+                emit backupLogMessage(tr("前回の途中経過は条件が変わっているため使いません"));
+            }
+        }
+    }
+
+    // コピーするファイル。差分モードでは前回のマニフェストと比べ、追加・変更されたものだけにする
+    std::pmr::vector<FileIndex::Id> filesToCopy(&arena);
+    // スナップショットで前の世代からリンクするファイル
+    std::pmr::vector<FileIndex::Id> filesToLink(&arena);
+    // ミラーでは前回のマニフェストにあって今回ないファイルを削除する（保存先を走査し直さない）
+    const bool mirror = config.updateMode() == BackupConfig::UpdateMirror;
+    QVector<QByteArray> staleFiles;
+    if (config.updateMode() != BackupConfig::UpdateFull && !previousManifestPath.isEmpty())
+    {
+        QElapsedTimer diffTimer;
+        diffTimer.start();
+        statistics.incremental = selectChangedFiles(fileIndex, previousManifestPath, filesToCopy, mirror ? &staleFiles : nullptr,
+                                                    snapshot ? &filesToLink : nullptr, statistics);
+        statistics.diffMs = diffTimer.elapsed();
+        if (mirror && !statistics.incremental)
+        {
+            emit backupLogMessage(tr("前回のファイル一覧がないため、今回は保存先からの削除を行いません"));
+        }
+    }
+    if (!statistics.incremental)
+    {
+        filesToLink.clear();
+        filesToCopy.clear();
+        filesToCopy.reserve(fileIndex.fileCount());
+        for (FileIndex::Id file = 0; file < static_cast<FileIndex::Id>(fileIndex.fileCount()); ++file)
+        {
+            filesToCopy.push_back(file);
+        }
+    }
+
+    // 前回の途中経過に続けて記録する。前回書き終えたファイルは確かめてから飛ばす
+    if (resuming)
+    {
+        emit backupLogMessage(tr("前回の途中経過から再開します（%1 開始, 記録 %2 件, %3 件目まで完了）")
+                                  .arg(QDateTime::fromMSecsSinceEpoch(checkpoint->header().startedMs).toString("yyyy-MM-dd HH:mm:ss"))
+                                  .arg(checkpoint->completedCount())
+                                  .arg(checkpoint->positionDone()));
+        statistics.resumedFiles = skipCheckpointedFiles(fileIndex, *checkpoint, targetRoot, filesToCopy) +
+                                  skipCheckpointedFiles(fileIndex, *checkpoint, targetRoot, filesToLink);
+        emit backupLogMessage(tr("前回書き終えた %1 個のファイルを飛ばします").arg(statistics.resumedFiles));
+    }
+    if (resuming ? !checkpoint->resume() : !checkpoint->begin(checkpointHeader))
+    {
+        emit backupLogMessage(tr("警告: 途中経過を記録できません（中断すると次回は最初から実行します）: %1").arg(checkpoint->errorString()));
+    }
+
+    // コピーを止めずに、書き終えたフォルダから順にバックグラウンドで同期する
+    std::unique_ptr<DurabilityFlusher> flusher;
+    if (DurabilityFlusher::isNeededFor(config.durabilityMode()))
+    {
+        flusher.reset(new DurabilityFlusher());
+    }
+
+    // コピーバックエンド（io_uring が使えなければ読み込み/書き込みスレッドのパイプライン）に
+    // ファイルを流し込む。結果はバックエンドのスレッドから届くので、ロックしたリストに貯めてこのスレッドで処理する
+    CopyResultSink sink(&arena);
+    // 元と先のディレクトリは開いたまま保持し、ファイルはその fd からの相対名で開く。
+    // フォルダの存在確認と作成もフォルダごとに1回で済む（バックエンドより先に作り、後で閉じる）
+    DirectoryHandleCache sourceDirs(sourceDir.absolutePath());
+    DirectoryHandleCache targetDirs(targetRoot);
+
+    // リンクは作成済みのフォルダに対して行うので、スナップショットでは常に先に作る
+    if (config.preCreateDirectories() || !filesToLink.empty())
+    {
+        // コピーを始める前に保存先のフォルダ構成を並列にまとめて作る
+        emit backupLogMessage(tr("保存先のフォルダ構成を作成しています..."));
+        QElapsedTimer skeletonTimer;
+        skeletonTimer.start();
+        QSet<FileIndex::Id> usedDirs;
+        for (FileIndex::Id file : filesToCopy)
+        {
+            usedDirs.insert(fileIndex.fileDirectory(file));
+        }
+        for (FileIndex::Id file : filesToLink)
+        {
+            usedDirs.insert(fileIndex.fileDirectory(file));
+        }
+        QVector<QByteArray> relativeDirs;
+        for (FileIndex::Id dir : usedDirs)
+        {
+            relativeDirs.append(fileIndex.directoryPath(dir));
+        }
+        targetDirs.createTree(relativeDirs);
+        statistics.skeletonMs = skeletonTimer.elapsed();
+        emit backupLogMessage(tr("フォルダを %1 個作成しました (%2 ms)").arg(targetDirs.createdCount()).arg(statistics.skeletonMs));
+        QApplication::processEvents();
+    }
+
+    if (!filesToLink.empty())
+    {
+        linkUnchangedFiles(fileIndex, filesToLink, previousSnapshot.path, targetRoot, filesToCopy, *checkpoint, statistics);
+        QApplication::processEvents();
+    }
+
+    // 総ファイル数
+    int totalFiles = static_cast<int>(filesToCopy.size());
+    int copiedFiles = 0;
+    int failedFiles = 0;
+    const bool syncEachFile = config.durabilityMode() == BackupConfig::DurabilityPerFile;
+    // コピーに失敗したファイル（マニフェストに載せず、次回もう一度コピーする）
+    std::pmr::vector<bool> failed(fileIndex.fileCount(), false, &arena);
+    // 結果が届いたファイル。filesToCopy の先頭から続けて届いた数を途中経過の位置として記録する
+    std::pmr::vector<bool> processed(fileIndex.fileCount(), false, &arena);
+    size_t checkpointDone = 0;
+    int checkpointPending = 0;
+    QElapsedTimer checkpointTimer;
+    checkpointTimer.start();
+    auto saveCheckpoint = [&]()
+    {
+        while (checkpointDone < filesToCopy.size() && processed[filesToCopy[checkpointDone]])
+        {
+            ++checkpointDone;
+        }
+        checkpoint->setPosition(static_cast<qint64>(checkpointDone),
+                                checkpointDone < filesToCopy.size() ? fileIndex.filePath(filesToCopy[checkpointDone]) : QByteArray());
+        checkpoint->flush();
+        checkpointPending = 0;
+        checkpointTimer.restart();
+    };
+
+    m_bufferPool->resetStats();
+    // HDD が絡むときはファイルを1つずつ流す（並べて読むとシークが増えるだけ）
+    const DeviceInfo::Device sourceDevice = DeviceInfo::forPath(sourceRoot);
+    const DeviceInfo::Device targetDevice = DeviceInfo::forPath(targetRoot);
+    const int fileStreams = DeviceInfo::fileStreamLimit(sourceDevice, targetDevice);
+    // 上限がなくても渡しておく（実行中に設定や全体の上限を変えたときに効くように）
+    setIoLimits(config.ioLimits());
+    m_throttle->setWatchedDevices(QStringList{sourceDevice.name, targetDevice.name});
+    // 全体の上限の自動調整は、最後に始めた実行のディスクを見る
+    IoThrottle::global().setWatchedDevices(QStringList{sourceDevice.name, targetDevice.name});
+    m_throttle->resetStats();
+    std::unique_ptr<CopyBackend> backend = CopyBackend::create(CopyBackend::Auto, m_bufferPool.get(), fileStreams, m_throttle.get(),
+                                                               config.cacheFriendly());
+    statistics.copyBackend = backend->name();
+    emit backupLogMessage(tr("コピー方式: %1").arg(backend->name()));
+    emit backupLogMessage(tr("ディスク: 元 %1 (%2) / 先 %3 (%4), 同時に扱うファイル: %5")
+                              .arg(sourceDevice.name, sourceDevice.typeName(), targetDevice.name, targetDevice.typeName(),
+                                   fileStreams > 0 ? QString::number(fileStreams) : tr("制限なし")));
+    QElapsedTimer copyTimer;
+    copyTimer.start();
+    // 古い世代の削除と重なったか（重なった実行のコピー時間と比べられるように記録する）
+    const bool pruningAtCopyStart = !m_pruner->isIdle();
+
+    // 受け取り用と処理用の2つのバッファを入れ替えて使い回す（容量が残るので再確保しない）
+    std::pmr::vector<CopyResult> finished(&arena);
+    auto drainResults = [&]()
+    {
+        finished.clear();
+        {
+            QMutexLocker locker(&sink.mutex);
+            finished.swap(sink.results);
+        }
+
+        for (const CopyResult &result : finished)
+        {
+            processed[result.file] = true;
+            if (!result.success)
+            {
+                const QString relativePath = QFile::decodeName(fileIndex.filePath(result.file));
+                const QString sourcePath = sourceRoot + "/" + relativePath;
+                failedFiles++;
+                failed[result.file] = true;
+                emit fileProcessed(sourcePath, false);
+                emit backupLogMessage(tr("ファイルコピー失敗: %1 → %2 (%3)").arg(sourcePath, targetRoot + "/" + relativePath, result.errorString));
+            }
+            else
+            {
+                const QByteArray relativePath = fileIndex.filePath(result.file);
+                checkpoint->add(relativePath, CheckpointJournal::Entry{fileIndex.fileSize(result.file), fileIndex.fileMtime(result.file)});
+                checkpointPending++;
+                if (flusher)
+                {
+                    flusher->addFile(targetRoot + "/" + QFile::decodeName(relativePath));
+                }
+            }
+            copiedFiles++;
+        }
+
+        if (!finished.empty())
+        {
+            emit backupProgress((copiedFiles * 100) / totalFiles);
+        }
+        if (checkpointPending >= kCheckpointBatch || (checkpointPending > 0 && checkpointTimer.elapsed() >= kCheckpointIntervalMs))
+        {
+            saveCheckpoint();
+        }
+    };
+
+    // バックアップ処理（索引はフォルダ順に並んでいるので、フォルダが変わったときだけ開き直す）
+    FileIndex::Id currentDir = FileIndex::kInvalidId;
+    DirectoryHandle source;
+    DirectoryHandle target;
+    for (FileIndex::Id file : filesToCopy)
+    {
+        // 中止されたら新しいファイルは渡さず、渡したものが書き終わるのを待つ
+        if (m_stopRequested)
+        {
+            break;
+        }
+        const FileIndex::Id dir = fileIndex.fileDirectory(file);
+        if (dir != currentDir)
+        {
+            currentDir = dir;
+            const QByteArray relativeDir = fileIndex.directoryPath(dir);
+            source = sourceDirs.handle(relativeDir);
+            target = targetDirs.handle(relativeDir, true);
+        }
+
+        if (!source.isValid() || !target.isValid())
+        {
+            const QString error = !source.isValid() ? sourceDirs.errorString() : targetDirs.errorString();
+            QMutexLocker locker(&sink.mutex);
+            sink.results.push_back(CopyResult{file, false, error});
+            continue;
+        }
+
+        // 一時ファイルに書いてから置き換える（途中で失敗しても前回のコピーは残る）
+        const QByteArray fileName = fileIndex.fileName(file).toByteArray();
+        CopyResultSink *resultSink = &sink;
+        backend->submitAt(source, fileName, target, fileName, syncEachFile, [resultSink, file](bool success, const QString &error)
+                          {
+            QMutexLocker locker(&resultSink->mutex);
+            resultSink->results.push_back(CopyResult{file, success, error}); });
+
+        drainResults();
+    }
 
-    // バックアップ処理
-    for (const QFileInfo &fileInfo : fileList)
+    // 残りのコピーが終わるまでUIの応答性を保ちながら待つ
+    while (!backend->waitForDone(50))
     {
-        QString relativePath = sourceDir.relativeFilePath(fileInfo.filePath());
-        QString targetPath = destPath + QDir::separator() + relativePath;
+        drainResults();
+        QApplication::processEvents();
+    }
+    drainResults();
+    statistics.copyMs = copyTimer.elapsed();
+    statistics.throttleWaitMs = m_throttle->waitedMs();
+    statistics.throttleFactor = m_throttle->adaptiveFactor();
+    statistics.pruningConcurrent = pruningAtCopyStart || !m_pruner->isIdle();
+    statistics.bufferPool = m_bufferPool->stats();
+    backend.reset();
 
-        // ターゲットディレクトリがなければ作成
-        QFileInfo targetFileInfo(targetPath);
-        QDir targetDir = targetFileInfo.dir();
-        if (!targetDir.exists())
+    // 中止: 書き終えたところまでを途中経過に残し、マニフェストは書かずに戻る
+    // （スナップショットの世代も作成中のまま残し、次の実行がその続きを書く）
+    if (m_stopRequested)
+    {
+        saveCheckpoint();
+        syncDestination(config, flusher.get());
+        if (snapshot)
+        {
+            m_pruner->setBackupActive(false);
+        }
+        statistics.stopped = true;
+        statistics.totalFiles = totalFiles;
+        statistics.copiedFiles = copiedFiles - failedFiles;
+        statistics.failedFiles = failedFiles;
+        statistics.directoriesCreated = targetDirs.createdCount();
+        statistics.totalMs = runTimer.elapsed();
+        statistics.arena = arena.stats();
+        m_lastStatistics = statistics;
+        for (const QString &line : statistics.toLogLines())
         {
-            targetDir.mkpath(".");
+            emit backupLogMessage(line);
         }
+        emit runStatisticsReady(statistics);
+        emit backupLogMessage(tr("バックアップを中止しました。次回の実行で続きから再開します"));
+        return;
+    }
+
+    // ミラー: バックアップ元からなくなったファイルを保存先から削除する
+    bool staleRemoved = false;
+    QSet<QByteArray> staleRemaining;
+    if (!staleFiles.isEmpty())
+    {
+        staleRemoved = removeStaleFiles(destPath, staleFiles, config.mirrorDeleteLimit(), statistics, &staleRemaining);
+    }
+
+    // 保存先の内容を次回の差分のためにマニフェストへ記録する。コピーに失敗したファイルは除き、
+    // バックアップ元からなくなっても保存先に残っているファイルは残す
+    // （新しい世代には前回からなくなったファイルは入っていないので、スナップショットでは残さない）
+    if (!writeManifest(fileIndex, previousManifestPath, manifestPath, [&failed](FileIndex::Id file)
+                       { return !failed[file]; },
+                       [snapshot, staleRemoved, &staleRemaining](const QByteArray &path)
+                       { return snapshot || (staleRemoved && !staleRemaining.contains(path)); }))
+    {
+        emit backupLogMessage(tr("警告: ファイル一覧を保存先に記録できませんでした: %1").arg(manifestPath));
+    }
+
+    statistics.syncMs = syncDestination(config, flusher.get());
 
-        // コピー実行
-        QFile sourceFile(fileInfo.filePath());
-        QFile targetFile(targetPath);
+    // マニフェストに記録したので途中経過はもう要らない（スナップショットでは世代の中に残さない）
+    if (!checkpoint->remove())
+    {
+        emit backupLogMessage(tr("警告: 途中経過のファイルを削除できませんでした: %1").arg(checkpoint->errorString()));
+    }
 
-        // 既存ファイルがある場合は削除
-        if (targetFile.exists())
+    // 書き込みがディスクに届いてから世代を完了にする（途中で止まった世代をリンク元にしない）
+    if (snapshot)
+    {
+        const bool finished = snapshots.finish(targetRoot);
+        if (!finished)
+        {
+            emit backupLogMessage(tr("警告: 世代を完了にできませんでした: %1").arg(snapshots.errorString()));
+        }
+        else if (config.durabilityMode() != BackupConfig::DurabilityNone)
+        {
+            FileSystem::syncPath(destPath);
+        }
+        m_pruner->setBackupActive(false);
+        // 欠けたファイルがある世代を数に入れて古い完全な世代を消さないよう、すべてコピーできたときだけ期限切れにする
+        if (finished && failedFiles == 0)
+        {
+            expireSnapshots(config, snapshots);
+        }
+        else if (failedFiles > 0)
         {
-            targetFile.remove();
+            emit backupLogMessage(tr("コピーに失敗したファイルがあるため、古い世代は削除しませんでした"));
         }
+    }
 
-        // コピー実行
-        sourceFile.copy(targetPath);
+    if (failedFiles > 0)
+    {
+        emit backupLogMessage(tr("%1 個のファイルのコピーに失敗しました").arg(failedFiles));
+    }
 
-        // 進捗更新
-        copiedFiles++;
-        int progress = (copiedFiles * 100) / totalFiles;
-        emit backupProgress(progress);
+    statistics.totalFiles = totalFiles;
+    statistics.copiedFiles = copiedFiles - failedFiles;
+    statistics.failedFiles = failedFiles;
+    statistics.directoriesCreated = targetDirs.createdCount();
+    statistics.totalMs = runTimer.elapsed();
+    statistics.arena = arena.stats();
+    m_lastStatistics = statistics;
+    for (const QString &line : statistics.toLogLines())
+    {
+        emit backupLogMessage(line);
     }
+    emit runStatisticsReady(statistics);
 
     // バックアップ処理が完了したら、明示的に進捗100%を設定してから完了シグナルを発行
     emit backupProgress(100);
@@ -251,78 +800,355 @@ void BackupEngine::runBackup(const BackupConfig &config)
     emit backupCompleted(); // 両方のシグナルを発行（互換性のため）
 }
 
-QFileInfoList BackupEngine::getFileList(const QDir &sourceDir,
-                                        const QStringList &excludedFiles,
-                                        const QStringList &excludedFolders,
-                                        const QStringList &excludedExtensions)
+bool BackupEngine::selectChangedFiles(const FileIndex &index, const QString &manifestPath,
+                                      std::pmr::vector<quint32> &files, QVector<QByteArray> *deletedFiles,
+                                      std::pmr::vector<quint32> *unchangedFiles, RunStatistics &statistics)
 {
-    QFileInfoList result;
+    ManifestReader previous(manifestPath);
+    if (!previous.open())
+    {
+        emit backupLogMessage(tr("前回のファイル一覧がないため、すべてのファイルをコピーします"));
+        return false;
+    }
 
-    QFileInfoList entries = sourceDir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden);
+    // 走査結果も前回の一覧もパス順なので、先頭から1回たどるだけで比べられる
+    FileIndexManifestSource current(index);
+    ManifestDiff diff;
+    const bool merged = diff.run(current, previous, [&files, deletedFiles, unchangedFiles](ManifestDiff::Change change, const ManifestEntry &entry, const ManifestEntry &old)
+                                 {
+        if (change == ManifestDiff::Added || change == ManifestDiff::Modified) {
+            files.push_back(entry.file);
+        } else if (change == ManifestDiff::Deleted && deletedFiles) {
+            deletedFiles->append(old.path);
+        } else if (change == ManifestDiff::Unchanged && unchangedFiles) {
+            unchangedFiles->push_back(entry.file);
+        } });
+    if (!merged)
+    {
+        files.clear();
+        if (deletedFiles)
+        {
+            deletedFiles->clear();
+        }
+        if (unchangedFiles)
+        {
+            unchangedFiles->clear();
+        }
+        emit backupLogMessage(tr("前回のファイル一覧を読み込めないため、すべてのファイルをコピーします: %1").arg(diff.errorString()));
+        return false;
+    }
+
+    statistics.diff = diff.stats();
+    emit backupLogMessage(tr("差分: 追加 %1 / 変更 %2 / 削除 %3 / 変更なし %4")
+                              .arg(statistics.diff.added)
+                              .arg(statistics.diff.modified)
+                              .arg(statistics.diff.deleted)
+                              .arg(statistics.diff.unchanged));
+    return true;
+}
+
+void BackupEngine::linkUnchangedFiles(const FileIndex &index, const std::pmr::vector<quint32> &files,
+                                      const QString &previousRoot, const QString &targetRoot,
+                                      std::pmr::vector<quint32> &copyFiles, CheckpointJournal &checkpoint, RunStatistics &statistics)
+{
+    emit backupLogMessage(tr("変更のない %1 個のファイルを前の世代からリンクしています...").arg(files.size()));
+    QElapsedTimer linkTimer;
+    linkTimer.start();
 
-    for (const QFileInfo &entry : entries)
+    // 索引の順なので同じフォルダのファイルが並んでおり、フォルダごとのバッチで並列にリンクできる
+    QVector<QByteArray> paths;
+    paths.reserve(static_cast<int>(files.size()));
+    for (FileIndex::Id file : files)
     {
-        QString relativePath = sourceDir.relativeFilePath(entry.filePath());
+        paths.append(index.filePath(file));
+    }
+    HardLinker linker(previousRoot, targetRoot);
+    linker.link(paths);
 
-        if (entry.isDir())
+    // 別のファイルシステムやリンク数の上限などでリンクできなかったものはコピーする
+    const QVector<HardLinker::Failure> failures = linker.failures();
+    QSet<QByteArray> failedPaths;
+    for (const HardLinker::Failure &failure : failures)
+    {
+        failedPaths.insert(failure.path);
+    }
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        if (failedPaths.contains(paths.at(i)))
         {
-            bool exclude = false;
+            copyFiles.push_back(files[i]);
+        }
+        else
+        {
+            checkpoint.add(paths.at(i), CheckpointJournal::Entry{index.fileSize(files[i]), index.fileMtime(files[i])});
+        }
+    }
+    checkpoint.flush();
+    if (!failures.isEmpty())
+    {
+        // 索引は並べ替え済みなので、番号順がフォルダ順になる
+        std::sort(copyFiles.begin(), copyFiles.end());
+        emit backupLogMessage(tr("%1 個のファイルはリンクできないためコピーします（例: %2: %3）")
+                                  .arg(failures.size())
+                                  .arg(QFile::decodeName(failures.first().path), failures.first().errorString));
+    }
 
-            for (const QString &pattern : excludedFolders)
-            {
-                // QRegExp から QRegularExpression に変更
-                QString wildcardPattern = QRegularExpression::wildcardToRegularExpression(pattern);
-                QRegularExpression regex(wildcardPattern, QRegularExpression::CaseInsensitiveOption);
-                if (regex.match(entry.fileName()).hasMatch() || regex.match(relativePath).hasMatch())
-                {
-                    exclude = true;
-                    break;
-                }
-            }
+    statistics.filesLinked = linker.linkedCount();
+    statistics.linkMs = linkTimer.elapsed();
+    emit backupLogMessage(tr("%1 個のファイルをリンクしました (%2 ms)").arg(statistics.filesLinked).arg(statistics.linkMs));
+}
 
-            if (!exclude)
-            {
-                QDir subDir(entry.filePath());
-                result.append(getFileList(subDir, excludedFiles, excludedFolders, excludedExtensions));
-            }
+qint64 BackupEngine::skipCheckpointedFiles(const FileIndex &index, const CheckpointJournal &checkpoint, const QString &targetRoot,
+                                          std::pmr::vector<quint32> &files)
+{
+    // バックアップ元は走査した索引と記録を比べるだけで済む。保存先は大きさだけを確かめる
+    // （書き終えた後に消されたり置き換えられたりしたものはもう一度コピーする）
+    const QDir target(targetRoot);
+    const auto done = [&](FileIndex::Id file)
+    {
+        const QByteArray path = index.filePath(file);
+        CheckpointJournal::Entry entry;
+        if (!checkpoint.completed(path, &entry) || entry.size != index.fileSize(file) || entry.mtimeNs != index.fileMtime(file))
+        {
+            return false;
+        }
+        const QFileInfo copied(target.filePath(QFile::decodeName(path)));
+        return copied.isFile() && copied.size() == entry.size;
+    };
+    const auto kept = std::remove_if(files.begin(), files.end(), done);
+    const qint64 skipped = files.end() - kept;
+    files.erase(kept, files.end());
+    return skipped;
+}
+
+void BackupEngine::expireSnapshots(const BackupConfig &config, SnapshotStore &snapshots)
+{
+    const RetentionPolicy policy(config.retention());
+    if (!policy.isEnabled())
+    {
+        return;
+    }
+
+    const QVector<SnapshotStore::Snapshot> all = snapshots.snapshots();
+    QVector<QDateTime> times;
+    for (const SnapshotStore::Snapshot &snapshot : all)
+    {
+        times.append(snapshot.time);
+    }
+    const QVector<bool> keep = policy.keep(times);
+
+    // 名前を変えて一覧から外すところまではすぐに済ませ、中身の削除は次のバックアップを待たせないよう後回しにする
+    int expired = 0;
+    for (int i = 0; i < all.size(); ++i)
+    {
+        if (keep.at(i))
+        {
+            continue;
         }
-        else if (entry.isFile())
+        const QString retired = snapshots.retire(all.at(i).path);
+        if (retired.isEmpty())
         {
-            bool exclude = false;
+            emit backupLogMessage(tr("警告: 古い世代を削除待ちにできませんでした: %1").arg(snapshots.errorString()));
+            continue;
+        }
+        m_pruner->remove(retired);
+        expired++;
+    }
+    if (expired > 0)
+    {
+        emit backupLogMessage(tr("保持設定により %1 個の古い世代をバックグラウンドで削除します（残す世代: %2 個）")
+                                  .arg(expired)
+                                  .arg(all.size() - expired));
+    }
+}
 
-            for (const QString &pattern : excludedFiles)
-            {
-                // QRegExp から QRegularExpression に変更
-                QString wildcardPattern = QRegularExpression::wildcardToRegularExpression(pattern);
-                QRegularExpression regex(wildcardPattern, QRegularExpression::CaseInsensitiveOption);
-                if (regex.match(entry.fileName()).hasMatch() || regex.match(relativePath).hasMatch())
-                {
-                    exclude = true;
-                    break;
+bool BackupEngine::removeStaleFiles(const QString &destPath, const QVector<QByteArray> &staleFiles,
+                                    int limitPercent, RunStatistics &statistics, QSet<QByteArray> *remaining)
+{
+    // バックアップ元を取り違えた場合などに保存先を丸ごと消さないよう、削除の割合に上限を設ける
+    const qint64 previousFiles = statistics.diff.deleted + statistics.diff.modified + statistics.diff.unchanged;
+    const qint64 percent = previousFiles > 0 ? (staleFiles.size() * 100) / previousFiles : 0;
+    if (limitPercent < 100 && percent > limitPercent)
+    {
+        emit backupLogMessage(tr("警告: 前回の %1 個のファイルのうち %2 個 (%3%) が削除対象で、上限 %4% を超えるため削除を中止しました")
+                                  .arg(previousFiles)
+                                  .arg(staleFiles.size())
+                                  .arg(percent)
+                                  .arg(limitPercent));
+        return false;
+    }
+
+    emit backupLogMessage(tr("バックアップ元にないファイルを %1 個削除しています...").arg(staleFiles.size()));
+    QElapsedTimer removeTimer;
+    removeTimer.start();
+
+    // マニフェスト順なので同じフォルダのファイルが並んでおり、フォルダごとのバッチで並列に消せる
+    FileRemover remover(destPath);
+    remover.removeFiles(staleFiles);
+
+    QVector<QByteArray> parents;
+    QByteArray lastParent;
+    for (const QByteArray &path : staleFiles)
+    {
+        QByteArray parent;
+        DirectoryHandleCache::split(path, &parent, nullptr);
+        if (!parent.isEmpty() && parent != lastParent)
+        {
+            parents.append(parent);
+            lastParent = parent;
+        }
+    }
+    statistics.directoriesRemoved = remover.removeEmptyDirectories(parents);
+
+    for (const FileRemover::Failure &failure : remover.failures())
+    {
+        remaining->insert(failure.path);
+        emit backupLogMessage(tr("削除失敗: %1 (%2)").arg(QFile::decodeName(failure.path), failure.errorString));
+    }
+    statistics.filesRemoved = remover.removedCount();
+    statistics.removeFailures = remaining->size();
+    statistics.removeMs = removeTimer.elapsed();
+    emit backupLogMessage(tr("%1 個のファイルと %2 個のフォルダを削除しました (%3 ms)")
+                              .arg(statistics.filesRemoved)
+                              .arg(statistics.directoriesRemoved)
+                              .arg(statistics.removeMs));
+    return true;
+}
+
+bool BackupEngine::writeManifest(const FileIndex &index, const QString &previousManifestPath, const QString &manifestPath,
+                                 const std::function<bool(quint32)> &include,
+                                 const std::function<bool(const QByteArray &)> &removed)
+{
+    // 前回の一覧と突き合わせ、変わっていないファイルは前回のハッシュを引き継ぐ
+    ManifestReader previous(previousManifestPath);
+    if (!previousManifestPath.isEmpty() && previous.open())
+    {
+        ManifestWriter writer(manifestPath, previous.hasHashes());
+        FileIndexManifestSource current(index, include);
+        ManifestDiff diff;
+        const bool merged = writer.open() && diff.run(current, previous, [&writer, &removed](ManifestDiff::Change change, const ManifestEntry &entry, const ManifestEntry &old)
+                                                      {
+            if (change == ManifestDiff::Unchanged) {
+                ManifestEntry carried = entry;
+                carried.hash = old.hash;
+                writer.write(carried);
+            } else if (change == ManifestDiff::Deleted) {
+                // 保存先に残っているものは記録し続ける（後でミラーにしたときに削除できるように）
+                if (!removed(old.path)) {
+                    writer.write(old);
                 }
-            }
+            } else {
+                writer.write(entry);
+            } });
+        // 置き換える前に読み込み側を閉じる（Windows では開いたままのファイルを置き換えられない）
+        previous.close();
+        if (merged && writer.commit())
+        {
+            return true;
+        }
+        // 前回の一覧が壊れていた場合は今回の分だけで書き直す
+    }
+
+    ManifestWriter writer(manifestPath);
+    if (!writer.open())
+    {
+        return false;
+    }
+    FileIndexManifestSource current(index, include);
+    ManifestEntry entry;
+    while (current.next(entry))
+    {
+        writer.write(entry);
+    }
+    return writer.commit();
+}
+
+qint64 BackupEngine::syncDestination(const BackupConfig &config, DurabilityFlusher *flusher)
+{
+    const BackupConfig::DurabilityMode mode = config.durabilityMode();
+    if (mode == BackupConfig::DurabilityNone || mode == BackupConfig::DurabilityPerFile)
+    {
+        return 0;
+    }
+
+    // 完了を報告する前に、書き込んだデータがディスクに届いていることを保証する
+    emit backupLogMessage(tr("バックアップ先をディスクに書き出しています..."));
+    QElapsedTimer timer;
+    timer.start();
 
-            if (!exclude)
+    if (flusher)
+    {
+        flusher->finish();
+        const QStringList failed = flusher->failedPaths();
+        if (!failed.isEmpty())
+        {
+            emit backupLogMessage(tr("警告: %1 個のパスの同期に失敗しました（例: %2）").arg(failed.size()).arg(failed.first()));
+        }
+    }
+    else if (!FileSystem::syncFileSystem(config.destinationPath()))
+    {
+        emit backupLogMessage(tr("警告: バックアップ先の同期に失敗しました: %1").arg(config.destinationPath()));
+    }
+
+    const qint64 elapsed = timer.elapsed();
+    emit backupLogMessage(tr("ディスクへの書き出しが完了しました (%1 ms)").arg(elapsed));
+    return elapsed;
+}
+
+void BackupEngine::buildFileIndex(const QDir &sourceDir,
+                                  const QStringList &excludedFiles,
+                                  const QStringList &excludedFolders,
+                                  const QStringList &excludedExtensions,
+                                  FileIndex &index)
+{
+    // パターンは走査の前に一度だけコンパイルしておく（フィルタは複数スレッドから呼ばれる）
+    auto compile = [](const QStringList &patterns)
+    {
+        QVector<QRegularExpression> result;
+        for (const QString &pattern : patterns)
+        {
+            QString wildcardPattern = QRegularExpression::wildcardToRegularExpression(pattern);
+            result.append(QRegularExpression(wildcardPattern, QRegularExpression::CaseInsensitiveOption));
+        }
+        return result;
+    };
+    const QVector<QRegularExpression> folderPatterns = compile(excludedFolders);
+    const QVector<QRegularExpression> filePatterns = compile(excludedFiles);
+    QStringList extensions;
+    for (const QString &ext : excludedExtensions)
+    {
+        extensions.append(ext.toLower());
+    }
+
+    TreeWalker::Options options;
+    options.sorted = true;
+    options.needMetadata = true;
+    options.filter = [&](const TreeWalker::Entry &entry)
+    {
+        // 従来どおりフォルダ・ファイルとも名前か、ルートからの相対パス（"sub/cache" など）で判定する
+        const QVector<QRegularExpression> &patterns = entry.isDir ? folderPatterns : filePatterns;
+        for (const QRegularExpression &regex : patterns)
+        {
+            if (regex.match(entry.name).hasMatch() || regex.match(entry.relativePath).hasMatch())
             {
-                QString extension = "." + entry.suffix().toLower();
-                for (const QString &ext : excludedExtensions)
-                {
-                    if (ext.toLower() == extension)
-                    {
-                        exclude = true;
-                        break;
-                    }
-                }
+                return false;
             }
+        }
 
-            if (!exclude)
+        if (!entry.isDir && !extensions.isEmpty())
+        {
+            const int dot = entry.name.lastIndexOf(QLatin1Char('.'));
+            const QString extension = "." + (dot < 0 ? QString() : entry.name.mid(dot + 1).toLower());
+            if (extensions.contains(extension))
             {
-                result.append(entry);
+                return false;
             }
         }
-    }
+        return true;
+    };
 
-    return result;
+    TreeWalker walker(options);
+    walker.walk(sourceDir.absolutePath(), index);
 }
 
 void BackupEngine::onFileProcessed(const QString &filePath, bool success)
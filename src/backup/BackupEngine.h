@@ -5,9 +5,25 @@
 #include <QFileInfoList>
 #include <QDir>
 #include <QRegularExpression>       // QRegExp から QRegularExpression に変更
+#include <QSet>
+#include <QVector>
 #include "../models/BackupConfig.h" // 明示的にBackupConfigをインクルード
+#include "RunStatistics.h"
+#include "../utils/ThreadPriority.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <vector>
 
 class BackupTask;
+class CheckpointJournal;
+class DurabilityFlusher;
+class BufferPool;
+class FileIndex;
+class IoThrottle;
+class SnapshotPruner;
+class SnapshotStore;
 
 class BackupEngine : public QObject
 {
@@ -18,10 +34,24 @@ public:
     ~BackupEngine();
 
     void startBackup(const QString &sourcePath, const QString &destinationPath);
+    // config のバックアップを実行する。エンジンは実行ごとの状態をすべてメンバーとローカルに持つので、
+    // 別々のインスタンスなら別々のスレッドで同時に実行できる（BackupJobScheduler を参照）
     void runBackup(const BackupConfig &config); // 既存のメソッドをヘッダーに追加
+    // 実行中の runBackup を止める（どのスレッドからでもよい）。コピー中のファイルを書き終えてから
+    // 途中経過を保存して戻るので、次の実行は続きから始まる。実行中でなければ何もしない
     void stopBackup();
     bool isRunning() const;
 
+    // 次の runBackup で、runBackup を呼んだスレッドとコピーのワーカーに設定する優先度。
+    // Normal 以外は元に戻せないので、使い捨てのスレッドから runBackup を呼ぶときだけ設定すること
+    void setPriorityClass(ThreadPriority::Class cls);
+
+    // 実行中の読み書きの速さの上限を変える（どのスレッドからでもよい。次の読み書きから効く）
+    void setIoLimits(const BackupConfig::IoLimits &limits);
+
+    // 直前の runBackup の集計
+    RunStatistics lastRunStatistics() const;
+
 signals:
     void backupProgress(int progress);
     void backupCompleted();
@@ -30,6 +60,7 @@ signals:
     void fileProcessed(const QString &filePath, bool success);
     void directoryProcessed(const QString &dirPath, bool created);
     void backupLogMessage(const QString &message);
+    void runStatisticsReady(const RunStatistics &statistics);
 
 private slots:
     void onBackupProgressUpdated(int progress);
@@ -40,11 +71,53 @@ private slots:
 
 private:
     BackupTask *m_currentTask;
+    std::unique_ptr<BufferPool> m_bufferPool; // コピー用バッファ（実行をまたいで使い回す）
+    std::unique_ptr<SnapshotPruner> m_pruner; // 期限切れの世代をバックグラウンドで削除する
+    std::unique_ptr<IoThrottle> m_throttle;   // 設定ごとの速さの上限（親は全体の上限）
+    RunStatistics m_lastStatistics;
+    std::atomic<bool> m_running; // runBackup の実行中（別のスレッドから isRunning で見る）
+    std::atomic<bool> m_stopRequested;
+    ThreadPriority::Class m_priorityClass;
+
+    // 実行を打ち切る。理由を m_lastStatistics に記録し、backupError を出す
+    void failRun(const QString &message);
+    // 書き出しを待った時間（ms）を返す
+    qint64 syncDestination(const BackupConfig &config, DurabilityFlusher *flusher);
+
+    // 除外設定を適用してバックアップ元を走査し、index に追加する
+    void buildFileIndex(const QDir &sourceDir,
+                        const QStringList &excludedFiles,
+                        const QStringList &excludedFolders,
+                        const QStringList &excludedExtensions,
+                        FileIndex &index);
 
-    QFileInfoList getFileList(const QDir &sourceDir,
-                              const QStringList &excludedFiles,
-                              const QStringList &excludedFolders,
-                              const QStringList &excludedExtensions);
+    // 前回のマニフェストと比べ、追加・変更されたファイルを files に入れる。
+    // マニフェストがない・読めない場合は false（すべてコピーする）
+    // deletedFiles を渡すと、前回あって今回ないファイルをそこに入れる。
+    // unchangedFiles を渡すと、変わっていないファイルをそこに入れる
+    bool selectChangedFiles(const FileIndex &index, const QString &manifestPath,
+                            std::pmr::vector<quint32> &files, QVector<QByteArray> *deletedFiles,
+                            std::pmr::vector<quint32> *unchangedFiles, RunStatistics &statistics);
+    // スナップショット: files を前の世代 previousRoot から今回の世代 targetRoot へハードリンクする。
+    // リンクできなかったファイルは copyFiles に加える（並び順は保つ）。リンクしたファイルは checkpoint に記録する
+    void linkUnchangedFiles(const FileIndex &index, const std::pmr::vector<quint32> &files,
+                            const QString &previousRoot, const QString &targetRoot,
+                            std::pmr::vector<quint32> &copyFiles, CheckpointJournal &checkpoint, RunStatistics &statistics);
+    // 前回の途中経過に書き終えたと記録され、バックアップ元も保存先（targetRoot）も変わっていないファイルを
+    // files から外す（並び順は保つ）。外した数を返す
+    qint64 skipCheckpointedFiles(const FileIndex &index, const CheckpointJournal &checkpoint, const QString &targetRoot,
+                                 std::pmr::vector<quint32> &files);
+    // ミラー: staleFiles を保存先から削除する。割合が上限を超えたら何もせず false。
+    // 削除できなかったファイルは remaining に入れる
+    bool removeStaleFiles(const QString &destPath, const QVector<QByteArray> &staleFiles,
+                          int limitPercent, RunStatistics &statistics, QSet<QByteArray> *remaining);
+    // 保持設定に当てはまらない世代を一覧から外し、バックグラウンドでの削除を予約する
+    void expireSnapshots(const BackupConfig &config, SnapshotStore &snapshots);
+    // include が true を返したファイルを manifestPath に書く。previousManifestPath（前回の一覧）に
+    // あって今回ないファイルは、removed が true を返したもの（保存先から削除したもの）を除いて残す
+    bool writeManifest(const FileIndex &index, const QString &previousManifestPath, const QString &manifestPath,
+                       const std::function<bool(quint32)> &include,
+                       const std::function<bool(const QByteArray &)> &removed);
 };
 
 #endif // BACKUPENGINE_H
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "BackupJobScheduler.h"
+#include "BackupEngine.h"
+#include <QThread>
+
+BackupJobScheduler::BackupJobScheduler(QObject *parent)
+    : QObject(parent), m_maxConcurrentJobs(2), m_jobsPerSsd(2)
+{
+}
+
+BackupJobScheduler::~BackupJobScheduler()
+{
+    // 終了時は実行中のジョブを中止して待つ（次に起動したときに続きから再開する）
+    m_pending.clear();
+    for (Slot &slot : m_slots)
+    {
+        if (slot.thread)
+        {
+            // 中止は runBackup に入ってからしか効かないので、始まったばかりのジョブにも届くよう繰り返す
+            do
+            {
+                slot.engine->stopBackup();
+            } while (!slot.thread->wait(50));
+            delete slot.thread;
+        }
+        delete slot.engine;
+    }
+}
+
+int BackupJobScheduler::maxConcurrentJobs() const
+{
+    return m_maxConcurrentJobs;
+}
+
+void BackupJobScheduler::setMaxConcurrentJobs(int jobs)
+{
+    m_maxConcurrentJobs = qMax(1, jobs);
+    dispatch();
+}
+
+int BackupJobScheduler::jobsPerSsd() const
+{
+    return m_jobsPerSsd;
+}
+
+void BackupJobScheduler::setJobsPerSsd(int jobs)
+{
+    m_jobsPerSsd = qMax(1, jobs);
+    dispatch();
+}
+
+bool BackupJobScheduler::enqueue(int jobId, const BackupConfig &config, bool background)
+{
+    if (isJobActive(jobId))
+    {
+        return false;
+    }
+    Job job;
+    job.id = jobId;
+    job.config = config;
+    job.background = background;
+    job.devices = devicesFor(config);
+    m_pending.append(job);
+    dispatch();
+    return true;
+}
+
+void BackupJobScheduler::setJobIoLimits(int jobId, const BackupConfig::IoLimits &limits)
+{
+    for (Job &job : m_pending)
+    {
+        if (job.id == jobId)
+        {
+            job.config.setIoLimits(limits);
+        }
+    }
+    for (Slot &slot : m_slots)
+    {
+        if (slot.thread && slot.job.id == jobId)
+        {
+            slot.job.config.setIoLimits(limits);
+            slot.engine->setIoLimits(limits);
+        }
+    }
+}
+
+void BackupJobScheduler::cancelPending()
+{
+    m_pending.clear();
+    if (runningJobs() == 0)
+    {
+        emit allJobsFinished();
+    }
+}
+
+void BackupJobScheduler::stopJob(int jobId)
+{
+    bool removed = false;
+    for (int i = m_pending.size() - 1; i >= 0; --i)
+    {
+        if (m_pending[i].id == jobId)
+        {
+            m_pending.removeAt(i);
+            removed = true;
+        }
+    }
+    for (Slot &slot : m_slots)
+    {
+        if (slot.thread && slot.job.id == jobId)
+        {
+            slot.engine->stopBackup();
+        }
+    }
+    // 実行中のジョブは終わったときに知らせる
+    if (removed && !isRunning())
+    {
+        emit allJobsFinished();
+    }
+}
+
+void BackupJobScheduler::stopAll()
+{
+    m_pending.clear();
+    for (Slot &slot : m_slots)
+    {
+        if (slot.thread)
+        {
+            slot.engine->stopBackup();
+        }
+    }
+    if (runningJobs() == 0)
+    {
+        emit allJobsFinished();
+    }
+}
+
+bool BackupJobScheduler::isRunning() const
+{
+    return !m_pending.isEmpty() || runningJobs() > 0;
+}
+
+bool BackupJobScheduler::isJobActive(int jobId) const
+{
+    for (const Job &job : m_pending)
+    {
+        if (job.id == jobId)
+        {
+            return true;
+        }
+    }
+    for (const Slot &slot : m_slots)
+    {
+        if (slot.thread && slot.job.id == jobId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int BackupJobScheduler::runningJobs() const
+{
+    int running = 0;
+    for (const Slot &slot : m_slots)
+    {
+        if (slot.thread)
+        {
+            running++;
+        }
+    }
+    return running;
+}
+
+int BackupJobScheduler::pendingJobs() const
+{
+    return m_pending.size();
+}
+
+QVector<DeviceInfo::Device> BackupJobScheduler::devicesFor(const BackupConfig &config)
+{
+    QVector<DeviceInfo::Device> devices;
+    devices.append(DeviceInfo::forPath(config.sourcePath()));
+    const DeviceInfo::Device destination = DeviceInfo::forPath(config.destinationPath());
+    if (destination.key != devices.first().key)
+    {
+        devices.append(destination);
+    }
+    return devices;
+}
+
+bool BackupJobScheduler::exceedsDeviceLimits(const Job &job) const
+{
+    for (const DeviceInfo::Device &device : job.devices)
+    {
+        int running = 0;
+        for (const Slot &slot : m_slots)
+        {
+            if (!slot.thread)
+            {
+                continue;
+            }
+            for (const DeviceInfo::Device &used : slot.job.devices)
+            {
+                if (used.key == device.key)
+                {
+                    running++;
+                    break;
+                }
+            }
+        }
+        if (running >= DeviceInfo::jobLimit(device, m_jobsPerSsd))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int BackupJobScheduler::freeSlot()
+{
+    for (int i = 0; i < m_slots.size(); ++i)
+    {
+        if (!m_slots[i].thread)
+        {
+            return i;
+        }
+    }
+
+    // エンジンは親を持たせない（ワーカースレッドへ移すため）。削除はデストラクタで行う
+    Slot slot;
+    slot.engine = new BackupEngine();
+    const int slotIndex = m_slots.size();
+    BackupEngine *engine = slot.engine;
+    // エンジンはワーカースレッドで信号を出すので、ここではキュー経由で受け取る
+    connect(engine, &BackupEngine::backupProgress, this, [this, slotIndex](int progress)
+            { emit jobProgress(m_slots[slotIndex].job.id, progress); });
+    connect(engine, &BackupEngine::backupLogMessage, this, [this, slotIndex](const QString &message)
+            { emit jobLogMessage(m_slots[slotIndex].job.id, message); });
+    connect(engine, &BackupEngine::fileProcessed, this, [this, slotIndex](const QString &filePath, bool success)
+            { emit jobFileProcessed(m_slots[slotIndex].job.id, filePath, success); });
+    connect(engine, &BackupEngine::directoryProcessed, this, [this, slotIndex](const QString &dirPath, bool created)
+            { emit jobDirectoryProcessed(m_slots[slotIndex].job.id, dirPath, created); });
+    connect(engine, &BackupEngine::backupError, this, [this, slotIndex](const QString &errorMessage)
+            { emit jobError(m_slots[slotIndex].job.id, errorMessage); });
+    m_slots.append(slot);
+    return slotIndex;
+}
+
+void BackupJobScheduler::dispatch()
+{
+    for (int i = 0; i < m_pending.size() && runningJobs() < m_maxConcurrentJobs;)
+    {
+        if (exceedsDeviceLimits(m_pending[i]))
+        {
+            ++i;
+            continue;
+        }
+        const Job job = m_pending.takeAt(i);
+        startJob(freeSlot(), job);
+    }
+}
+
+void BackupJobScheduler::startJob(int slotIndex, const Job &job)
+{
+    Slot &slot = m_slots[slotIndex];
+    slot.job = job;
+    BackupEngine *engine = slot.engine;
+    QThread *ownerThread = thread();
+    const BackupConfig config = job.config;
+    // ジョブのスレッドは実行ごとに作り直すので、下げた優先度が後の実行に残ることはない
+    engine->setPriorityClass(job.background ? static_cast<ThreadPriority::Class>(config.backgroundPriority())
+                                            : ThreadPriority::Normal);
+    slot.thread = QThread::create([engine, config, ownerThread]()
+                                  {
+        engine->runBackup(config);
+        // 次の実行に備えて、このスケジューラのスレッドへ戻しておく
+        engine->moveToThread(ownerThread); });
+    engine->moveToThread(slot.thread);
+    connect(slot.thread, &QThread::finished, this, [this, slotIndex]()
+            { onJobThreadFinished(slotIndex); });
+
+    emit jobStarted(job.id, job.config);
+    slot.thread->start();
+}
+
+void BackupJobScheduler::onJobThreadFinished(int slotIndex)
+{
+    Slot &slot = m_slots[slotIndex];
+    slot.thread->deleteLater();
+    slot.thread = nullptr;
+    const Job job = slot.job;
+    const RunStatistics statistics = slot.engine->lastRunStatistics();
+
+    // 次のジョブを先に始めてから知らせる（受け取った側が isRunning を見ても正しいように）
+    dispatch();
+    emit jobFinished(job.id, statistics);
+    if (!isRunning())
+    {
+        emit allJobsFinished();
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef BACKUPJOBSCHEDULER_H
+#define BACKUPJOBSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "../models/BackupConfig.h"
+#include "RunStatistics.h"
+#include "../utils/DeviceInfo.h"
+
+class BackupEngine;
+class QThread;
+
+// 複数のバックアップ設定（ジョブ）を同時に実行する。
+// ジョブごとに BackupEngine を1つずつワーカースレッドで動かし、進捗やログはジョブの番号を付けて
+// このオブジェクトのスレッドへ届ける。ジョブが読み書きする物理ディスク（DeviceInfo）ごとに同時に
+// 動かす数を制限し（HDD は1つ、SSD は jobsPerSsd 個まで）、上限に達したディスクを使うジョブは
+// 待たせる（待っている間も、後ろのジョブで動かせるものは先に始める）。
+class BackupJobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BackupJobScheduler(QObject *parent = nullptr);
+    // 実行中のジョブが終わるまで待つ
+    ~BackupJobScheduler();
+
+    // 同時に実行するジョブの最大数（1 なら1つずつ順に実行する）
+    int maxConcurrentJobs() const;
+    void setMaxConcurrentJobs(int jobs);
+
+    // 1つの SSD で同時に動かすジョブの数（HDD は常に1つ）
+    int jobsPerSsd() const;
+    void setJobsPerSsd(int jobs);
+
+    // jobId（呼び出し側の番号。設定の並び順など）で config の実行を予約する。
+    // background（スケジュールによる自動実行）なら、設定の backgroundPriority で実行する。
+    // 同じ jobId が予約済み・実行中なら false
+    bool enqueue(int jobId, const BackupConfig &config, bool background = false);
+    // 予約中・実行中のジョブの読み書きの速さの上限を変える（実行中なら次の読み書きから効く）
+    void setJobIoLimits(int jobId, const BackupConfig::IoLimits &limits);
+    // まだ始まっていない予約を取り消す
+    void cancelPending();
+    // jobId の予約を取り消し、実行中なら中止する（書き終えたところまでを途中経過に残し、次の実行が続きから始める）
+    void stopJob(int jobId);
+    // すべての予約を取り消し、実行中のジョブを中止する
+    void stopAll();
+
+    // 予約か実行中のジョブがあるか
+    bool isRunning() const;
+    bool isJobActive(int jobId) const;
+    int runningJobs() const;
+    int pendingJobs() const;
+
+    // config が読み書きする物理ディスク（重複なし）
+    static QVector<DeviceInfo::Device> devicesFor(const BackupConfig &config);
+
+signals:
+    void jobStarted(int jobId, const BackupConfig &config);
+    void jobProgress(int jobId, int progress);
+    void jobLogMessage(int jobId, const QString &message);
+    void jobFileProcessed(int jobId, const QString &filePath, bool success);
+    void jobDirectoryProcessed(int jobId, const QString &dirPath, bool created);
+    void jobError(int jobId, const QString &errorMessage);
+    void jobFinished(int jobId, const RunStatistics &statistics);
+    // 予約がすべて終わった
+    void allJobsFinished();
+
+private:
+    struct Job
+    {
+        int id = -1;
+        BackupConfig config;
+        bool background = false;
+        QVector<DeviceInfo::Device> devices;
+    };
+
+    // ジョブを動かす枠。エンジンは実行をまたいで使い回す（コピー用バッファや世代の削除を引き継ぐ）
+    struct Slot
+    {
+        BackupEngine *engine = nullptr;
+        QThread *thread = nullptr;
+        Job job;
+    };
+
+    // 始められる予約を空いている枠で始める
+    void dispatch();
+    // job が使うディスクのどれかが、同時に動かせる数に達しているか
+    bool exceedsDeviceLimits(const Job &job) const;
+    int freeSlot();
+    void startJob(int slotIndex, const Job &job);
+    void onJobThreadFinished(int slotIndex);
+
+    int m_maxConcurrentJobs;
+    int m_jobsPerSsd;
+    QList<Job> m_pending;
+    QVector<Slot> m_slots;
+};
+
+#endif // BACKUPJOBSCHEDULER_H
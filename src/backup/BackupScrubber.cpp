@@ -0,0 +1,283 @@
+#include "BackupScrubber.h"
+#include "Manifest.h"
+#include "RestoreEngine.h"
+#include "../utils/FileHasher.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+namespace
+{
+    // 読んだ量が「経過時間 × 上限」を超えないように、呼び出したスレッドを待たせる
+    class ReadPacer
+    {
+    public:
+        ReadPacer(int rateLimitMBps, const std::atomic<bool> &stopRequested)
+            : m_bytesPerSecond(static_cast<qint64>(rateLimitMBps) * 1024 * 1024), m_stopRequested(stopRequested), m_bytes(0)
+        {
+            m_timer.start();
+        }
+
+        // 中止が頼まれたら false
+        bool consume(qint64 bytes)
+        {
+            m_bytes += bytes;
+            if (m_bytesPerSecond <= 0)
+            {
+                return !m_stopRequested;
+            }
+            const qint64 dueMs = m_bytes * 1000 / m_bytesPerSecond;
+            qint64 waitMs = dueMs - m_timer.elapsed();
+            // 中止にすぐ応じられるよう、短く区切って待つ
+            while (waitMs > 0 && !m_stopRequested)
+            {
+                QThread::msleep(static_cast<unsigned long>(qMin<qint64>(waitMs, 100)));
+                waitMs = dueMs - m_timer.elapsed();
+            }
+            return !m_stopRequested;
+        }
+
+    private:
+        const qint64 m_bytesPerSecond;
+        const std::atomic<bool> &m_stopRequested;
+        qint64 m_bytes;
+        QElapsedTimer m_timer;
+    };
+}
+
+QStringList BackupScrubber::SliceResult::toLogLines(int maxFiles) const
+{
+    QStringList lines;
+    const double megabytes = bytesRead / (1024.0 * 1024.0);
+    lines << QCoreApplication::translate("BackupScrubber", "点検結果: %1 ファイル (%2 MB, %3 MB/s, %4 ms), 破損 %5 個, 読み込みエラー %6 個")
+                 .arg(scrubbedFiles)
+                 .arg(megabytes, 0, 'f', 1)
+                 .arg(elapsedMs > 0 ? megabytes * 1000.0 / elapsedMs : 0.0, 0, 'f', 1)
+                 .arg(elapsedMs)
+                 .arg(corruptFiles.size())
+                 .arg(unreadableFiles.size());
+    if (unhashedFiles > 0)
+    {
+        lines << QCoreApplication::translate("BackupScrubber", "  ハッシュが記録されていないため点検できなかったファイル: %1 個（内容の検証を行うと記録されます）")
+                     .arg(unhashedFiles);
+    }
+    int listed = 0;
+    for (const QByteArray &path : corruptFiles)
+    {
+        if (listed++ >= maxFiles)
+        {
+            break;
+        }
+        lines << QCoreApplication::translate("BackupScrubber", "  破損: %1").arg(QFile::decodeName(path));
+    }
+    for (const QByteArray &path : unreadableFiles)
+    {
+        if (listed++ >= maxFiles)
+        {
+            break;
+        }
+        lines << QCoreApplication::translate("BackupScrubber", "  読み込みエラー: %1").arg(QFile::decodeName(path));
+    }
+    if (problems() > maxFiles)
+    {
+        lines << QCoreApplication::translate("BackupScrubber", "  ...ほか %1 件").arg(problems() - maxFiles);
+    }
+    return lines;
+}
+
+BackupScrubber::BackupScrubber(QObject *parent)
+    : QObject(parent), m_running(false), m_stopRequested(false)
+{
+}
+
+void BackupScrubber::stop()
+{
+    m_stopRequested = true;
+}
+
+bool BackupScrubber::isRunning() const
+{
+    return m_running;
+}
+
+BackupScrubber::SliceResult BackupScrubber::lastResult() const
+{
+    return m_lastResult;
+}
+
+QString BackupScrubber::backupRootFor(const BackupConfig &config)
+{
+    return RestoreEngine::defaultBackupRoot(config);
+}
+
+bool BackupScrubber::runSlice(const QString &backupRoot, BackupConfig::ScrubState &state, const Options &options)
+{
+    if (m_running)
+    {
+        return false;
+    }
+    const QString manifestPath = manifestFilePath(backupRoot);
+    if (backupRoot.isEmpty() || !QFileInfo::exists(manifestPath))
+    {
+        emit scrubLogMessage(tr("点検できる保存先がありません（ファイル一覧がありません）: %1").arg(backupRoot));
+        return false;
+    }
+
+    m_running = true;
+    m_stopRequested = false;
+    QElapsedTimer timer;
+    timer.start();
+
+    SliceResult result;
+    const qint64 startPosition = qMax<qint64>(0, state.position);
+    const QString root = backupRoot + "/";
+    qint64 position = startPosition;
+    qint64 totalEntries = -1; // 数えきれなかったら -1
+    bool opened = false;
+    bool readError = false;
+    QString errorString;
+
+    // 1本のワーカーでマニフェストを先頭から読み、startPosition 番目から時間の許す限り点検する。
+    // 速さを抑えるのが目的なので並列にはしない
+    auto work = [&]()
+    {
+        ManifestReader reader(manifestPath);
+        if (!reader.open())
+        {
+            errorString = reader.errorString();
+            return;
+        }
+        opened = true;
+
+        ManifestEntry entry;
+        bool reachedEnd = false;
+        for (qint64 skipped = 0; skipped < startPosition; ++skipped)
+        {
+            if (!reader.next(entry))
+            {
+                // 前回からマニフェストが短くなった
+                position = skipped;
+                reachedEnd = true;
+                break;
+            }
+        }
+
+        ReadPacer pacer(options.rateLimitMBps, m_stopRequested);
+        FileHasher::Options hasherOptions;
+        hasherOptions.onRead = [&pacer](qint64 bytes)
+        {
+            return pacer.consume(bytes);
+        };
+        FileHasher hasher(hasherOptions);
+
+        while (!reachedEnd && !m_stopRequested && timer.elapsed() < options.sliceMs)
+        {
+            if (!reader.next(entry))
+            {
+                reachedEnd = true;
+                break;
+            }
+            if (entry.hash.isEmpty())
+            {
+                result.unhashedFiles++;
+                position++;
+                continue;
+            }
+
+            const QByteArray actual = hasher.hash(root + QFile::decodeName(entry.path));
+            if (actual.isEmpty())
+            {
+                if (m_stopRequested)
+                {
+                    // 読みかけのファイルは次回読み直す
+                    break;
+                }
+                result.unreadableFiles.append(entry.path);
+            }
+            else if (actual != entry.hash)
+            {
+                result.corruptFiles.append(entry.path);
+            }
+            result.scrubbedFiles++;
+            position++;
+        }
+        result.bytesRead = hasher.bytesRead();
+
+        // 進み具合を出せるように残りの件数も数える（内容は読まないので速い）
+        if (reachedEnd)
+        {
+            totalEntries = position;
+        }
+        else if (!m_stopRequested)
+        {
+            totalEntries = position;
+            while (reader.next(entry))
+            {
+                totalEntries++;
+            }
+        }
+        readError = reader.hasError();
+        if (readError)
+        {
+            errorString = reader.errorString();
+        }
+        result.passCompleted = !readError && (reachedEnd || totalEntries == position);
+    };
+
+    QThread *thread = QThread::create(work);
+    thread->start();
+    while (!thread->wait(100))
+    {
+        QCoreApplication::processEvents();
+    }
+    delete thread;
+
+    result.elapsedMs = timer.elapsed();
+    m_lastResult = result;
+    m_running = false;
+
+    if (!opened || readError)
+    {
+        emit scrubLogMessage(tr("ファイル一覧を読めないため点検を中止しました: %1").arg(errorString));
+        return false;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    state.lastRun = now;
+    state.passProblems += result.problems();
+    if (result.passCompleted)
+    {
+        state.lastPassProblems = state.passProblems;
+        state.lastPassCompleted = now;
+        state.passProblems = 0;
+        state.position = 0;
+        state.totalEntries = qMax(totalEntries, position);
+    }
+    else
+    {
+        state.position = position;
+        if (totalEntries >= 0)
+        {
+            state.totalEntries = totalEntries;
+        }
+    }
+
+    for (const QString &line : result.toLogLines())
+    {
+        emit scrubLogMessage(line);
+    }
+    if (result.passCompleted)
+    {
+        emit scrubLogMessage(tr("保存先の点検が一巡しました（破損・読み込みエラー %1 件）").arg(state.lastPassProblems));
+    }
+    else if (state.totalEntries > 0)
+    {
+        emit scrubLogMessage(tr("点検の位置: %1 / %2 項目 (%3%)")
+                                 .arg(state.position)
+                                 .arg(state.totalEntries)
+                                 .arg(state.position * 100 / state.totalEntries));
+    }
+    return true;
+}
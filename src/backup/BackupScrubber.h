@@ -0,0 +1,65 @@
+#ifndef BACKUPSCRUBBER_H
+#define BACKUPSCRUBBER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include "../models/BackupConfig.h"
+#include <atomic>
+
+// 保存先のファイルを読み直し、マニフェストに記録されたハッシュと比べて、置いておく間に
+// 壊れていないか（ビット腐敗）を確かめる定期点検（スクラブ）。
+// 一度に全部は読まず、決めた時間だけ・決めた速さ（MB/s）以下で少しずつ進め、
+// 次の位置を BackupConfig::ScrubState に残す。数十TBでも数週間かけて一巡すればよい。
+// ハッシュが記録されていないファイル（内容の検証をまだしていないもの）は点検できないので数えるだけにする。
+class BackupScrubber : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int rateLimitMBps = 20;      // 読み込みの速さの上限（0 なら制限しない）
+        qint64 sliceMs = 5 * 60 * 1000; // 1回の点検に使う時間（読みかけのファイルは読み終えてから止める）
+    };
+
+    // 1回の点検の結果
+    struct SliceResult
+    {
+        int scrubbedFiles = 0;  // ハッシュと比べたファイル
+        int unhashedFiles = 0;  // ハッシュが記録されておらず比べられなかったファイル
+        qint64 bytesRead = 0;
+        qint64 elapsedMs = 0;
+        bool passCompleted = false; // マニフェストの最後まで点検した（次は先頭から）
+        QVector<QByteArray> corruptFiles;    // 内容がハッシュと違った
+        QVector<QByteArray> unreadableFiles; // なくなっていた・読めなかった
+
+        int problems() const { return corruptFiles.size() + unreadableFiles.size(); }
+        QStringList toLogLines(int maxFiles = 20) const;
+    };
+
+    explicit BackupScrubber(QObject *parent = nullptr);
+
+    // backupRoot を state.position から点検し、state を進める（呼び出したスレッドで、
+    // UIの応答性を保ちながら終わるまで実行する）。点検できなかった（マニフェストがない）場合は false
+    bool runSlice(const QString &backupRoot, BackupConfig::ScrubState &state, const Options &options);
+    void stop();
+    bool isRunning() const;
+
+    SliceResult lastResult() const;
+
+    // config の点検する保存先（スナップショットなら最新の世代）。点検できないなら空
+    static QString backupRootFor(const BackupConfig &config);
+
+signals:
+    void scrubLogMessage(const QString &message);
+
+private:
+    bool m_running;
+    std::atomic<bool> m_stopRequested; // ワーカーも見る
+    SliceResult m_lastResult;
+};
+
+#endif // BACKUPSCRUBBER_H
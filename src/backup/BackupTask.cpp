@@ -1,13 +1,17 @@
 #include "BackupTask.h"
+#include "DurabilityFlusher.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QFile>
 #include <QApplication>
 #include <QDebug>
-#include <QDirIterator>
+#include <memory>
+#include "../utils/FileSystem.h"
+#include "../utils/TreeWalker.h"
 
 BackupTask::BackupTask(const QString &sourcePath, const QString &destinationPath, QObject *parent)
-    : QObject(parent), m_sourcePath(sourcePath), m_destinationPath(destinationPath), m_running(false)
+    : QObject(parent), m_sourcePath(sourcePath), m_destinationPath(destinationPath), m_running(false),
+      m_durabilityMode(BackupConfig::DurabilityNone), m_flusher(nullptr)
 {
 }
 
@@ -59,8 +63,31 @@ void BackupTask::start()
     }
 
     // フォルダ単位でバックアップを行う（ソースディレクトリの中身をコピー）
+    // フォルダ単位の同期はバックグラウンドで行う
+    std::unique_ptr<DurabilityFlusher> flusher;
+    if (DurabilityFlusher::isNeededFor(m_durabilityMode))
+    {
+        flusher.reset(new DurabilityFlusher());
+        m_flusher = flusher.get();
+    }
+
     bool success = copyDirectoryContents(sourceDir, actualDestDir, processedItems, totalItems);
 
+    // 完了を通知する前に同期を終わらせる
+    if (flusher)
+    {
+        flusher->finish();
+        m_flusher = nullptr;
+        if (!flusher->failedPaths().isEmpty())
+        {
+            emit operationLog(tr("警告: %1 個のパスの同期に失敗しました").arg(flusher->failedPaths().size()));
+        }
+    }
+    else if (m_durabilityMode == BackupConfig::DurabilityEndOfRun && !FileSystem::syncFileSystem(actualDestPath))
+    {
+        emit operationLog(tr("警告: バックアップ先の同期に失敗しました: %1").arg(actualDestPath));
+    }
+
     m_running = false;
     emit progressUpdated(100);
     emit finished();
@@ -129,24 +156,24 @@ bool BackupTask::copyDirectoryContents(const QDir &sourceDir, const QDir &destDi
             // ファイルの場合、コピー
             qDebug() << "Copying file:" << srcItemPath << "to" << destItemPath;
 
-            // 既にファイルが存在する場合は削除
-            QFile destFile(destItemPath);
-            if (destFile.exists())
+            // 一時ファイルに書いてから置き換える（既存ファイルは最後まで残す）
+            QString copyError;
+            const bool syncEachFile = m_durabilityMode == BackupConfig::DurabilityPerFile;
+            if (!FileSystem::copyFile(srcItemPath, destItemPath, syncEachFile, &copyError))
             {
-                destFile.remove();
-            }
-
-            QFile srcFile(srcItemPath);
-            if (!srcFile.copy(destItemPath))
-            {
-                qDebug() << "Failed to copy file:" << srcFile.errorString();
+                qDebug() << "Failed to copy file:" << copyError;
                 success = false;
                 // ファイルコピー失敗のログとシグナル
                 emit fileProcessed(srcItemPath, false);
-                emit operationLog(tr("ファイルコピー失敗: %1 → %2 (%3)").arg(srcItemPath, destItemPath, srcFile.errorString()));
+                emit operationLog(tr("ファイルコピー失敗: %1 → %2 (%3)").arg(srcItemPath, destItemPath, copyError));
             }
             else
             {
+                if (m_flusher)
+                {
+                    m_flusher->addFile(destItemPath);
+                }
+
                 // ファイルコピー成功のログとシグナル
                 emit fileProcessed(srcItemPath, true);
                 emit operationLog(tr("ファイルコピー: %1").arg(info.fileName()));
@@ -173,14 +200,11 @@ bool BackupTask::copyDirectory(const QDir &sourceDir, const QDir &destDir, int &
 
 int BackupTask::countItems(const QString &path)
 {
-    int count = 0;
-    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    while (it.hasNext())
-    {
-        it.next();
-        count++;
-    }
-    return count;
+    // 進捗表示用なのでエントリは保持せずに数だけ数える
+    TreeWalker::Options options;
+    options.includeDirectories = true;
+    options.includeHidden = false;
+    return static_cast<int>(TreeWalker(options).count(path));
 }
 
 void BackupTask::stop()
@@ -201,4 +225,9 @@ QString BackupTask::source() const
 QString BackupTask::destination() const
 {
     return m_destinationPath;
+}
+
+void BackupTask::setDurabilityMode(BackupConfig::DurabilityMode mode)
+{
+    m_durabilityMode = mode;
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <QObject>
 #include <QString>
 #include <QDir>
+#include "../models/BackupConfig.h"
+
+class DurabilityFlusher;
 
 class BackupTask : public QObject
 {
@@ -17,6 +20,9 @@ public:
     QString source() const;
     QString destination() const;
 
+    // 書き込みの永続化レベル（デフォルトは DurabilityNone）
+    void setDurabilityMode(BackupConfig::DurabilityMode mode);
+
 signals:
     void progressUpdated(int progress);
     void finished();
@@ -34,6 +40,8 @@ private:
     QString m_sourcePath;
     QString m_destinationPath;
     bool m_running;
+    BackupConfig::DurabilityMode m_durabilityMode;
+    DurabilityFlusher *m_flusher; // 実行中のみ有効
 };
 
 #endif // BACKUPTASK_H
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include "BackupVerifier.h"
+#include "Manifest.h"
+#include "RestoreEngine.h"
+#include "../utils/FileHasher.h"
+#include "../utils/FileIndex.h"
+#include "../utils/RunArena.h"
+#include "../utils/TreeWalker.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // 1ファイルを確かめた結果（ワーカーが自分の番号の所にだけ書く）
+    struct CheckResult
+    {
+        enum Status : quint8
+        {
+            Matched,
+            Mismatched,
+            SourceChanged // 元が変わっていて、比べる相手がなかった
+        };
+
+        Status status = Matched;
+        bool checked = false; // 中止せずに最後まで確かめた
+        bool sourceChanged = false;
+        bool hashReused = false;
+        BackupVerifier::Mismatch::Kind kind = BackupVerifier::Mismatch::Missing;
+        QString detail;
+        QByteArray hash; // マニフェストに新しく記録するハッシュ
+    };
+
+    bool statFile(const QString &path, qint64 *size, qint64 *mtimeNs)
+    {
+#ifdef Q_OS_LINUX
+        struct stat st;
+        if (::stat(QFile::encodeName(path).constData(), &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            return false;
+        }
+        *size = st.st_size;
+        *mtimeNs = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return true;
+#else
+        const QFileInfo info(path);
+        if (!info.isFile())
+        {
+            return false;
+        }
+        *size = info.size();
+        *mtimeNs = info.lastModified().toMSecsSinceEpoch() * 1000000;
+        return true;
+#endif
+    }
+}
+
+QStringList BackupVerifier::Statistics::toLogLines(int maxMismatches) const
+{
+    int missing = 0;
+    int size = 0;
+    int content = 0;
+    int errors = 0;
+    for (const Mismatch &mismatch : mismatches)
+    {
+        switch (mismatch.kind)
+        {
+        case Mismatch::Missing:
+            missing++;
+            break;
+        case Mismatch::SizeDiffers:
+            size++;
+            break;
+        case Mismatch::ContentDiffers:
+            content++;
+            break;
+        case Mismatch::ReadError:
+            errors++;
+            break;
+        }
+    }
+
+    QStringList lines;
+    lines << QCoreApplication::translate("BackupVerifier", "検証結果: %1 ファイル中 %2 個一致, %3 個不一致 (%4 ms)")
+                 .arg(checkedFiles)
+                 .arg(matchedFiles)
+                 .arg(mismatches.size())
+                 .arg(elapsedMs);
+    if (!mismatches.isEmpty())
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  不一致の内訳: 保存先にない %1 / サイズ違い %2 / 内容違い %3 / 読み込みエラー %4")
+                     .arg(missing)
+                     .arg(size)
+                     .arg(content)
+                     .arg(errors);
+    }
+    if (sourceChanged > 0)
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  バックアップ後に元が変更・削除されたファイル: %1 個").arg(sourceChanged);
+    }
+    if (bytesHashed > 0 || hashesReused > 0)
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  内容の読み込み: %1 MB / 記録済みのハッシュを使用 %2 個 / 新しく記録 %3 個")
+                     .arg(bytesHashed / (1024.0 * 1024.0), 0, 'f', 1)
+                     .arg(hashesReused)
+                     .arg(hashesRecorded);
+    }
+    if (!usedManifest)
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  ファイル一覧（マニフェスト）がないため、保存先を走査して元と比べました");
+    }
+    for (int i = 0; i < mismatches.size() && i < maxMismatches; ++i)
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  不一致: %1 (%2)")
+                     .arg(QFile::decodeName(mismatches[i].path), mismatches[i].detail);
+    }
+    if (mismatches.size() > maxMismatches)
+    {
+        lines << QCoreApplication::translate("BackupVerifier", "  ...ほか %1 件").arg(mismatches.size() - maxMismatches);
+    }
+    return lines;
+}
+
+BackupVerifier::BackupVerifier(QObject *parent)
+    : QObject(parent), m_running(false), m_stopRequested(false)
+{
+}
+
+void BackupVerifier::stop()
+{
+    m_stopRequested = true;
+}
+
+bool BackupVerifier::isRunning() const
+{
+    return m_running;
+}
+
+BackupVerifier::Statistics BackupVerifier::lastStatistics() const
+{
+    return m_lastStatistics;
+}
+
+BackupVerifier::Request BackupVerifier::requestFor(const BackupConfig &config)
+{
+    Request request;
+    request.sourceRoot = config.sourcePath();
+    request.mode = config.verifyMode() == BackupConfig::VerifyContent ? Content : Metadata;
+    // セーブデータのバックアップは元と保存先でフォルダ構成が違うので比べられない
+    if (config.extraData().value("backupMode").toInt() != 1)
+    {
+        request.backupRoot = RestoreEngine::defaultBackupRoot(config);
+    }
+    return request;
+}
+
+bool BackupVerifier::verify(const Request &request)
+{
+    if (m_running)
+    {
+        return false;
+    }
+    if (request.backupRoot.isEmpty() || !QFileInfo(request.backupRoot).isDir())
+    {
+        emit verifyLogMessage(tr("検証できる保存先がありません: %1").arg(request.backupRoot));
+        return false;
+    }
+
+    m_running = true;
+    m_stopRequested = false;
+    QElapsedTimer timer;
+    timer.start();
+    Statistics statistics;
+    emit verifyLogMessage(tr("検証を開始します（%1）: %2 ⇔ %3")
+                              .arg(request.mode == Content ? tr("内容") : tr("メタデータ"), request.sourceRoot, request.backupRoot));
+
+    // 比べるファイルの一覧と、記録されているハッシュ（番号はマニフェストの順）
+    RunArena arena;
+    FileIndex index(&arena);
+    std::vector<QByteArray> recordedHashes;
+    const QString manifestPath = manifestFilePath(request.backupRoot);
+    {
+        ManifestReader reader(manifestPath);
+        if (reader.open())
+        {
+            ManifestIndexBuilder builder(index);
+            ManifestEntry entry;
+            while (reader.next(entry))
+            {
+                builder.add(entry);
+                recordedHashes.push_back(entry.hash);
+            }
+            statistics.usedManifest = !reader.hasError();
+        }
+    }
+    if (!statistics.usedManifest)
+    {
+        index.clear();
+        recordedHashes.clear();
+        const QString manifestName = QFileInfo(manifestPath).fileName();
+        TreeWalker::Options options;
+        options.sorted = true;
+        options.needMetadata = true;
+        options.filter = [&manifestName](const TreeWalker::Entry &entry)
+        {
+            return entry.depth != 1 || entry.isDir || entry.name != manifestName;
+        };
+        TreeWalker walker(options);
+        walker.walk(request.backupRoot, index);
+        recordedHashes.resize(index.fileCount());
+    }
+
+    const int fileCount = index.fileCount();
+    std::vector<CheckResult> results(fileCount);
+    std::atomic<int> nextFile(0);
+    std::atomic<int> doneFiles(0);
+    std::atomic<qint64> bytesHashed(0);
+    const bool content = request.mode == Content;
+    const bool hasManifest = statistics.usedManifest;
+    const QString sourceRoot = request.sourceRoot + "/";
+    const QString backupRoot = request.backupRoot + "/";
+
+    // 各ワーカーは次の番号を取って1ファイルずつ確かめる。読み込みはワーカーごとの FileHasher で行う
+    auto work = [&]()
+    {
+        FileHasher::Options hasherOptions;
+        hasherOptions.onRead = [this](qint64)
+        {
+            return !m_stopRequested;
+        };
+        FileHasher hasher(hasherOptions);
+        for (;;)
+        {
+            const int file = nextFile++;
+            if (file >= fileCount || m_stopRequested)
+            {
+                break;
+            }
+            CheckResult &result = results[file];
+            const QString relativePath = QFile::decodeName(index.filePath(file));
+            const QString backupPath = backupRoot + relativePath;
+            const QString sourcePath = sourceRoot + relativePath;
+
+            qint64 backupSize = 0;
+            qint64 backupMtime = 0;
+            qint64 sourceSize = 0;
+            qint64 sourceMtime = 0;
+            const bool sourceExists = statFile(sourcePath, &sourceSize, &sourceMtime);
+            // マニフェストがなければ元の今の状態を記録の代わりにする
+            const qint64 expectedSize = hasManifest ? index.fileSize(file) : sourceSize;
+            const bool sourceUnchanged = sourceExists && (!hasManifest || (sourceSize == index.fileSize(file) && sourceMtime == index.fileMtime(file)));
+            result.sourceChanged = !sourceUnchanged;
+
+            if (!statFile(backupPath, &backupSize, &backupMtime))
+            {
+                result.status = CheckResult::Mismatched;
+                result.kind = Mismatch::Missing;
+                result.detail = tr("保存先にありません");
+            }
+            else if (!hasManifest && !sourceExists)
+            {
+                result.status = CheckResult::SourceChanged;
+            }
+            else if (backupSize != expectedSize)
+            {
+                result.status = CheckResult::Mismatched;
+                result.kind = Mismatch::SizeDiffers;
+                result.detail = tr("サイズが違います: 保存先 %1 バイト / 元 %2 バイト").arg(backupSize).arg(expectedSize);
+            }
+            else if (content)
+            {
+                // 記録されたハッシュがあれば元を読まずに済む。なければ元が変わっていないときだけ読んで計算する
+                QByteArray expected = recordedHashes[file];
+                result.hashReused = !expected.isEmpty();
+                if (expected.isEmpty() && sourceUnchanged)
+                {
+                    expected = hasher.hash(sourcePath);
+                    if (expected.isEmpty() && !m_stopRequested)
+                    {
+                        result.status = CheckResult::Mismatched;
+                        result.kind = Mismatch::ReadError;
+                        result.detail = tr("元を読めません: %1").arg(hasher.errorString());
+                    }
+                }
+                if (expected.isEmpty())
+                {
+                    if (result.status != CheckResult::Mismatched)
+                    {
+                        result.status = CheckResult::SourceChanged;
+                    }
+                }
+                else
+                {
+                    const QByteArray actual = hasher.hash(backupPath);
+                    if (actual.isEmpty())
+                    {
+                        result.status = CheckResult::Mismatched;
+                        result.kind = Mismatch::ReadError;
+                        result.detail = tr("保存先を読めません: %1").arg(hasher.errorString());
+                    }
+                    else if (actual != expected)
+                    {
+                        result.status = CheckResult::Mismatched;
+                        result.kind = Mismatch::ContentDiffers;
+                        result.detail = tr("内容が違います");
+                    }
+                    else if (!result.hashReused)
+                    {
+                        result.hash = actual;
+                    }
+                }
+            }
+            result.checked = !m_stopRequested;
+            doneFiles++;
+        }
+        bytesHashed += hasher.bytesRead();
+    };
+
+    int threadCount = request.threads > 0 ? request.threads : qBound(1, QThread::idealThreadCount(), 8);
+    threadCount = qMin(threadCount, qMax(1, fileCount));
+    QVector<QThread *> threads;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.append(QThread::create(work));
+        threads.last()->start();
+    }
+    int lastProgress = -1;
+    for (QThread *thread : threads)
+    {
+        while (!thread->wait(100))
+        {
+            const int progress = fileCount > 0 ? doneFiles * 100 / fileCount : 100;
+            if (progress != lastProgress)
+            {
+                lastProgress = progress;
+                emit verifyProgress(progress);
+            }
+            QCoreApplication::processEvents();
+        }
+        delete thread;
+    }
+
+    const bool stopped = m_stopRequested;
+    int newHashes = 0;
+    for (int file = 0; file < fileCount; ++file)
+    {
+        const CheckResult &result = results[file];
+        if (!result.checked)
+        {
+            continue;
+        }
+        statistics.checkedFiles++;
+        if (result.sourceChanged)
+        {
+            statistics.sourceChanged++;
+        }
+        if (result.hashReused)
+        {
+            statistics.hashesReused++;
+        }
+        if (!result.hash.isEmpty())
+        {
+            newHashes++;
+        }
+        if (result.status == CheckResult::Matched)
+        {
+            statistics.matchedFiles++;
+        }
+        else if (result.status == CheckResult::Mismatched)
+        {
+            statistics.mismatches.append(Mismatch{index.filePath(file), result.kind, result.detail});
+        }
+    }
+    statistics.bytesHashed = bytesHashed;
+
+    // 確かめた内容のハッシュをマニフェストに書き戻す（元を読み直さずに次回の検証や定期点検で使う）
+    if (hasManifest && newHashes > 0 && !stopped)
+    {
+        ManifestReader reader(manifestPath);
+        ManifestWriter writer(manifestPath, true);
+        if (reader.open() && writer.open())
+        {
+            ManifestEntry entry;
+            size_t file = 0;
+            while (reader.next(entry))
+            {
+                if (file < results.size() && !results[file].hash.isEmpty())
+                {
+                    entry.hash = results[file].hash;
+                }
+                writer.write(entry);
+                file++;
+            }
+            const bool complete = !reader.hasError() && file == results.size();
+            reader.close();
+            if (complete && writer.commit())
+            {
+                statistics.hashesRecorded = newHashes;
+            }
+        }
+    }
+
+    statistics.elapsedMs = timer.elapsed();
+    if (stopped)
+    {
+        emit verifyLogMessage(tr("検証を中止しました（%1 / %2 ファイル）").arg(statistics.checkedFiles).arg(fileCount));
+    }
+    for (const QString &line : statistics.toLogLines())
+    {
+        emit verifyLogMessage(line);
+    }
+
+    m_lastStatistics = statistics;
+    m_running = false;
+    emit verifyProgress(100);
+    emit verifyCompleted(statistics);
+    return !stopped && statistics.isOk();
+}
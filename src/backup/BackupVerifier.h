@@ -0,0 +1,93 @@
+#ifndef BACKUPVERIFIER_H
+#define BACKUPVERIFIER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include "../models/BackupConfig.h"
+#include <atomic>
+
+// バックアップ元と保存先を比べ、保存先が元と一致しているかを確かめる。
+// 比べるファイルは保存先のマニフェストから取る（ないときは保存先を走査する）。
+//   メタデータ: 保存先にあるか、サイズが記録と同じか
+//   内容: 加えて保存先の内容のハッシュを、記録されたハッシュ（なければ元を読んで計算したもの）と比べる
+// ファイルは複数スレッドで並列に確かめ、内容の読み込みは FileHasher の範囲を限った先読みで行う。
+// 内容を確かめたファイルのハッシュはマニフェストに書き戻し、次回の検証や定期点検では元を読み直さない。
+class BackupVerifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode
+    {
+        Metadata,
+        Content
+    };
+
+    struct Request
+    {
+        QString sourceRoot; // バックアップ元
+        QString backupRoot; // 保存先（スナップショットなら比べる世代のフォルダ）
+        Mode mode = Metadata;
+        int threads = 0; // 0 なら CPU 数（最大 8）
+    };
+
+    // 一致しなかったファイル
+    struct Mismatch
+    {
+        enum Kind
+        {
+            Missing,       // 保存先にない
+            SizeDiffers,   // 保存先のサイズが記録（元）と違う
+            ContentDiffers, // 保存先の内容のハッシュが違う
+            ReadError      // 保存先か元が読めない
+        };
+
+        QByteArray path; // ルートからの相対パス
+        Kind kind;
+        QString detail;
+    };
+
+    struct Statistics
+    {
+        bool usedManifest = false;
+        int checkedFiles = 0;
+        int matchedFiles = 0;
+        int sourceChanged = 0;  // バックアップ後に元が変更・削除されたため、元とは比べられなかった
+        int hashesReused = 0;   // マニフェストのハッシュを使い、元を読まずに済んだ
+        int hashesRecorded = 0; // マニフェストに新しく書き込んだハッシュ
+        qint64 bytesHashed = 0;
+        qint64 elapsedMs = 0;
+        QVector<Mismatch> mismatches;
+
+        bool isOk() const { return mismatches.isEmpty(); }
+        QStringList toLogLines(int maxMismatches = 20) const;
+    };
+
+    explicit BackupVerifier(QObject *parent = nullptr);
+
+    // request を確かめる（呼び出したスレッドで、UIの応答性を保ちながら終わるまで実行する）。
+    // すべて一致したら true
+    bool verify(const Request &request);
+    void stop();
+    bool isRunning() const;
+
+    Statistics lastStatistics() const;
+
+    // config の検証方法と比べる保存先（スナップショットなら最新の世代）で request を作る
+    static Request requestFor(const BackupConfig &config);
+
+signals:
+    void verifyProgress(int progress);
+    void verifyLogMessage(const QString &message);
+    void verifyCompleted(const BackupVerifier::Statistics &statistics);
+
+private:
+    bool m_running;
+    std::atomic<bool> m_stopRequested; // ワーカーも見る
+    Statistics m_lastStatistics;
+};
+
+#endif // BACKUPVERIFIER_H
@@ -0,0 +1,229 @@
+#include "CheckpointJournal.h"
+#include <QDir>
+
+namespace
+{
+    const quint32 kMagic = 0x53424350; // "SBCP"
+    const quint16 kVersion = 1;
+
+    const quint8 kTagEntry = 1;
+    const quint8 kTagPosition = 2;
+}
+
+bool CheckpointJournal::Header::matches(const Header &other) const
+{
+    return sourcePath == other.sourcePath && updateMode == other.updateMode &&
+           baseManifestSize == other.baseManifestSize && baseManifestMtimeMs == other.baseManifestMtimeMs;
+}
+
+CheckpointJournal::CheckpointJournal(const QString &filePath)
+    : m_file(filePath), m_positionDone(0), m_validLength(0)
+{
+}
+
+CheckpointJournal::~CheckpointJournal()
+{
+    if (m_file.isOpen())
+    {
+        flush();
+    }
+}
+
+QString CheckpointJournal::filePath(const QString &targetRoot)
+{
+    return QDir(targetRoot).filePath(QStringLiteral(".sbs-checkpoint"));
+}
+
+bool CheckpointJournal::load()
+{
+    m_completed.clear();
+    m_positionDone = 0;
+    m_positionPath.clear();
+    m_validLength = 0;
+    m_errorString.clear();
+
+    QFile file(m_file.fileName());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_errorString = file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    Header header;
+    stream >> magic >> version;
+    if (stream.status() == QDataStream::Ok && magic == kMagic && version == kVersion)
+    {
+        stream >> header.sourcePath >> header.updateMode >> header.baseManifestSize >> header.baseManifestMtimeMs >> header.startedMs;
+    }
+    if (stream.status() != QDataStream::Ok || magic != kMagic || version != kVersion)
+    {
+        m_errorString = QStringLiteral("Not a checkpoint journal: %1").arg(file.fileName());
+        return false;
+    }
+    m_header = header;
+    m_validLength = file.pos();
+
+    // 記録は1件ずつ追記しているので、読めなくなったところ（書きかけの末尾）で止める
+    while (!stream.atEnd())
+    {
+        quint8 tag = 0;
+        stream >> tag;
+        if (tag == kTagEntry)
+        {
+            QByteArray path;
+            Entry entry;
+            stream >> path >> entry.size >> entry.mtimeNs;
+            if (stream.status() != QDataStream::Ok)
+            {
+                break;
+            }
+            m_completed.insert(path, entry);
+        }
+        else if (tag == kTagPosition)
+        {
+            qint64 done = 0;
+            QByteArray path;
+            stream >> done >> path;
+            if (stream.status() != QDataStream::Ok)
+            {
+                break;
+            }
+            m_positionDone = done;
+            m_positionPath = path;
+        }
+        else
+        {
+            break;
+        }
+        m_validLength = file.pos();
+    }
+    return true;
+}
+
+CheckpointJournal::Header CheckpointJournal::header() const
+{
+    return m_header;
+}
+
+qint64 CheckpointJournal::positionDone() const
+{
+    return m_positionDone;
+}
+
+QByteArray CheckpointJournal::positionPath() const
+{
+    return m_positionPath;
+}
+
+int CheckpointJournal::completedCount() const
+{
+    return m_completed.size();
+}
+
+bool CheckpointJournal::completed(const QByteArray &path, Entry *entry) const
+{
+    const auto it = m_completed.constFind(path);
+    if (it == m_completed.constEnd())
+    {
+        return false;
+    }
+    if (entry)
+    {
+        *entry = it.value();
+    }
+    return true;
+}
+
+bool CheckpointJournal::begin(const Header &header)
+{
+    m_completed.clear();
+    m_positionDone = 0;
+    m_positionPath.clear();
+    m_errorString.clear();
+    m_file.close();
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+    writeHeader(header);
+    return flush();
+}
+
+bool CheckpointJournal::resume()
+{
+    m_errorString.clear();
+    m_file.close();
+    if (!m_file.resize(m_validLength) || !m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+    return true;
+}
+
+void CheckpointJournal::writeHeader(const Header &header)
+{
+    m_header = header;
+    m_stream << kMagic << kVersion;
+    m_stream << header.sourcePath << header.updateMode << header.baseManifestSize << header.baseManifestMtimeMs << header.startedMs;
+}
+
+void CheckpointJournal::add(const QByteArray &path, const Entry &entry)
+{
+    if (!m_file.isOpen())
+    {
+        return;
+    }
+    m_stream << kTagEntry << path << entry.size << entry.mtimeNs;
+}
+
+void CheckpointJournal::setPosition(qint64 done, const QByteArray &nextPath)
+{
+    m_positionDone = done;
+    m_positionPath = nextPath;
+    if (!m_file.isOpen())
+    {
+        return;
+    }
+    m_stream << kTagPosition << done << nextPath;
+}
+
+bool CheckpointJournal::flush()
+{
+    if (!m_file.isOpen())
+    {
+        return false;
+    }
+    if (m_stream.status() != QDataStream::Ok || !m_file.flush())
+    {
+        m_errorString = QStringLiteral("Failed to write checkpoint journal: %1").arg(m_file.fileName());
+        return false;
+    }
+    return true;
+}
+
+bool CheckpointJournal::remove()
+{
+    m_stream.setDevice(nullptr);
+    m_file.close();
+    if (m_file.exists() && !m_file.remove())
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString CheckpointJournal::errorString() const
+{
+    return m_errorString;
+}
@@ -0,0 +1,83 @@
+#ifndef CHECKPOINTJOURNAL_H
+#define CHECKPOINTJOURNAL_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+// 実行の途中経過（チェックポイント）。保存先に置き、書き終えたファイルと、ファイル一覧のどこまで
+// 進んだかを実行中に少しずつ追記する。実行が最後まで終わったら削除するので、残っていれば前回の実行は
+// 途中で止まっている。次の実行は見出し（バックアップ元・更新方式・比べた前回のマニフェスト）が同じなら、
+// 記録されたファイルのうちバックアップ元と保存先が変わっていないものを飛ばして続きから始める。
+// 追記の途中で止まった末尾の記録は読むときに捨てる。
+// ファイルは一時ファイルに書いてから置き換えるので、書きかけのファイルの続きからは再開できない
+// （記録するのは置き換えまで終わったファイルだけ）。
+class CheckpointJournal
+{
+public:
+    // 再開してよいかを決める実行の条件
+    struct Header
+    {
+        QString sourcePath;
+        qint32 updateMode = 0;
+        // 比べた前回のマニフェストの大きさと更新日時（なければ -1）。実行が終わるまでマニフェストは
+        // 書き換えないので、変わっていれば間にほかの実行が終わっている
+        qint64 baseManifestSize = -1;
+        qint64 baseManifestMtimeMs = -1;
+        qint64 startedMs = 0; // 最初に始めた日時（表示用。比べない）
+
+        bool matches(const Header &other) const;
+    };
+
+    // 書き終えたときのバックアップ元のファイルの状態
+    struct Entry
+    {
+        qint64 size = 0;
+        qint64 mtimeNs = 0;
+    };
+
+    explicit CheckpointJournal(const QString &filePath);
+    ~CheckpointJournal();
+
+    // ジャーナルを保存先のどこに置くか
+    static QString filePath(const QString &targetRoot);
+
+    // 既存のジャーナルを読む。ないか形式が違えば false
+    bool load();
+    Header header() const;
+    // 記録されている進んだ位置（先頭から done 件が終わっていて、次は nextPath）
+    qint64 positionDone() const;
+    QByteArray positionPath() const;
+    int completedCount() const;
+    // path が書き終えたファイルとして記録されていれば entry に入れて true
+    bool completed(const QByteArray &path, Entry *entry = nullptr) const;
+
+    // 新しく書き始める（既存の内容は捨てる）
+    bool begin(const Header &header);
+    // load した内容に続けて書く（書きかけの末尾は切り詰める）
+    bool resume();
+    void add(const QByteArray &path, const Entry &entry);
+    void setPosition(qint64 done, const QByteArray &nextPath);
+    // ここまでの記録をファイルへ書き出す
+    bool flush();
+    // 実行が最後まで終わったので削除する
+    bool remove();
+
+    QString errorString() const;
+
+private:
+    void writeHeader(const Header &header);
+
+    QFile m_file;
+    QDataStream m_stream;
+    Header m_header;
+    QHash<QByteArray, Entry> m_completed;
+    qint64 m_positionDone;
+    QByteArray m_positionPath;
+    qint64 m_validLength; // load で読めた末尾（これより後は書きかけ）
+    QString m_errorString;
+};
+
+#endif // CHECKPOINTJOURNAL_H
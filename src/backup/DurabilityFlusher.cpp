@@ -0,0 +1,139 @@
+#include "DurabilityFlusher.h"
+#include "../utils/FileSystem.h"
+#include "../utils/ThreadPriority.h"
+#include <QThread>
+#include <QFileInfo>
+
+DurabilityFlusher::DurabilityFlusher(int maxPendingBatches)
+    : m_thread(nullptr),
+      m_maxPendingBatches(qMax(1, maxPendingBatches)),
+      m_finishing(false),
+      m_syncedFiles(0)
+{
+    // 実行の優先度クラス（SCHED_IDLE など）をそのまま使う。QThread の優先度を指定すると上書きされる
+    m_thread = QThread::create(ThreadPriority::inheritCurrent([this]()
+                                                              { run(); }));
+    m_thread->start(QThread::InheritPriority);
+}
+
+bool DurabilityFlusher::isNeededFor(BackupConfig::DurabilityMode mode)
+{
+#ifdef Q_OS_LINUX
+    return mode == BackupConfig::DurabilityPerDirectory;
+#else
+    return mode == BackupConfig::DurabilityPerDirectory || mode == BackupConfig::DurabilityEndOfRun;
+#endif
+}
+
+DurabilityFlusher::~DurabilityFlusher()
+{
+    finish();
+    delete m_thread;
+}
+
+void DurabilityFlusher::addFile(const QString &filePath)
+{
+    const QString dirPath = QFileInfo(filePath).absolutePath();
+    if (!m_current.files.isEmpty() && m_current.dirPath != dirPath)
+    {
+        enqueueCurrentBatch();
+    }
+
+    m_current.dirPath = dirPath;
+    m_current.files.append(filePath);
+}
+
+void DurabilityFlusher::enqueueCurrentBatch()
+{
+    if (m_current.files.isEmpty())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // 同期が追いつかない場合はコピー側を待たせる（キューを無制限に伸ばさない）
+    while (m_queue.size() >= m_maxPendingBatches)
+    {
+        m_notFull.wait(&m_mutex);
+    }
+
+    m_queue.enqueue(m_current);
+    m_current = Batch();
+    m_notEmpty.wakeOne();
+}
+
+void DurabilityFlusher::finish()
+{
+    if (!m_thread || m_thread->isFinished())
+    {
+        return;
+    }
+
+    enqueueCurrentBatch();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finishing = true;
+        m_notEmpty.wakeOne();
+    }
+
+    m_thread->wait();
+}
+
+void DurabilityFlusher::run()
+{
+    for (;;)
+    {
+        Batch batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_finishing)
+            {
+                m_notEmpty.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty())
+            {
+                return;
+            }
+            batch = m_queue.dequeue();
+            m_notFull.wakeOne();
+        }
+
+        int synced = 0;
+        QStringList failed;
+        for (const QString &file : batch.files)
+        {
+            if (FileSystem::syncPath(file))
+            {
+                synced++;
+            }
+            else
+            {
+                failed.append(file);
+            }
+        }
+
+        // ファイルの rename を永続化するためにディレクトリも同期する
+        if (!FileSystem::syncPath(batch.dirPath))
+        {
+            failed.append(batch.dirPath);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_syncedFiles += synced;
+        m_failedPaths.append(failed);
+    }
+}
+
+int DurabilityFlusher::syncedFiles() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_syncedFiles;
+}
+
+QStringList DurabilityFlusher::failedPaths() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failedPaths;
+}
@@ -0,0 +1,59 @@
+#ifndef DURABILITYFLUSHER_H
+#define DURABILITYFLUSHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include "../models/BackupConfig.h"
+
+class QThread;
+
+// 書き込み済みのファイルをディレクトリ単位でまとめ、バックグラウンドで fsync する。
+// コピー処理は同期を待たずに次のファイルへ進み、finish() で残りの同期完了を待つ。
+class DurabilityFlusher
+{
+public:
+    explicit DurabilityFlusher(int maxPendingBatches = 64);
+    ~DurabilityFlusher();
+
+    // この永続化レベルでバックグラウンドの同期が必要か。
+    // syncfs がない環境では終了時同期もディレクトリ単位の同期で代替する。
+    static bool isNeededFor(BackupConfig::DurabilityMode mode);
+
+    // 書き込みが完了したファイルを登録する。
+    // 親ディレクトリが変わった時点でそれまでのバッチをフラッシャーに渡す。
+    void addFile(const QString &filePath);
+
+    // 残りのバッチをすべて同期し、スレッドの終了を待つ
+    void finish();
+
+    int syncedFiles() const;
+    QStringList failedPaths() const;
+
+private:
+    struct Batch
+    {
+        QString dirPath;
+        QStringList files;
+    };
+
+    void enqueueCurrentBatch();
+    void run();
+
+    QThread *m_thread;
+    const int m_maxPendingBatches;
+
+    Batch m_current; // 呼び出し側スレッドだけが触る
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<Batch> m_queue;
+    bool m_finishing;
+    int m_syncedFiles;
+    QStringList m_failedPaths;
+};
+
+#endif // DURABILITYFLUSHER_H
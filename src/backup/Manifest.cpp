@@ -0,0 +1,246 @@
+#include "Manifest.h"
+#include <QDir>
+
+namespace
+{
+    const quint32 kMagic = 0x53424d46; // "SBMF"
+    const quint16 kVersion = 1;
+    const quint16 kFlagHashes = 0x0001;
+
+    const quint8 kTagEnd = 0;
+    const quint8 kTagEntry = 1;
+
+    qsizetype commonPrefixLength(const QByteArray &a, const QByteArray &b)
+    {
+        const qsizetype length = qMin(a.size(), b.size());
+        qsizetype i = 0;
+        while (i < length && a.at(i) == b.at(i))
+        {
+            ++i;
+        }
+        return i;
+    }
+}
+
+QString manifestFilePath(const QString &destinationRoot)
+{
+    return QDir(destinationRoot).filePath(QStringLiteral(".sbs-manifest"));
+}
+
+ManifestReader::ManifestReader(const QString &filePath)
+    : m_file(filePath), m_hasHashes(false), m_finished(false)
+{
+}
+
+bool ManifestReader::open()
+{
+    m_finished = true;
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint16 flags = 0;
+    m_stream >> magic >> version >> flags;
+    if (m_stream.status() != QDataStream::Ok || magic != kMagic || version != kVersion)
+    {
+        m_errorString = QStringLiteral("Not a manifest file: %1").arg(m_file.fileName());
+        return false;
+    }
+    m_hasHashes = (flags & kFlagHashes) != 0;
+    m_finished = false;
+    return true;
+}
+
+void ManifestReader::close()
+{
+    m_stream.setDevice(nullptr);
+    m_file.close();
+    m_finished = true;
+}
+
+bool ManifestReader::hasHashes() const
+{
+    return m_hasHashes;
+}
+
+bool ManifestReader::next(ManifestEntry &entry)
+{
+    if (m_finished)
+    {
+        return false;
+    }
+
+    quint8 tag = kTagEnd;
+    m_stream >> tag;
+    if (m_stream.status() == QDataStream::Ok && tag == kTagEnd)
+    {
+        m_finished = true;
+        return false;
+    }
+
+    quint32 prefix = 0;
+    QByteArray suffix;
+    if (tag == kTagEntry)
+    {
+        m_stream >> prefix >> suffix >> entry.size >> entry.mtimeNs >> entry.mode;
+        if (m_hasHashes)
+        {
+            m_stream >> entry.hash;
+        }
+        else
+        {
+            entry.hash.clear();
+        }
+    }
+
+    // 終端の印がないまま終わったもの（書き込み途中で止まった）も壊れているものとして扱う
+    if (m_stream.status() != QDataStream::Ok || tag != kTagEntry || prefix > quint32(m_previousPath.size()))
+    {
+        m_errorString = QStringLiteral("Manifest is truncated or corrupt: %1").arg(m_file.fileName());
+        m_finished = true;
+        return false;
+    }
+
+    m_previousPath.truncate(prefix);
+    m_previousPath.append(suffix);
+    entry.path.resize(0);
+    entry.path.append(m_previousPath);
+    entry.file = FileIndex::kInvalidId;
+    return true;
+}
+
+bool ManifestReader::hasError() const
+{
+    return !m_errorString.isEmpty();
+}
+
+QString ManifestReader::errorString() const
+{
+    return m_errorString;
+}
+
+ManifestWriter::ManifestWriter(const QString &filePath, bool withHashes)
+    : m_file(filePath), m_withHashes(withHashes), m_count(0)
+{
+}
+
+bool ManifestWriter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+    m_stream << kMagic << kVersion << quint16(m_withHashes ? kFlagHashes : 0);
+    return m_stream.status() == QDataStream::Ok;
+}
+
+void ManifestWriter::write(const ManifestEntry &entry)
+{
+    const qsizetype prefix = commonPrefixLength(m_previousPath, entry.path);
+    m_stream << kTagEntry << quint32(prefix);
+    m_stream.writeBytes(entry.path.constData() + prefix, entry.path.size() - prefix);
+    m_stream << entry.size << entry.mtimeNs << entry.mode;
+    if (m_withHashes)
+    {
+        m_stream << entry.hash;
+    }
+    m_previousPath = entry.path;
+    ++m_count;
+}
+
+bool ManifestWriter::commit()
+{
+    m_stream << kTagEnd;
+    if (m_stream.status() != QDataStream::Ok)
+    {
+        m_file.cancelWriting();
+        return false;
+    }
+    return m_file.commit();
+}
+
+qint64 ManifestWriter::count() const
+{
+    return m_count;
+}
+
+QString ManifestWriter::errorString() const
+{
+    return m_file.errorString();
+}
+
+FileIndexManifestSource::FileIndexManifestSource(const FileIndex &index, std::function<bool(FileIndex::Id)> filter)
+    : m_index(index), m_filter(std::move(filter)), m_nextFile(0), m_currentDir(FileIndex::kInvalidId)
+{
+}
+
+bool FileIndexManifestSource::next(ManifestEntry &entry)
+{
+    const FileIndex::Id count = static_cast<FileIndex::Id>(m_index.fileCount());
+    while (m_nextFile < count)
+    {
+        const FileIndex::Id file = m_nextFile++;
+        if (m_filter && !m_filter(file))
+        {
+            continue;
+        }
+
+        // フォルダのパスはフォルダが変わったときだけ作る
+        const FileIndex::Id dir = m_index.fileDirectory(file);
+        if (dir != m_currentDir)
+        {
+            m_currentDir = dir;
+            m_dirPath = m_index.directoryPath(dir);
+            if (!m_dirPath.isEmpty())
+            {
+                m_dirPath.append('/');
+            }
+        }
+
+        entry.path.resize(0);
+        entry.path.append(m_dirPath);
+        entry.path.append(m_index.fileName(file));
+        entry.size = m_index.fileSize(file);
+        entry.mtimeNs = m_index.fileMtime(file);
+        entry.mode = m_index.fileMode(file);
+        entry.hash.clear();
+        entry.file = file;
+        return true;
+    }
+    return false;
+}
+
+ManifestIndexBuilder::ManifestIndexBuilder(FileIndex &index)
+    : m_index(index)
+{
+    m_directories.insert(QByteArray(), FileIndex::kRootDirectory);
+}
+
+FileIndex::Id ManifestIndexBuilder::add(const ManifestEntry &entry)
+{
+    const int slash = entry.path.lastIndexOf('/');
+    const FileIndex::Id dir = slash < 0 ? FileIndex::kRootDirectory : directory(entry.path.left(slash));
+    return m_index.addFile(dir, QByteArrayView(entry.path).mid(slash + 1), entry.size, entry.mtimeNs, entry.mode);
+}
+
+FileIndex::Id ManifestIndexBuilder::directory(const QByteArray &path)
+{
+    const auto existing = m_directories.constFind(path);
+    if (existing != m_directories.constEnd())
+    {
+        return existing.value();
+    }
+    const int slash = path.lastIndexOf('/');
+    const FileIndex::Id parent = slash < 0 ? FileIndex::kRootDirectory : directory(path.left(slash));
+    const FileIndex::Id id = m_index.addDirectory(parent, QByteArrayView(path).mid(slash + 1));
+    m_directories.insert(path, id);
+    return id;
+}
@@ -0,0 +1,125 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <functional>
+#include "../utils/FileIndex.h"
+
+// 前回のバックアップで保存先に書き込んだファイルの一覧（マニフェスト）。
+// パスの順（FileIndex::sort と同じ: フォルダのパス順、同じフォルダ内は名前順）に並べて書き、
+// 先頭から1件ずつ読むので、件数によらず使うメモリは一定。
+// パスは直前のパスとの共通部分を省いて保存する。
+
+// マニフェストの1件
+struct ManifestEntry
+{
+    QByteArray path; // ルートからの相対パス（区切りは '/'）
+    qint64 size = 0;
+    qint64 mtimeNs = 0;
+    quint32 mode = 0;
+    QByteArray hash;                           // 空なら未計算
+    FileIndex::Id file = FileIndex::kInvalidId; // 今回の走査での番号（マニフェストから読んだものは無効）
+};
+
+// マニフェストを保存先のどこに置くか
+QString manifestFilePath(const QString &destinationRoot);
+
+// パス順に1件ずつ返す入力
+class ManifestSource
+{
+public:
+    virtual ~ManifestSource() {}
+
+    // 次の1件を entry に入れる。終わりかエラーなら false
+    virtual bool next(ManifestEntry &entry) = 0;
+
+    virtual bool hasError() const { return false; }
+    virtual QString errorString() const { return QString(); }
+};
+
+// マニフェストファイルを読む
+class ManifestReader : public ManifestSource
+{
+public:
+    explicit ManifestReader(const QString &filePath);
+
+    // ファイルがない・形式が違う場合は false
+    bool open();
+    void close();
+    bool hasHashes() const;
+
+    bool next(ManifestEntry &entry) override;
+    bool hasError() const override;
+    QString errorString() const override;
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+    QByteArray m_previousPath;
+    bool m_hasHashes;
+    bool m_finished;
+    QString m_errorString;
+};
+
+// マニフェストファイルを書く。一時ファイルに書いて commit() で置き換えるので、
+// 途中で失敗しても前回のマニフェストは残る
+class ManifestWriter
+{
+public:
+    explicit ManifestWriter(const QString &filePath, bool withHashes = false);
+
+    bool open();
+    // パス順に渡すこと
+    void write(const ManifestEntry &entry);
+    bool commit();
+
+    qint64 count() const;
+    QString errorString() const;
+
+private:
+    QSaveFile m_file;
+    QDataStream m_stream;
+    QByteArray m_previousPath;
+    bool m_withHashes;
+    qint64 m_count;
+};
+
+// FileIndex をマニフェストの入力として読む（索引は sort() 済みであること）
+class FileIndexManifestSource : public ManifestSource
+{
+public:
+    // filter が false を返したファイルは飛ばす
+    explicit FileIndexManifestSource(const FileIndex &index, std::function<bool(FileIndex::Id)> filter = nullptr);
+
+    bool next(ManifestEntry &entry) override;
+
+private:
+    const FileIndex &m_index;
+    std::function<bool(FileIndex::Id)> m_filter;
+    FileIndex::Id m_nextFile;
+    FileIndex::Id m_currentDir;
+    QByteArray m_dirPath;
+};
+
+// マニフェストの項目を FileIndex に追加する（マニフェストの中身を索引として扱いたい復元や検証用）。
+// フォルダは初めて出てきたときに親から順に作る。追加した順に番号が付く
+class ManifestIndexBuilder
+{
+public:
+    explicit ManifestIndexBuilder(FileIndex &index);
+
+    FileIndex::Id add(const ManifestEntry &entry);
+
+private:
+    FileIndex::Id directory(const QByteArray &path);
+
+    FileIndex &m_index;
+    QHash<QByteArray, FileIndex::Id> m_directories;
+};
+
+#endif // MANIFEST_H
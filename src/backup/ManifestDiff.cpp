@@ -0,0 +1,153 @@
+#include "ManifestDiff.h"
+#include <cstring>
+
+namespace
+{
+    // '/' を最も小さい文字として比べる（FileIndex::sort のフォルダの順位付けと同じ）
+    int compareDirectories(QByteArrayView a, QByteArrayView b)
+    {
+        const qsizetype length = qMin(a.size(), b.size());
+        for (qsizetype i = 0; i < length; ++i)
+        {
+            const uchar ca = static_cast<uchar>(a.at(i));
+            const uchar cb = static_cast<uchar>(b.at(i));
+            if (ca == cb)
+            {
+                continue;
+            }
+            if (ca == '/')
+            {
+                return -1;
+            }
+            if (cb == '/')
+            {
+                return 1;
+            }
+            return ca < cb ? -1 : 1;
+        }
+        return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+    }
+
+    int compareNames(QByteArrayView a, QByteArrayView b)
+    {
+        const int result = memcmp(a.data(), b.data(), static_cast<size_t>(qMin(a.size(), b.size())));
+        if (result != 0)
+        {
+            return result < 0 ? -1 : 1;
+        }
+        return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+    }
+}
+
+ManifestDiff::ManifestDiff()
+{
+}
+
+int ManifestDiff::comparePaths(QByteArrayView a, QByteArrayView b)
+{
+    const qsizetype slashA = a.lastIndexOf('/');
+    const qsizetype slashB = b.lastIndexOf('/');
+    const QByteArrayView dirA = slashA < 0 ? QByteArrayView() : a.first(slashA);
+    const QByteArrayView dirB = slashB < 0 ? QByteArrayView() : b.first(slashB);
+    const int dirOrder = compareDirectories(dirA, dirB);
+    if (dirOrder != 0)
+    {
+        return dirOrder;
+    }
+    return compareNames(a.sliced(slashA + 1), b.sliced(slashB + 1));
+}
+
+bool ManifestDiff::isModified(const ManifestEntry &current, const ManifestEntry &previous)
+{
+    if (current.size != previous.size || current.mtimeNs != previous.mtimeNs)
+    {
+        return true;
+    }
+    return !current.hash.isEmpty() && !previous.hash.isEmpty() && current.hash != previous.hash;
+}
+
+bool ManifestDiff::advance(ManifestSource &source, ManifestEntry &entry, QByteArray &lastPath)
+{
+    if (!source.next(entry))
+    {
+        return false;
+    }
+    // 並び順が崩れているとマージの結果が信用できないので、ここで止める
+    if (!lastPath.isEmpty() && comparePaths(lastPath, entry.path) >= 0)
+    {
+        m_errorString = QStringLiteral("Entries are not in manifest order: %1").arg(QString::fromUtf8(entry.path));
+        return false;
+    }
+    // 共有させると入力側が次の1件を書くときに複製が起きるので、同じバッファに写す
+    lastPath.resize(0);
+    lastPath.append(entry.path);
+    return true;
+}
+
+bool ManifestDiff::run(ManifestSource &current, ManifestSource &previous, const Handler &handler)
+{
+    m_stats = Stats();
+    m_errorString.clear();
+
+    const ManifestEntry none;
+    ManifestEntry currentEntry;
+    ManifestEntry previousEntry;
+    QByteArray lastCurrent;
+    QByteArray lastPrevious;
+    bool hasCurrent = advance(current, currentEntry, lastCurrent);
+    bool hasPrevious = m_errorString.isEmpty() && advance(previous, previousEntry, lastPrevious);
+
+    while ((hasCurrent || hasPrevious) && m_errorString.isEmpty())
+    {
+        const int order = !hasPrevious ? -1 : (!hasCurrent ? 1 : comparePaths(currentEntry.path, previousEntry.path));
+        if (order < 0)
+        {
+            m_stats.added++;
+            m_stats.addedBytes += currentEntry.size;
+            handler(Added, currentEntry, none);
+            hasCurrent = advance(current, currentEntry, lastCurrent);
+        }
+        else if (order > 0)
+        {
+            m_stats.deleted++;
+            handler(Deleted, none, previousEntry);
+            hasPrevious = advance(previous, previousEntry, lastPrevious);
+        }
+        else
+        {
+            if (isModified(currentEntry, previousEntry))
+            {
+                m_stats.modified++;
+                m_stats.modifiedBytes += currentEntry.size;
+                handler(Modified, currentEntry, previousEntry);
+            }
+            else
+            {
+                m_stats.unchanged++;
+                handler(Unchanged, currentEntry, previousEntry);
+            }
+            hasCurrent = advance(current, currentEntry, lastCurrent);
+            hasPrevious = m_errorString.isEmpty() && advance(previous, previousEntry, lastPrevious);
+        }
+    }
+
+    if (m_errorString.isEmpty() && current.hasError())
+    {
+        m_errorString = current.errorString();
+    }
+    if (m_errorString.isEmpty() && previous.hasError())
+    {
+        m_errorString = previous.errorString();
+    }
+    return m_errorString.isEmpty();
+}
+
+ManifestDiff::Stats ManifestDiff::stats() const
+{
+    return m_stats;
+}
+
+QString ManifestDiff::errorString() const
+{
+    return m_errorString;
+}
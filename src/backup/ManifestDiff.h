@@ -0,0 +1,55 @@
+#ifndef MANIFESTDIFF_H
+#define MANIFESTDIFF_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <functional>
+#include "Manifest.h"
+
+// 今回の走査結果と前回のマニフェストを比べ、追加・変更・削除・変更なしを順に通知する。
+// 両方ともパス順に並んでいる前提で、先頭から1回たどるだけのマージで比べる。
+// ハッシュ表を作らないので、件数によらず使うメモリは2件分だけ。
+class ManifestDiff
+{
+public:
+    enum Change
+    {
+        Added,     // 今回だけにある
+        Modified,  // 両方にあり、サイズ・更新日時（両方にあればハッシュ）が違う
+        Deleted,   // 前回だけにある
+        Unchanged
+    };
+
+    struct Stats
+    {
+        qint64 added = 0;
+        qint64 modified = 0;
+        qint64 deleted = 0;
+        qint64 unchanged = 0;
+        qint64 addedBytes = 0;    // 追加分のサイズ（今回）
+        qint64 modifiedBytes = 0; // 変更分のサイズ（今回）
+    };
+
+    // Added では previous が、Deleted では current が空の ManifestEntry になる
+    using Handler = std::function<void(Change change, const ManifestEntry &current, const ManifestEntry &previous)>;
+
+    ManifestDiff();
+
+    // 途中で並び順の乱れや読み込みエラーを見つけたら false（それまでの通知は届いている）
+    bool run(ManifestSource &current, ManifestSource &previous, const Handler &handler);
+
+    Stats stats() const;
+    QString errorString() const;
+
+    // マニフェストの並び順（フォルダのパスを '/' が最小の文字として比べ、同じなら名前で比べる）
+    static int comparePaths(QByteArrayView a, QByteArrayView b);
+    static bool isModified(const ManifestEntry &current, const ManifestEntry &previous);
+
+private:
+    bool advance(ManifestSource &source, ManifestEntry &entry, QByteArray &lastPath);
+
+    Stats m_stats;
+    QString m_errorString;
+};
+
+#endif // MANIFESTDIFF_H
@@ -0,0 +1,412 @@
+#include "RestoreEngine.h"
+#include "Manifest.h"
+#include "CheckpointJournal.h"
+#include "SnapshotStore.h"
+#include "../utils/BufferPool.h"
+#include "../utils/CopyBackend.h"
+#include "../utils/DirectoryHandleCache.h"
+#include "../utils/FileIndex.h"
+#include "../utils/FileSystem.h"
+#include "../utils/RunArena.h"
+#include "../utils/TreeWalker.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // コピーが終わった1ファイル分の結果
+    struct RestoreResult
+    {
+        quint32 file;
+        bool success;
+        QString errorString;
+    };
+
+    struct RestoreResultSink
+    {
+        QMutex mutex;
+        std::vector<RestoreResult> results;
+    };
+
+    // 要求のパスを保存先のマニフェストと同じ形（先頭と末尾の '/' なし、区切りは '/'）にする。
+    // ルート全体を指すものがあれば空を返す（すべてを復元する）
+    QVector<QByteArray> normalizeSelection(const QStringList &paths)
+    {
+        QVector<QByteArray> selection;
+        for (const QString &path : paths)
+        {
+            QString cleaned = QDir::cleanPath(QDir::fromNativeSeparators(path));
+            while (cleaned.startsWith(QLatin1Char('/')))
+            {
+                cleaned.remove(0, 1);
+            }
+            if (cleaned.isEmpty() || cleaned == QLatin1String("."))
+            {
+                return QVector<QByteArray>();
+            }
+            selection.append(QFile::encodeName(cleaned));
+        }
+        return selection;
+    }
+
+    // path が選択したファイルそのものか、選択したフォルダの中にあるか
+    bool isSelected(const QByteArray &path, const QVector<QByteArray> &selection)
+    {
+        if (selection.isEmpty())
+        {
+            return true;
+        }
+        for (const QByteArray &selected : selection)
+        {
+            if (path.startsWith(selected) && (path.size() == selected.size() || path.at(selected.size()) == '/'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // フォルダ path の中に選択したものがあるか（走査でそのフォルダに入る必要があるか）
+    bool containsSelection(const QByteArray &path, const QVector<QByteArray> &selection)
+    {
+        for (const QByteArray &selected : selection)
+        {
+            if (selected.size() > path.size() && selected.startsWith(path) && selected.at(path.size()) == '/')
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 復元先の name がすでに size・mtimeNs のファイルか（前回の復元で書き終えたものか）
+    bool isUpToDate(const DirectoryHandle &dir, const QByteArray &name, qint64 size, qint64 mtimeNs)
+    {
+#ifdef Q_OS_LINUX
+        struct stat st;
+        const int result = dir.fd >= 0 ? ::fstatat(dir.fd, name.constData(), &st, AT_SYMLINK_NOFOLLOW)
+                                       : ::lstat(QFile::encodeName(dir.filePath(name)).constData(), &st);
+        if (result != 0 || !S_ISREG(st.st_mode))
+        {
+            return false;
+        }
+        return st.st_size == size && static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec == mtimeNs;
+#else
+        const QFileInfo info(dir.filePath(name));
+        // 更新時刻はミリ秒までしか取れない
+        return info.isFile() && info.size() == size &&
+               info.lastModified().toMSecsSinceEpoch() == mtimeNs / 1000000;
+#endif
+    }
+}
+
+QStringList RestoreEngine::Statistics::toLogLines() const
+{
+    QStringList lines;
+    lines << QCoreApplication::translate("RestoreEngine", "復元統計: %1 ファイル中 %2 個復元, %3 個は復元済み, %4 個失敗 (%5 MB)")
+                 .arg(selectedFiles)
+                 .arg(restoredFiles)
+                 .arg(skippedFiles)
+                 .arg(failedFiles)
+                 .arg(restoredBytes / (1024.0 * 1024.0), 0, 'f', 1);
+    lines << QCoreApplication::translate("RestoreEngine", "  時間: 対象の選択 %1 ms (%2) / コピー %3 ms / 合計 %4 ms")
+                 .arg(listMs)
+                 .arg(usedManifest ? QCoreApplication::translate("RestoreEngine", "マニフェスト")
+                                   : QCoreApplication::translate("RestoreEngine", "保存先を走査"))
+                 .arg(copyMs)
+                 .arg(totalMs);
+    if (!copyBackend.isEmpty())
+    {
+        lines << QCoreApplication::translate("RestoreEngine", "  コピー方式: %1").arg(copyBackend);
+    }
+    return lines;
+}
+
+RestoreEngine::RestoreEngine(QObject *parent)
+    : QObject(parent), m_running(false), m_stopRequested(false)
+{
+    BufferPool::Options poolOptions;
+    poolOptions.sizeClasses = {256 * 1024, 1024 * 1024};
+    m_bufferPool.reset(new BufferPool(poolOptions));
+}
+
+RestoreEngine::~RestoreEngine()
+{
+}
+
+void RestoreEngine::stopRestore()
+{
+    m_stopRequested = true;
+}
+
+bool RestoreEngine::isRunning() const
+{
+    return m_running;
+}
+
+RestoreEngine::Statistics RestoreEngine::lastStatistics() const
+{
+    return m_lastStatistics;
+}
+
+QString RestoreEngine::defaultBackupRoot(const BackupConfig &config)
+{
+    if (config.updateMode() == BackupConfig::UpdateSnapshot)
+    {
+        return SnapshotStore(config.destinationPath()).latest().path;
+    }
+    return QFileInfo(config.destinationPath()).isDir() ? config.destinationPath() : QString();
+}
+
+bool RestoreEngine::runRestore(const Request &request)
+{
+    if (m_running)
+    {
+        emit restoreError(tr("復元が実行中です"));
+        return false;
+    }
+    if (!QFileInfo(request.backupRoot).isDir())
+    {
+        emit restoreError(tr("復元元のフォルダが存在しません: %1").arg(request.backupRoot));
+        return false;
+    }
+    if (!QDir().mkpath(request.targetRoot))
+    {
+        emit restoreError(tr("復元先のフォルダを作成できません: %1").arg(request.targetRoot));
+        return false;
+    }
+
+    m_running = true;
+    m_stopRequested = false;
+    Statistics statistics;
+    QElapsedTimer runTimer;
+    runTimer.start();
+    emit restoreLogMessage(tr("復元を開始します: %1 → %2").arg(request.backupRoot, request.targetRoot));
+
+    // 対象のファイル一覧（フォルダ順に並べ、フォルダが変わったときだけ開き直してコピーする）
+    RunArena arena;
+    FileIndex index(&arena);
+    statistics.usedManifest = selectFromManifest(request.backupRoot, request.paths, index);
+    if (!statistics.usedManifest)
+    {
+        emit restoreLogMessage(tr("ファイル一覧（マニフェスト）がないため、保存先を走査して対象を選びます"));
+        index.clear();
+        selectByWalking(request.backupRoot, request.paths, index);
+    }
+    statistics.listMs = runTimer.elapsed();
+    statistics.selectedFiles = index.fileCount();
+    emit restoreLogMessage(tr("復元の対象: %1 個のファイル (%2 ms)").arg(statistics.selectedFiles).arg(statistics.listMs));
+
+    if (statistics.selectedFiles == 0)
+    {
+        if (!request.paths.isEmpty())
+        {
+            emit restoreLogMessage(tr("指定したパスはバックアップに見つかりませんでした: %1").arg(request.paths.join(", ")));
+        }
+        statistics.totalMs = runTimer.elapsed();
+        m_lastStatistics = statistics;
+        m_running = false;
+        emit restoreProgress(100);
+        emit restoreCompleted();
+        return request.paths.isEmpty();
+    }
+
+    // 復元先のフォルダ構成を先にまとめて作る
+    DirectoryHandleCache sourceDirs(request.backupRoot);
+    DirectoryHandleCache targetDirs(request.targetRoot);
+    {
+        QSet<FileIndex::Id> usedDirs;
+        for (FileIndex::Id file = 0; file < static_cast<FileIndex::Id>(index.fileCount()); ++file)
+        {
+            usedDirs.insert(index.fileDirectory(file));
+        }
+        QVector<QByteArray> relativeDirs;
+        for (FileIndex::Id dir : usedDirs)
+        {
+            relativeDirs.append(index.directoryPath(dir));
+        }
+        targetDirs.createTree(relativeDirs);
+    }
+
+    std::unique_ptr<CopyBackend> backend = CopyBackend::create(CopyBackend::KernelCopy, m_bufferPool.get());
+    statistics.copyBackend = backend->name();
+    QElapsedTimer copyTimer;
+    copyTimer.start();
+
+    RestoreResultSink sink;
+    std::vector<RestoreResult> finished;
+    int doneFiles = 0;
+    const QString targetRoot = request.targetRoot;
+    auto drainResults = [&]()
+    {
+        finished.clear();
+        {
+            QMutexLocker locker(&sink.mutex);
+            finished.swap(sink.results);
+        }
+
+        for (const RestoreResult &result : finished)
+        {
+            const QString relativePath = QFile::decodeName(index.filePath(result.file));
+            const QString targetPath = targetRoot + "/" + relativePath;
+            if (result.success)
+            {
+                // 元の更新時刻に戻す（再開時にこのファイルを復元済みと判定できるようにする）
+                FileSystem::setModificationTime(targetPath, index.fileMtime(result.file));
+                statistics.restoredFiles++;
+                statistics.restoredBytes += index.fileSize(result.file);
+            }
+            else
+            {
+                statistics.failedFiles++;
+                emit restoreLogMessage(tr("ファイルの復元に失敗: %1 (%2)").arg(targetPath, result.errorString));
+            }
+            doneFiles++;
+        }
+
+        if (!finished.empty())
+        {
+            emit restoreProgress(doneFiles * 100 / statistics.selectedFiles);
+        }
+    };
+
+    FileIndex::Id currentDir = FileIndex::kInvalidId;
+    DirectoryHandle source;
+    DirectoryHandle target;
+    for (FileIndex::Id file = 0; file < static_cast<FileIndex::Id>(index.fileCount()) && !m_stopRequested; ++file)
+    {
+        const FileIndex::Id dir = index.fileDirectory(file);
+        if (dir != currentDir)
+        {
+            currentDir = dir;
+            const QByteArray relativeDir = index.directoryPath(dir);
+            source = sourceDirs.handle(relativeDir);
+            target = targetDirs.handle(relativeDir, true);
+            QCoreApplication::processEvents();
+        }
+
+        if (!source.isValid() || !target.isValid())
+        {
+            const QString error = !source.isValid() ? sourceDirs.errorString() : targetDirs.errorString();
+            QMutexLocker locker(&sink.mutex);
+            sink.results.push_back(RestoreResult{file, false, error});
+            continue;
+        }
+
+        const QByteArray fileName = index.fileName(file).toByteArray();
+        if (request.skipUnchanged && isUpToDate(target, fileName, index.fileSize(file), index.fileMtime(file)))
+        {
+            statistics.skippedFiles++;
+            doneFiles++;
+            continue;
+        }
+
+        RestoreResultSink *resultSink = &sink;
+        backend->submitAt(source, fileName, target, fileName, false, [resultSink, file](bool success, const QString &error)
+                          {
+            QMutexLocker locker(&resultSink->mutex);
+            resultSink->results.push_back(RestoreResult{file, success, error}); });
+
+        drainResults();
+    }
+
+    while (!backend->waitForDone(50))
+    {
+        drainResults();
+        QCoreApplication::processEvents();
+    }
+    drainResults();
+    backend.reset();
+    statistics.copyMs = copyTimer.elapsed();
+
+    // 書き戻したデータをまとめてディスクへ書き出す（ファイルごとの fsync はしない）
+    if (statistics.restoredFiles > 0 && !FileSystem::syncFileSystem(request.targetRoot))
+    {
+        emit restoreLogMessage(tr("警告: 復元先をディスクへ書き出せませんでした"));
+    }
+
+    const bool stopped = m_stopRequested;
+    if (stopped)
+    {
+        emit restoreLogMessage(tr("復元を中止しました（もう一度実行すると続きから復元します）"));
+    }
+
+    statistics.totalMs = runTimer.elapsed();
+    m_lastStatistics = statistics;
+    for (const QString &line : statistics.toLogLines())
+    {
+        emit restoreLogMessage(line);
+    }
+
+    m_running = false;
+    emit restoreProgress(100);
+    emit restoreCompleted();
+    return !stopped && statistics.failedFiles == 0;
+}
+
+bool RestoreEngine::selectFromManifest(const QString &backupRoot, const QStringList &paths, FileIndex &index)
+{
+    ManifestReader reader(manifestFilePath(backupRoot));
+    if (!reader.open())
+    {
+        return false;
+    }
+
+    const QVector<QByteArray> selection = normalizeSelection(paths);
+    ManifestIndexBuilder builder(index);
+    ManifestEntry entry;
+    while (reader.next(entry))
+    {
+        if (isSelected(entry.path, selection))
+        {
+            builder.add(entry);
+        }
+    }
+    if (reader.hasError())
+    {
+        emit restoreLogMessage(tr("警告: ファイル一覧（マニフェスト）を最後まで読めませんでした: %1").arg(reader.errorString()));
+        return false;
+    }
+    index.sort();
+    return true;
+}
+
+void RestoreEngine::selectByWalking(const QString &backupRoot, const QStringList &paths, FileIndex &index)
+{
+    const QVector<QByteArray> selection = normalizeSelection(paths);
+    const QString manifestName = QFileInfo(manifestFilePath(backupRoot)).fileName();
+    const QString checkpointName = QFileInfo(CheckpointJournal::filePath(backupRoot)).fileName();
+
+    TreeWalker::Options options;
+    options.sorted = true;
+    options.needMetadata = true;
+    options.filter = [&](const TreeWalker::Entry &entry)
+    {
+        // バックアップが書いた管理用のファイルは復元しない
+        if (entry.depth == 1 && !entry.isDir && (entry.name == manifestName || entry.name == checkpointName))
+        {
+            return false;
+        }
+        const QByteArray path = QFile::encodeName(entry.relativePath);
+        return isSelected(path, selection) || (entry.isDir && containsSelection(path, selection));
+    };
+    options.onWait = []()
+    {
+        QCoreApplication::processEvents();
+    };
+
+    TreeWalker walker(options);
+    walker.walk(backupRoot, index);
+}
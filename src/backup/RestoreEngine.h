@@ -0,0 +1,83 @@
+#ifndef RESTOREENGINE_H
+#define RESTOREENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "../models/BackupConfig.h"
+#include <memory>
+
+class BufferPool;
+class FileIndex;
+
+// バックアップ（保存先、またはスナップショットの1世代）からファイルを書き戻す。
+// 対象のファイルは保存先のマニフェストから選ぶので、1ファイルだけの復元でも保存先を走査しない
+// （マニフェストがない古いバックアップだけは走査する）。コピーはバックアップと同じバックエンドで並列に行い、
+// Linux では copy_file_range でデータをユーザー空間に持ち込まない。
+// 復元したファイルには元の更新時刻を付けるので、途中で止まっても同じ要求をもう一度実行すれば
+// 書き終えたファイル（サイズと更新時刻が一致するもの）を飛ばして続きから復元できる。
+class RestoreEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request
+    {
+        QString backupRoot; // 復元元（保存先のフォルダ、またはスナップショットの世代のフォルダ）
+        QString targetRoot; // 復元先（元のバックアップ元など）
+        // backupRoot からの相対パス（ファイルかフォルダ。区切りは '/'）。空ならすべてを復元する
+        QStringList paths;
+        // 復元先に同じサイズ・更新時刻のファイルがあれば書き直さない（中断した復元の再開にも使う）
+        bool skipUnchanged = true;
+    };
+
+    // 1回の復元の集計
+    struct Statistics
+    {
+        QString copyBackend;
+        bool usedManifest = false; // 対象をマニフェストから選んだ（false なら保存先を走査した）
+        int selectedFiles = 0;     // 要求に当てはまったファイル
+        int restoredFiles = 0;
+        int skippedFiles = 0;      // 復元先に同じものがあって飛ばしたファイル
+        int failedFiles = 0;
+        qint64 restoredBytes = 0;
+        qint64 listMs = 0; // 対象の選択
+        qint64 copyMs = 0;
+        qint64 totalMs = 0;
+
+        QStringList toLogLines() const;
+    };
+
+    explicit RestoreEngine(QObject *parent = nullptr);
+    ~RestoreEngine();
+
+    // request を復元する（呼び出したスレッドで、UIの応答性を保ちながら終わるまで実行する）。
+    // すべて復元できたら true
+    bool runRestore(const Request &request);
+    void stopRestore();
+    bool isRunning() const;
+
+    Statistics lastStatistics() const;
+
+    // config のバックアップの既定の復元元（スナップショットなら最新の世代、それ以外は保存先）。なければ空
+    static QString defaultBackupRoot(const BackupConfig &config);
+
+signals:
+    void restoreProgress(int progress);
+    void restoreLogMessage(const QString &message);
+    void restoreError(const QString &errorMessage);
+    void restoreCompleted();
+
+private:
+    // マニフェストから paths に当てはまるファイルを index に入れる。マニフェストが読めなければ false
+    bool selectFromManifest(const QString &backupRoot, const QStringList &paths, FileIndex &index);
+    // マニフェストがない場合: backupRoot を走査して paths に当てはまるファイルを index に入れる
+    void selectByWalking(const QString &backupRoot, const QStringList &paths, FileIndex &index);
+
+    std::unique_ptr<BufferPool> m_bufferPool;
+    bool m_running;
+    bool m_stopRequested;
+    Statistics m_lastStatistics;
+};
+
+#endif // RESTOREENGINE_H
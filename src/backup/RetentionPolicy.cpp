@@ -0,0 +1,66 @@
+#include "RetentionPolicy.h"
+#include <algorithm>
+#include <functional>
+
+RetentionPolicy::RetentionPolicy(const BackupConfig::Retention &retention)
+    : m_retention(retention)
+{
+}
+
+bool RetentionPolicy::isEnabled() const
+{
+    return m_retention.isEnabled();
+}
+
+QVector<bool> RetentionPolicy::keep(const QVector<QDateTime> &times) const
+{
+    QVector<bool> result(times.size(), !isEnabled());
+    if (!isEnabled() || times.isEmpty())
+    {
+        return result;
+    }
+
+    // 新しい順にたどる
+    QVector<int> order(times.size());
+    for (int i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&times](int a, int b)
+                     { return times.at(a) > times.at(b); });
+    result[order.first()] = true;
+
+    // 期間ごとに最新の世代を count 個の期間ぶん残す
+    auto apply = [&](int count, const std::function<qint64(const QDateTime &)> &bucket)
+    {
+        int kept = 0;
+        bool first = true;
+        qint64 lastBucket = 0;
+        for (int i : order)
+        {
+            if (kept >= count)
+            {
+                break;
+            }
+            const qint64 current = bucket(times.at(i));
+            if (first || current != lastBucket)
+            {
+                result[i] = true;
+                kept++;
+                first = false;
+                lastBucket = current;
+            }
+        }
+    };
+
+    apply(m_retention.hourly, [](const QDateTime &time)
+          { return time.date().toJulianDay() * 24 + time.time().hour(); });
+    apply(m_retention.daily, [](const QDateTime &time)
+          { return time.date().toJulianDay(); });
+    apply(m_retention.weekly, [](const QDateTime &time)
+          {
+        int year = 0;
+        const int week = time.date().weekNumber(&year);
+        return static_cast<qint64>(year) * 100 + week; });
+    return result;
+}
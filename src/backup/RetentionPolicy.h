@@ -0,0 +1,26 @@
+#ifndef RETENTIONPOLICY_H
+#define RETENTIONPOLICY_H
+
+#include <QDateTime>
+#include <QVector>
+#include "../models/BackupConfig.h"
+
+// スナップショットの世代のうち、どれを残すかを決める。
+// 時・日・週の各規則は、新しい順に見て期間ごとに最新の1世代を、指定の数の期間ぶん残す
+// （restic の --keep-hourly などと同じ考え方）。どれかの規則で残る世代は残し、最新の世代は常に残す。
+class RetentionPolicy
+{
+public:
+    explicit RetentionPolicy(const BackupConfig::Retention &retention);
+
+    // 世代を削除する設定か（すべて 0 なら何も削除しない）
+    bool isEnabled() const;
+
+    // times（各世代の作成日時。順不同）と同じ並びで、残すものを true にして返す
+    QVector<bool> keep(const QVector<QDateTime> &times) const;
+
+private:
+    BackupConfig::Retention m_retention;
+};
+
+#endif // RETENTIONPOLICY_H
@@ -0,0 +1,92 @@
+#include "RunStatistics.h"
+#include <QCoreApplication>
+
+namespace
+{
+    QString megabytes(qint64 bytes)
+    {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MiB";
+    }
+}
+
+QStringList RunStatistics::toLogLines() const
+{
+    QStringList lines;
+    lines << QCoreApplication::translate("RunStatistics", "実行統計: %1 ファイル中 %2 個成功, %3 個失敗")
+                 .arg(totalFiles)
+                 .arg(copiedFiles)
+                 .arg(failedFiles);
+    lines << QCoreApplication::translate("RunStatistics", "  時間: 一覧 %1 ms / フォルダ作成 %2 ms / コピー %3 ms / 同期 %4 ms / 合計 %5 ms")
+                 .arg(scanMs)
+                 .arg(skeletonMs)
+                 .arg(copyMs)
+                 .arg(syncMs)
+                 .arg(totalMs);
+    if (stopped)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  途中で中止しました（次回の実行で続きから再開します）");
+    }
+    if (resumedFiles > 0)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  再開: 前回書き終えた %1 個のファイルを飛ばしました").arg(resumedFiles);
+    }
+    if (incremental)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  差分: 追加 %1 (%2) / 変更 %3 (%4) / 削除 %5 / 変更なし %6 (%7 ms)")
+                     .arg(diff.added)
+                     .arg(megabytes(diff.addedBytes))
+                     .arg(diff.modified)
+                     .arg(megabytes(diff.modifiedBytes))
+                     .arg(diff.deleted)
+                     .arg(diff.unchanged)
+                     .arg(diffMs);
+    }
+    if (!snapshotName.isEmpty())
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  スナップショット: %1 (リンク %2 個 / %3 ms)")
+                     .arg(snapshotName)
+                     .arg(filesLinked)
+                     .arg(linkMs);
+    }
+    if (pruningConcurrent)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  古い世代の削除と並行してコピーしました（削除の速さは抑制）");
+    }
+    if (filesRemoved > 0 || removeFailures > 0)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  削除: ファイル %1 個 / フォルダ %2 個 / 失敗 %3 個 (%4 ms)")
+                     .arg(filesRemoved)
+                     .arg(directoriesRemoved)
+                     .arg(removeFailures)
+                     .arg(removeMs);
+    }
+    lines << QCoreApplication::translate("RunStatistics", "  ファイル一覧: %1 (1件あたり %2 bytes)")
+                 .arg(megabytes(indexBytes))
+                 .arg(scannedFiles > 0 ? indexBytes / scannedFiles : 0);
+    lines << QCoreApplication::translate("RunStatistics", "  作成したフォルダ: %1 個").arg(directoriesCreated);
+    lines << QCoreApplication::translate("RunStatistics", "  コピー方式: %1").arg(copyBackend);
+    if (!priorityClass.isEmpty())
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  優先度: %1").arg(priorityClass);
+    }
+    if (throttleWaitMs > 0 || throttleFactor < 1.0)
+    {
+        lines << QCoreApplication::translate("RunStatistics", "  速さの上限による待ち: %1 ms (自動調整 %2%)")
+                     .arg(throttleWaitMs)
+                     .arg(qRound(throttleFactor * 100));
+    }
+    lines << QCoreApplication::translate("RunStatistics", "  バッファ: ピーク %1 / 定常 %2 / 確保済み %3%4 (取得 %5 回, 待機 %6 回)")
+                 .arg(megabytes(bufferPool.peakInUseBytes),
+                      megabytes(bufferPool.averageInUseBytes),
+                      megabytes(bufferPool.reservedBytes),
+                      bufferPool.hugePages ? QStringLiteral(", huge pages") : QString())
+                 .arg(bufferPool.acquisitions)
+                 .arg(bufferPool.waits);
+    // ヒープからの取得はブロック単位なので、1ファイルあたりの回数はほぼ 0 になる
+    lines << QCoreApplication::translate("RunStatistics", "  実行用メモリ: ピーク %1 / アリーナ確保 %2 回 / ヒープ取得 %3 回 (1ファイルあたり %4 回)")
+                 .arg(megabytes(arena.peakReservedBytes))
+                 .arg(arena.allocations)
+                 .arg(arena.blocks)
+                 .arg(scannedFiles > 0 ? QString::number(double(arena.blocks) / scannedFiles, 'f', 4) : QStringLiteral("0"));
+    return lines;
+}
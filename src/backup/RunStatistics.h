@@ -0,0 +1,58 @@
+#ifndef RUNSTATISTICS_H
+#define RUNSTATISTICS_H
+
+#include <QString>
+#include <QStringList>
+#include "../utils/BufferPool.h"
+#include "../utils/RunArena.h"
+#include "ManifestDiff.h"
+
+// 1回のバックアップ実行の集計。実行の最後にログへ出力し、シグナルでも通知する
+struct RunStatistics
+{
+    QString configName;
+    QString copyBackend;
+    QString priorityClass; // 実行した I/O・CPU の優先度（ThreadPriority）
+
+    int scannedFiles = 0; // バックアップ元で見つかったファイル
+    int totalFiles = 0;   // コピー対象（差分モードでは追加・変更分）
+    int copiedFiles = 0;
+    int failedFiles = 0;
+    qint64 resumedFiles = 0; // 前回の途中経過から、書き終えていたので飛ばしたファイル
+    bool stopped = false;    // 途中で中止した（マニフェストは書かず、次の実行が続きから始める）
+    bool failed = false;     // コピーを始める前などに失敗して実行を打ち切った
+    QString errorString;     // failed のときの理由
+
+    bool incremental = false; // 前回のマニフェストとの差分でコピーするファイルを決めた
+    ManifestDiff::Stats diff;
+
+    qint64 filesRemoved = 0;     // ミラーで保存先から削除したファイル
+    int directoriesRemoved = 0;  // 空になって削除したフォルダ
+    int removeFailures = 0;
+
+    QString snapshotName; // スナップショットモードで作った世代
+    qint64 filesLinked = 0; // 前の世代からハードリンクしたファイル
+    bool pruningConcurrent = false; // コピー中に古い世代の削除が動いていた
+
+    int directoriesCreated = 0;
+    qint64 indexBytes = 0; // ファイル一覧（FileIndex）のメモリ使用量
+
+    qint64 scanMs = 0;     // ファイル一覧の作成
+    qint64 diffMs = 0;     // 前回のマニフェストとの比較（差分モードのみ）
+    qint64 skeletonMs = 0; // フォルダ構成の事前作成（有効な場合）
+    qint64 linkMs = 0;     // 前の世代からのハードリンク（スナップショットのみ）
+    qint64 copyMs = 0;     // コピー（投入から全完了まで）
+    qint64 removeMs = 0;   // ミラーでの削除
+    qint64 syncMs = 0;  // ディスクへの書き出し待ち
+    qint64 throttleWaitMs = 0;  // 速さの上限で待った時間（ワーカーごとの合計）
+    double throttleFactor = 1.0; // 終了時に adaptive でかけていた倍率（1.0 なら下げていない）
+    qint64 totalMs = 0;
+
+    BufferPool::Stats bufferPool;
+    RunArena::Stats arena; // 実行用アリーナ（ファイル一覧・コピー結果）
+
+    // ログ表示用の行
+    QStringList toLogLines() const;
+};
+
+#endif // RUNSTATISTICS_H
@@ -0,0 +1,183 @@
+#include "SnapshotPruner.h"
+#include "../utils/FileRemover.h"
+#include <QDir>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+SnapshotPruner::SnapshotPruner(QObject *parent)
+    : SnapshotPruner(Options(), parent)
+{
+}
+
+SnapshotPruner::SnapshotPruner(const Options &options, QObject *parent)
+    : QObject(parent),
+      m_options(options),
+      m_thread(nullptr),
+      m_stopping(false),
+      m_backupActive(false),
+      m_current(nullptr),
+      m_overlapped(false)
+{
+    m_thread = QThread::create([this]()
+                               { run(); });
+    // バックアップやUIより後回しにしてよい処理なので、最も低い優先度で動かす
+    m_thread->start(QThread::IdlePriority);
+}
+
+SnapshotPruner::~SnapshotPruner()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        if (m_current)
+        {
+            m_current->cancel();
+        }
+        m_notEmpty.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void SnapshotPruner::remove(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.contains(path))
+    {
+        return;
+    }
+    m_pending.insert(path);
+    m_queue.enqueue(path);
+    m_notEmpty.wakeOne();
+}
+
+void SnapshotPruner::setBackupActive(bool active)
+{
+    QMutexLocker locker(&m_mutex);
+    m_backupActive = active;
+    if (m_current)
+    {
+        m_overlapped = m_overlapped || active;
+        m_current->setMaxOperationsPerSecond(active ? m_options.throttledOperationsPerSecond : 0);
+    }
+}
+
+bool SnapshotPruner::isIdle() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending.isEmpty();
+}
+
+bool SnapshotPruner::waitForIdle(int msecs)
+{
+    QDeadlineTimer deadline(msecs < 0 ? QDeadlineTimer::Forever : QDeadlineTimer(msecs));
+    QMutexLocker locker(&m_mutex);
+    while (!m_pending.isEmpty())
+    {
+        if (!m_idle.wait(&m_mutex, deadline))
+        {
+            return m_pending.isEmpty();
+        }
+    }
+    return true;
+}
+
+SnapshotPruner::Statistics SnapshotPruner::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+void SnapshotPruner::run()
+{
+    for (;;)
+    {
+        QString path;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_stopping)
+            {
+                m_notEmpty.wait(&m_mutex);
+            }
+            if (m_stopping)
+            {
+                return;
+            }
+            path = m_queue.dequeue();
+        }
+
+        removeOne(path);
+
+        QMutexLocker locker(&m_mutex);
+        m_pending.remove(path);
+        if (m_pending.isEmpty())
+        {
+            m_idle.wakeAll();
+        }
+    }
+}
+
+void SnapshotPruner::removeOne(const QString &path)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    FileRemover::Options options;
+    options.threads = m_options.threads;
+    FileRemover remover(path, options);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_current = &remover;
+        m_overlapped = m_backupActive;
+        remover.setMaxOperationsPerSecond(m_backupActive ? m_options.throttledOperationsPerSecond : 0);
+    }
+
+    const bool removed = remover.removeTree() && QDir().rmdir(path);
+    const FileRemover::Progress progress = remover.progress();
+    const QVector<FileRemover::Failure> failures = remover.failures();
+    const qint64 elapsed = timer.elapsed();
+
+    bool overlapped = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_current = nullptr;
+        overlapped = m_overlapped;
+        m_statistics.files += progress.files;
+        m_statistics.subdirectories += progress.directories;
+        m_statistics.failures += failures.size();
+        m_statistics.elapsedMs += elapsed;
+        if (overlapped)
+        {
+            m_statistics.overlappedMs += elapsed;
+        }
+        if (removed)
+        {
+            m_statistics.directories++;
+        }
+    }
+
+    const QString name = QFileInfo(path).fileName();
+    if (removed)
+    {
+        emit logMessage(tr("古い世代を削除しました: %1 (ファイル %2 個, %3 ms, %4 件/秒%5)")
+                            .arg(name)
+                            .arg(progress.files)
+                            .arg(elapsed)
+                            .arg(elapsed > 0 ? progress.files * 1000 / elapsed : progress.files)
+                            .arg(overlapped ? tr(", バックアップ中は速さを抑制") : QString()));
+    }
+    else if (!failures.isEmpty())
+    {
+        emit logMessage(tr("古い世代を削除できませんでした: %1 (%2 個のエラー, 例: %3: %4)")
+                            .arg(name)
+                            .arg(failures.size())
+                            .arg(QFile::decodeName(failures.first().path), failures.first().errorString));
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SNAPSHOTPRUNER_H
+#define SNAPSHOTPRUNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QSet>
+#include <atomic>
+
+class QThread;
+class FileRemover;
+
+// 期限切れの世代などのフォルダを、低優先度のバックグラウンドスレッドで削除する。
+// 削除の予約はすぐに戻るので、次のバックアップを待たせない。バックアップの実行中は
+// 削除の速さを抑え、コピーの I/O を奪わないようにする。
+class SnapshotPruner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int threads = 2;                            // 1つのフォルダを削除するスレッド数
+        qint64 throttledOperationsPerSecond = 2000; // バックアップ実行中の削除の速さの上限（0 なら抑えない）
+    };
+
+    // 削除の集計（予約されてからの累計）
+    struct Statistics
+    {
+        int directories = 0;     // 削除し終えたフォルダ（世代）
+        qint64 files = 0;
+        qint64 subdirectories = 0;
+        int failures = 0;
+        qint64 elapsedMs = 0;    // 削除にかかった時間
+        qint64 overlappedMs = 0; // そのうちバックアップと重なったフォルダの削除にかかった時間
+
+        // 1秒あたりに削除したファイル数
+        double filesPerSecond() const { return elapsedMs > 0 ? files * 1000.0 / elapsedMs : 0.0; }
+    };
+
+    explicit SnapshotPruner(QObject *parent = nullptr);
+    SnapshotPruner(const Options &options, QObject *parent = nullptr);
+    // 削除中のものは途中で止める（残りは SnapshotStore::retiredSnapshots から予約し直せる）
+    ~SnapshotPruner();
+
+    // path（SnapshotStore::retire で一覧から外したフォルダ）の削除を予約する
+    void remove(const QString &path);
+
+    // バックアップの実行中か。実行中は削除の速さを抑える
+    void setBackupActive(bool active);
+
+    // 予約がすべて終わっているか
+    bool isIdle() const;
+    // 予約がすべて終わるまで待つ。msecs が負なら無制限。終わっていれば true
+    bool waitForIdle(int msecs = -1);
+
+    Statistics statistics() const;
+
+signals:
+    void logMessage(const QString &message);
+
+private:
+    SnapshotPruner(const SnapshotPruner &) = delete;
+    SnapshotPruner &operator=(const SnapshotPruner &) = delete;
+
+    void run();
+    void removeOne(const QString &path);
+
+    Options m_options;
+    QThread *m_thread;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_idle;
+    QQueue<QString> m_queue;
+    QSet<QString> m_pending; // 予約済みか削除中のパス
+    bool m_stopping;
+    bool m_backupActive;
+    FileRemover *m_current; // 削除中のもの（速さの変更と中止のため）
+    bool m_overlapped;      // 削除中のフォルダがバックアップと重なったか
+    Statistics m_statistics;
+};
+
+#endif // SNAPSHOTPRUNER_H
@@ -0,0 +1,155 @@
+#include "SnapshotStore.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+
+namespace
+{
+    const char kNameFormat[] = "yyyy-MM-dd_HHmmss";
+    const char kPartialSuffix[] = ".partial";
+    const char kRetiredPrefix[] = ".expired-";
+}
+
+SnapshotStore::SnapshotStore(const QString &rootPath)
+    : m_rootPath(QDir::cleanPath(rootPath))
+{
+}
+
+QString SnapshotStore::snapshotName(const QDateTime &time)
+{
+    return time.toString(QLatin1String(kNameFormat));
+}
+
+bool SnapshotStore::parseSnapshotName(const QString &name, QDateTime *time)
+{
+    static const QRegularExpression pattern(QStringLiteral("^(\\d{4}-\\d{2}-\\d{2}_\\d{6})(_\\d+)?$"));
+    const QRegularExpressionMatch match = pattern.match(name);
+    if (!match.hasMatch())
+    {
+        return false;
+    }
+    const QDateTime parsed = QDateTime::fromString(match.captured(1), QLatin1String(kNameFormat));
+    if (!parsed.isValid())
+    {
+        return false;
+    }
+    if (time)
+    {
+        *time = parsed;
+    }
+    return true;
+}
+
+QVector<SnapshotStore::Snapshot> SnapshotStore::snapshots() const
+{
+    QVector<Snapshot> result;
+    const QDir root(m_rootPath);
+    for (const QString &name : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        QDateTime time;
+        if (parseSnapshotName(name, &time))
+        {
+            result.append(Snapshot{name, root.filePath(name), time});
+        }
+    }
+    // 同じ秒の世代は "_2" などの番号順にする
+    std::sort(result.begin(), result.end(), [](const Snapshot &a, const Snapshot &b)
+              {
+        if (a.time != b.time) {
+            return a.time < b.time;
+        }
+        return a.name.size() != b.name.size() ? a.name.size() < b.name.size() : a.name < b.name; });
+    return result;
+}
+
+SnapshotStore::Snapshot SnapshotStore::latest() const
+{
+    const QVector<Snapshot> all = snapshots();
+    return all.isEmpty() ? Snapshot() : all.last();
+}
+
+QString SnapshotStore::begin(const QDateTime &time)
+{
+    m_errorString.clear();
+    const QDir root(m_rootPath);
+    const QString base = snapshotName(time);
+    QString name = base;
+    for (int i = 2; root.exists(name) || root.exists(name + QLatin1String(kPartialSuffix)); ++i)
+    {
+        name = base + QStringLiteral("_%1").arg(i);
+    }
+
+    const QString partialPath = root.filePath(name + QLatin1String(kPartialSuffix));
+    if (!root.mkpath(partialPath))
+    {
+        m_errorString = QStringLiteral("Failed to create snapshot directory: %1").arg(partialPath);
+        return QString();
+    }
+    return partialPath;
+}
+
+bool SnapshotStore::finish(const QString &partialPath)
+{
+    m_errorString.clear();
+    if (!partialPath.endsWith(QLatin1String(kPartialSuffix)))
+    {
+        m_errorString = QStringLiteral("Not a partial snapshot: %1").arg(partialPath);
+        return false;
+    }
+    const QString finalPath = partialPath.left(partialPath.size() - int(sizeof(kPartialSuffix) - 1));
+    if (!QDir().rename(partialPath, finalPath))
+    {
+        m_errorString = QStringLiteral("Failed to rename %1 to %2").arg(partialPath, finalPath);
+        return false;
+    }
+    return true;
+}
+
+QStringList SnapshotStore::partialSnapshots() const
+{
+    QStringList result;
+    const QDir root(m_rootPath);
+    for (const QString &name : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        if (name.endsWith(QLatin1String(kPartialSuffix)) &&
+            parseSnapshotName(name.left(name.size() - int(sizeof(kPartialSuffix) - 1)), nullptr))
+        {
+            result.append(root.filePath(name));
+        }
+    }
+    return result;
+}
+
+QString SnapshotStore::retire(const QString &snapshotPath)
+{
+    m_errorString.clear();
+    const QDir root(m_rootPath);
+    const QString retiredPath = root.filePath(QLatin1String(kRetiredPrefix) + QFileInfo(snapshotPath).fileName());
+    if (!QDir().rename(snapshotPath, retiredPath))
+    {
+        m_errorString = QStringLiteral("Failed to rename %1 to %2").arg(snapshotPath, retiredPath);
+        return QString();
+    }
+    return retiredPath;
+}
+
+QStringList SnapshotStore::retiredSnapshots() const
+{
+    QStringList result;
+    const QDir root(m_rootPath);
+    for (const QString &name : root.entryList(QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot))
+    {
+        if (name.startsWith(QLatin1String(kRetiredPrefix)))
+        {
+            result.append(root.filePath(name));
+        }
+    }
+    return result;
+}
+
+QString SnapshotStore::errorString() const
+{
+    return m_errorString;
+}
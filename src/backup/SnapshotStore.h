@@ -0,0 +1,55 @@
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <QString>
+#include <QDateTime>
+#include <QStringList>
+#include <QVector>
+
+// スナップショットモードの保存先。保存先の直下に実行ごとの日時付きフォルダ（世代）を並べ、
+// 変わっていないファイルは前の世代からハードリンクする（rsnapshot や rsync --link-dest と同じ方式）。
+// 作成中の世代は名前に ".partial" を付けておき、最後まで書けたら外す。
+// 途中で止まった世代は一覧に出ず、リンク元にも使われない。
+// 期限切れの世代は先に ".expired-" を付けた名前に変えて一覧から外し、後でゆっくり削除する。
+class SnapshotStore
+{
+public:
+    struct Snapshot
+    {
+        QString name;
+        QString path;
+        QDateTime time; // 名前から読んだ作成日時（ローカル時刻）
+    };
+
+    explicit SnapshotStore(const QString &rootPath);
+
+    // 完了した世代を古い順に返す
+    QVector<Snapshot> snapshots() const;
+    // 最新の完了した世代。なければ name が空
+    Snapshot latest() const;
+
+    // time の世代を作成中として作り、そのパスを返す。失敗したら空
+    QString begin(const QDateTime &time);
+    // begin で作った世代を完了にする
+    bool finish(const QString &partialPath);
+    // 途中で止まった世代（".partial"）のパス
+    QStringList partialSnapshots() const;
+
+    // 世代（作成中のものも可）の名前を変えて一覧から外し、削除待ちにする。変えた後のパスを返す。失敗したら空
+    QString retire(const QString &snapshotPath);
+    // 削除待ちのまま残っている世代のパス
+    QStringList retiredSnapshots() const;
+
+    QString errorString() const;
+
+    // 世代のフォルダ名（"yyyy-MM-dd_HHmmss"。同じ秒に作った場合は後ろに "_2" などが付く）
+    static QString snapshotName(const QDateTime &time);
+    // フォルダ名が世代のものなら true を返し、作成日時を time に入れる
+    static bool parseSnapshotName(const QString &name, QDateTime *time);
+
+private:
+    QString m_rootPath;
+    QString m_errorString;
+};
+
+#endif // SNAPSHOTSTORE_H
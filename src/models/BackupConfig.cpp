@@ -4,12 +4,17 @@
 #include <QJsonArray>
 
 BackupConfig::BackupConfig()
-    : m_lastBackupTime(QDateTime::currentDateTime())
+    : m_lastBackupTime(QDateTime::currentDateTime()), m_durabilityMode(DurabilityNone), m_preCreateDirectories(false),
+      m_updateMode(UpdateFull), m_mirrorDeleteLimit(50), m_verifyMode(VerifyNone),
+      m_backgroundPriority(BackgroundIdle), m_cacheFriendly(false)
 {
 }
 
 BackupConfig::BackupConfig(const QString &name, const QString &sourcePath, const QString &destinationPath)
-    : m_name(name), m_sourcePath(sourcePath), m_destinationPath(destinationPath), m_lastBackupTime(QDateTime::currentDateTime())
+    : m_name(name), m_sourcePath(sourcePath), m_destinationPath(destinationPath), m_lastBackupTime(QDateTime::currentDateTime()),
+      m_durabilityMode(DurabilityNone), m_preCreateDirectories(false),
+      m_updateMode(UpdateFull), m_mirrorDeleteLimit(50), m_verifyMode(VerifyNone),
+      m_backgroundPriority(BackgroundIdle), m_cacheFriendly(false)
 {
 }
 
@@ -83,6 +88,111 @@ void BackupConfig::setExcludedExtensions(const QStringList &extensions)
     m_excludedExtensions = extensions;
 }
 
+BackupConfig::DurabilityMode BackupConfig::durabilityMode() const
+{
+    return m_durabilityMode;
+}
+
+void BackupConfig::setDurabilityMode(DurabilityMode mode)
+{
+    m_durabilityMode = mode;
+}
+
+bool BackupConfig::preCreateDirectories() const
+{
+    return m_preCreateDirectories;
+}
+
+void BackupConfig::setPreCreateDirectories(bool enabled)
+{
+    m_preCreateDirectories = enabled;
+}
+
+BackupConfig::UpdateMode BackupConfig::updateMode() const
+{
+    return m_updateMode;
+}
+
+void BackupConfig::setUpdateMode(UpdateMode mode)
+{
+    m_updateMode = mode;
+}
+
+int BackupConfig::mirrorDeleteLimit() const
+{
+    return m_mirrorDeleteLimit;
+}
+
+void BackupConfig::setMirrorDeleteLimit(int percent)
+{
+    m_mirrorDeleteLimit = qBound(0, percent, 100);
+}
+
+BackupConfig::Retention BackupConfig::retention() const
+{
+    return m_retention;
+}
+
+void BackupConfig::setRetention(const Retention &retention)
+{
+    m_retention.hourly = qMax(0, retention.hourly);
+    m_retention.daily = qMax(0, retention.daily);
+    m_retention.weekly = qMax(0, retention.weekly);
+}
+
+BackupConfig::VerifyMode BackupConfig::verifyMode() const
+{
+    return m_verifyMode;
+}
+
+void BackupConfig::setVerifyMode(VerifyMode mode)
+{
+    m_verifyMode = mode;
+}
+
+BackupConfig::ScrubState BackupConfig::scrubState() const
+{
+    return m_scrubState;
+}
+
+void BackupConfig::setScrubState(const ScrubState &state)
+{
+    m_scrubState = state;
+}
+
+bool BackupConfig::cacheFriendly() const
+{
+    return m_cacheFriendly;
+}
+
+void BackupConfig::setCacheFriendly(bool enabled)
+{
+    m_cacheFriendly = enabled;
+}
+
+BackupConfig::BackgroundPriority BackupConfig::backgroundPriority() const
+{
+    return m_backgroundPriority;
+}
+
+void BackupConfig::setBackgroundPriority(BackgroundPriority priority)
+{
+    m_backgroundPriority = priority;
+}
+
+BackupConfig::IoLimits BackupConfig::ioLimits() const
+{
+    return m_ioLimits;
+}
+
+void BackupConfig::setIoLimits(const IoLimits &limits)
+{
+    m_ioLimits.readMBps = qMax(0, limits.readMBps);
+    m_ioLimits.writeMBps = qMax(0, limits.writeMBps);
+    m_ioLimits.iops = qMax(0, limits.iops);
+    m_ioLimits.adaptive = limits.adaptive;
+}
+
 QJsonObject BackupConfig::extraData() const
 {
     return m_extraData;
@@ -131,6 +241,33 @@ QJsonObject BackupConfig::toJson() const
         json["excludedExtensions"] = extensionsArray;
     }
 
+    json["durabilityMode"] = static_cast<int>(m_durabilityMode);
+    json["preCreateDirectories"] = m_preCreateDirectories;
+    json["updateMode"] = static_cast<int>(m_updateMode);
+    json["mirrorDeleteLimit"] = m_mirrorDeleteLimit;
+    json["retentionHourly"] = m_retention.hourly;
+    json["retentionDaily"] = m_retention.daily;
+    json["retentionWeekly"] = m_retention.weekly;
+    json["verifyMode"] = static_cast<int>(m_verifyMode);
+    json["scrubPosition"] = m_scrubState.position;
+    json["scrubTotalEntries"] = m_scrubState.totalEntries;
+    json["scrubPassProblems"] = m_scrubState.passProblems;
+    json["scrubLastPassProblems"] = m_scrubState.lastPassProblems;
+    if (m_scrubState.lastRun.isValid())
+    {
+        json["scrubLastRun"] = m_scrubState.lastRun.toString(Qt::ISODate);
+    }
+    if (m_scrubState.lastPassCompleted.isValid())
+    {
+        json["scrubLastPassCompleted"] = m_scrubState.lastPassCompleted.toString(Qt::ISODate);
+    }
+    json["ioReadLimit"] = m_ioLimits.readMBps;
+    json["ioWriteLimit"] = m_ioLimits.writeMBps;
+    json["ioIopsLimit"] = m_ioLimits.iops;
+    json["ioAdaptive"] = m_ioLimits.adaptive;
+    json["backgroundPriority"] = static_cast<int>(m_backgroundPriority);
+    json["cacheFriendly"] = m_cacheFriendly;
+
     // 追加データを保存
     json["extraData"] = m_extraData;
 
@@ -182,6 +319,65 @@ BackupConfig BackupConfig::fromJson(const QJsonObject &json)
         config.setExcludedExtensions(extensions);
     }
 
+    if (json.contains("durabilityMode"))
+    {
+        config.m_durabilityMode = static_cast<DurabilityMode>(json["durabilityMode"].toInt());
+    }
+
+    if (json.contains("preCreateDirectories"))
+    {
+        config.m_preCreateDirectories = json["preCreateDirectories"].toBool();
+    }
+
+    if (json.contains("updateMode"))
+    {
+        config.m_updateMode = static_cast<UpdateMode>(json["updateMode"].toInt());
+    }
+
+    if (json.contains("mirrorDeleteLimit"))
+    {
+        config.setMirrorDeleteLimit(json["mirrorDeleteLimit"].toInt());
+    }
+
+    Retention retention;
+    retention.hourly = json["retentionHourly"].toInt();
+    retention.daily = json["retentionDaily"].toInt();
+    retention.weekly = json["retentionWeekly"].toInt();
+    config.setRetention(retention);
+
+    if (json.contains("verifyMode"))
+    {
+        config.m_verifyMode = static_cast<VerifyMode>(json["verifyMode"].toInt());
+    }
+
+    ScrubState scrub;
+    scrub.position = json["scrubPosition"].toInteger();
+    scrub.totalEntries = json["scrubTotalEntries"].toInteger();
+    scrub.passProblems = json["scrubPassProblems"].toInt();
+    scrub.lastPassProblems = json["scrubLastPassProblems"].toInt();
+    if (json.contains("scrubLastRun"))
+    {
+        scrub.lastRun = QDateTime::fromString(json["scrubLastRun"].toString(), Qt::ISODate);
+    }
+    if (json.contains("scrubLastPassCompleted"))
+    {
+        scrub.lastPassCompleted = QDateTime::fromString(json["scrubLastPassCompleted"].toString(), Qt::ISODate);
+    }
+    config.m_scrubState = scrub;
+
+    IoLimits ioLimits;
+    ioLimits.readMBps = json["ioReadLimit"].toInt();
+    ioLimits.writeMBps = json["ioWriteLimit"].toInt();
+    ioLimits.iops = json["ioIopsLimit"].toInt();
+    ioLimits.adaptive = json["ioAdaptive"].toBool();
+    config.setIoLimits(ioLimits);
+
+    if (json.contains("backgroundPriority"))
+    {
+        config.m_backgroundPriority = static_cast<BackgroundPriority>(json["backgroundPriority"].toInt());
+    }
+    config.m_cacheFriendly = json["cacheFriendly"].toBool();
+
     // 追加データを読み込み
     if (json.contains("extraData"))
     {
@@ -9,6 +9,76 @@
 class BackupConfig
 {
 public:
+    // 書き込みの永続化レベル
+    enum DurabilityMode
+    {
+        DurabilityNone = 0,        // fsyncしない（最速）
+        DurabilityEndOfRun = 1,    // 実行終了時にsyncfsを1回だけ行う
+        DurabilityPerFile = 2,     // ファイルごとにfsyncする（最も安全）
+        DurabilityPerDirectory = 3 // ディレクトリ単位でまとめてバックグラウンドでfsyncする
+    };
+
+    // 保存先の更新方法
+    enum UpdateMode
+    {
+        UpdateFull = 0,       // 毎回すべてのファイルをコピーする
+        UpdateIncremental = 1, // 前回のマニフェストと比べ、追加・変更されたファイルだけコピーする
+        UpdateMirror = 2,      // 差分コピーに加え、バックアップ元からなくなったファイルを保存先から削除する
+        UpdateSnapshot = 3     // 実行ごとに日時付きの世代を作り、変わっていないファイルは前の世代からハードリンクする
+    };
+
+    // 検証の方法
+    enum VerifyMode
+    {
+        VerifyNone = 0,     // 定期検証の対象にしない（手動ではメタデータで検証する）
+        VerifyMetadata = 1, // 保存先にあるか・サイズが同じかを比べる
+        VerifyContent = 2   // 加えて内容のハッシュを比べる
+    };
+
+    // 自動実行（スケジュール）のときの I/O・CPU の優先度（手動の実行は常に通常）。
+    // 値は ThreadPriority::Class と同じ
+    enum BackgroundPriority
+    {
+        BackgroundNormal = 0, // 下げない
+        BackgroundLow = 1,    // 低い（I/O は best-effort の最低、CPU は nice）
+        BackgroundIdle = 2    // ほかに使う処理がないときだけ（I/O は idle、CPU は SCHED_IDLE）
+    };
+
+    // スナップショットの世代の保持数。各期間（時・日・週）ごとに最新の世代を指定の数だけ残す。
+    // すべて 0 なら世代を削除しない
+    struct Retention
+    {
+        int hourly = 0;
+        int daily = 0;
+        int weekly = 0;
+
+        bool isEnabled() const { return hourly > 0 || daily > 0 || weekly > 0; }
+    };
+
+    // 保存先の定期点検（スクラブ）の進み具合と結果。点検は少しずつ進めるので、次の位置を覚えておく
+    struct ScrubState
+    {
+        qint64 position = 0;       // 次に点検するマニフェストの項目の番号
+        qint64 totalEntries = 0;   // 前回見たときのマニフェストの項目数
+        int passProblems = 0;      // 今の一巡で見つかった壊れた・読めないファイルの数
+        int lastPassProblems = 0;  // 最後に終えた一巡で見つかった数
+        QDateTime lastRun;         // 最後に点検した日時
+        QDateTime lastPassCompleted; // 最後に一巡を終えた日時
+
+        bool hasProblems() const { return passProblems > 0 || lastPassProblems > 0; }
+    };
+
+    // 読み書きの速さの上限。0 なら制限しない。adaptive ならディスクが混んできたときに自動で下げる
+    struct IoLimits
+    {
+        int readMBps = 0;
+        int writeMBps = 0;
+        int iops = 0;
+        bool adaptive = false;
+
+        bool isEnabled() const { return readMBps > 0 || writeMBps > 0 || iops > 0 || adaptive; }
+    };
+
     BackupConfig();
     BackupConfig(const QString &name, const QString &sourcePath, const QString &destinationPath);
 
@@ -34,6 +104,46 @@ public:
     QStringList excludedExtensions() const;
     void setExcludedExtensions(const QStringList &extensions);
 
+    // 書き込みの永続化レベル
+    DurabilityMode durabilityMode() const;
+    void setDurabilityMode(DurabilityMode mode);
+
+    // コピー前に保存先のフォルダ構成をまとめて（並列に）作成するか
+    bool preCreateDirectories() const;
+    void setPreCreateDirectories(bool enabled);
+
+    // 保存先の更新方法
+    UpdateMode updateMode() const;
+    void setUpdateMode(UpdateMode mode);
+
+    // ミラー時、前回のファイル数に対してこの割合（%）を超えて削除することになる場合は削除を中止する
+    int mirrorDeleteLimit() const;
+    void setMirrorDeleteLimit(int percent);
+
+    // スナップショットの世代の保持数
+    Retention retention() const;
+    void setRetention(const Retention &retention);
+
+    // 検証の方法
+    VerifyMode verifyMode() const;
+    void setVerifyMode(VerifyMode mode);
+
+    // 保存先の定期点検の状態
+    ScrubState scrubState() const;
+    void setScrubState(const ScrubState &state);
+
+    // 読み書きしたファイルをページキャッシュに残さない（ほかのアプリのキャッシュを追い出さない）
+    bool cacheFriendly() const;
+    void setCacheFriendly(bool enabled);
+
+    // 自動実行のときの優先度
+    BackgroundPriority backgroundPriority() const;
+    void setBackgroundPriority(BackgroundPriority priority);
+
+    // 読み書きの速さの上限（全体の上限とあわせて守る）
+    IoLimits ioLimits() const;
+    void setIoLimits(const IoLimits &limits);
+
     // 追加: JSON形式の追加データ
     QJsonObject extraData() const;
     void setExtraData(const QJsonObject &data);
@@ -53,6 +163,17 @@ private:
     QStringList m_excludedFolders;
     QStringList m_excludedExtensions;
 
+    DurabilityMode m_durabilityMode;
+    bool m_preCreateDirectories;
+    UpdateMode m_updateMode;
+    int m_mirrorDeleteLimit;
+    Retention m_retention;
+    VerifyMode m_verifyMode;
+    ScrubState m_scrubState;
+    IoLimits m_ioLimits;
+    BackgroundPriority m_backgroundPriority;
+    bool m_cacheFriendly;
+
     // 追加データ
     QJsonObject m_extraData;
 };
@@ -5,7 +5,13 @@ BackupScheduler::BackupScheduler(QObject *parent)
     : QObject(parent),
       m_scheduleEnabled(false),
       m_periodicEnabled(false),
-      m_periodicInterval(8) // デフォルトは8時間
+      m_periodicInterval(8), // デフォルトは8時間
+      m_verifyEnabled(false),
+      m_verifyInterval(7),
+      m_scrubEnabled(false),
+      m_scrubInterval(1),
+      m_scrubSliceMinutes(10),
+      m_scrubRateLimit(20)
 {
     // タイマー設定
     m_dailyTimer.setSingleShot(true);     // 一日一回
@@ -14,6 +20,10 @@ BackupScheduler::BackupScheduler(QObject *parent)
     // シグナル/スロット接続
     connect(&m_dailyTimer, &QTimer::timeout, this, &BackupScheduler::dailyTimerTimeout);
     connect(&m_periodicTimer, &QTimer::timeout, this, &BackupScheduler::periodicTimerTimeout);
+    connect(&m_verifyTimer, &QTimer::timeout, this, &BackupScheduler::verifyTimerTimeout);
+    m_verifyTimer.setInterval(60 * 60 * 1000);
+    connect(&m_scrubTimer, &QTimer::timeout, this, &BackupScheduler::scrubTimerTriggered);
+    m_scrubTimer.setInterval(m_scrubInterval * 60 * 60 * 1000);
 
     // 次回バックアップ時間を無効な状態で初期化
     m_nextBackupTime = QDateTime();
@@ -72,6 +82,115 @@ void BackupScheduler::setPeriodicInterval(int hours)
     }
 }
 
+bool BackupScheduler::isVerifyScheduleEnabled() const
+{
+    return m_verifyEnabled;
+}
+
+void BackupScheduler::setVerifyScheduleEnabled(bool enabled)
+{
+    m_verifyEnabled = enabled;
+    if (enabled)
+    {
+        m_verifyTimer.start();
+    }
+    else
+    {
+        m_verifyTimer.stop();
+    }
+}
+
+int BackupScheduler::verifyInterval() const
+{
+    return m_verifyInterval;
+}
+
+void BackupScheduler::setVerifyInterval(int days)
+{
+    if (days > 0)
+    {
+        m_verifyInterval = days;
+    }
+}
+
+QDateTime BackupScheduler::lastVerifyTime() const
+{
+    return m_lastVerifyTime;
+}
+
+void BackupScheduler::setLastVerifyTime(const QDateTime &time)
+{
+    m_lastVerifyTime = time;
+}
+
+QDateTime BackupScheduler::nextVerifyTime() const
+{
+    if (!m_verifyEnabled)
+    {
+        return QDateTime();
+    }
+    // まだ一度も検証していなければ次の確認で実行する
+    return m_lastVerifyTime.isValid() ? m_lastVerifyTime.addDays(m_verifyInterval) : QDateTime::currentDateTime();
+}
+
+bool BackupScheduler::isScrubEnabled() const
+{
+    return m_scrubEnabled;
+}
+
+void BackupScheduler::setScrubEnabled(bool enabled)
+{
+    m_scrubEnabled = enabled;
+    if (enabled)
+    {
+        m_scrubTimer.start();
+    }
+    else
+    {
+        m_scrubTimer.stop();
+    }
+}
+
+int BackupScheduler::scrubInterval() const
+{
+    return m_scrubInterval;
+}
+
+void BackupScheduler::setScrubInterval(int hours)
+{
+    if (hours > 0)
+    {
+        m_scrubInterval = hours;
+        m_scrubTimer.setInterval(hours * 60 * 60 * 1000);
+    }
+}
+
+int BackupScheduler::scrubSliceMinutes() const
+{
+    return m_scrubSliceMinutes;
+}
+
+void BackupScheduler::setScrubSliceMinutes(int minutes)
+{
+    if (minutes > 0)
+    {
+        m_scrubSliceMinutes = minutes;
+    }
+}
+
+int BackupScheduler::scrubRateLimit() const
+{
+    return m_scrubRateLimit;
+}
+
+void BackupScheduler::setScrubRateLimit(int megabytesPerSecond)
+{
+    if (megabytesPerSecond > 0)
+    {
+        m_scrubRateLimit = megabytesPerSecond;
+    }
+}
+
 QDateTime BackupScheduler::calculateNextBackupTime() const
 {
     QDateTime nextBackupTime;
@@ -181,4 +300,17 @@ void BackupScheduler::periodicTimerTimeout()
     // periodicTimerはsingleShotではないので自動的に再開します
     // ただし設定を更新するために一応updateTimersを呼ぶ
     updateTimers();
-}
\ No newline at end of file
+}
+void BackupScheduler::verifyTimerTimeout()
+{
+    if (!m_verifyEnabled || QDateTime::currentDateTime() < nextVerifyTime())
+    {
+        return;
+    }
+
+    qDebug() << "定期検証がトリガーされました: " << m_verifyInterval << "日ごと";
+
+    // 実行の成否にかかわらず次は間隔をあける（失敗しても1時間ごとに繰り返さない）
+    m_lastVerifyTime = QDateTime::currentDateTime();
+    emit verifyTimerTriggered();
+}
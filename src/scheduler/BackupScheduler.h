@@ -25,6 +25,25 @@ public:
     int periodicInterval() const;
     void setPeriodicInterval(int hours);
 
+    // 定期検証（日数ごと）。前回の検証からの日数で判定するので、アプリを再起動しても間隔は保たれる
+    bool isVerifyScheduleEnabled() const;
+    void setVerifyScheduleEnabled(bool enabled);
+    int verifyInterval() const;
+    void setVerifyInterval(int days);
+    QDateTime lastVerifyTime() const;
+    void setLastVerifyTime(const QDateTime &time);
+    QDateTime nextVerifyTime() const;
+
+    // 保存先の定期点検（スクラブ）。interval 時間ごとに sliceMinutes 分だけ、rateLimit MB/s 以下で少しずつ進める
+    bool isScrubEnabled() const;
+    void setScrubEnabled(bool enabled);
+    int scrubInterval() const;
+    void setScrubInterval(int hours);
+    int scrubSliceMinutes() const;
+    void setScrubSliceMinutes(int minutes);
+    int scrubRateLimit() const;
+    void setScrubRateLimit(int megabytesPerSecond);
+
     // スケジュール計算
     QDateTime calculateNextBackupTime() const;
     QDateTime nextBackupTime() const; // 追加: 次回バックアップ時間を取得するメソッド
@@ -32,10 +51,13 @@ public:
 signals:
     void backupTimerTriggered();                           // 追加: バックアップのトリガーシグナル
     void nextBackupTimeChanged(const QDateTime &nextTime); // 追加: 次回バックアップ時間変更シグナル
+    void verifyTimerTriggered();
+    void scrubTimerTriggered();
 
 private slots:
     void dailyTimerTimeout();    // 追加: 日次タイマータイムアウト
     void periodicTimerTimeout(); // 追加: 定期タイマータイムアウト
+    void verifyTimerTimeout();
 
 private:
     void updateTimers(); // 追加: タイマー更新メソッド
@@ -43,6 +65,8 @@ private:
     // 追加: タイマーメンバー変数
     QTimer m_dailyTimer;    // 日次バックアップ用タイマー
     QTimer m_periodicTimer; // 定期バックアップ用タイマー
+    QTimer m_verifyTimer;   // 定期検証の時期かを確かめるタイマー（間隔が長いので1時間ごとに確かめる）
+    QTimer m_scrubTimer;    // 定期点検を少しずつ進めるタイマー
 
     // 既存のメンバー変数
     bool m_scheduleEnabled;
@@ -50,6 +74,13 @@ private:
     bool m_periodicEnabled;
     int m_periodicInterval;
     QDateTime m_nextBackupTime; // 追加: 次回バックアップ時間を保存するメンバ変数
+    bool m_verifyEnabled;
+    int m_verifyInterval; // 日
+    QDateTime m_lastVerifyTime;
+    bool m_scrubEnabled;
+    int m_scrubInterval;     // 時間
+    int m_scrubSliceMinutes; // 分
+    int m_scrubRateLimit;    // MB/s
 };
 
 #endif // BACKUPSCHEDULER_H
\ No newline at end of file
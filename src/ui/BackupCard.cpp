@@ -87,7 +87,18 @@ void BackupCard::setupUI()
     m_lastBackupLabel = new QLabel(lastBackupInfo, this);
     m_lastBackupLabel->setFont(smallFont);
     m_lastBackupLabel->setAlignment(Qt::AlignRight);
-    mainLayout->addWidget(m_lastBackupLabel);
+
+    // 保存先の点検結果（左）と最終バックアップ日時（右）を1行に並べる
+    m_healthLabel = new QLabel(this);
+    m_healthLabel->setFont(smallFont);
+    updateHealthLabel();
+
+    QHBoxLayout *statusLayout = new QHBoxLayout();
+    statusLayout->setSpacing(3);
+    statusLayout->addWidget(m_healthLabel);
+    statusLayout->addStretch();
+    statusLayout->addWidget(m_lastBackupLabel);
+    mainLayout->addLayout(statusLayout);
 
     // プログレスバー
     m_progressBar = new QProgressBar(this);
@@ -103,21 +114,29 @@ void BackupCard::setupUI()
 
     m_backupButton = new QPushButton(tr("実行"), this);
     m_editButton = new QPushButton(tr("編集"), this); // 追加: 編集ボタン
+    m_restoreButton = new QPushButton(tr("復元"), this);
+    m_verifyButton = new QPushButton(tr("検証"), this);
     m_removeButton = new QPushButton(tr("削除"), this);
 
     // ボタンを小さく
     m_backupButton->setFixedHeight(22);
     m_editButton->setFixedHeight(22); // 追加
+    m_restoreButton->setFixedHeight(22);
+    m_verifyButton->setFixedHeight(22);
     m_removeButton->setFixedHeight(22);
 
     QFont buttonFont = m_backupButton->font();
     buttonFont.setPointSize(8);
     m_backupButton->setFont(buttonFont);
     m_editButton->setFont(buttonFont); // 追加
+    m_restoreButton->setFont(buttonFont);
+    m_verifyButton->setFont(buttonFont);
     m_removeButton->setFont(buttonFont);
 
     buttonLayout->addWidget(m_backupButton);
     buttonLayout->addWidget(m_editButton); // 追加
+    buttonLayout->addWidget(m_restoreButton);
+    buttonLayout->addWidget(m_verifyButton);
     buttonLayout->addWidget(m_removeButton);
     mainLayout->addLayout(buttonLayout);
 
@@ -128,6 +147,12 @@ void BackupCard::setupUI()
     connect(m_editButton, &QPushButton::clicked, [this]() // 追加: 編集ボタン接続
             { emit editBackup(m_index); });
 
+    connect(m_restoreButton, &QPushButton::clicked, [this]()
+            { emit restoreBackup(m_index); });
+
+    connect(m_verifyButton, &QPushButton::clicked, [this]()
+            { emit verifyBackup(m_index); });
+
     connect(m_removeButton, &QPushButton::clicked, [this]()
             { emit removeBackup(m_index); });
 
@@ -174,6 +199,60 @@ void BackupCard::resetProgress()
     }
 }
 
+void BackupCard::setScrubState(const BackupConfig::ScrubState &state)
+{
+    m_config.setScrubState(state);
+    updateHealthLabel();
+}
+
+void BackupCard::updateHealthLabel()
+{
+    const BackupConfig::ScrubState state = m_config.scrubState();
+    QString text;
+    QColor color;
+    if (state.hasProblems())
+    {
+        text = tr("● 破損 %1").arg(state.passProblems + state.lastPassProblems);
+        color = QColor(198, 40, 40);
+    }
+    else if (state.lastPassCompleted.isValid())
+    {
+        text = tr("● 正常");
+        color = QColor(46, 125, 50);
+    }
+    else if (state.lastRun.isValid() && state.totalEntries > 0)
+    {
+        text = tr("● 点検中 %1%").arg(state.position * 100 / state.totalEntries);
+        color = QColor(21, 101, 192);
+    }
+    else
+    {
+        text = tr("● 未点検");
+        color = QColor(117, 117, 117);
+    }
+    m_healthLabel->setText(text);
+    QPalette healthPal = m_healthLabel->palette();
+    healthPal.setColor(QPalette::WindowText, color);
+    m_healthLabel->setPalette(healthPal);
+
+    QString toolTip = tr("保存先の定期点検");
+    if (state.lastRun.isValid())
+    {
+        toolTip += tr("\n最終点検: %1").arg(state.lastRun.toString("yyyy/MM/dd HH:mm"));
+    }
+    if (state.lastPassCompleted.isValid())
+    {
+        toolTip += tr("\n最後に一巡した日時: %1（破損・読み込みエラー %2 件）")
+                       .arg(state.lastPassCompleted.toString("yyyy/MM/dd HH:mm"))
+                       .arg(state.lastPassProblems);
+    }
+    if (state.passProblems > 0)
+    {
+        toolTip += tr("\n今回の一巡で見つかった破損・読み込みエラー: %1 件").arg(state.passProblems);
+    }
+    m_healthLabel->setToolTip(toolTip);
+}
+
 void BackupCard::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
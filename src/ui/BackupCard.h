@@ -25,17 +25,21 @@ public:
     void updateProgress(int progress);
     void resetProgress();
     void setProgress(int value); // 追加：進捗を設定するメソッド
+    void setScrubState(const BackupConfig::ScrubState &state); // 保存先の点検結果を表示に反映
 
 signals:
     void runBackup(const BackupConfig &config);
     void removeBackup(int index);
     void editBackup(int index); // 追加: 編集シグナル
+    void restoreBackup(int index);
+    void verifyBackup(int index);
 
 protected:
     void resizeEvent(QResizeEvent *event) override; // 追加
 
 private:
     void setupUI();
+    void updateHealthLabel();
 
     BackupConfig m_config;
     int m_index;
@@ -43,8 +47,11 @@ private:
     QLabel *m_titleLabel;
     QLabel *m_pathLabel;
     QLabel *m_lastBackupLabel;
+    QLabel *m_healthLabel; // 保存先の点検結果（正常・破損あり・未点検）
     QPushButton *m_backupButton;
     QPushButton *m_editButton; // 追加: 編集ボタン
+    QPushButton *m_restoreButton;
+    QPushButton *m_verifyButton;
     QPushButton *m_removeButton;
     QProgressBar *m_progressBar;
 };
@@ -161,6 +161,112 @@ void BackupDialog::setupUI()
             saveDataFoldersEdit->setEnabled(true);
         } });
 
+    // 詳細設定タブ
+    QWidget *advancedTab = new QWidget(tabWidget);
+    QFormLayout *advancedLayout = new QFormLayout(advancedTab);
+
+    // 書き込みの永続化レベル
+    durabilityCombo = new QComboBox(advancedTab);
+    durabilityCombo->addItem(tr("同期しない（最速）"), BackupConfig::DurabilityNone);
+    durabilityCombo->addItem(tr("終了時にまとめて同期"), BackupConfig::DurabilityEndOfRun);
+    durabilityCombo->addItem(tr("フォルダごとに同期（バックグラウンド）"), BackupConfig::DurabilityPerDirectory);
+    durabilityCombo->addItem(tr("ファイルごとに同期（最も安全）"), BackupConfig::DurabilityPerFile);
+    durabilityCombo->setToolTip(tr("停電などでバックアップ直後のデータが失われないよう、ディスクへの書き出しを待つタイミングを選びます"));
+    advancedLayout->addRow(tr("書き込みの安全性:"), durabilityCombo);
+
+    // フォルダ構成の事前作成
+    preCreateDirectoriesCheck = new QCheckBox(tr("コピー前にフォルダ構成をまとめて作成する"), advancedTab);
+    preCreateDirectoriesCheck->setToolTip(tr("フォルダの多いバックアップで、保存先のフォルダを先に並列で作成してからファイルをコピーします"));
+    advancedLayout->addRow(QString(), preCreateDirectoriesCheck);
+
+    // 保存先の更新方法
+    updateModeCombo = new QComboBox(advancedTab);
+    updateModeCombo->addItem(tr("毎回すべてコピー"), BackupConfig::UpdateFull);
+    updateModeCombo->addItem(tr("追加・変更されたファイルだけコピー（差分）"), BackupConfig::UpdateIncremental);
+    updateModeCombo->addItem(tr("バックアップ元と同じにする（ミラー・削除あり）"), BackupConfig::UpdateMirror);
+    updateModeCombo->addItem(tr("世代を残す（スナップショット・変更のないファイルはハードリンク）"), BackupConfig::UpdateSnapshot);
+    updateModeCombo->setToolTip(tr("前回のバックアップで保存先に記録したファイル一覧と比べ、サイズか更新日時が変わったファイルだけをコピーします"));
+    advancedLayout->addRow(tr("更新方法:"), updateModeCombo);
+
+    // ミラー時の削除の上限
+    mirrorDeleteLimitSpin = new QSpinBox(advancedTab);
+    mirrorDeleteLimitSpin->setRange(0, 100);
+    mirrorDeleteLimitSpin->setSuffix(tr(" %"));
+    mirrorDeleteLimitSpin->setValue(50);
+    mirrorDeleteLimitSpin->setToolTip(tr("前回のバックアップのファイル数に対して、これを超える割合のファイルを削除することになる場合は削除を中止します（バックアップ元の取り違えなどへの安全策）"));
+    mirrorDeleteLimitSpin->setEnabled(false);
+    advancedLayout->addRow(tr("削除の上限:"), mirrorDeleteLimitSpin);
+
+    // スナップショットの世代の保持数
+    QHBoxLayout *retentionLayout = new QHBoxLayout();
+    retentionHourlySpin = new QSpinBox(advancedTab);
+    retentionHourlySpin->setPrefix(tr("毎時 "));
+    retentionDailySpin = new QSpinBox(advancedTab);
+    retentionDailySpin->setPrefix(tr("毎日 "));
+    retentionWeeklySpin = new QSpinBox(advancedTab);
+    retentionWeeklySpin->setPrefix(tr("毎週 "));
+    for (QSpinBox *spin : {retentionHourlySpin, retentionDailySpin, retentionWeeklySpin})
+    {
+        spin->setRange(0, 999);
+        spin->setToolTip(tr("それぞれの期間ごとに最新の世代を、この数の期間ぶん残します。すべて 0 なら世代を削除しません（古い世代はバックグラウンドで削除します）"));
+        spin->setEnabled(false);
+        retentionLayout->addWidget(spin);
+    }
+    advancedLayout->addRow(tr("世代の保持:"), retentionLayout);
+
+    // 検証の方法（定期検証の対象にするか）
+    verifyModeCombo = new QComboBox(advancedTab);
+    verifyModeCombo->addItem(tr("定期検証しない"), BackupConfig::VerifyNone);
+    verifyModeCombo->addItem(tr("メタデータ（存在とサイズ）"), BackupConfig::VerifyMetadata);
+    verifyModeCombo->addItem(tr("内容（ハッシュ）"), BackupConfig::VerifyContent);
+    verifyModeCombo->setToolTip(tr("保存先がバックアップ元と一致しているかの確かめ方です。内容の検証では確かめたハッシュを保存先に記録し、次回からは元を読み直しません"));
+    advancedLayout->addRow(tr("検証:"), verifyModeCombo);
+
+    // 読み書きの速さの上限（全体の上限とあわせて守る）
+    QHBoxLayout *ioLimitLayout = new QHBoxLayout();
+    readLimitSpin = new QSpinBox(advancedTab);
+    readLimitSpin->setPrefix(tr("読み "));
+    readLimitSpin->setSuffix(tr(" MB/s"));
+    writeLimitSpin = new QSpinBox(advancedTab);
+    writeLimitSpin->setPrefix(tr("書き "));
+    writeLimitSpin->setSuffix(tr(" MB/s"));
+    iopsLimitSpin = new QSpinBox(advancedTab);
+    iopsLimitSpin->setSuffix(tr(" IOPS"));
+    for (QSpinBox *spin : {readLimitSpin, writeLimitSpin, iopsLimitSpin})
+    {
+        spin->setRange(0, 100000);
+        spin->setSpecialValueText(tr("制限なし"));
+        spin->setToolTip(tr("このバックアップの読み書きの上限です。0 なら制限しません。実行中に変更するとすぐに反映されます"));
+        ioLimitLayout->addWidget(spin);
+    }
+    advancedLayout->addRow(tr("速さの上限:"), ioLimitLayout);
+    adaptiveThrottleCheck = new QCheckBox(tr("ディスクが混んできたら自動で速さを下げる"), advancedTab);
+    adaptiveThrottleCheck->setToolTip(tr("ディスクの応答が遅くなったら（ほかのアプリが使っているとき）、コピーの速さを下げて譲ります"));
+    advancedLayout->addRow(QString(), adaptiveThrottleCheck);
+
+    cacheFriendlyCheck = new QCheckBox(tr("コピーしたファイルをメモリのキャッシュに残さない"), advancedTab);
+    cacheFriendlyCheck->setToolTip(tr("大量のコピーでほかのアプリのキャッシュを追い出さないように、読み書きが済んだ範囲をすぐにキャッシュから外します。書き込みはディスクへの書き出しを待つので少し遅くなります"));
+    advancedLayout->addRow(QString(), cacheFriendlyCheck);
+
+    // 自動実行のときの優先度（手動で実行したときは常に通常）
+    backgroundPriorityCombo = new QComboBox(advancedTab);
+    backgroundPriorityCombo->addItem(tr("通常"), BackupConfig::BackgroundNormal);
+    backgroundPriorityCombo->addItem(tr("低い"), BackupConfig::BackgroundLow);
+    backgroundPriorityCombo->addItem(tr("ほかの処理がないときだけ"), BackupConfig::BackgroundIdle);
+    backgroundPriorityCombo->setToolTip(tr("スケジュールで自動実行するときのディスクと CPU の優先度です。手動で実行したときは通常の優先度で動きます"));
+    backgroundPriorityCombo->setCurrentIndex(backgroundPriorityCombo->findData(BackupConfig::BackgroundIdle));
+    advancedLayout->addRow(tr("自動実行の優先度:"), backgroundPriorityCombo);
+
+    connect(updateModeCombo, &QComboBox::currentIndexChanged, [this]()
+            {
+        const int mode = updateModeCombo->currentData().toInt();
+        mirrorDeleteLimitSpin->setEnabled(mode == BackupConfig::UpdateMirror);
+        for (QSpinBox *spin : {retentionHourlySpin, retentionDailySpin, retentionWeeklySpin}) {
+            spin->setEnabled(mode == BackupConfig::UpdateSnapshot);
+        } });
+
+    tabWidget->addTab(advancedTab, tr("詳細設定"));
+
     // メインレイアウトにタブを追加
     mainLayout->addWidget(tabWidget);
 
@@ -198,6 +304,22 @@ void BackupDialog::loadFromConfig(const BackupConfig &config)
     excludedFoldersEdit->setPlainText(config.excludedFolders().join("\n"));
     excludedExtensionsEdit->setPlainText(config.excludedExtensions().join("\n"));
 
+    // 詳細設定
+    durabilityCombo->setCurrentIndex(qMax(0, durabilityCombo->findData(config.durabilityMode())));
+    preCreateDirectoriesCheck->setChecked(config.preCreateDirectories());
+    updateModeCombo->setCurrentIndex(qMax(0, updateModeCombo->findData(config.updateMode())));
+    mirrorDeleteLimitSpin->setValue(config.mirrorDeleteLimit());
+    retentionHourlySpin->setValue(config.retention().hourly);
+    retentionDailySpin->setValue(config.retention().daily);
+    retentionWeeklySpin->setValue(config.retention().weekly);
+    verifyModeCombo->setCurrentIndex(qMax(0, verifyModeCombo->findData(config.verifyMode())));
+    readLimitSpin->setValue(config.ioLimits().readMBps);
+    writeLimitSpin->setValue(config.ioLimits().writeMBps);
+    iopsLimitSpin->setValue(config.ioLimits().iops);
+    adaptiveThrottleCheck->setChecked(config.ioLimits().adaptive);
+    backgroundPriorityCombo->setCurrentIndex(qMax(0, backgroundPriorityCombo->findData(config.backgroundPriority())));
+    cacheFriendlyCheck->setChecked(config.cacheFriendly());
+
     // バックアップモードの設定
     if (config.extraData().contains("backupMode"))
     {
@@ -256,6 +378,26 @@ BackupConfig BackupDialog::getBackupConfig() const
         }
         config.setExcludedExtensions(excludedExtensions);
 
+        // 詳細設定
+        config.setDurabilityMode(static_cast<BackupConfig::DurabilityMode>(durabilityCombo->currentData().toInt()));
+        config.setPreCreateDirectories(preCreateDirectoriesCheck->isChecked());
+        config.setUpdateMode(static_cast<BackupConfig::UpdateMode>(updateModeCombo->currentData().toInt()));
+        config.setMirrorDeleteLimit(mirrorDeleteLimitSpin->value());
+        BackupConfig::Retention retention;
+        retention.hourly = retentionHourlySpin->value();
+        retention.daily = retentionDailySpin->value();
+        retention.weekly = retentionWeeklySpin->value();
+        config.setRetention(retention);
+        config.setVerifyMode(static_cast<BackupConfig::VerifyMode>(verifyModeCombo->currentData().toInt()));
+        BackupConfig::IoLimits ioLimits;
+        ioLimits.readMBps = readLimitSpin->value();
+        ioLimits.writeMBps = writeLimitSpin->value();
+        ioLimits.iops = iopsLimitSpin->value();
+        ioLimits.adaptive = adaptiveThrottleCheck->isChecked();
+        config.setIoLimits(ioLimits);
+        config.setCacheFriendly(cacheFriendlyCheck->isChecked());
+        config.setBackgroundPriority(static_cast<BackupConfig::BackgroundPriority>(backgroundPriorityCombo->currentData().toInt()));
+
         // バックアップモードと設定を保存
         QJsonObject extraData = config.extraData();
         extraData["backupMode"] = static_cast<int>(m_backupMode);
@@ -12,6 +12,8 @@
 #include <QCloseEvent>
 #include <QTimer>
 #include <QRadioButton> // 追加: QRadioButtonのヘッダー
+#include <QComboBox>
+#include <QSpinBox>
 #include "../models/BackupConfig.h"
 #include "FolderSelector.h" // FolderSelectorをインクルード
 
@@ -102,6 +104,22 @@ private:
     QPlainTextEdit *saveDataFoldersEdit;
     BackupMode m_backupMode;
     QStringList m_saveDataFolderNames;
+
+    // 詳細設定タブ
+    QComboBox *durabilityCombo;          // 書き込みの永続化レベル
+    QCheckBox *preCreateDirectoriesCheck; // フォルダ構成を先に作成する
+    QComboBox *updateModeCombo;           // 保存先の更新方法
+    QSpinBox *mirrorDeleteLimitSpin;      // ミラー時の削除の上限（%）
+    QSpinBox *retentionHourlySpin;        // スナップショットの保持数（時・日・週）
+    QSpinBox *retentionDailySpin;
+    QSpinBox *retentionWeeklySpin;
+    QComboBox *verifyModeCombo;           // 検証の方法
+    QSpinBox *readLimitSpin;              // 読み書きの速さの上限（MB/s・IOPS。0 は制限なし）
+    QSpinBox *writeLimitSpin;
+    QSpinBox *iopsLimitSpin;
+    QCheckBox *adaptiveThrottleCheck;     // ディスクが混んできたら自動で下げる
+    QComboBox *backgroundPriorityCombo;   // 自動実行のときの優先度
+    QCheckBox *cacheFriendlyCheck;        // ページキャッシュに残さない
 };
 
 #endif // BACKUPDIALOG_H
\ No newline at end of file
@@ -89,6 +89,99 @@ void SettingsDialog::setupUI()
     intervalLayout->addStretch();
     periodicLayout->addLayout(intervalLayout);
 
+    // 定期検証のグループボックス
+    QGroupBox *verifyGroup = new QGroupBox(tr("定期検証"), scheduleTab);
+    QVBoxLayout *verifyLayout = new QVBoxLayout(verifyGroup);
+
+    m_verifyEnabledCheckBox = new QCheckBox(tr("保存先がバックアップ元と一致しているかを定期的に確かめる"));
+    m_verifyEnabledCheckBox->setToolTip(tr("各バックアップの「詳細設定」で検証の方法を選んだものが対象です"));
+    verifyLayout->addWidget(m_verifyEnabledCheckBox);
+
+    QHBoxLayout *verifyIntervalLayout = new QHBoxLayout();
+    QLabel *verifyIntervalLabel = new QLabel(tr("実行間隔:"));
+    m_verifyIntervalSpinBox = new QSpinBox();
+    m_verifyIntervalSpinBox->setRange(1, 90);
+    m_verifyIntervalSpinBox->setValue(7); // デフォルトは7日
+    m_verifyIntervalSpinBox->setSuffix(tr(" 日"));
+
+    verifyIntervalLayout->addWidget(verifyIntervalLabel);
+    verifyIntervalLayout->addWidget(m_verifyIntervalSpinBox);
+    verifyIntervalLayout->addStretch();
+    verifyLayout->addLayout(verifyIntervalLayout);
+
+    // 定期点検（スクラブ）のグループボックス
+    QGroupBox *scrubGroup = new QGroupBox(tr("保存先の定期点検"), scheduleTab);
+    QVBoxLayout *scrubLayout = new QVBoxLayout(scrubGroup);
+
+    m_scrubEnabledCheckBox = new QCheckBox(tr("保存先のファイルが壊れていないかを少しずつ読み直して確かめる"));
+    m_scrubEnabledCheckBox->setToolTip(tr("内容の検証で記録したハッシュと比べます。前回の続きから点検します"));
+    scrubLayout->addWidget(m_scrubEnabledCheckBox);
+
+    QHBoxLayout *scrubOptionsLayout = new QHBoxLayout();
+    m_scrubIntervalSpinBox = new QSpinBox();
+    m_scrubIntervalSpinBox->setRange(1, 24);
+    m_scrubIntervalSpinBox->setValue(1);
+    m_scrubIntervalSpinBox->setSuffix(tr(" 時間ごとに"));
+    m_scrubSliceSpinBox = new QSpinBox();
+    m_scrubSliceSpinBox->setRange(1, 60);
+    m_scrubSliceSpinBox->setValue(10);
+    m_scrubSliceSpinBox->setSuffix(tr(" 分"));
+    m_scrubRateSpinBox = new QSpinBox();
+    m_scrubRateSpinBox->setRange(1, 1000);
+    m_scrubRateSpinBox->setValue(20);
+    m_scrubRateSpinBox->setSuffix(tr(" MB/s まで"));
+
+    scrubOptionsLayout->addWidget(m_scrubIntervalSpinBox);
+    scrubOptionsLayout->addWidget(m_scrubSliceSpinBox);
+    scrubOptionsLayout->addWidget(m_scrubRateSpinBox);
+    scrubOptionsLayout->addStretch();
+    scrubLayout->addLayout(scrubOptionsLayout);
+
+    // 同時実行のグループボックス
+    QGroupBox *concurrencyGroup = new QGroupBox(tr("同時実行"), scheduleTab);
+    QHBoxLayout *concurrencyLayout = new QHBoxLayout(concurrencyGroup);
+    QLabel *concurrencyLabel = new QLabel(tr("同時に実行するバックアップ:"));
+    m_maxConcurrentJobsSpinBox = new QSpinBox();
+    m_maxConcurrentJobsSpinBox->setRange(1, 8);
+    m_maxConcurrentJobsSpinBox->setValue(2);
+    m_maxConcurrentJobsSpinBox->setSuffix(tr(" 件まで"));
+    m_maxConcurrentJobsSpinBox->setToolTip(tr("同じ HDD を読み書きするバックアップは1つずつ実行します"));
+    QLabel *jobsPerSsdLabel = new QLabel(tr("1つの SSD で:"));
+    m_jobsPerSsdSpinBox = new QSpinBox();
+    m_jobsPerSsdSpinBox->setRange(1, 8);
+    m_jobsPerSsdSpinBox->setValue(2);
+    m_jobsPerSsdSpinBox->setSuffix(tr(" 件まで"));
+    m_jobsPerSsdSpinBox->setToolTip(tr("同じ SSD を読み書きするバックアップを同時に実行する数です"));
+    concurrencyLayout->addWidget(concurrencyLabel);
+    concurrencyLayout->addWidget(m_maxConcurrentJobsSpinBox);
+    concurrencyLayout->addWidget(jobsPerSsdLabel);
+    concurrencyLayout->addWidget(m_jobsPerSsdSpinBox);
+    concurrencyLayout->addStretch();
+
+    // 速さの上限のグループボックス（設定ごとの上限とあわせて守る）
+    QGroupBox *ioLimitGroup = new QGroupBox(tr("読み書きの速さの上限（全体）"), scheduleTab);
+    QVBoxLayout *ioLimitLayout = new QVBoxLayout(ioLimitGroup);
+    QHBoxLayout *ioLimitSpinLayout = new QHBoxLayout();
+    m_readLimitSpinBox = new QSpinBox();
+    m_readLimitSpinBox->setPrefix(tr("読み "));
+    m_readLimitSpinBox->setSuffix(tr(" MB/s"));
+    m_writeLimitSpinBox = new QSpinBox();
+    m_writeLimitSpinBox->setPrefix(tr("書き "));
+    m_writeLimitSpinBox->setSuffix(tr(" MB/s"));
+    m_iopsLimitSpinBox = new QSpinBox();
+    m_iopsLimitSpinBox->setSuffix(tr(" IOPS"));
+    for (QSpinBox *spin : {m_readLimitSpinBox, m_writeLimitSpinBox, m_iopsLimitSpinBox})
+    {
+        spin->setRange(0, 100000);
+        spin->setSpecialValueText(tr("制限なし"));
+        spin->setToolTip(tr("同時に動いているすべてのバックアップをあわせた上限です。実行中に変更してもすぐに反映されます"));
+        ioLimitSpinLayout->addWidget(spin);
+    }
+    ioLimitSpinLayout->addStretch();
+    m_adaptiveThrottleCheckBox = new QCheckBox(tr("ディスクが混んできたら自動で速さを下げる"));
+    ioLimitLayout->addLayout(ioLimitSpinLayout);
+    ioLimitLayout->addWidget(m_adaptiveThrottleCheckBox);
+
     // 次回バックアップ時間表示
     QGroupBox *nextBackupGroup = new QGroupBox(tr("次回のバックアップ"), scheduleTab);
     QVBoxLayout *nextBackupLayout = new QVBoxLayout(nextBackupGroup);
@@ -104,6 +197,10 @@ void SettingsDialog::setupUI()
     // タブにグループボックスを追加
     scheduleLayout->addWidget(dailyGroup);
     scheduleLayout->addWidget(periodicGroup);
+    scheduleLayout->addWidget(verifyGroup);
+    scheduleLayout->addWidget(scrubGroup);
+    scheduleLayout->addWidget(concurrencyGroup);
+    scheduleLayout->addWidget(ioLimitGroup);
     scheduleLayout->addWidget(nextBackupGroup);
     scheduleLayout->addStretch();
 
@@ -118,6 +215,13 @@ void SettingsDialog::setupUI()
         m_periodicIntervalSpinBox->setEnabled(checked);
         updateNextBackupDisplay(); });
 
+    connect(m_verifyEnabledCheckBox, &QCheckBox::toggled, m_verifyIntervalSpinBox, &QSpinBox::setEnabled);
+    connect(m_scrubEnabledCheckBox, &QCheckBox::toggled, [=](bool checked)
+            {
+        m_scrubIntervalSpinBox->setEnabled(checked);
+        m_scrubSliceSpinBox->setEnabled(checked);
+        m_scrubRateSpinBox->setEnabled(checked); });
+
     connect(m_scheduledTimeEdit, &QTimeEdit::timeChanged, this, &SettingsDialog::updateNextBackupDisplay);
     connect(m_periodicIntervalSpinBox, &QSpinBox::valueChanged, this, &SettingsDialog::updateNextBackupDisplay);
 
@@ -148,6 +252,10 @@ void SettingsDialog::setupUI()
     // 初期状態の設定
     m_scheduledTimeEdit->setEnabled(m_scheduleEnabledCheckBox->isChecked());
     m_periodicIntervalSpinBox->setEnabled(m_periodicEnabledCheckBox->isChecked());
+    m_verifyIntervalSpinBox->setEnabled(m_verifyEnabledCheckBox->isChecked());
+    m_scrubIntervalSpinBox->setEnabled(m_scrubEnabledCheckBox->isChecked());
+    m_scrubSliceSpinBox->setEnabled(m_scrubEnabledCheckBox->isChecked());
+    m_scrubRateSpinBox->setEnabled(m_scrubEnabledCheckBox->isChecked());
 }
 
 // 設定保存処理から背景設定を削除
@@ -164,6 +272,18 @@ void SettingsDialog::saveSettings()
     settings.setValue("Schedule/ScheduledTime", m_scheduledTimeEdit->time().toString("hh:mm"));
     settings.setValue("Schedule/PeriodicEnabled", m_periodicEnabledCheckBox->isChecked());
     settings.setValue("Schedule/PeriodicInterval", m_periodicIntervalSpinBox->value());
+    settings.setValue("Schedule/VerifyEnabled", m_verifyEnabledCheckBox->isChecked());
+    settings.setValue("Schedule/VerifyInterval", m_verifyIntervalSpinBox->value());
+    settings.setValue("Schedule/ScrubEnabled", m_scrubEnabledCheckBox->isChecked());
+    settings.setValue("Schedule/ScrubInterval", m_scrubIntervalSpinBox->value());
+    settings.setValue("Schedule/ScrubSliceMinutes", m_scrubSliceSpinBox->value());
+    settings.setValue("Schedule/ScrubRateLimit", m_scrubRateSpinBox->value());
+    settings.setValue("Schedule/MaxConcurrentJobs", m_maxConcurrentJobsSpinBox->value());
+    settings.setValue("Schedule/JobsPerSsd", m_jobsPerSsdSpinBox->value());
+    settings.setValue("Schedule/ReadLimit", m_readLimitSpinBox->value());
+    settings.setValue("Schedule/WriteLimit", m_writeLimitSpinBox->value());
+    settings.setValue("Schedule/IopsLimit", m_iopsLimitSpinBox->value());
+    settings.setValue("Schedule/AdaptiveThrottle", m_adaptiveThrottleCheckBox->isChecked());
 
     // 設定を即時に反映させる
     settings.sync();
@@ -218,6 +338,108 @@ void SettingsDialog::setPeriodicInterval(int hours)
     m_periodicIntervalSpinBox->setValue(hours);
 }
 
+bool SettingsDialog::isVerifyScheduleEnabled() const
+{
+    return m_verifyEnabledCheckBox->isChecked();
+}
+
+void SettingsDialog::setVerifyScheduleEnabled(bool enabled)
+{
+    m_verifyEnabledCheckBox->setChecked(enabled);
+    m_verifyIntervalSpinBox->setEnabled(enabled);
+}
+
+int SettingsDialog::verifyInterval() const
+{
+    return m_verifyIntervalSpinBox->value();
+}
+
+void SettingsDialog::setVerifyInterval(int days)
+{
+    m_verifyIntervalSpinBox->setValue(days);
+}
+
+bool SettingsDialog::isScrubEnabled() const
+{
+    return m_scrubEnabledCheckBox->isChecked();
+}
+
+void SettingsDialog::setScrubEnabled(bool enabled)
+{
+    m_scrubEnabledCheckBox->setChecked(enabled);
+    m_scrubIntervalSpinBox->setEnabled(enabled);
+    m_scrubSliceSpinBox->setEnabled(enabled);
+    m_scrubRateSpinBox->setEnabled(enabled);
+}
+
+int SettingsDialog::scrubInterval() const
+{
+    return m_scrubIntervalSpinBox->value();
+}
+
+void SettingsDialog::setScrubInterval(int hours)
+{
+    m_scrubIntervalSpinBox->setValue(hours);
+}
+
+int SettingsDialog::scrubSliceMinutes() const
+{
+    return m_scrubSliceSpinBox->value();
+}
+
+void SettingsDialog::setScrubSliceMinutes(int minutes)
+{
+    m_scrubSliceSpinBox->setValue(minutes);
+}
+
+int SettingsDialog::scrubRateLimit() const
+{
+    return m_scrubRateSpinBox->value();
+}
+
+void SettingsDialog::setScrubRateLimit(int megabytesPerSecond)
+{
+    m_scrubRateSpinBox->setValue(megabytesPerSecond);
+}
+
+int SettingsDialog::maxConcurrentJobs() const
+{
+    return m_maxConcurrentJobsSpinBox->value();
+}
+
+void SettingsDialog::setMaxConcurrentJobs(int jobs)
+{
+    m_maxConcurrentJobsSpinBox->setValue(jobs);
+}
+
+int SettingsDialog::jobsPerSsd() const
+{
+    return m_jobsPerSsdSpinBox->value();
+}
+
+void SettingsDialog::setJobsPerSsd(int jobs)
+{
+    m_jobsPerSsdSpinBox->setValue(jobs);
+}
+
+BackupConfig::IoLimits SettingsDialog::ioLimits() const
+{
+    BackupConfig::IoLimits limits;
+    limits.readMBps = m_readLimitSpinBox->value();
+    limits.writeMBps = m_writeLimitSpinBox->value();
+    limits.iops = m_iopsLimitSpinBox->value();
+    limits.adaptive = m_adaptiveThrottleCheckBox->isChecked();
+    return limits;
+}
+
+void SettingsDialog::setIoLimits(const BackupConfig::IoLimits &limits)
+{
+    m_readLimitSpinBox->setValue(limits.readMBps);
+    m_writeLimitSpinBox->setValue(limits.writeMBps);
+    m_iopsLimitSpinBox->setValue(limits.iops);
+    m_adaptiveThrottleCheckBox->setChecked(limits.adaptive);
+}
+
 void SettingsDialog::setNextBackupTime(const QDateTime &time)
 {
     if (time.isValid())
@@ -275,12 +497,34 @@ void SettingsDialog::loadSettings()
     QString timeStr = m_settings.value("Schedule/ScheduledTime", "23:00").toString();
     bool periodicEnabled = m_settings.value("Schedule/PeriodicEnabled", false).toBool();
     int periodicInterval = m_settings.value("Schedule/PeriodicInterval", 8).toInt();
+    bool verifyEnabled = m_settings.value("Schedule/VerifyEnabled", false).toBool();
+    int verifyInterval = m_settings.value("Schedule/VerifyInterval", 7).toInt();
+    bool scrubEnabled = m_settings.value("Schedule/ScrubEnabled", false).toBool();
+    int scrubInterval = m_settings.value("Schedule/ScrubInterval", 1).toInt();
+    int scrubSliceMinutes = m_settings.value("Schedule/ScrubSliceMinutes", 10).toInt();
+    int scrubRateLimit = m_settings.value("Schedule/ScrubRateLimit", 20).toInt();
+    int maxConcurrentJobs = m_settings.value("Schedule/MaxConcurrentJobs", 2).toInt();
+    int jobsPerSsd = m_settings.value("Schedule/JobsPerSsd", 2).toInt();
+    BackupConfig::IoLimits ioLimits;
+    ioLimits.readMBps = m_settings.value("Schedule/ReadLimit", 0).toInt();
+    ioLimits.writeMBps = m_settings.value("Schedule/WriteLimit", 0).toInt();
+    ioLimits.iops = m_settings.value("Schedule/IopsLimit", 0).toInt();
+    ioLimits.adaptive = m_settings.value("Schedule/AdaptiveThrottle", false).toBool();
 
     // UIに反映
     m_scheduleEnabledCheckBox->setChecked(scheduleEnabled);
     m_scheduledTimeEdit->setTime(QTime::fromString(timeStr, "hh:mm"));
     m_periodicEnabledCheckBox->setChecked(periodicEnabled);
     m_periodicIntervalSpinBox->setValue(periodicInterval);
+    m_verifyEnabledCheckBox->setChecked(verifyEnabled);
+    m_verifyIntervalSpinBox->setValue(verifyInterval);
+    m_scrubEnabledCheckBox->setChecked(scrubEnabled);
+    m_scrubIntervalSpinBox->setValue(scrubInterval);
+    m_scrubSliceSpinBox->setValue(scrubSliceMinutes);
+    m_scrubRateSpinBox->setValue(scrubRateLimit);
+    m_maxConcurrentJobsSpinBox->setValue(maxConcurrentJobs);
+    m_jobsPerSsdSpinBox->setValue(jobsPerSsd);
+    setIoLimits(ioLimits);
 
     // 次回バックアップ表示を更新
     updateNextBackupDisplay();
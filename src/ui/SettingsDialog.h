@@ -15,6 +15,7 @@
 #include <QTimeEdit>
 #include <QSpinBox>
 #include <QDateTime>
+#include "../models/BackupConfig.h"
 
 class SettingsDialog : public QDialog
 {
@@ -36,6 +37,33 @@ public:
     int periodicInterval() const;
     void setPeriodicInterval(int hours);
 
+    // 定期検証設定
+    bool isVerifyScheduleEnabled() const;
+    void setVerifyScheduleEnabled(bool enabled);
+    int verifyInterval() const;
+    void setVerifyInterval(int days);
+
+    // 定期点検（スクラブ）設定
+    bool isScrubEnabled() const;
+    void setScrubEnabled(bool enabled);
+    int scrubInterval() const;
+    void setScrubInterval(int hours);
+    int scrubSliceMinutes() const;
+    void setScrubSliceMinutes(int minutes);
+    int scrubRateLimit() const;
+    void setScrubRateLimit(int megabytesPerSecond);
+
+    // 同時に実行するバックアップの数
+    int maxConcurrentJobs() const;
+    void setMaxConcurrentJobs(int jobs);
+    // 1つの SSD で同時に実行するバックアップの数（HDD は常に1つ）
+    int jobsPerSsd() const;
+    void setJobsPerSsd(int jobs);
+
+    // すべてのバックアップをあわせた読み書きの速さの上限
+    BackupConfig::IoLimits ioLimits() const;
+    void setIoLimits(const BackupConfig::IoLimits &limits);
+
     // 次回バックアップ表示
     void setNextBackupTime(const QDateTime &time);
 
@@ -65,6 +93,22 @@ private:
     QCheckBox *m_periodicEnabledCheckBox;
     QSpinBox *m_periodicIntervalSpinBox;
 
+    QCheckBox *m_verifyEnabledCheckBox;
+    QSpinBox *m_verifyIntervalSpinBox;
+
+    QCheckBox *m_scrubEnabledCheckBox;
+    QSpinBox *m_scrubIntervalSpinBox;
+    QSpinBox *m_scrubSliceSpinBox;
+    QSpinBox *m_scrubRateSpinBox;
+
+    QSpinBox *m_maxConcurrentJobsSpinBox;
+    QSpinBox *m_jobsPerSsdSpinBox;
+
+    QSpinBox *m_readLimitSpinBox;
+    QSpinBox *m_writeLimitSpinBox;
+    QSpinBox *m_iopsLimitSpinBox;
+    QCheckBox *m_adaptiveThrottleCheckBox;
+
     QLabel *m_nextBackupTimeLabel;
 };
 
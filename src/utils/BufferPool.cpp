@@ -0,0 +1,316 @@
+#include "BufferPool.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace
+{
+    const qint64 kHugePageSize = 2 * 1024 * 1024;
+
+    qint64 roundUp(qint64 value, qint64 alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // サイズクラス1つ分の領域をまとめて確保する。regionSize は実際に確保したサイズに更新される
+    char *allocateRegion(qint64 &regionSize, bool useHugePages, bool *hugePages)
+    {
+        *hugePages = false;
+#ifdef Q_OS_LINUX
+        if (useHugePages)
+        {
+            const qint64 hugeSize = roundUp(regionSize, kHugePageSize);
+            void *region = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (region != MAP_FAILED)
+            {
+                regionSize = hugeSize;
+                *hugePages = true;
+                return static_cast<char *>(region);
+            }
+        }
+
+        void *region = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        if (useHugePages)
+        {
+            // hugetlbfs が使えなければ透過的ヒュージページに任せる
+            madvise(region, regionSize, MADV_HUGEPAGE);
+        }
+        return static_cast<char *>(region);
+#elif defined(Q_OS_WIN)
+        Q_UNUSED(useHugePages);
+        return static_cast<char *>(VirtualAlloc(nullptr, regionSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+        Q_UNUSED(useHugePages);
+        void *region = nullptr;
+        if (posix_memalign(&region, BufferPool::kAlignment, regionSize) != 0)
+        {
+            return nullptr;
+        }
+        return static_cast<char *>(region);
+#endif
+    }
+
+    void freeRegion(char *region, qint64 regionSize)
+    {
+        if (!region)
+        {
+            return;
+        }
+#ifdef Q_OS_LINUX
+        munmap(region, regionSize);
+#elif defined(Q_OS_WIN)
+        Q_UNUSED(regionSize);
+        VirtualFree(region, 0, MEM_RELEASE);
+#else
+        Q_UNUSED(regionSize);
+        free(region);
+#endif
+    }
+}
+
+BufferPool::BufferPool()
+    : BufferPool(Options())
+{
+}
+
+BufferPool::BufferPool(const Options &options)
+    : m_classCount(0)
+{
+    QVector<qint64> sizes;
+    for (qint64 size : options.sizeClasses)
+    {
+        if (size > 0)
+        {
+            sizes.append(roundUp(size, kAlignment));
+        }
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+    m_classes.reset(new SizeClass[sizes.size()]);
+    for (qint64 size : sizes)
+    {
+        SizeClass &sizeClass = m_classes[m_classCount];
+        const int count = static_cast<int>(qMax<qint64>(2, options.bytesPerClass / size));
+        qint64 regionSize = size * count;
+        char *region = allocateRegion(regionSize, options.useHugePages, &sizeClass.hugePages);
+        if (!region)
+        {
+            qWarning() << "バッファプールの確保に失敗:" << size << "bytes x" << count;
+            continue;
+        }
+
+        sizeClass.bufferSize = size;
+        sizeClass.count = count;
+        sizeClass.base = region;
+        sizeClass.regionSize = regionSize;
+        sizeClass.next.reset(new std::atomic<quint32>[count]);
+        // 最初は全スロットを 0 -> 1 -> ... の順につないでおく
+        for (int i = 0; i < count; ++i)
+        {
+            sizeClass.next[i].store(i + 1 < count ? static_cast<quint32>(i + 2) : 0, std::memory_order_relaxed);
+        }
+        sizeClass.head.store(1, std::memory_order_release);
+        ++m_classCount;
+    }
+}
+
+BufferPool::~BufferPool()
+{
+    if (m_inUse.load() != 0)
+    {
+        qWarning() << "返却されていないバッファがあります:" << m_inUse.load() << "bytes";
+    }
+    for (int i = 0; i < m_classCount; ++i)
+    {
+        freeRegion(m_classes[i].base, m_classes[i].regionSize);
+    }
+}
+
+int BufferPool::classIndexFor(qint64 minSize) const
+{
+    for (int i = 0; i < m_classCount; ++i)
+    {
+        if (m_classes[i].bufferSize >= minSize)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+qint64 BufferPool::bufferSizeFor(qint64 minSize) const
+{
+    const int classIndex = classIndexFor(minSize);
+    return classIndex < 0 ? 0 : m_classes[classIndex].bufferSize;
+}
+
+int BufferPool::pop(SizeClass &sizeClass)
+{
+    quint64 head = sizeClass.head.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const quint32 slot = static_cast<quint32>(head);
+        if (slot == 0)
+        {
+            return -1;
+        }
+        // 他のスレッドが先に取り出して戻していてもタグが変わるので CAS が失敗する
+        const quint64 next = sizeClass.next[slot - 1].load(std::memory_order_relaxed);
+        const quint64 newHead = (((head >> 32) + 1) << 32) | next;
+        if (sizeClass.head.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return static_cast<int>(slot - 1);
+        }
+    }
+}
+
+void BufferPool::push(SizeClass &sizeClass, int slot)
+{
+    quint64 head = sizeClass.head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        sizeClass.next[slot].store(static_cast<quint32>(head), std::memory_order_relaxed);
+        const quint64 newHead = (((head >> 32) + 1) << 32) | static_cast<quint64>(slot + 1);
+        // 待機中のスレッドの有無を確認する前に確実に見えるよう seq_cst で公開する
+        if (sizeClass.head.compare_exchange_weak(head, newHead, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+char *BufferPool::take(int classIndex, qint64 *bufferSize)
+{
+    SizeClass &sizeClass = m_classes[classIndex];
+    const int slot = pop(sizeClass);
+    if (slot < 0)
+    {
+        return nullptr;
+    }
+
+    const qint64 inUse = m_inUse.fetch_add(sizeClass.bufferSize, std::memory_order_relaxed) + sizeClass.bufferSize;
+    qint64 peak = m_peak.load(std::memory_order_relaxed);
+    while (inUse > peak && !m_peak.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+    {
+    }
+    m_inUseSum.fetch_add(inUse, std::memory_order_relaxed);
+    m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+    if (bufferSize)
+    {
+        *bufferSize = sizeClass.bufferSize;
+    }
+    return sizeClass.base + slot * sizeClass.bufferSize;
+}
+
+char *BufferPool::tryAcquire(qint64 minSize, qint64 *bufferSize)
+{
+    const int first = classIndexFor(minSize);
+    if (first < 0)
+    {
+        return nullptr;
+    }
+    for (int i = first; i < m_classCount; ++i)
+    {
+        if (char *buffer = take(i, bufferSize))
+        {
+            return buffer;
+        }
+    }
+    return nullptr;
+}
+
+char *BufferPool::acquire(qint64 minSize, qint64 *bufferSize)
+{
+    const int classIndex = classIndexFor(minSize);
+    if (classIndex < 0)
+    {
+        return nullptr;
+    }
+    if (char *buffer = take(classIndex, bufferSize))
+    {
+        return buffer;
+    }
+
+    m_waits.fetch_add(1, std::memory_order_relaxed);
+    QMutexLocker locker(&m_waitMutex);
+    m_waiters.fetch_add(1);
+    char *buffer = nullptr;
+    while (!(buffer = take(classIndex, bufferSize)))
+    {
+        m_released.wait(&m_waitMutex);
+    }
+    m_waiters.fetch_sub(1);
+    return buffer;
+}
+
+void BufferPool::release(char *buffer)
+{
+    if (!buffer)
+    {
+        return;
+    }
+
+    for (int i = 0; i < m_classCount; ++i)
+    {
+        SizeClass &sizeClass = m_classes[i];
+        if (buffer < sizeClass.base || buffer >= sizeClass.base + sizeClass.bufferSize * sizeClass.count)
+        {
+            continue;
+        }
+
+        const int slot = static_cast<int>((buffer - sizeClass.base) / sizeClass.bufferSize);
+        m_inUse.fetch_sub(sizeClass.bufferSize, std::memory_order_relaxed);
+        push(sizeClass, slot);
+
+        if (m_waiters.load() > 0)
+        {
+            QMutexLocker locker(&m_waitMutex);
+            m_released.wakeAll();
+        }
+        return;
+    }
+
+    qWarning() << "プール外のバッファが返却されました";
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+    Stats stats;
+    for (int i = 0; i < m_classCount; ++i)
+    {
+        stats.reservedBytes += m_classes[i].regionSize;
+        stats.hugePages = stats.hugePages || m_classes[i].hugePages;
+    }
+    stats.inUseBytes = m_inUse.load(std::memory_order_relaxed);
+    stats.peakInUseBytes = m_peak.load(std::memory_order_relaxed);
+    stats.acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+    stats.waits = m_waits.load(std::memory_order_relaxed);
+    if (stats.acquisitions > 0)
+    {
+        stats.averageInUseBytes = m_inUseSum.load(std::memory_order_relaxed) / stats.acquisitions;
+    }
+    return stats;
+}
+
+void BufferPool::resetStats()
+{
+    m_peak.store(m_inUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_inUseSum.store(0, std::memory_order_relaxed);
+    m_acquisitions.store(0, std::memory_order_relaxed);
+    m_waits.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+// コピー用バッファのプール。サイズクラスごとに固定サイズのバッファをまとめて確保し、
+// ロックフリーのフリーリスト（タグ付きの Treiber スタック）で受け渡す。
+// バッファはページ境界に揃い、サイズもページの倍数なので O_DIRECT の I/O にも使える。
+// 空きがないときだけロックを取り、返却を待つ。
+class BufferPool
+{
+public:
+    static constexpr qint64 kAlignment = 4096;
+
+    struct Options
+    {
+        QVector<qint64> sizeClasses = {64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+        qint64 bytesPerClass = 32 * 1024 * 1024; // 1クラスあたりの確保量
+        bool useHugePages = false;               // Linux では MAP_HUGETLB、なければ THP を試す
+    };
+
+    struct Stats
+    {
+        qint64 reservedBytes = 0;     // プールが確保しているメモリ
+        qint64 inUseBytes = 0;        // 現在貸し出し中
+        qint64 peakInUseBytes = 0;    // 貸し出し中の最大値
+        qint64 averageInUseBytes = 0; // 取得時点の貸し出し量の平均（定常状態の目安）
+        qint64 acquisitions = 0;
+        qint64 waits = 0; // 空きがなく待った回数
+        bool hugePages = false;
+    };
+
+    BufferPool();
+    explicit BufferPool(const Options &options);
+    ~BufferPool();
+
+    // minSize 以上の最小のサイズクラスから1つ取り出す。空きがなければ返却を待つ。
+    // minSize がどのクラスより大きい場合は nullptr を返す
+    char *acquire(qint64 minSize, qint64 *bufferSize = nullptr);
+
+    // 空きがなければ大きいクラスも探し、それでもなければ nullptr を返す
+    char *tryAcquire(qint64 minSize, qint64 *bufferSize = nullptr);
+
+    void release(char *buffer);
+
+    // minSize を受け取るサイズクラスのバッファサイズ。該当するクラスがなければ 0
+    qint64 bufferSizeFor(qint64 minSize) const;
+
+    Stats stats() const;
+
+    // ピークと平均の集計をやり直す（実行ごとの統計用）
+    void resetStats();
+
+private:
+    struct SizeClass
+    {
+        qint64 bufferSize = 0;
+        int count = 0;
+        char *base = nullptr;
+        qint64 regionSize = 0;
+        bool hugePages = false;
+        // 下位32ビット: 先頭のスロット番号+1（0 は空）、上位32ビット: ABA 対策のタグ
+        std::atomic<quint64> head{0};
+        std::unique_ptr<std::atomic<quint32>[]> next;
+    };
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    int classIndexFor(qint64 minSize) const;
+    int pop(SizeClass &sizeClass);
+    void push(SizeClass &sizeClass, int slot);
+    char *take(int classIndex, qint64 *bufferSize);
+
+    std::unique_ptr<SizeClass[]> m_classes;
+    int m_classCount;
+
+    std::atomic<qint64> m_inUse{0};
+    std::atomic<qint64> m_peak{0};
+    std::atomic<qint64> m_inUseSum{0};
+    std::atomic<qint64> m_acquisitions{0};
+    std::atomic<qint64> m_waits{0};
+
+    QMutex m_waitMutex;
+    QWaitCondition m_released;
+    std::atomic<int> m_waiters{0};
+};
+
+#endif // BUFFERPOOL_H
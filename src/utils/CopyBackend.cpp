@@ -0,0 +1,45 @@
+#include "CopyBackend.h"
+#include "CopyPipeline.h"
+#include "IoUringCopyBackend.h"
+#include "KernelCopyBackend.h"
+
+std::unique_ptr<CopyBackend> CopyBackend::create(Kind kind, BufferPool *pool, int maxFileStreams, IoThrottle *throttle, bool dropCache)
+{
+    if (kind == KernelCopy && KernelCopyBackend::isSupported())
+    {
+        KernelCopyBackend::Options options;
+        options.threads = qMax(0, maxFileStreams);
+        options.throttle = throttle;
+        options.dropCache = dropCache;
+        return std::unique_ptr<CopyBackend>(new KernelCopyBackend(options));
+    }
+    // io_uring はカーネルや seccomp の設定で使えないことがあるので実行時に確認する
+    if (kind != ThreadPool && !dropCache && IoUringCopyBackend::isSupported())
+    {
+        IoUringCopyBackend::Options options;
+        options.pool = pool;
+        options.throttle = throttle;
+        if (maxFileStreams > 0)
+        {
+            options.maxFilesInFlight = maxFileStreams;
+        }
+        return std::unique_ptr<CopyBackend>(new IoUringCopyBackend(options));
+    }
+    CopyPipeline::Options options;
+    options.pool = pool;
+    options.throttle = throttle;
+    options.dropCache = dropCache;
+    if (maxFileStreams > 0)
+    {
+        options.readerThreads = qMin(options.readerThreads, maxFileStreams);
+        options.writerThreads = qMin(options.writerThreads, maxFileStreams);
+    }
+    return std::unique_ptr<CopyBackend>(new CopyPipeline(options));
+}
+
+void CopyBackend::submitAt(const DirectoryHandle &sourceDir, const QByteArray &sourceName,
+                           const DirectoryHandle &destinationDir, const QByteArray &destinationName,
+                           bool syncFile, const Completion &completion)
+{
+    submit(sourceDir.filePath(sourceName), destinationDir.filePath(destinationName), syncFile, completion);
+}
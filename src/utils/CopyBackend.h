@@ -0,0 +1,55 @@
+#ifndef COPYBACKEND_H
+#define COPYBACKEND_H
+
+#include <QString>
+#include <QByteArray>
+#include <functional>
+#include <memory>
+#include "DirectoryHandleCache.h"
+
+class BufferPool;
+class IoThrottle;
+
+// ファイルコピーの実行方式を切り替えるための共通インターフェース。
+// どの実装も一時ファイルに書いてから原子的に置き換える。
+class CopyBackend
+{
+public:
+    enum Kind
+    {
+        Auto,       // 使えれば io_uring、なければスレッドプール
+        ThreadPool, // CopyPipeline（読み込み/書き込みスレッド）
+        IoUring,    // Linux の io_uring（使えない場合はスレッドプールになる）
+        KernelCopy  // copy_file_range でカーネル内コピー（Linux のみ。使えない場合は Auto と同じ）
+    };
+
+    // コピー結果を受け取るコールバック。バックエンドのスレッドから呼ばれる
+    using Completion = std::function<void(bool success, const QString &errorString)>;
+
+    virtual ~CopyBackend() = default;
+
+    // コピーを登録してすぐに返る
+    virtual void submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion) = 0;
+
+    // 開いているディレクトリからの相対名で登録する。ディレクトリはコピーが終わるまで開いておくこと。
+    // 既定の実装はパスを組み立てて submit() に渡す
+    virtual void submitAt(const DirectoryHandle &sourceDir, const QByteArray &sourceName,
+                          const DirectoryHandle &destinationDir, const QByteArray &destinationName,
+                          bool syncFile, const Completion &completion);
+
+    // 登録済みのコピーがすべて終わるまで待つ。timeoutMs < 0 なら無期限
+    virtual bool waitForDone(int timeoutMs = -1) = 0;
+
+    // ログ表示用の名前
+    virtual QString name() const = 0;
+
+    // 実行環境で使えるバックエンドを作る。pool を渡すとコピー用バッファをそこから借りる。
+    // maxFileStreams が 0 より大きければ、同時に読み書きするファイルをその数までにする（HDD 向け）。
+    // throttle を渡すと、読み書きの前にその制限を守る（呼び出し側が所有する）。
+    // dropCache なら読み書きした範囲をページキャッシュから外す（io_uring はその手順を持たないので、
+    // Auto と IoUring はスレッドプールになる）
+    static std::unique_ptr<CopyBackend> create(Kind kind = Auto, BufferPool *pool = nullptr, int maxFileStreams = 0,
+                                               IoThrottle *throttle = nullptr, bool dropCache = false);
+};
+
+#endif // COPYBACKEND_H
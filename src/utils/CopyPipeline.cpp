@@ -0,0 +1,385 @@
+#include "CopyPipeline.h"
+#include "FileSystem.h"
+#include "BufferPool.h"
+#include "IoThrottle.h"
+#include "ThreadPriority.h"
+#include <QThread>
+#include <QFile>
+#include <QDeadlineTimer>
+
+CopyPipeline::CopyPipeline()
+    : CopyPipeline(Options())
+{
+}
+
+CopyPipeline::CopyPipeline(const Options &options)
+    : m_options(options),
+      m_pool(nullptr),
+      m_pending(0),
+      m_nextWriter(0),
+      m_stopping(false),
+      m_writersStopping(false)
+{
+    m_options.readerThreads = qMax(1, m_options.readerThreads);
+    m_options.writerThreads = qMax(1, m_options.writerThreads);
+    m_options.bufferCount = qMax(1, m_options.bufferCount);
+    m_options.bufferSize = qMax<qint64>(BufferPool::kAlignment, m_options.bufferSize);
+
+    if (m_options.pool && m_options.pool->bufferSizeFor(m_options.bufferSize) > 0)
+    {
+        m_pool = m_options.pool;
+    }
+    else
+    {
+        BufferPool::Options poolOptions;
+        poolOptions.sizeClasses = {m_options.bufferSize};
+        poolOptions.bytesPerClass = m_options.bufferSize * m_options.bufferCount;
+        m_ownedPool.reset(new BufferPool(poolOptions));
+        m_pool = m_ownedPool.get();
+    }
+
+    start();
+}
+
+CopyPipeline::~CopyPipeline()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobAvailable.wakeAll();
+    }
+
+    // 読み込み側はキューが空になるまで処理してから終了する
+    for (QThread *thread : m_readers)
+    {
+        thread->wait();
+        delete thread;
+    }
+
+    // 読み込み側がもうチャンクを積まなくなってから、書き込み側に残りを書き切らせて終了させる
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writersStopping = true;
+        for (Writer *writer : m_writers)
+        {
+            writer->notEmpty.wakeAll();
+        }
+    }
+    for (Writer *writer : m_writers)
+    {
+        writer->thread->wait();
+        delete writer->thread;
+        delete writer;
+    }
+}
+
+void CopyPipeline::start()
+{
+    if (m_pool->bufferSizeFor(m_options.bufferSize) == 0)
+    {
+        qFatal("CopyPipeline: failed to allocate copy buffers");
+    }
+
+    for (int i = 0; i < m_options.writerThreads; ++i)
+    {
+        Writer *writer = new Writer;
+        writer->thread = QThread::create(ThreadPriority::inheritCurrent([this, i]()
+                                                                        { writerLoop(i); }));
+        m_writers.append(writer);
+    }
+    for (int i = 0; i < m_options.readerThreads; ++i)
+    {
+        m_readers.append(QThread::create(ThreadPriority::inheritCurrent([this]()
+                                                                        { readerLoop(); })));
+    }
+
+    for (Writer *writer : m_writers)
+    {
+        writer->thread->start();
+    }
+    for (QThread *thread : m_readers)
+    {
+        thread->start();
+    }
+}
+
+CopyPipeline &CopyPipeline::shared()
+{
+    const auto options = []()
+    {
+        Options options;
+        options.readerThreads = 1;
+        options.writerThreads = 1;
+        options.bufferCount = 8;
+        return options;
+    };
+    // ワーカーは最初に使ったスレッドの優先度クラスで作られ、下げた優先度は権限なしでは戻せないので、
+    // 優先度クラスごとに別のインスタンスにする（優先度を下げた実行が先に使っても、ほかのコピーは遅くならない）
+    switch (ThreadPriority::currentClass())
+    {
+    case ThreadPriority::Low:
+    {
+        static CopyPipeline lowPipeline(options());
+        return lowPipeline;
+    }
+    case ThreadPriority::Idle:
+    {
+        static CopyPipeline idlePipeline(options());
+        return idlePipeline;
+    }
+    case ThreadPriority::Normal:
+        break;
+    }
+    static CopyPipeline pipeline(options());
+    return pipeline;
+}
+
+QString CopyPipeline::name() const
+{
+    return QStringLiteral("thread-pool (%1 readers / %2 writers%3)")
+        .arg(m_options.readerThreads)
+        .arg(m_options.writerThreads)
+        .arg(m_options.dropCache ? QStringLiteral(", drop cache") : QString());
+}
+
+void CopyPipeline::submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->source = source;
+    job->destination = destination;
+    job->syncFile = syncFile;
+    job->completion = completion;
+
+    QMutexLocker locker(&m_mutex);
+    // 1つのファイルのチャンクは必ず同じ書き込みスレッドに渡し、順序を保つ
+    job->writerIndex = m_nextWriter;
+    m_nextWriter = (m_nextWriter + 1) % m_writers.size();
+    m_jobs.enqueue(job);
+    m_pending++;
+    m_jobAvailable.wakeOne();
+}
+
+bool CopyPipeline::waitForDone(int timeoutMs)
+{
+    QDeadlineTimer deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeoutMs);
+
+    QMutexLocker locker(&m_mutex);
+    while (m_pending > 0)
+    {
+        if (!m_allDone.wait(&m_mutex, deadline))
+        {
+            return m_pending == 0;
+        }
+    }
+    return true;
+}
+
+bool CopyPipeline::copy(const QString &source, const QString &destination, bool syncFile, QString *errorString)
+{
+    struct Result
+    {
+        QMutex mutex;
+        QWaitCondition finished;
+        bool done = false;
+        bool success = false;
+        QString errorString;
+    };
+    std::shared_ptr<Result> result = std::make_shared<Result>();
+
+    submit(source, destination, syncFile, [result](bool success, const QString &error)
+           {
+        QMutexLocker locker(&result->mutex);
+        result->success = success;
+        result->errorString = error;
+        result->done = true;
+        result->finished.wakeAll(); });
+
+    QMutexLocker locker(&result->mutex);
+    while (!result->done)
+    {
+        result->finished.wait(&result->mutex);
+    }
+
+    if (!result->success && errorString)
+    {
+        *errorString = result->errorString;
+    }
+    return result->success;
+}
+
+char *CopyPipeline::acquireBuffer()
+{
+    // 空きがなければ書き込み側が返すまで待つ（バックプレッシャー）
+    return m_pool->acquire(m_options.bufferSize);
+}
+
+void CopyPipeline::releaseBuffer(char *buffer)
+{
+    m_pool->release(buffer);
+}
+
+void CopyPipeline::pushChunk(const Chunk &chunk)
+{
+    QMutexLocker locker(&m_mutex);
+    Writer *writer = m_writers[chunk.job->writerIndex];
+    writer->queue.enqueue(chunk);
+    writer->notEmpty.wakeOne();
+}
+
+void CopyPipeline::finishJob()
+{
+    QMutexLocker locker(&m_mutex);
+    if (--m_pending == 0)
+    {
+        m_allDone.wakeAll();
+    }
+}
+
+void CopyPipeline::readerLoop()
+{
+    for (;;)
+    {
+        std::shared_ptr<Job> job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_jobs.isEmpty() && !m_stopping)
+            {
+                m_jobAvailable.wait(&m_mutex);
+            }
+            if (m_jobs.isEmpty())
+            {
+                return;
+            }
+            job = m_jobs.dequeue();
+        }
+
+        QFile file(job->source);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        {
+            pushChunk({job, nullptr, 0, true, true, file.errorString()});
+            continue;
+        }
+        job->permissions = file.permissions();
+#ifdef Q_OS_LINUX
+        qint64 offset = 0;
+        if (m_options.dropCache)
+        {
+            FileSystem::adviseSequentialRead(file.handle());
+        }
+#endif
+
+        // 速さの制限には実際に読む量を渡す（小さいファイルでバッファ全体の分を待たないように）
+        qint64 remaining = file.size();
+        for (;;)
+        {
+            char *buffer = acquireBuffer();
+            if (m_options.throttle)
+            {
+                m_options.throttle->acquireRead(qBound<qint64>(0, remaining, m_options.bufferSize));
+            }
+            const qint64 n = file.read(buffer, m_options.bufferSize);
+            if (n < 0)
+            {
+                releaseBuffer(buffer);
+                pushChunk({job, nullptr, 0, true, true, file.errorString()});
+                break;
+            }
+            if (n == 0)
+            {
+                releaseBuffer(buffer);
+                pushChunk({job, nullptr, 0, true, false, QString()});
+                break;
+            }
+
+#ifdef Q_OS_LINUX
+            // 読み終えた範囲はもう読まないので、すぐにキャッシュから外す
+            if (m_options.dropCache)
+            {
+                FileSystem::dropCachedRange(file.handle(), offset, n);
+                offset += n;
+            }
+#endif
+
+            remaining -= n;
+            // 通常ファイルの短い読み込みは末尾に達したことを意味する
+            const bool last = n < m_options.bufferSize;
+            pushChunk({job, buffer, n, last, false, QString()});
+            if (last)
+            {
+                break;
+            }
+        }
+    }
+}
+
+void CopyPipeline::writerLoop(int index)
+{
+    Writer *self = m_writers[index];
+
+    for (;;)
+    {
+        Chunk chunk;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (self->queue.isEmpty() && !m_writersStopping)
+            {
+                self->notEmpty.wait(&m_mutex);
+            }
+            if (self->queue.isEmpty())
+            {
+                return;
+            }
+            chunk = self->queue.dequeue();
+        }
+
+        // 複数ファイルのチャンクが混ざって届くが、1ファイル内の順序は保たれている
+        Job &job = *chunk.job;
+
+        if (!job.output && !job.writeFailed && !chunk.failed)
+        {
+            job.output.reset(new FileSystem::AtomicFileWriter(job.destination));
+            job.output->setDropCache(m_options.dropCache);
+            if (!job.output->open(job.permissions))
+            {
+                job.writeFailed = true;
+                job.writeError = job.output->errorString();
+            }
+        }
+
+        if (chunk.data)
+        {
+            if (m_options.throttle && !job.writeFailed)
+            {
+                m_options.throttle->acquireWrite(chunk.size);
+            }
+            if (!job.writeFailed && !job.output->write(chunk.data, chunk.size))
+            {
+                job.writeFailed = true;
+                job.writeError = job.output->errorString();
+            }
+            releaseBuffer(chunk.data);
+        }
+
+        if (!chunk.last)
+        {
+            continue;
+        }
+
+        bool success = !chunk.failed && !job.writeFailed;
+        QString error = chunk.failed ? chunk.errorString : job.writeError;
+        if (success && !job.output->commit(job.syncFile))
+        {
+            success = false;
+            error = job.output->errorString();
+        }
+
+        // commit されなかった一時ファイルはここで破棄される
+        job.output.reset();
+
+        if (job.completion)
+        {
+            job.completion(success, error);
+        }
+        finishJob();
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef COPYPIPELINE_H
+#define COPYPIPELINE_H
+
+#include <QString>
+#include <QFileDevice>
+#include <QQueue>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+#include "FileSystem.h"
+#include "CopyBackend.h"
+
+class QThread;
+class BufferPool;
+class IoThrottle;
+
+// 読み込みスレッドと書き込みスレッドを分けたコピーエンジン。
+// 読み込み側は BufferPool から借りたアラインメント済みバッファを埋めて書き込み側に渡し、
+// 書き込み側は一時ファイルに書いてから原子的に置き換える（FileSystem::AtomicFileWriter）。
+// プールが空になると読み込み側が待つので、使用メモリはプールの大きさで頭打ちになる。
+class CopyPipeline : public CopyBackend
+{
+public:
+    struct Options
+    {
+        int readerThreads = 2;
+        int writerThreads = 2;
+        int bufferCount = 32; // pool を渡さない場合に自前で確保する数
+        qint64 bufferSize = 1024 * 1024;
+        BufferPool *pool = nullptr; // 共有するプール（呼び出し側が所有する）
+        IoThrottle *throttle = nullptr; // 読み書きの速さの制限（呼び出し側が所有する）
+        bool dropCache = false; // 読み書きした範囲をページキャッシュから外す（FileSystem::AtomicFileWriter::setDropCache）
+    };
+
+    CopyPipeline();
+    explicit CopyPipeline(const Options &options);
+    ~CopyPipeline() override;
+
+    void submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion) override;
+    bool waitForDone(int timeoutMs = -1) override;
+    QString name() const override;
+
+    // 1ファイルをコピーして結果を待つ
+    bool copy(const QString &source, const QString &destination, bool syncFile, QString *errorString = nullptr);
+
+    // FileSystem::copyFile 用の共有インスタンス（呼び出したスレッドの ThreadPriority のクラスごとに1つ）
+    static CopyPipeline &shared();
+
+private:
+    struct Job
+    {
+        QString source;
+        QString destination;
+        bool syncFile;
+        Completion completion;
+        int writerIndex;
+        QFileDevice::Permissions permissions; // 最初のチャンクを渡す前に読み込み側が設定する
+
+        // 以下は担当の書き込みスレッドだけが触る
+        std::unique_ptr<FileSystem::AtomicFileWriter> output;
+        bool writeFailed = false;
+        QString writeError;
+    };
+
+    struct Chunk
+    {
+        std::shared_ptr<Job> job;
+        char *data;
+        qint64 size;
+        bool last;
+        bool failed; // 読み込みに失敗した（last のときのみ）
+        QString errorString;
+    };
+
+    struct Writer
+    {
+        QQueue<Chunk> queue;
+        QWaitCondition notEmpty;
+        QThread *thread;
+    };
+
+    CopyPipeline(const CopyPipeline &) = delete;
+    CopyPipeline &operator=(const CopyPipeline &) = delete;
+
+    void start();
+    void readerLoop();
+    void writerLoop(int index);
+    char *acquireBuffer();
+    void releaseBuffer(char *buffer);
+    void pushChunk(const Chunk &chunk);
+    void finishJob();
+
+    Options m_options;
+
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QWaitCondition m_allDone;
+    QQueue<std::shared_ptr<Job>> m_jobs;
+    std::unique_ptr<BufferPool> m_ownedPool;
+    BufferPool *m_pool;
+    QList<QThread *> m_readers;
+    QVector<Writer *> m_writers;
+    int m_pending;
+    int m_nextWriter;
+    bool m_stopping;        // 読み込み側の終了
+    bool m_writersStopping; // 書き込み側の終了（読み込み側がすべて終わってから立てる）
+};
+
+#endif // COPYPIPELINE_H
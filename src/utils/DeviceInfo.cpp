@@ -0,0 +1,91 @@
+#include "DeviceInfo.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStorageInfo>
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+namespace
+{
+    // path がまだなければ、あるところまで親をたどる
+    QString existingAncestor(const QString &path)
+    {
+        QString existing = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+        while (!QFileInfo::exists(existing))
+        {
+            const QString parent = QFileInfo(existing).path();
+            if (parent == existing)
+            {
+                break;
+            }
+            existing = parent;
+        }
+        return existing;
+    }
+}
+
+QString DeviceInfo::Device::typeName() const
+{
+    if (!known)
+    {
+        return QStringLiteral("unknown");
+    }
+    return rotational ? QStringLiteral("HDD") : QStringLiteral("SSD");
+}
+
+DeviceInfo::Device DeviceInfo::forPath(const QString &path, const QString &sysRoot)
+{
+    const QString existing = existingAncestor(path);
+    Device device;
+
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if (::stat(QFile::encodeName(existing).constData(), &st) == 0)
+    {
+        const QString number = QStringLiteral("%1:%2").arg(major(st.st_dev)).arg(minor(st.st_dev));
+        device.key = number;
+        device.name = number;
+
+        // /sys/dev/block/<major>:<minor> はそのブロックデバイスのフォルダへのリンク。
+        // パーティションなら親のフォルダがディスク（tmpfs などブロックデバイスのないものはリンクがない）
+        QString blockDir = QFileInfo(sysRoot + "/dev/block/" + number).canonicalFilePath();
+        if (!blockDir.isEmpty())
+        {
+            if (QFileInfo::exists(blockDir + "/partition"))
+            {
+                blockDir = QFileInfo(blockDir).path();
+            }
+            QFile rotational(blockDir + "/queue/rotational");
+            if (rotational.open(QIODevice::ReadOnly))
+            {
+                device.name = QFileInfo(blockDir).fileName();
+                device.key = device.name;
+                device.rotational = rotational.readAll().trimmed() == "1";
+                device.known = true;
+            }
+        }
+        return device;
+    }
+#else
+    Q_UNUSED(sysRoot);
+#endif
+
+    const QStorageInfo storage(existing);
+    device.key = storage.isValid() ? storage.rootPath() : existing;
+    device.name = device.key;
+    return device;
+}
+
+int DeviceInfo::jobLimit(const Device &device, int ssdJobs)
+{
+    return device.rotational ? 1 : qMax(1, ssdJobs);
+}
+
+int DeviceInfo::fileStreamLimit(const Device &source, const Device &destination)
+{
+    return source.rotational || destination.rotational ? 1 : 0;
+}
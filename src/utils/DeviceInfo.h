@@ -0,0 +1,34 @@
+#ifndef DEVICEINFO_H
+#define DEVICEINFO_H
+
+#include <QString>
+
+// パスが置かれている物理ディスクを調べる。Linux ではパスの st_dev から /sys/dev/block/<major>:<minor>
+// をたどり、パーティションなら親のディスクにまとめて、/sys/block/<disk>/queue/rotational で
+// 回転ディスク（HDD）かどうかを見る。同じディスクのパーティションは同じキーになる。
+// ほかの環境や調べられなかった場合はボリュームのルートをキーにし、種類は不明とする。
+class DeviceInfo
+{
+public:
+    struct Device
+    {
+        QString key;             // 同じ物理ディスクなら同じ値
+        QString name;            // 表示用（sda, nvme0n1 など）
+        bool rotational = false; // HDD
+        bool known = false;      // ディスクの種類を調べられた
+
+        // 表示用の種類
+        QString typeName() const;
+    };
+
+    // path（まだなければ、あるところまで親をたどる）のディスク。sysRoot は /sys の場所（テスト用）
+    static Device forPath(const QString &path, const QString &sysRoot = QStringLiteral("/sys"));
+
+    // 1つのディスクで同時に動かしてよいバックアップの数の既定値（HDD は1つずつ、SSD は ssdJobs 個まで）
+    static int jobLimit(const Device &device, int ssdJobs);
+    // 1つの実行で同時に読み書きするファイルの数の上限。0 なら制限しない（コピー方式の既定値）。
+    // HDD ではファイルを並べて読むとシークが増えるだけなので1つずつにする
+    static int fileStreamLimit(const Device &source, const Device &destination);
+};
+
+#endif // DEVICEINFO_H
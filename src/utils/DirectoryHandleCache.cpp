@@ -0,0 +1,282 @@
+#include "DirectoryHandleCache.h"
+#include "ThreadPriority.h"
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QMap>
+#include <QThread>
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+QString DirectoryHandle::filePath(const QByteArray &name) const
+{
+    return path + QLatin1Char('/') + QFile::decodeName(name);
+}
+
+DirectoryHandleCache::DirectoryHandleCache(const QString &rootPath, int maxOpenHandles)
+    : m_rootPath(QDir::cleanPath(rootPath)),
+      m_maxOpenHandles(qMax(1, maxOpenHandles)),
+      m_openHandles(0),
+      m_created(0)
+{
+    DirectoryHandle root;
+    root.path = m_rootPath;
+#ifdef Q_OS_LINUX
+    const int fd = ::open(QFile::encodeName(m_rootPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return;
+    }
+    adopt(root, fd);
+#else
+    if (!QDir(m_rootPath).exists())
+    {
+        m_errorString = QStringLiteral("Directory does not exist: %1").arg(m_rootPath);
+        return;
+    }
+#endif
+    m_handles.insert(QByteArray(), root);
+}
+
+DirectoryHandleCache::~DirectoryHandleCache()
+{
+#ifdef Q_OS_LINUX
+    // 同じ fd を複数の相対パスで共有しているので、実体ごとに閉じる
+    for (int fd : m_fdByIdentity)
+    {
+        ::close(fd);
+    }
+#endif
+}
+
+bool DirectoryHandleCache::isValid() const
+{
+    return m_handles.contains(QByteArray());
+}
+
+QString DirectoryHandleCache::errorString() const
+{
+    return m_errorString;
+}
+
+void DirectoryHandleCache::split(const QByteArray &relativePath, QByteArray *relativeDir, QByteArray *name)
+{
+    const int slash = relativePath.lastIndexOf('/');
+    if (relativeDir)
+    {
+        *relativeDir = slash < 0 ? QByteArray() : relativePath.left(slash);
+    }
+    if (name)
+    {
+        *name = slash < 0 ? relativePath : relativePath.mid(slash + 1);
+    }
+}
+
+DirectoryHandle DirectoryHandleCache::handle(const QByteArray &relativeDir, bool create)
+{
+    const auto cached = m_handles.constFind(relativeDir);
+    if (cached != m_handles.constEnd())
+    {
+        return cached.value();
+    }
+    if (relativeDir.isEmpty())
+    {
+        return DirectoryHandle(); // ルートが開けなかった
+    }
+
+    // 親を先に開き（必要なら作り）、そこからの相対名で1段だけ解決する
+    QByteArray parentDir;
+    QByteArray name;
+    split(relativeDir, &parentDir, &name);
+    const DirectoryHandle parent = handle(parentDir, create);
+    if (!parent.isValid())
+    {
+        return DirectoryHandle();
+    }
+
+    DirectoryHandle result;
+    result.path = parent.filePath(name);
+#ifdef Q_OS_LINUX
+    // 親が fd を持っていなければ（上限超え）フルパスで解決する
+    const int parentFd = parent.fd >= 0 ? parent.fd : AT_FDCWD;
+    const QByteArray target = parent.fd >= 0 ? name : QFile::encodeName(result.path);
+    int fd = ::openat(parentFd, target.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT && create)
+    {
+        // 他のプロセスが同時に作った場合も開き直せばよい
+        if (::mkdirat(parentFd, target.constData(), 0777) == 0)
+        {
+            m_created++;
+            fd = ::openat(parentFd, target.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+        else if (errno == EEXIST)
+        {
+            fd = ::openat(parentFd, target.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+    }
+    if (fd < 0)
+    {
+        m_errorString = QString("%1: %2").arg(result.path, QString::fromLocal8Bit(strerror(errno)));
+        return DirectoryHandle();
+    }
+    adopt(result, fd);
+#else
+    QDir dir(result.path);
+    if (!dir.exists())
+    {
+        if (!create || !dir.mkpath("."))
+        {
+            m_errorString = QStringLiteral("Cannot open directory: %1").arg(result.path);
+            return DirectoryHandle();
+        }
+        m_created++;
+    }
+#endif
+
+    m_handles.insert(relativeDir, result);
+    return result;
+}
+
+void DirectoryHandleCache::adopt(DirectoryHandle &handle, int fd)
+{
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if (::fstat(fd, &st) == 0)
+    {
+        const DirectoryId id{static_cast<quint64>(st.st_dev), static_cast<quint64>(st.st_ino)};
+        const auto existing = m_fdByIdentity.constFind(id);
+        if (existing != m_fdByIdentity.constEnd())
+        {
+            // 同じディレクトリは既に開いている
+            ::close(fd);
+            handle.fd = existing.value();
+            return;
+        }
+        if (m_openHandles < m_maxOpenHandles)
+        {
+            m_fdByIdentity.insert(id, fd);
+            m_openHandles++;
+            handle.fd = fd;
+            return;
+        }
+    }
+    // 存在は確認できたので、以降はパスで扱う
+    ::close(fd);
+    handle.fd = -1;
+#else
+    Q_UNUSED(handle);
+    Q_UNUSED(fd);
+#endif
+}
+
+int DirectoryHandleCache::createdCount() const
+{
+    return m_created;
+}
+
+void DirectoryHandleCache::createTree(const QVector<QByteArray> &relativeDirs, int threads)
+{
+    if (!isValid())
+    {
+        return;
+    }
+
+    // 親も含めて重複を除き、深さごと・親ごとにまとめる
+    QSet<QByteArray> all;
+    for (const QByteArray &dir : relativeDirs)
+    {
+        QByteArray current = dir;
+        while (!current.isEmpty() && !all.contains(current) && !m_handles.contains(current))
+        {
+            all.insert(current);
+            DirectoryHandleCache::split(current, &current, nullptr);
+        }
+    }
+    if (all.isEmpty())
+    {
+        return;
+    }
+
+    QMap<int, QHash<QByteArray, QVector<QByteArray>>> levels;
+    for (const QByteArray &dir : all)
+    {
+        QByteArray parent;
+        QByteArray name;
+        split(dir, &parent, &name);
+        levels[dir.count('/')][parent].append(name);
+    }
+
+#ifdef Q_OS_LINUX
+    if (threads <= 0)
+    {
+        threads = qBound(1, QThread::idealThreadCount(), 16);
+    }
+    const int rootFd = m_handles.value(QByteArray()).fd;
+    const QByteArray rootPath = QFile::encodeName(m_rootPath);
+    std::atomic<int> created{0};
+
+    // 親が揃ってから子を作るので深さごとに進める。同じ深さの中は親ごとに並列
+    for (auto level = levels.cbegin(); level != levels.cend(); ++level)
+    {
+        const QList<QByteArray> parents = level.value().keys();
+        std::atomic<int> next{0};
+        auto work = [&]()
+        {
+            for (int i = next.fetch_add(1); i < parents.size(); i = next.fetch_add(1))
+            {
+                const QByteArray &parent = parents.at(i);
+                int parentFd = rootFd;
+                if (!parent.isEmpty())
+                {
+                    parentFd = rootFd >= 0 ? ::openat(rootFd, parent.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+                                           : ::open((rootPath + '/' + parent).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                }
+                if (parentFd < 0)
+                {
+                    continue; // 作れなかったフォルダはコピー時に改めて報告される
+                }
+                for (const QByteArray &name : level.value().value(parent))
+                {
+                    if (::mkdirat(parentFd, name.constData(), 0777) == 0)
+                    {
+                        created.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (parentFd != rootFd)
+                {
+                    ::close(parentFd);
+                }
+            }
+        };
+
+        const int workers = qMin(threads, static_cast<int>(parents.size()));
+        QVector<QThread *> pool;
+        for (int i = 1; i < workers; ++i)
+        {
+            pool.append(QThread::create(ThreadPriority::inheritCurrent(work)));
+            pool.last()->start();
+        }
+        work();
+        for (QThread *thread : pool)
+        {
+            thread->wait();
+            delete thread;
+        }
+    }
+    m_created += created.load();
+#else
+    Q_UNUSED(threads);
+    for (const QByteArray &dir : all)
+    {
+        handle(dir, true);
+    }
+#endif
+}
@@ -0,0 +1,77 @@
+#ifndef DIRECTORYHANDLECACHE_H
+#define DIRECTORYHANDLECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+// 開いているディレクトリ。fd が -1 の環境ではパスで扱う
+struct DirectoryHandle
+{
+    int fd = -1;
+    QString path;
+
+    bool isValid() const { return !path.isEmpty(); }
+
+    // name をこのディレクトリの中のパスにする（パスでしか扱えない処理用）
+    QString filePath(const QByteArray &name) const;
+};
+
+// ルート以下のディレクトリを開いたまま保持し、相対パスで引けるようにする。
+// Linux では親ディレクトリの fd から openat/mkdirat で1段ずつたどるので、
+// ファイルごとにルートからパスを解決し直さずに済む。パスは UTF-8 などの
+// ファイルシステムのバイト列（QFile::encodeName）、区切りは '/' で渡す。
+// 単一スレッドから使うこと。返した fd はこのオブジェクトが閉じるまで有効。
+// 開いたままにする fd の数には上限があり、超えた分は fd -1（パスで扱う）として返す。
+// fd はディレクトリの実体（デバイスと inode）ごとに1つだけ持ち、シンボリックリンクなどで
+// 別の相対パスから同じディレクトリに着いた場合は既存の fd を共有する。
+class DirectoryHandleCache
+{
+public:
+    explicit DirectoryHandleCache(const QString &rootPath, int maxOpenHandles = 512);
+    ~DirectoryHandleCache();
+
+    // ルートが開けたか
+    bool isValid() const;
+    QString errorString() const;
+
+    // relativeDir（空ならルート）を開く。create なら途中のディレクトリも作る
+    DirectoryHandle handle(const QByteArray &relativeDir, bool create = false);
+
+    // relativeDirs とその親をまとめて作成する（コピー前の骨組み作成）。
+    // 同じ深さのフォルダは親ごとに threads 本で並列に作る。threads が 0 なら CPU 数
+    void createTree(const QVector<QByteArray> &relativeDirs, int threads = 0);
+
+    // このキャッシュで新たに作成したフォルダの数
+    int createdCount() const;
+
+    // relativePath をディレクトリ部分と名前に分ける
+    static void split(const QByteArray &relativePath, QByteArray *relativeDir, QByteArray *name);
+
+private:
+    DirectoryHandleCache(const DirectoryHandleCache &) = delete;
+    DirectoryHandleCache &operator=(const DirectoryHandleCache &) = delete;
+
+    struct DirectoryId
+    {
+        quint64 device;
+        quint64 inode;
+
+        bool operator==(const DirectoryId &other) const { return device == other.device && inode == other.inode; }
+    };
+    friend size_t qHash(const DirectoryId &id, size_t seed) { return qHashMulti(seed, id.device, id.inode); }
+
+    // 開いた fd を登録する（同じ実体の fd があればそちらを使い、新しい fd は閉じる）
+    void adopt(DirectoryHandle &handle, int fd);
+
+    QString m_rootPath;
+    QString m_errorString;
+    QHash<QByteArray, DirectoryHandle> m_handles;
+    QHash<DirectoryId, int> m_fdByIdentity;
+    int m_maxOpenHandles;
+    int m_openHandles;
+    int m_created;
+};
+
+#endif // DIRECTORYHANDLECACHE_H
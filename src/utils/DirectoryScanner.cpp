@@ -0,0 +1,325 @@
+#include "DirectoryScanner.h"
+#include <QFile>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace
+{
+#ifdef Q_OS_LINUX
+    // getdents64 が返すレコード（glibc はこの構造体を公開していない）
+    struct LinuxDirent64
+    {
+        quint64 d_ino;
+        qint64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    const int kDentBufferSize = 64 * 1024;
+
+    DirectoryScanner::Type typeFromMode(mode_t mode)
+    {
+        if (S_ISREG(mode))
+        {
+            return DirectoryScanner::File;
+        }
+        if (S_ISDIR(mode))
+        {
+            return DirectoryScanner::Directory;
+        }
+        return DirectoryScanner::Other;
+    }
+#endif
+}
+
+QString DirectoryScanner::Entry::fileName() const
+{
+    return QFile::decodeName(name);
+}
+
+DirectoryScanner::DirectoryScanner(const QString &path)
+    : DirectoryScanner(path, Options())
+{
+}
+
+DirectoryScanner::DirectoryScanner(const QString &path, const Options &options)
+    : m_options(options),
+      m_sortedIndex(0),
+      m_sortedLoaded(false)
+#ifdef Q_OS_LINUX
+      ,
+      m_fd(-1),
+      m_bufferPos(0),
+      m_bufferEnd(0),
+      m_eof(false)
+#endif
+{
+#ifdef Q_OS_LINUX
+    m_fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_fd < 0)
+    {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return;
+    }
+    m_buffer.resize(kDentBufferSize);
+#else
+    QDir::Filters filters = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System;
+    if (m_options.includeHidden)
+    {
+        filters |= QDir::Hidden;
+    }
+    if (!QFileInfo(path).isDir())
+    {
+        m_errorString = QStringLiteral("Not a directory: %1").arg(path);
+        return;
+    }
+    m_iterator.reset(new QDirIterator(path, filters));
+#endif
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+#endif
+}
+
+bool DirectoryScanner::isOpen() const
+{
+#ifdef Q_OS_LINUX
+    return m_fd >= 0;
+#else
+    return m_iterator != nullptr;
+#endif
+}
+
+QString DirectoryScanner::errorString() const
+{
+    return m_errorString;
+}
+
+QVector<DirectoryScanner::Entry> DirectoryScanner::list(const QString &path, const Options &options)
+{
+    QVector<Entry> entries;
+    DirectoryScanner scanner(path, options);
+    Entry entry;
+    while (scanner.next(entry))
+    {
+        entries.append(entry);
+    }
+    return entries;
+}
+
+bool DirectoryScanner::next(Entry &entry)
+{
+    if (!m_options.sorted)
+    {
+        return readNext(entry);
+    }
+
+    if (!m_sortedLoaded)
+    {
+        Entry loaded;
+        while (readNext(loaded))
+        {
+            m_sortedEntries.append(loaded);
+        }
+        std::sort(m_sortedEntries.begin(), m_sortedEntries.end(), [](const Entry &a, const Entry &b)
+                  { return a.name < b.name; });
+        m_sortedLoaded = true;
+    }
+
+    if (m_sortedIndex >= m_sortedEntries.size())
+    {
+        return false;
+    }
+    entry = m_sortedEntries.at(m_sortedIndex++);
+    return true;
+}
+
+#ifdef Q_OS_LINUX
+
+bool DirectoryScanner::fill()
+{
+    for (;;)
+    {
+        const long n = syscall(SYS_getdents64, m_fd, m_buffer.data(), m_buffer.size());
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            m_errorString = QString::fromLocal8Bit(strerror(errno));
+        }
+        if (n <= 0)
+        {
+            m_eof = true;
+            return false;
+        }
+        m_bufferPos = 0;
+        m_bufferEnd = static_cast<int>(n);
+        return true;
+    }
+}
+
+bool DirectoryScanner::readNext(Entry &entry)
+{
+    if (m_fd < 0)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        if (m_bufferPos >= m_bufferEnd && (m_eof || !fill()))
+        {
+            return false;
+        }
+
+        const LinuxDirent64 *dent = reinterpret_cast<const LinuxDirent64 *>(m_buffer.constData() + m_bufferPos);
+        m_bufferPos += dent->d_reclen;
+
+        const char *name = dent->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            continue;
+        }
+        if (!m_options.includeHidden && name[0] == '.')
+        {
+            continue;
+        }
+
+        entry.name = QByteArray(name);
+        entry.isSymlink = dent->d_type == DT_LNK;
+        entry.size = -1;
+        switch (dent->d_type)
+        {
+        case DT_REG:
+            entry.type = File;
+            break;
+        case DT_DIR:
+            entry.type = Directory;
+            break;
+        case DT_LNK:
+        case DT_UNKNOWN:
+            entry.type = Unknown;
+            break;
+        default:
+            entry.type = Other;
+            break;
+        }
+
+        if (accept(entry))
+        {
+            return true;
+        }
+    }
+}
+
+bool DirectoryScanner::accept(Entry &entry)
+{
+    const bool resolveLink = entry.isSymlink && m_options.followSymlinks;
+    const bool needType = entry.type == Unknown;
+    const bool wantsFileStat = m_options.needSize || m_options.needMetadata;
+    const bool needSize = wantsFileStat && entry.type != Directory && entry.type != Other;
+    if (!needType && !needSize)
+    {
+        return true;
+    }
+
+    // 必要な項目だけを要求する（STATX_TYPE だけならネットワークファイルシステムでも軽い）
+    unsigned int mask = STATX_TYPE;
+    if (needSize)
+    {
+        mask |= STATX_SIZE;
+    }
+    if (needSize && m_options.needMetadata)
+    {
+        mask |= STATX_MTIME | STATX_MODE;
+    }
+    int flags = AT_STATX_SYNC_AS_STAT;
+    if (entry.isSymlink && !resolveLink)
+    {
+        flags |= AT_SYMLINK_NOFOLLOW;
+    }
+
+    struct statx stx;
+    if (statx(m_fd, entry.name.constData(), flags, mask, &stx) != 0)
+    {
+        // リンク切れや走査中に消えたエントリ
+        entry.type = Other;
+        return true;
+    }
+
+    entry.type = typeFromMode(stx.stx_mode);
+    if (needSize && entry.type == File)
+    {
+        entry.size = static_cast<qint64>(stx.stx_size);
+        if (m_options.needMetadata)
+        {
+            entry.mtimeNs = static_cast<qint64>(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec;
+            entry.mode = stx.stx_mode & 07777;
+        }
+    }
+    return true;
+}
+
+#else
+
+bool DirectoryScanner::readNext(Entry &entry)
+{
+    if (!m_iterator || !m_iterator->hasNext())
+    {
+        return false;
+    }
+
+    m_iterator->next();
+    const QFileInfo info = m_iterator->fileInfo();
+    entry.name = QFile::encodeName(info.fileName());
+    entry.isSymlink = info.isSymLink();
+    entry.type = info.isDir() ? Directory : (info.isFile() ? File : Other);
+    const bool wantsFileStat = (m_options.needSize || m_options.needMetadata) && entry.type == File;
+    entry.size = wantsFileStat ? info.size() : -1;
+    if (wantsFileStat && m_options.needMetadata)
+    {
+        entry.mtimeNs = info.lastModified().toMSecsSinceEpoch() * 1000000;
+        // QFileDevice::Permissions を POSIX のビットに直す（所有者 0700 / グループ 070 / その他 07）
+        const QFileDevice::Permissions permissions = info.permissions();
+        entry.mode = 0;
+        entry.mode |= (permissions & QFileDevice::ReadOwner) ? 0400 : 0;
+        entry.mode |= (permissions & QFileDevice::WriteOwner) ? 0200 : 0;
+        entry.mode |= (permissions & QFileDevice::ExeOwner) ? 0100 : 0;
+        entry.mode |= (permissions & QFileDevice::ReadGroup) ? 040 : 0;
+        entry.mode |= (permissions & QFileDevice::WriteGroup) ? 020 : 0;
+        entry.mode |= (permissions & QFileDevice::ExeGroup) ? 010 : 0;
+        entry.mode |= (permissions & QFileDevice::ReadOther) ? 04 : 0;
+        entry.mode |= (permissions & QFileDevice::WriteOther) ? 02 : 0;
+        entry.mode |= (permissions & QFileDevice::ExeOther) ? 01 : 0;
+    }
+    return accept(entry);
+}
+
+bool DirectoryScanner::accept(Entry &entry)
+{
+    Q_UNUSED(entry);
+    return true;
+}
+
+#endif
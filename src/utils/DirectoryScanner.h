@@ -0,0 +1,89 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <memory>
+
+class QDirIterator;
+
+// 1つのディレクトリのエントリを順に読み出す。
+// Linux では openat + getdents64 で読み、d_type で種類が分かるものは stat しない。
+// 種類が不明なエントリやサイズが必要な場合だけ statx を最小限のマスクで呼ぶ。
+// QDir::entryInfoList と違い、sorted を指定しない限り並べ替えも一括の確保もしない。
+// その他の環境では QDirIterator で同じインターフェースを提供する。
+class DirectoryScanner
+{
+public:
+    enum Type
+    {
+        Unknown,
+        File,
+        Directory,
+        Other // デバイス、FIFO、ソケット、リンク切れのシンボリックリンクなど
+    };
+
+    struct Entry
+    {
+        QByteArray name; // ファイルシステム上のバイト列（QFile::decodeName で QString にする）
+        Type type = Unknown;
+        bool isSymlink = false;
+        qint64 size = -1;   // needSize / needMetadata のときのみ
+        qint64 mtimeNs = 0; // needMetadata のときのみ（UNIX 時刻のナノ秒）
+        quint32 mode = 0;   // needMetadata のときのみ（パーミッションのビット 07777）
+
+        QString fileName() const;
+    };
+
+    struct Options
+    {
+        bool needSize = false;      // 通常ファイルのサイズを取得する
+        bool needMetadata = false;  // 通常ファイルのサイズ・更新時刻・パーミッションを取得する
+        bool followSymlinks = true; // シンボリックリンクはリンク先の種類で返す（QFileInfo と同じ）
+        bool includeHidden = true;  // '.' で始まる名前を含める
+        bool sorted = false;        // 名前のバイト順に並べる（全エントリを読んでから返す）
+    };
+
+    explicit DirectoryScanner(const QString &path);
+    DirectoryScanner(const QString &path, const Options &options);
+    ~DirectoryScanner();
+
+    bool isOpen() const;
+    QString errorString() const;
+
+    // 次のエントリを読む。終わりまたはエラーなら false
+    bool next(Entry &entry);
+
+    // 全エントリをまとめて読む
+    static QVector<Entry> list(const QString &path, const Options &options);
+
+private:
+    DirectoryScanner(const DirectoryScanner &) = delete;
+    DirectoryScanner &operator=(const DirectoryScanner &) = delete;
+
+    bool readNext(Entry &entry);
+    bool accept(Entry &entry);
+
+    Options m_options;
+    QString m_errorString;
+
+    // sorted のときに先読みしたエントリ
+    QVector<Entry> m_sortedEntries;
+    int m_sortedIndex;
+    bool m_sortedLoaded;
+
+#ifdef Q_OS_LINUX
+    bool fill();
+
+    int m_fd;
+    QByteArray m_buffer;
+    int m_bufferPos;
+    int m_bufferEnd;
+    bool m_eof;
+#else
+    std::unique_ptr<QDirIterator> m_iterator;
+#endif
+};
+
+#endif // DIRECTORYSCANNER_H
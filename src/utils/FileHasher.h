@@ -0,0 +1,51 @@
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <functional>
+#include <memory>
+
+// ファイルの内容のハッシュを計算する。マニフェストに記録するハッシュと同じ方式で、
+// 検証や定期点検で読み直した内容と比べるのに使う。
+// 読み込みは固定長のバッファで先頭から順に行い、先読みはカーネルに「この先 readAheadBytes だけ」
+// を少しずつ頼む（posix_fadvise）。並列に何ファイル読んでも、先読みで抱えるメモリは
+// スレッド数 × readAheadBytes に収まる。1つのインスタンスは1スレッドから使うこと。
+class FileHasher
+{
+public:
+    struct Options
+    {
+        qint64 readAheadBytes = 8 * 1024 * 1024; // 先読みを頼む範囲（0 なら頼まない）
+        int bufferSize = 1024 * 1024;
+        // 読み込むたびにこのスレッドで呼ばれる（速さの上限を守るために待つなど）。false を返すと中止する
+        std::function<bool(qint64 bytes)> onRead;
+    };
+
+    FileHasher();
+    explicit FileHasher(const Options &options);
+    ~FileHasher();
+
+    // マニフェストのハッシュの方式
+    static QCryptographicHash::Algorithm algorithm();
+
+    // path の内容のハッシュ。読めなかった・中止した場合は空
+    QByteArray hash(const QString &path);
+
+    // これまでに読んだバイト数
+    qint64 bytesRead() const;
+    QString errorString() const;
+
+private:
+    FileHasher(const FileHasher &) = delete;
+    FileHasher &operator=(const FileHasher &) = delete;
+
+    Options m_options;
+    std::unique_ptr<char[]> m_buffer;
+    QCryptographicHash m_hash;
+    qint64 m_bytesRead;
+    QString m_errorString;
+};
+
+#endif // FILEHASHER_H
@@ -0,0 +1,307 @@
+#include "FileIndex.h"
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const qint64 kNameChunkSize = 64 * 1024;
+
+    // '/' を最も小さい文字として比べる（TreeWalker の並び順と同じ）
+    bool pathLess(const QByteArray &a, const QByteArray &b)
+    {
+        const qsizetype length = qMin(a.size(), b.size());
+        for (qsizetype i = 0; i < length; ++i)
+        {
+            const uchar ca = static_cast<uchar>(a.at(i));
+            const uchar cb = static_cast<uchar>(b.at(i));
+            if (ca == cb)
+            {
+                continue;
+            }
+            if (ca == '/')
+            {
+                return true;
+            }
+            if (cb == '/')
+            {
+                return false;
+            }
+            return ca < cb;
+        }
+        return a.size() < b.size();
+    }
+
+    std::string_view toView(QByteArrayView name)
+    {
+        return std::string_view(name.data(), static_cast<size_t>(name.size()));
+    }
+
+}
+
+FileIndex::FileIndex(std::pmr::memory_resource *resource)
+    : m_resource(resource),
+      m_chunks(resource),
+      m_names(resource),
+      m_nameLookup(resource),
+      m_dirParent(resource),
+      m_dirName(resource),
+      m_fileDir(resource),
+      m_fileName(resource),
+      m_fileSize(resource),
+      m_fileMtime(resource),
+      m_fileMode(resource)
+{
+    clear();
+}
+
+FileIndex::~FileIndex()
+{
+    releaseChunks();
+}
+
+void FileIndex::releaseChunks()
+{
+    for (char *chunk : m_chunks)
+    {
+        m_resource->deallocate(chunk, kNameChunkSize, 1);
+    }
+    m_chunks.clear();
+}
+
+void FileIndex::clear()
+{
+    releaseChunks();
+    m_chunkUsed = 0;
+    m_names.clear();
+    m_nameLookup.clear();
+    m_dirParent.clear();
+    m_dirName.clear();
+    m_fileDir.clear();
+    m_fileName.clear();
+    m_fileSize.clear();
+    m_fileMtime.clear();
+    m_fileMode.clear();
+    m_totalSize = 0;
+
+    // ルートは親なし・空の名前
+    m_dirParent.push_back(kInvalidId);
+    m_dirName.push_back(intern(QByteArrayView()));
+}
+
+FileIndex::Id FileIndex::intern(QByteArrayView name)
+{
+    const auto existing = m_nameLookup.find(toView(name));
+    if (existing != m_nameLookup.end())
+    {
+        return existing->second;
+    }
+
+    // 名前は最大でも数百バイトなのでチャンクに収まる
+    if (m_chunks.empty() || m_chunkUsed + name.size() > kNameChunkSize)
+    {
+        m_chunks.push_back(static_cast<char *>(m_resource->allocate(kNameChunkSize, 1)));
+        m_chunkUsed = 0;
+    }
+    char *data = m_chunks.back() + m_chunkUsed;
+    if (!name.isEmpty())
+    {
+        memcpy(data, name.data(), name.size());
+    }
+    m_chunkUsed += name.size();
+
+    const Id id = static_cast<Id>(m_names.size());
+    const QByteArrayView stored(data, name.size());
+    m_names.push_back(stored);
+    m_nameLookup.emplace(toView(stored), id);
+    return id;
+}
+
+FileIndex::Id FileIndex::addDirectory(Id parent, QByteArrayView name)
+{
+    const Id id = static_cast<Id>(m_dirParent.size());
+    m_dirParent.push_back(parent);
+    m_dirName.push_back(intern(name));
+    return id;
+}
+
+FileIndex::Id FileIndex::addFile(Id directory, QByteArrayView name, qint64 size, qint64 mtimeNs, quint32 mode)
+{
+    const Id id = static_cast<Id>(m_fileDir.size());
+    m_fileDir.push_back(directory);
+    m_fileName.push_back(intern(name));
+    m_fileSize.push_back(size);
+    m_fileMtime.push_back(mtimeNs);
+    m_fileMode.push_back(mode);
+    m_totalSize += size;
+    return id;
+}
+
+int FileIndex::directoryCount() const
+{
+    return static_cast<int>(m_dirParent.size());
+}
+
+int FileIndex::fileCount() const
+{
+    return static_cast<int>(m_fileDir.size());
+}
+
+qint64 FileIndex::totalSize() const
+{
+    return m_totalSize;
+}
+
+FileIndex::Id FileIndex::parentDirectory(Id directory) const
+{
+    return m_dirParent.at(directory);
+}
+
+QByteArrayView FileIndex::directoryName(Id directory) const
+{
+    return m_names.at(m_dirName.at(directory));
+}
+
+QByteArray FileIndex::directoryPath(Id directory) const
+{
+    // 親をたどって名前を集め、逆順につなぐ
+    QVector<Id> chain;
+    qsizetype length = 0;
+    for (Id current = directory; current != kRootDirectory && current != kInvalidId; current = m_dirParent.at(current))
+    {
+        chain.append(current);
+        length += directoryName(current).size() + 1;
+    }
+
+    QByteArray path;
+    path.reserve(length);
+    for (auto it = chain.crbegin(); it != chain.crend(); ++it)
+    {
+        if (!path.isEmpty())
+        {
+            path.append('/');
+        }
+        path.append(directoryName(*it));
+    }
+    return path;
+}
+
+FileIndex::Id FileIndex::fileDirectory(Id file) const
+{
+    return m_fileDir.at(file);
+}
+
+QByteArrayView FileIndex::fileName(Id file) const
+{
+    return m_names.at(m_fileName.at(file));
+}
+
+QByteArray FileIndex::filePath(Id file) const
+{
+    QByteArray path = directoryPath(fileDirectory(file));
+    if (!path.isEmpty())
+    {
+        path.append('/');
+    }
+    path.append(fileName(file));
+    return path;
+}
+
+qint64 FileIndex::fileSize(Id file) const
+{
+    return m_fileSize.at(file);
+}
+
+qint64 FileIndex::fileMtime(Id file) const
+{
+    return m_fileMtime.at(file);
+}
+
+quint32 FileIndex::fileMode(Id file) const
+{
+    return m_fileMode.at(file);
+}
+
+void FileIndex::sort()
+{
+    // ディレクトリは数が少ないのでパスを組み立てて順位を付ける
+    QVector<QByteArray> dirPaths;
+    dirPaths.reserve(directoryCount());
+    QVector<Id> dirOrder;
+    dirOrder.reserve(directoryCount());
+    for (Id dir = 0; dir < static_cast<Id>(directoryCount()); ++dir)
+    {
+        dirPaths.append(directoryPath(dir));
+        dirOrder.append(dir);
+    }
+    std::sort(dirOrder.begin(), dirOrder.end(), [&](Id a, Id b)
+              { return pathLess(dirPaths.at(a), dirPaths.at(b)); });
+    QVector<Id> dirRank(directoryCount());
+    for (int rank = 0; rank < dirOrder.size(); ++rank)
+    {
+        dirRank[dirOrder.at(rank)] = static_cast<Id>(rank);
+    }
+
+    QVector<Id> order;
+    order.reserve(fileCount());
+    for (Id file = 0; file < static_cast<Id>(fileCount()); ++file)
+    {
+        order.append(file);
+    }
+    std::sort(order.begin(), order.end(), [&](Id a, Id b)
+              {
+        const Id rankA = dirRank.at(m_fileDir.at(a));
+        const Id rankB = dirRank.at(m_fileDir.at(b));
+        if (rankA != rankB)
+        {
+            return rankA < rankB;
+        }
+        return toView(fileName(a)) < toView(fileName(b)); });
+
+    // 列をその場で並べ替える（巡回置換をたどる）。新しい列を確保しないので、
+    // アリーナ上で古い列の分のメモリが無駄にならない
+    for (Id start = 0; start < static_cast<Id>(order.size()); ++start)
+    {
+        if (order.at(start) == start)
+        {
+            continue;
+        }
+        const Id dir = m_fileDir[start];
+        const Id name = m_fileName[start];
+        const qint64 size = m_fileSize[start];
+        const qint64 mtime = m_fileMtime[start];
+        const quint32 mode = m_fileMode[start];
+        Id to = start;
+        while (order.at(to) != start)
+        {
+            const Id from = order.at(to);
+            m_fileDir[to] = m_fileDir[from];
+            m_fileName[to] = m_fileName[from];
+            m_fileSize[to] = m_fileSize[from];
+            m_fileMtime[to] = m_fileMtime[from];
+            m_fileMode[to] = m_fileMode[from];
+            order[to] = to;
+            to = from;
+        }
+        m_fileDir[to] = dir;
+        m_fileName[to] = name;
+        m_fileSize[to] = size;
+        m_fileMtime[to] = mtime;
+        m_fileMode[to] = mode;
+        order[to] = to;
+    }
+}
+
+qint64 FileIndex::memoryUsage() const
+{
+    qint64 bytes = static_cast<qint64>(m_chunks.size()) * kNameChunkSize;
+    bytes += static_cast<qint64>(m_names.capacity() * sizeof(QByteArrayView));
+    // ハッシュ表はバケット配列とノード（キー・値・次へのポインタ・ハッシュ値）のおおよその値
+    bytes += static_cast<qint64>(m_nameLookup.bucket_count()) * qint64(sizeof(void *));
+    bytes += static_cast<qint64>(m_nameLookup.size()) * qint64(sizeof(std::string_view) + sizeof(Id) + 2 * sizeof(void *));
+    bytes += static_cast<qint64>((m_dirParent.capacity() + m_dirName.capacity()) * sizeof(Id));
+    bytes += static_cast<qint64>((m_fileDir.capacity() + m_fileName.capacity()) * sizeof(Id));
+    bytes += static_cast<qint64>((m_fileSize.capacity() + m_fileMtime.capacity()) * sizeof(qint64));
+    bytes += static_cast<qint64>(m_fileMode.capacity() * sizeof(quint32));
+    return bytes;
+}
@@ -0,0 +1,85 @@
+#ifndef FILEINDEX_H
+#define FILEINDEX_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 走査結果を省メモリで保持するファイル一覧。
+// ディレクトリは親の番号と名前だけを持つ木として保存し、名前はアリーナにまとめて
+// 重複なく格納する（同じ名前は1回だけ）。ファイルの属性は列ごとの配列に持つ。
+// 絶対パスの QString を並べる QFileInfoList に比べ、共通の接頭辞を繰り返さない。
+// パスはファイルシステムのバイト列（QFile::encodeName）で、区切りは '/'。
+// 保持するメモリは指定したリソース（実行中は RunArena）から取る。
+// スレッドセーフではない（並列に追加する場合は呼び出し側でロックする）。
+class FileIndex
+{
+public:
+    using Id = quint32;
+    static constexpr Id kRootDirectory = 0;
+    static constexpr Id kInvalidId = 0xffffffffu;
+
+    explicit FileIndex(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    ~FileIndex();
+
+    void clear();
+
+    Id addDirectory(Id parent, QByteArrayView name);
+    Id addFile(Id directory, QByteArrayView name, qint64 size, qint64 mtimeNs, quint32 mode);
+
+    int directoryCount() const;
+    int fileCount() const;
+    qint64 totalSize() const;
+
+    Id parentDirectory(Id directory) const;
+    QByteArrayView directoryName(Id directory) const;
+    // ルートからの相対パス（ルートは空）
+    QByteArray directoryPath(Id directory) const;
+
+    Id fileDirectory(Id file) const;
+    QByteArrayView fileName(Id file) const;
+    QByteArray filePath(Id file) const;
+    qint64 fileSize(Id file) const;
+    qint64 fileMtime(Id file) const; // ナノ秒（UNIX 時刻）
+    quint32 fileMode(Id file) const; // パーミッションのビット（07777）
+
+    // ファイルをディレクトリのパス順、同じディレクトリ内は名前順に並べ替える
+    // （ディレクトリの中身は親の直後に来る）
+    void sort();
+
+    // 確保しているメモリのおおよそのバイト数
+    qint64 memoryUsage() const;
+
+private:
+    FileIndex(const FileIndex &) = delete;
+    FileIndex &operator=(const FileIndex &) = delete;
+
+    Id intern(QByteArrayView name);
+    void releaseChunks();
+
+    std::pmr::memory_resource *m_resource;
+
+    // 名前のアリーナ。チャンクは移動しないので QByteArrayView で指せる
+    std::pmr::vector<char *> m_chunks;
+    qint64 m_chunkUsed;
+    std::pmr::vector<QByteArrayView> m_names;
+    std::pmr::unordered_map<std::string_view, Id> m_nameLookup;
+
+    // ディレクトリ
+    std::pmr::vector<Id> m_dirParent;
+    std::pmr::vector<Id> m_dirName;
+
+    // ファイル（列ごとの配列）
+    std::pmr::vector<Id> m_fileDir;
+    std::pmr::vector<Id> m_fileName;
+    std::pmr::vector<qint64> m_fileSize;
+    std::pmr::vector<qint64> m_fileMtime;
+    std::pmr::vector<quint32> m_fileMode;
+
+    qint64 m_totalSize;
+};
+
+#endif // FILEINDEX_H
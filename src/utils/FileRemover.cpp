@@ -0,0 +1,571 @@
+#include "FileRemover.h"
+#include "DirectoryHandleCache.h"
+#include "ThreadPriority.h"
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QDirIterator>
+#include <QThread>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+FileRemover::FileRemover(const QString &rootPath)
+    : FileRemover(rootPath, Options())
+{
+}
+
+FileRemover::FileRemover(const QString &rootPath, const Options &options)
+    : m_rootPath(QDir::cleanPath(rootPath)),
+      m_options(options),
+      m_rootFd(-1),
+      m_cancelled(false),
+      m_removedFiles(0),
+      m_removedDirectories(0),
+      m_maxOperationsPerSecond(options.maxOperationsPerSecond),
+      m_operations(0),
+      m_rateStartMs(0),
+      m_outstanding(0)
+{
+    if (m_options.threads <= 0)
+    {
+        m_options.threads = qBound(1, QThread::idealThreadCount(), 16);
+    }
+    m_options.batchSize = qMax(1, m_options.batchSize);
+#ifdef Q_OS_LINUX
+    m_rootFd = ::open(QFile::encodeName(m_rootPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#endif
+}
+
+FileRemover::~FileRemover()
+{
+#ifdef Q_OS_LINUX
+    if (m_rootFd >= 0)
+    {
+        ::close(m_rootFd);
+    }
+#endif
+}
+
+int FileRemover::openDirectory(const QByteArray &relativeDir) const
+{
+#ifdef Q_OS_LINUX
+    if (m_rootFd < 0)
+    {
+        return -1;
+    }
+    if (relativeDir.isEmpty())
+    {
+        return m_rootFd;
+    }
+    int fd = m_rootFd;
+    for (const QByteArray &component : relativeDir.split('/'))
+    {
+        const int next = ::openat(fd, component.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        const int error = errno;
+        if (fd != m_rootFd)
+        {
+            ::close(fd);
+        }
+        if (next < 0)
+        {
+            errno = error;
+            return -1;
+        }
+        fd = next;
+    }
+    return fd;
+#else
+    Q_UNUSED(relativeDir);
+    return -1;
+#endif
+}
+
+void FileRemover::addFailure(const QByteArray &path, const QString &errorString)
+{
+    QMutexLocker locker(&m_mutex);
+    m_failures.append(Failure{path, errorString});
+}
+
+void FileRemover::throttle()
+{
+    const qint64 rate = m_maxOperationsPerSecond;
+    if (rate <= 0)
+    {
+        return;
+    }
+    // 上限を決めた時点からの操作数に見合う時間が経つまで待つ
+    // （上限の変更と重なって見積もりがずれても、1回の待ちは1秒までにする）
+    const qint64 operations = m_operations.fetch_add(1) + 1;
+    const qint64 due = m_rateStartMs + operations * 1000 / rate;
+    const qint64 elapsed = m_timer.elapsed();
+    if (due > elapsed)
+    {
+        QThread::msleep(static_cast<unsigned long>(qMin<qint64>(due - elapsed, 1000)));
+    }
+}
+
+void FileRemover::runWorkers(int threads, const std::function<void()> &work)
+{
+    m_timer.start();
+    m_rateStartMs = 0;
+    m_operations = 0;
+
+    QVector<QThread *> pool;
+    for (int i = 0; i < qMax(1, threads); ++i)
+    {
+        pool.append(QThread::create(ThreadPriority::inheritCurrent(work)));
+        pool.last()->start();
+    }
+    // TreeWalker と同じく、待つ間に呼び出し元へ進捗を返す
+    for (QThread *thread : pool)
+    {
+        while (!thread->wait(100))
+        {
+            if (m_options.onProgress && !m_options.onProgress(progress()))
+            {
+                cancel();
+            }
+        }
+        delete thread;
+    }
+    if (m_options.onProgress)
+    {
+        m_options.onProgress(progress());
+    }
+}
+
+void FileRemover::removeBatch(const QVector<QByteArray> &relativePaths, const Batch &batch)
+{
+    qint64 removed = 0;
+#ifdef Q_OS_LINUX
+    const int dirFd = openDirectory(batch.directory);
+    if (dirFd < 0)
+    {
+        // フォルダごとないなら、中のファイルも削除済み
+        const int error = errno;
+        if (error == ENOENT)
+        {
+            removed = batch.count;
+        }
+        else
+        {
+            const QString message = QString::fromLocal8Bit(strerror(error));
+            for (int i = batch.first; i < batch.first + batch.count; ++i)
+            {
+                addFailure(relativePaths.at(i), message);
+            }
+        }
+    }
+    else
+    {
+        const qsizetype nameOffset = batch.directory.isEmpty() ? 0 : batch.directory.size() + 1;
+        for (int i = batch.first; i < batch.first + batch.count && !isCancelled(); ++i)
+        {
+            const QByteArray &path = relativePaths.at(i);
+            throttle();
+            if (::unlinkat(dirFd, path.constData() + nameOffset, 0) == 0 || errno == ENOENT)
+            {
+                removed++;
+            }
+            else
+            {
+                addFailure(path, QString::fromLocal8Bit(strerror(errno)));
+            }
+        }
+        if (dirFd != m_rootFd)
+        {
+            ::close(dirFd);
+        }
+    }
+#else
+    for (int i = batch.first; i < batch.first + batch.count && !isCancelled(); ++i)
+    {
+        const QByteArray &path = relativePaths.at(i);
+        throttle();
+        QFile file(m_rootPath + QLatin1Char('/') + QFile::decodeName(path));
+        if (file.remove() || !file.exists())
+        {
+            removed++;
+        }
+        else
+        {
+            addFailure(path, file.errorString());
+        }
+    }
+#endif
+
+    m_removedFiles += removed;
+}
+
+void FileRemover::removeFiles(const QVector<QByteArray> &relativePaths)
+{
+#ifdef Q_OS_LINUX
+    if (m_rootFd < 0)
+    {
+        const QString message = QString::fromLocal8Bit(strerror(ENOENT));
+        for (const QByteArray &path : relativePaths)
+        {
+            addFailure(path, message);
+        }
+        return;
+    }
+#endif
+
+    // 同じフォルダの並びを batchSize ずつに区切る
+    QVector<Batch> batches;
+    for (int i = 0; i < relativePaths.size(); ++i)
+    {
+        QByteArray directory;
+        DirectoryHandleCache::split(relativePaths.at(i), &directory, nullptr);
+        if (batches.isEmpty() || batches.last().directory != directory || batches.last().count >= m_options.batchSize)
+        {
+            batches.append(Batch{directory, i, 0});
+        }
+        batches.last().count++;
+    }
+
+    if (batches.isEmpty())
+    {
+        return;
+    }
+
+    std::atomic<int> next{0};
+    auto work = [&]()
+    {
+        for (int i = next.fetch_add(1); i < batches.size() && !isCancelled(); i = next.fetch_add(1))
+        {
+            removeBatch(relativePaths, batches.at(i));
+        }
+    };
+    runWorkers(qMin(m_options.threads, static_cast<int>(batches.size())), work);
+}
+
+int FileRemover::removeEmptyDirectories(const QVector<QByteArray> &relativeDirs)
+{
+    QSet<QByteArray> all;
+    for (const QByteArray &dir : relativeDirs)
+    {
+        QByteArray current = dir;
+        while (!current.isEmpty() && !all.contains(current))
+        {
+            all.insert(current);
+            DirectoryHandleCache::split(current, &current, nullptr);
+        }
+    }
+
+    // 子を先に消せるよう深い順に並べる
+    QVector<QByteArray> ordered(all.cbegin(), all.cend());
+    std::sort(ordered.begin(), ordered.end(), [](const QByteArray &a, const QByteArray &b)
+              { return a.count('/') > b.count('/'); });
+
+    int removed = 0;
+    for (const QByteArray &dir : ordered)
+    {
+        // 中身が残っているフォルダは削除に失敗するだけなので、エラーは無視する
+#ifdef Q_OS_LINUX
+        QByteArray parent;
+        QByteArray name;
+        DirectoryHandleCache::split(dir, &parent, &name);
+        const int parentFd = openDirectory(parent);
+        if (parentFd < 0)
+        {
+            continue;
+        }
+        if (::unlinkat(parentFd, name.constData(), AT_REMOVEDIR) == 0)
+        {
+            removed++;
+            m_removedDirectories++;
+        }
+        if (parentFd != m_rootFd)
+        {
+            ::close(parentFd);
+        }
+#else
+        if (QDir(m_rootPath).rmdir(QFile::decodeName(dir)))
+        {
+            removed++;
+            m_removedDirectories++;
+        }
+#endif
+    }
+    return removed;
+}
+
+bool FileRemover::removeTree(const QByteArray &relativeDir)
+{
+    const qsizetype failuresBefore = failures().size();
+#ifdef Q_OS_LINUX
+    if (m_rootFd < 0)
+    {
+        addFailure(relativeDir, QString::fromLocal8Bit(strerror(ENOENT)));
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_nodes.clear();
+        m_queue.clear();
+        m_nodes.push_back(std::unique_ptr<TreeNode>(new TreeNode{relativeDir, nullptr, {1}}));
+        m_queue.push_back(m_nodes.back().get());
+        m_outstanding = 1;
+    }
+    runWorkers(m_options.threads, [this]()
+               { treeWorker(); });
+
+    QMutexLocker locker(&m_queueMutex);
+    m_nodes.clear();
+    m_queue.clear();
+#else
+    // 中身を先に集め、ファイルを消してから深い順にフォルダを消す
+    const QString base = relativeDir.isEmpty() ? m_rootPath : m_rootPath + QLatin1Char('/') + QFile::decodeName(relativeDir);
+    QVector<QByteArray> files;
+    QVector<QByteArray> directories;
+    if (!relativeDir.isEmpty())
+    {
+        directories.append(relativeDir);
+    }
+    const QDir root(m_rootPath);
+    QDirIterator it(base, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext() && !isCancelled())
+    {
+        it.next();
+        const QByteArray path = QFile::encodeName(root.relativeFilePath(it.filePath()));
+        if (it.fileInfo().isDir() && !it.fileInfo().isSymLink())
+        {
+            directories.append(path);
+        }
+        else
+        {
+            files.append(path);
+        }
+    }
+    removeFiles(files);
+    std::sort(directories.begin(), directories.end(), [](const QByteArray &a, const QByteArray &b)
+              { return a.count('/') > b.count('/'); });
+    for (const QByteArray &dir : directories)
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+        if (root.rmdir(QFile::decodeName(dir)))
+        {
+            m_removedDirectories++;
+        }
+        else
+        {
+            addFailure(dir, QStringLiteral("Failed to remove directory"));
+        }
+    }
+#endif
+    return !isCancelled() && failures().size() == failuresBefore;
+}
+
+void FileRemover::treeWorker()
+{
+    for (;;)
+    {
+        TreeNode *node = nullptr;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            while (m_queue.empty() && m_outstanding > 0 && !isCancelled())
+            {
+                m_queueCondition.wait(&m_queueMutex, 100);
+            }
+            if (m_queue.empty() || isCancelled())
+            {
+                return;
+            }
+            node = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        scanAndRemove(node);
+
+        QMutexLocker locker(&m_queueMutex);
+        if (--m_outstanding == 0)
+        {
+            m_queueCondition.wakeAll();
+        }
+    }
+}
+
+void FileRemover::scanAndRemove(TreeNode *node)
+{
+#ifdef Q_OS_LINUX
+    const int dirFd = openDirectory(node->path);
+    if (dirFd < 0)
+    {
+        // 既にないなら消えたものとして親へ進める
+        if (errno != ENOENT)
+        {
+            addFailure(node->path, QString::fromLocal8Bit(strerror(errno)));
+        }
+        completeNode(node);
+        return;
+    }
+
+    // readdir 用の DIR は複製した fd で持ち、unlinkat は元の fd で行う
+    DIR *dir = ::fdopendir(::fcntl(dirFd, F_DUPFD_CLOEXEC, 0));
+    if (!dir)
+    {
+        addFailure(node->path, QString::fromLocal8Bit(strerror(errno)));
+    }
+    QVector<TreeNode *> children;
+    const QByteArray prefix = node->path.isEmpty() ? QByteArray() : node->path + '/';
+    while (dir && !isCancelled())
+    {
+        errno = 0;
+        const dirent *entry = ::readdir(dir);
+        if (!entry)
+        {
+            if (errno != 0)
+            {
+                addFailure(node->path, QString::fromLocal8Bit(strerror(errno)));
+            }
+            break;
+        }
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            continue;
+        }
+
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN)
+        {
+            struct stat st;
+            isDirectory = ::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
+
+        if (isDirectory)
+        {
+            // 子が終わるまで自分を rmdir しないよう、積む前に数えておく
+            node->pending++;
+            children.append(new TreeNode{prefix + name, node, {1}});
+            continue;
+        }
+
+        throttle();
+        if (::unlinkat(dirFd, name, 0) == 0 || errno == ENOENT)
+        {
+            m_removedFiles++;
+        }
+        else
+        {
+            addFailure(prefix + name, QString::fromLocal8Bit(strerror(errno)));
+        }
+    }
+    if (dir)
+    {
+        ::closedir(dir);
+    }
+    if (dirFd != m_rootFd)
+    {
+        ::close(dirFd);
+    }
+
+    if (!children.isEmpty())
+    {
+        QMutexLocker locker(&m_queueMutex);
+        for (TreeNode *child : children)
+        {
+            m_nodes.push_back(std::unique_ptr<TreeNode>(child));
+            m_queue.push_back(child);
+        }
+        m_outstanding += children.size();
+        m_queueCondition.wakeAll();
+    }
+    completeNode(node);
+#else
+    Q_UNUSED(node);
+#endif
+}
+
+void FileRemover::completeNode(TreeNode *node)
+{
+    // 最後に終わった子が親の rmdir を引き受ける。再帰せずに上へたどる
+    while (node && node->pending.fetch_sub(1) == 1)
+    {
+        if (node->path.isEmpty() || isCancelled())
+        {
+            return;
+        }
+#ifdef Q_OS_LINUX
+        QByteArray parent;
+        QByteArray name;
+        DirectoryHandleCache::split(node->path, &parent, &name);
+        const int parentFd = openDirectory(parent);
+        if (parentFd < 0)
+        {
+            if (errno != ENOENT)
+            {
+                addFailure(node->path, QString::fromLocal8Bit(strerror(errno)));
+            }
+        }
+        else
+        {
+            throttle();
+            if (::unlinkat(parentFd, name.constData(), AT_REMOVEDIR) == 0 || errno == ENOENT)
+            {
+                m_removedDirectories++;
+            }
+            else
+            {
+                addFailure(node->path, QString::fromLocal8Bit(strerror(errno)));
+            }
+            if (parentFd != m_rootFd)
+            {
+                ::close(parentFd);
+            }
+        }
+#endif
+        node = node->parent;
+    }
+}
+
+void FileRemover::setMaxOperationsPerSecond(qint64 operationsPerSecond)
+{
+    m_rateStartMs = m_timer.isValid() ? m_timer.elapsed() : 0;
+    m_operations = 0;
+    m_maxOperationsPerSecond = operationsPerSecond;
+}
+
+void FileRemover::cancel()
+{
+    m_cancelled = true;
+}
+
+bool FileRemover::isCancelled() const
+{
+    return m_cancelled;
+}
+
+FileRemover::Progress FileRemover::progress() const
+{
+    Progress result;
+    result.files = m_removedFiles;
+    result.directories = m_removedDirectories;
+    QMutexLocker locker(&m_mutex);
+    result.failures = m_failures.size();
+    return result;
+}
+
+qint64 FileRemover::removedCount() const
+{
+    return m_removedFiles;
+}
+
+QVector<FileRemover::Failure> FileRemover::failures() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failures;
+}
@@ -0,0 +1,129 @@
+#ifndef FILEREMOVER_H
+#define FILEREMOVER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+// ルート以下のファイルやフォルダをまとめて削除する。
+// ファイルはフォルダごとのバッチに分け、各バッチはフォルダを1回だけ開いて
+// その fd から unlinkat するので、ファイルごとにルートからパスを解決し直さない。
+// バッチは複数スレッドで並列に処理する。フォルダはシンボリックリンクをたどらずに開くので、
+// リンク先（ルートの外）のファイルを消すことはない。
+// パスはファイルシステムのバイト列（QFile::encodeName）、区切りは '/'。
+class FileRemover
+{
+public:
+    struct Progress
+    {
+        qint64 files = 0;       // 削除したファイル（既になかったものを含む）
+        qint64 directories = 0; // 削除したフォルダ
+        qint64 failures = 0;
+    };
+
+    struct Options
+    {
+        int threads = 0;                   // 0 なら CPU 数（最大 16）
+        int batchSize = 256;               // removeFiles の1バッチのファイル数の上限
+        qint64 maxOperationsPerSecond = 0; // 削除の速さの上限（同時に動くバックアップの I/O を妨げないため）。0 なら制限なし
+        // 呼び出し元スレッドで約 100 ms ごとに呼ばれる。false を返すと中止する
+        std::function<bool(const Progress &progress)> onProgress;
+    };
+
+    struct Failure
+    {
+        QByteArray path; // ルートからの相対パス
+        QString errorString;
+    };
+
+    explicit FileRemover(const QString &rootPath);
+    FileRemover(const QString &rootPath, const Options &options);
+    ~FileRemover();
+
+    // relativePaths のファイルを削除する。同じフォルダのファイルは並べて渡すこと
+    // （マニフェストの順ならそうなっている）。既にないファイルは削除済みとして数える
+    void removeFiles(const QVector<QByteArray> &relativePaths);
+
+    // relativeDirs とその親のうち、空になったものを深い順に削除する（ルートは残す）。
+    // 削除したフォルダの数を返す
+    int removeEmptyDirectories(const QVector<QByteArray> &relativeDirs);
+
+    // relativeDir 以下をすべて削除し、relativeDir 自身も削除する（空ならルートの中身だけを消す）。
+    // 再帰せずにフォルダをキューで配り、各スレッドが中のファイルを消してサブフォルダを積む。
+    // フォルダは中身がすべて消えた時点で下から順に rmdir する。
+    // 失敗や中止がなければ true
+    bool removeTree(const QByteArray &relativeDir = QByteArray());
+
+    // 削除の速さの上限を変える（別のスレッドから呼んでよい。実行中なら以降の削除に効く）
+    void setMaxOperationsPerSecond(qint64 operationsPerSecond);
+
+    // 実行中の削除を止める（別のスレッドから呼んでよい）。一度止めると以降の削除も行わない
+    void cancel();
+    bool isCancelled() const;
+
+    Progress progress() const;
+    qint64 removedCount() const;
+    QVector<Failure> failures() const;
+
+private:
+    FileRemover(const FileRemover &) = delete;
+    FileRemover &operator=(const FileRemover &) = delete;
+
+    struct Batch
+    {
+        QByteArray directory;
+        int first; // relativePaths の範囲
+        int count;
+    };
+
+    // removeTree で処理するフォルダ。pending は自分の走査と未完了のサブフォルダの数で、
+    // 0 になったら自分を rmdir して親の pending を減らす
+    struct TreeNode
+    {
+        QByteArray path;
+        TreeNode *parent;
+        std::atomic<int> pending;
+    };
+
+    void removeBatch(const QVector<QByteArray> &relativePaths, const Batch &batch);
+    void scanAndRemove(TreeNode *node);
+    void completeNode(TreeNode *node);
+    void treeWorker();
+    void addFailure(const QByteArray &path, const QString &errorString);
+    // 削除の速さの上限を超えないよう必要なら待つ
+    void throttle();
+    // threads 本のスレッドで work を動かし、終わるまで呼び出し元で進捗を通知する
+    void runWorkers(int threads, const std::function<void()> &work);
+    // relativeDir をシンボリックリンクをたどらずに1段ずつ開く。失敗したら -1
+    int openDirectory(const QByteArray &relativeDir) const;
+
+    QString m_rootPath;
+    Options m_options;
+    int m_rootFd;
+    std::atomic<bool> m_cancelled;
+    std::atomic<qint64> m_removedFiles;
+    std::atomic<qint64> m_removedDirectories;
+    std::atomic<qint64> m_maxOperationsPerSecond;
+    std::atomic<qint64> m_operations; // m_rateStartMs からの操作数
+    std::atomic<qint64> m_rateStartMs;
+    QElapsedTimer m_timer;
+
+    mutable QMutex m_mutex; // m_failures を守る
+    QVector<Failure> m_failures;
+
+    // removeTree の作業キュー
+    QMutex m_queueMutex;
+    QWaitCondition m_queueCondition;
+    std::deque<TreeNode *> m_queue;
+    std::deque<std::unique_ptr<TreeNode>> m_nodes;
+    int m_outstanding; // キューにあるか処理中のフォルダの数
+};
+
+#endif // FILEREMOVER_H
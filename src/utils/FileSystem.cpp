@@ -4,9 +4,601 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QApplication>
+#include <QTemporaryFile>
+#include <QDateTime>
+#include "CopyPipeline.h"
+#include "TreeWalker.h"
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#endif
 
 namespace FileSystem
 {
+    namespace
+    {
+        const qint64 kCopyBufferSize = 1024 * 1024;
+        // setDropCache で書き出してからキャッシュから外す区切り。書き出しを待つのは1つ前の区切りだけなので、
+        // 書き込みとディスクへの書き出しが重なる
+        const qint64 kDropWindow = 8 * 1024 * 1024;
+
+        void setError(QString *errorString, const QString &message)
+        {
+            if (errorString)
+            {
+                *errorString = message;
+            }
+        }
+
+#ifdef Q_OS_LINUX
+        QString errnoString(const char *what)
+        {
+            return QString("%1: %2").arg(QString::fromLatin1(what), QString::fromLocal8Bit(strerror(errno)));
+        }
+
+        bool syncDirectory(const QByteArray &dirPath)
+        {
+            int fd = ::open(dirPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                return false;
+            }
+            bool ok = ::fsync(fd) == 0;
+            ::close(fd);
+            return ok;
+        }
+
+        // Qtのパーミッションフラグを mode_t に変換する
+        mode_t toMode(QFileDevice::Permissions permissions)
+        {
+            mode_t mode = 0;
+            if (permissions & QFileDevice::ReadOwner)
+                mode |= S_IRUSR;
+            if (permissions & QFileDevice::WriteOwner)
+                mode |= S_IWUSR;
+            if (permissions & QFileDevice::ExeOwner)
+                mode |= S_IXUSR;
+            if (permissions & QFileDevice::ReadGroup)
+                mode |= S_IRGRP;
+            if (permissions & QFileDevice::WriteGroup)
+                mode |= S_IWGRP;
+            if (permissions & QFileDevice::ExeGroup)
+                mode |= S_IXGRP;
+            if (permissions & QFileDevice::ReadOther)
+                mode |= S_IROTH;
+            if (permissions & QFileDevice::WriteOther)
+                mode |= S_IWOTH;
+            if (permissions & QFileDevice::ExeOther)
+                mode |= S_IXOTH;
+            return mode;
+        }
+
+        // O_TMPFILE で開いた名前のないファイルに path の名前を付ける。/proc がなければ AT_EMPTY_PATH を使う
+        bool linkAnonymous(int fd, const QByteArray &path)
+        {
+            const QByteArray procPath = "/proc/self/fd/" + QByteArray::number(fd);
+            if (::linkat(AT_FDCWD, procPath.constData(), AT_FDCWD, path.constData(), AT_SYMLINK_FOLLOW) == 0)
+            {
+                return true;
+            }
+#ifdef AT_EMPTY_PATH
+            return ::linkat(fd, "", AT_FDCWD, path.constData(), AT_EMPTY_PATH) == 0;
+#else
+            return false;
+#endif
+        }
+
+        // 名前のないファイルに後から名前を付けられるか。/proc がなく、AT_EMPTY_PATH も
+        // 権限（CAP_DAC_READ_SEARCH）が足りずに使えない環境がある。プロセスで一度だけ fd で試す
+        bool canLinkAnonymous(int fd, const QByteArray &dirPath)
+        {
+            static std::atomic<int> state(-1);
+            const int known = state.load();
+            if (known >= 0)
+            {
+                return known == 1;
+            }
+            bool ok = ::access("/proc/self/fd", X_OK) == 0;
+            if (!ok)
+            {
+                const QByteArray probePath = dirPath + "/.sbs-link-probe-" + QByteArray::number(::getpid());
+                ::unlink(probePath.constData());
+                ok = linkAnonymous(fd, probePath);
+                if (ok)
+                {
+                    ::unlink(probePath.constData());
+                }
+            }
+            state.store(ok ? 1 : 0);
+            return ok;
+        }
+#else
+        std::filesystem::path toFsPath(const QString &path)
+        {
+#ifdef Q_OS_WIN
+            return std::filesystem::path(path.toStdWString());
+#else
+            return std::filesystem::path(QFile::encodeName(path).toStdString());
+#endif
+        }
+#endif
+    }
+
+#ifdef Q_OS_LINUX
+    void adviseSequentialRead(int fd)
+    {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    void dropCachedRange(int fd, qint64 offset, qint64 length)
+    {
+        ::posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+    }
+
+    AtomicFileWriter::AtomicFileWriter(const QString &destination)
+        : m_destination(destination), m_fd(-1), m_anonymous(false),
+          m_dropCache(false), m_written(0), m_flushStarted(0), m_dropped(0)
+    {
+    }
+
+    void AtomicFileWriter::setDropCache(bool enabled)
+    {
+        m_dropCache = enabled;
+    }
+
+    void AtomicFileWriter::dropWrittenPages(bool all)
+    {
+        while (m_written - m_flushStarted >= kDropWindow || (all && m_written > m_flushStarted))
+        {
+            const qint64 end = all ? m_written : m_flushStarted + kDropWindow;
+            // 今の区切りの書き出しを始めてから、1つ前の区切りの書き出しを待って外す
+            ::sync_file_range(m_fd, m_flushStarted, end - m_flushStarted, SYNC_FILE_RANGE_WRITE);
+            if (m_flushStarted > m_dropped)
+            {
+                ::sync_file_range(m_fd, m_dropped, m_flushStarted - m_dropped,
+                                  SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+                dropCachedRange(m_fd, m_dropped, m_flushStarted - m_dropped);
+                m_dropped = m_flushStarted;
+            }
+            m_flushStarted = end;
+        }
+        if (all && m_written > m_dropped)
+        {
+            ::sync_file_range(m_fd, m_dropped, m_written - m_dropped,
+                              SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            dropCachedRange(m_fd, m_dropped, m_written - m_dropped);
+            m_dropped = m_written;
+        }
+    }
+
+    AtomicFileWriter::~AtomicFileWriter()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+        // commit されなかった一時ファイルを片付ける
+        if (!m_tmpPath.isEmpty())
+        {
+            ::unlink(m_tmpPath.constData());
+        }
+    }
+
+    bool AtomicFileWriter::open(QFileDevice::Permissions permissions)
+    {
+        const QFileInfo destInfo(m_destination);
+        const QByteArray dirPath = QFile::encodeName(destInfo.absolutePath());
+        const mode_t mode = toMode(permissions);
+
+        // まず名前のない O_TMPFILE を試す。途中で落ちてもゴミが残らない
+#ifdef O_TMPFILE
+        m_fd = ::open(dirPath.constData(), O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+        if (m_fd >= 0 && !canLinkAnonymous(m_fd, dirPath))
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        m_anonymous = m_fd >= 0;
+#endif
+        if (m_fd < 0)
+        {
+            // O_TMPFILE 非対応のファイルシステムでは名前付き一時ファイルを使う
+            m_tmpPath = dirPath + "/." + QFile::encodeName(destInfo.fileName()) + ".sbs-XXXXXX";
+            m_fd = ::mkostemp(m_tmpPath.data(), O_CLOEXEC);
+            if (m_fd < 0)
+            {
+                m_errorString = errnoString("mkostemp");
+                m_tmpPath.clear();
+                return false;
+            }
+        }
+
+        // umask の影響を受けないように元ファイルと同じ権限にする
+        ::fchmod(m_fd, mode);
+        return true;
+    }
+
+    bool AtomicFileWriter::write(const char *data, qint64 size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(m_fd, data, static_cast<size_t>(size));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                m_errorString = errnoString("write");
+                return false;
+            }
+            data += written;
+            size -= written;
+            m_written += written;
+        }
+        if (m_dropCache)
+        {
+            dropWrittenPages(false);
+        }
+        return true;
+    }
+
+    bool AtomicFileWriter::copyFrom(int sourceFd, const ChunkCallback &beforeChunk)
+    {
+        // 1回の呼び出しで大きく進めつつ、止めたいときに長く待たせない程度の長さにする
+        const size_t kernelChunk = 64 * kCopyBufferSize;
+        qint64 sourceOffset = 0;
+        if (m_dropCache)
+        {
+            adviseSequentialRead(sourceFd);
+            sourceOffset = qMax<qint64>(0, ::lseek(sourceFd, 0, SEEK_CUR));
+        }
+        // 速さの制限に渡すのは、元の大きさから見て実際に進む量まで。
+        // 大きさの分を進め終えた後の（末尾を確かめるだけの）呼び出しでは渡さない
+        qint64 remaining = -1;
+        struct stat sourceStat;
+        if (::fstat(sourceFd, &sourceStat) == 0 && S_ISREG(sourceStat.st_mode))
+        {
+            remaining = qMax<qint64>(0, sourceStat.st_size - qMax<qint64>(0, ::lseek(sourceFd, 0, SEEK_CUR)));
+        }
+        auto charge = [&](qint64 chunk)
+        {
+            if (!beforeChunk || remaining == 0)
+            {
+                return;
+            }
+            beforeChunk(remaining > 0 ? qMin(chunk, remaining) : chunk);
+        };
+        // 元の読み終えた範囲をキャッシュから外す（コピーしたデータは書き込み側で外す）
+        auto consumed = [&](qint64 bytes)
+        {
+            if (remaining > 0)
+            {
+                remaining = qMax<qint64>(0, remaining - bytes);
+            }
+            if (m_dropCache)
+            {
+                dropCachedRange(sourceFd, sourceOffset, bytes);
+                sourceOffset += bytes;
+            }
+        };
+        for (;;)
+        {
+            charge(static_cast<qint64>(kernelChunk));
+            const ssize_t copied = ::copy_file_range(sourceFd, nullptr, m_fd, nullptr, kernelChunk, 0);
+            if (copied > 0)
+            {
+                m_written += copied;
+                consumed(copied);
+                if (m_dropCache)
+                {
+                    dropWrittenPages(false);
+                }
+                continue;
+            }
+            if (copied == 0)
+            {
+                return true;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP)
+            {
+                m_errorString = errnoString("copy_file_range");
+                return false;
+            }
+            break;
+        }
+
+        // 古いカーネルや特殊なファイルシステムでは、ここまでに進んだ位置から読み書きで続ける
+        std::unique_ptr<char[]> buffer(new char[kCopyBufferSize]);
+        for (;;)
+        {
+            charge(kCopyBufferSize);
+            const ssize_t bytesRead = ::read(sourceFd, buffer.get(), kCopyBufferSize);
+            if (bytesRead < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                m_errorString = errnoString("read");
+                return false;
+            }
+            if (bytesRead == 0)
+            {
+                return true;
+            }
+            if (!write(buffer.get(), bytesRead))
+            {
+                return false;
+            }
+            consumed(bytesRead);
+        }
+    }
+
+    bool AtomicFileWriter::commit(bool syncFile)
+    {
+        if (m_fd < 0)
+        {
+            m_errorString = QStringLiteral("commit: file is not open");
+            return false;
+        }
+
+        const QByteArray dirPath = QFile::encodeName(QFileInfo(m_destination).absolutePath());
+
+        // 残りを書き出してキャッシュから外す（データは書き出し済みなので、この後の fsync は軽い）
+        if (m_dropCache)
+        {
+            dropWrittenPages(true);
+        }
+
+        if (syncFile && ::fsync(m_fd) != 0)
+        {
+            m_errorString = errnoString("fsync");
+            return false;
+        }
+
+        if (m_anonymous)
+        {
+            // 一時名を付けてから rename で置き換える
+            m_tmpPath = dirPath + "/." + QFile::encodeName(QFileInfo(m_destination).fileName()) + ".sbs-" + QByteArray::number(::getpid()) + "-" + QByteArray::number(m_fd);
+            ::unlink(m_tmpPath.constData());
+            if (!linkAnonymous(m_fd, m_tmpPath))
+            {
+                m_errorString = errnoString("linkat");
+                m_tmpPath.clear();
+                return false;
+            }
+        }
+
+        const int fd = m_fd;
+        m_fd = -1;
+        if (::close(fd) != 0)
+        {
+            m_errorString = errnoString("close");
+            return false;
+        }
+
+        if (::rename(m_tmpPath.constData(), QFile::encodeName(m_destination).constData()) != 0)
+        {
+            m_errorString = errnoString("rename");
+            return false;
+        }
+        m_tmpPath.clear();
+
+        // rename 自体を永続化するためにディレクトリも fsync する
+        if (syncFile)
+        {
+            syncDirectory(dirPath);
+        }
+        return true;
+    }
+#else
+    AtomicFileWriter::AtomicFileWriter(const QString &destination)
+        : m_destination(destination), m_tempFile(nullptr)
+    {
+    }
+
+    AtomicFileWriter::~AtomicFileWriter()
+    {
+        // autoRemove が有効なままなら commit されなかった一時ファイルは削除される
+        delete m_tempFile;
+    }
+
+    bool AtomicFileWriter::open(QFileDevice::Permissions permissions)
+    {
+        const QFileInfo destInfo(m_destination);
+        m_tempFile = new QTemporaryFile(destInfo.absolutePath() + "/." + destInfo.fileName() + ".sbs-XXXXXX");
+        if (!m_tempFile->open())
+        {
+            m_errorString = m_tempFile->errorString();
+            return false;
+        }
+        m_tempFile->setPermissions(permissions);
+        return true;
+    }
+
+    void AtomicFileWriter::setDropCache(bool enabled)
+    {
+        Q_UNUSED(enabled);
+    }
+
+    bool AtomicFileWriter::write(const char *data, qint64 size)
+    {
+        if (m_tempFile->write(data, size) != size)
+        {
+            m_errorString = m_tempFile->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    bool AtomicFileWriter::commit(bool syncFile)
+    {
+        if (!m_tempFile || !m_tempFile->isOpen())
+        {
+            m_errorString = QStringLiteral("commit: file is not open");
+            return false;
+        }
+
+        if (!m_tempFile->flush())
+        {
+            m_errorString = m_tempFile->errorString();
+            return false;
+        }
+
+        if (syncFile)
+        {
+#ifdef Q_OS_WIN
+            _commit(m_tempFile->handle());
+#else
+            ::fsync(m_tempFile->handle());
+#endif
+        }
+
+        const QString tempPath = m_tempFile->fileName();
+        m_tempFile->close();
+
+        // std::filesystem::rename は既存のファイルを置き換える（WindowsではMoveFileEx）
+        std::error_code ec;
+        std::filesystem::rename(toFsPath(tempPath), toFsPath(m_destination), ec);
+        if (ec)
+        {
+            m_errorString = QString::fromStdString(ec.message());
+            return false;
+        }
+        m_tempFile->setAutoRemove(false);
+        return true;
+    }
+#endif
+
+    QString AtomicFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool copyFileAtomic(const QString &source, const QString &destination,
+                        bool syncFile, QString *errorString)
+    {
+        QFile sourceFile(source);
+        if (!sourceFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        {
+            setError(errorString, sourceFile.errorString());
+            return false;
+        }
+
+        AtomicFileWriter writer(destination);
+        if (!writer.open(sourceFile.permissions()))
+        {
+            setError(errorString, writer.errorString());
+            return false;
+        }
+
+        std::unique_ptr<char[]> buffer(new char[kCopyBufferSize]);
+        qint64 n;
+        while ((n = sourceFile.read(buffer.get(), kCopyBufferSize)) > 0)
+        {
+            if (!writer.write(buffer.get(), n))
+            {
+                setError(errorString, writer.errorString());
+                return false;
+            }
+        }
+        if (n < 0)
+        {
+            setError(errorString, sourceFile.errorString());
+            return false;
+        }
+
+        if (!writer.commit(syncFile))
+        {
+            setError(errorString, writer.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    bool copyFile(const QString &source, const QString &destination,
+                  bool syncFile, QString *errorString)
+    {
+        // 読み込みと書き込みを別スレッドで重ねる共有パイプラインを使う
+        return CopyPipeline::shared().copy(source, destination, syncFile, errorString);
+    }
+
+    bool syncFileSystem(const QString &path)
+    {
+#ifdef Q_OS_LINUX
+        int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = ::syncfs(fd) == 0;
+        ::close(fd);
+        return ok;
+#else
+        Q_UNUSED(path);
+        qWarning() << "syncFileSystem is not supported on this platform";
+        return false;
+#endif
+    }
+
+    bool syncPath(const QString &path)
+    {
+#ifdef Q_OS_WIN
+        if (QFileInfo(path).isDir())
+        {
+            return true;
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            return false;
+        }
+        return _commit(file.handle()) == 0;
+#else
+        int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    bool setModificationTime(const QString &path, qint64 mtimeNs)
+    {
+#ifdef Q_OS_WIN
+        QFile file(path);
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            return false;
+        }
+        return file.setFileTime(QDateTime::fromMSecsSinceEpoch(mtimeNs / 1000000), QFileDevice::FileModificationTime);
+#else
+        struct timespec times[2];
+        times[0].tv_sec = 0;
+        times[0].tv_nsec = UTIME_OMIT; // アクセス時刻はそのまま
+        times[1].tv_sec = static_cast<time_t>(mtimeNs / 1000000000);
+        times[1].tv_nsec = static_cast<long>(mtimeNs % 1000000000);
+        return ::utimensat(AT_FDCWD, QFile::encodeName(path).constData(), times, AT_SYMLINK_NOFOLLOW) == 0;
+#endif
+    }
 
     bool copyDirectory(const QString &sourceDir, const QString &destDir)
     {
@@ -28,7 +620,7 @@ namespace FileSystem
         {
             QString srcFilePath = source.filePath(file);
             QString destFilePath = destination.filePath(file);
-            if (!QFile::copy(srcFilePath, destFilePath))
+            if (!copyFile(srcFilePath, destFilePath))
             {
                 qWarning() << "Failed to copy file:" << srcFilePath << "to" << destFilePath;
                 return false;
@@ -50,32 +642,59 @@ namespace FileSystem
 
     bool deleteDirectory(const QString &dirPath)
     {
-        QDir dir(dirPath);
-        if (!dir.exists())
+        return deleteDirectory(dirPath, FileRemover::Options());
+    }
+
+    bool deleteDirectory(const QString &dirPath, const FileRemover::Options &options, QString *errorString)
+    {
+        const QFileInfo info(dirPath);
+        if (info.isSymLink())
+        {
+            // リンク先の中身は消さない
+            if (!QFile::remove(dirPath))
+            {
+                setError(errorString, QStringLiteral("Failed to remove symbolic link: %1").arg(dirPath));
+                return false;
+            }
+            return true;
+        }
+        if (!info.exists())
         {
             return true; // Directory does not exist, nothing to delete
         }
 
-        foreach (QString file, dir.entryList(QDir::Files))
+        FileRemover remover(dirPath, options);
+        if (!remover.removeTree())
         {
-            QFile::remove(dir.filePath(file));
+            const QVector<FileRemover::Failure> failures = remover.failures();
+            if (failures.isEmpty())
+            {
+                setError(errorString, QStringLiteral("Directory removal was cancelled: %1").arg(dirPath));
+            }
+            else
+            {
+                setError(errorString, QStringLiteral("Failed to remove %1 (%2 errors): %3")
+                                          .arg(QFile::decodeName(failures.first().path))
+                                          .arg(failures.size())
+                                          .arg(failures.first().errorString));
+            }
+            return false;
         }
 
-        foreach (QString subDir, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        if (!QDir().rmdir(dirPath))
         {
-            deleteDirectory(dir.filePath(subDir));
+            setError(errorString, QStringLiteral("Failed to remove directory: %1").arg(dirPath));
+            return false;
         }
-
-        return dir.rmdir(dirPath);
+        return true;
     }
 
     // 特定の名前を持つフォルダーを再帰的に検索する関数
     QStringList findSpecificFolders(const QString &rootDir, const QStringList &folderNames, int maxDepth)
     {
         QStringList result;
-        QDir dir(rootDir);
 
-        if (!dir.exists())
+        if (!QDir(rootDir).exists())
         {
             qWarning() << "Directory does not exist:" << rootDir;
             return result;
@@ -87,45 +706,52 @@ namespace FileSystem
             return result;
         }
 
-        // 直下の一致するフォルダーをチェック
-        foreach (QString folderName, folderNames)
+        // 深さ maxDepth までのフォルダを並列に列挙し、名前が一致するものを拾う
+        // （従来どおり隠しフォルダには入らず、ファイルは対象にしない）
+        TreeWalker::Options options;
+        options.sorted = true;
+        options.maxDepth = maxDepth;
+        options.includeFiles = false;
+        options.includeDirectories = true;
+        options.includeHidden = false;
+        options.onWait = []()
+        {
+            // UI応答性を維持するためのイベント処理
+            QApplication::processEvents();
+        };
+        const QVector<TreeWalker::Entry> entries = TreeWalker(options).walk(rootDir);
+
+        // QDir::exists と同じく、Windows では名前の大文字・小文字を区別しない
+#ifdef Q_OS_WIN
+        const Qt::CaseSensitivity nameCase = Qt::CaseInsensitive;
+#else
+        const Qt::CaseSensitivity nameCase = Qt::CaseSensitive;
+#endif
+        for (const TreeWalker::Entry &entry : entries)
         {
-            if (dir.exists(folderName))
+            if (!entry.isDir)
             {
-                QString fullPath = dir.filePath(folderName);
-                result.append(fullPath);
-                qDebug() << "Found matching folder:" << fullPath;
+                continue;
             }
-        }
-
-        // サブディレクトリを再帰的にチェック
-        foreach (QString subDir, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
-        {
-            QString subDirPath = dir.filePath(subDir);
-
-            // 特殊パターンのためのログ出力
-            if (subDir == "www")
+            if (folderNames.contains(entry.name, nameCase))
             {
-                qDebug() << "Checking special pattern www/save in:" << subDirPath;
+                result.append(entry.path);
+                qDebug() << "Found matching folder:" << entry.path;
             }
 
-            result.append(findSpecificFolders(subDirPath, folderNames, maxDepth - 1));
-
             // www/save のような特殊パターンもチェック
-            if (subDir == "www")
+            if (entry.name == "www")
             {
-                QString wwwSavePath = subDirPath + "/save";
+                QString wwwSavePath = entry.path + "/save";
                 if (QDir(wwwSavePath).exists())
                 {
                     result.append(wwwSavePath);
                     qDebug() << "Found special www/save pattern:" << wwwSavePath;
                 }
             }
-
-            // UI応答性を維持するためのイベント処理
-            QApplication::processEvents();
         }
 
+        result.removeDuplicates();
         return result;
     }
 
@@ -3,13 +3,93 @@
 
 #include <QString>
 #include <QStringList>
+#include <QFileDevice>
 #include <functional>
+#include "FileRemover.h"
+
+class QTemporaryFile;
 
 namespace FileSystem
 {
-    bool copyFile(const QString &source, const QString &destination);
+    // 一時ファイルに書き込み、commit() で destination を原子的に置き換える。
+    // commit() せずに破棄すると一時ファイルは削除され、既存のファイルはそのまま残る。
+    class AtomicFileWriter
+    {
+    public:
+        // copyFrom がデータを進める前に、進めるバイト数（元の大きさの残りまで）を渡して呼ぶ（速さの制限用）
+        using ChunkCallback = std::function<void(qint64 bytes)>;
+
+        explicit AtomicFileWriter(const QString &destination);
+        ~AtomicFileWriter();
+
+        bool open(QFileDevice::Permissions permissions);
+        // 書いた範囲を順にディスクへ書き出し（sync_file_range）、書き出し終えた範囲をページキャッシュから外す。
+        // copyFrom では読み終えた元の範囲も外す。大量のコピーでほかのアプリのキャッシュを追い出さないための設定で、
+        // Linux 以外では何もしない
+        void setDropCache(bool enabled);
+        bool write(const char *data, qint64 size);
+#ifdef Q_OS_LINUX
+        // sourceFd の現在位置から終わりまでをカーネル内でコピーする（copy_file_range。
+        // ファイルシステムによってはデータを複製せずに共有する）。使えない組み合わせなら読み書きに切り替える
+        bool copyFrom(int sourceFd, const ChunkCallback &beforeChunk = ChunkCallback());
+#endif
+        bool commit(bool syncFile);
+        QString errorString() const;
+
+    private:
+        AtomicFileWriter(const AtomicFileWriter &) = delete;
+        AtomicFileWriter &operator=(const AtomicFileWriter &) = delete;
+
+        QString m_destination;
+        QString m_errorString;
+#ifdef Q_OS_LINUX
+        // setDropCache のとき、書き出しを始めた範囲が区切りを超えるごとに1つ前の区切りまでを外す
+        void dropWrittenPages(bool all);
+
+        int m_fd;
+        bool m_anonymous;   // O_TMPFILE で開いたか
+        bool m_dropCache;
+        qint64 m_written;      // 書いたバイト数
+        qint64 m_flushStarted; // 書き出しを始めた位置
+        qint64 m_dropped;      // キャッシュから外した位置
+        QByteArray m_tmpPath; // 名前付き一時ファイルのパス
+#else
+        QTemporaryFile *m_tempFile;
+#endif
+    };
+
+#ifdef Q_OS_LINUX
+    // fd をこれから先頭から順に読むことをカーネルに伝える（先読みを大きくする）
+    void adviseSequentialRead(int fd);
+    // fd の [offset, offset + length) をページキャッシュから外す（length が 0 なら終わりまで）。
+    // 書き出し前の範囲は外れない
+    void dropCachedRange(int fd, qint64 offset, qint64 length);
+#endif
+
+    // 読み込みと書き込みを重ねるパイプライン経由でコピーする（置き換えは原子的）
+    bool copyFile(const QString &source, const QString &destination,
+                  bool syncFile = false, QString *errorString = nullptr);
+
+    // 呼び出したスレッドで AtomicFileWriter を使ってコピーする。
+    // syncFile が true ならファイルとディレクトリを fsync してから返す。
+    bool copyFileAtomic(const QString &source, const QString &destination,
+                        bool syncFile, QString *errorString = nullptr);
+
+    // path を含むファイルシステム全体をディスクへ書き出す（Linuxのみ syncfs）
+    bool syncFileSystem(const QString &path);
+
+    // 1つのファイルまたはディレクトリを fsync する
+    // （Windowsではディレクトリの同期はできないので何もせず true を返す）
+    bool syncPath(const QString &path);
+    // path の更新時刻を mtimeNs（UNIX 時刻のナノ秒）にする。シンボリックリンクはたどらない
+    bool setModificationTime(const QString &path, qint64 mtimeNs);
     bool copyDirectory(const QString &sourceDir, const QString &destDir);
+
+    // dirPath を中身ごと削除する（既になければ true）。FileRemover で再帰せずに並列に消す。
+    // options で進捗の通知・中止・削除の速さの上限を指定できる。
+    // シンボリックリンクならリンクだけを消す
     bool deleteDirectory(const QString &dirPath);
+    bool deleteDirectory(const QString &dirPath, const FileRemover::Options &options, QString *errorString = nullptr);
 
     // 新しい関数の宣言を追加
     QStringList findSpecificFolders(const QString &rootDir, const QStringList &folderNames);
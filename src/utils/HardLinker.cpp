@@ -0,0 +1,208 @@
+#include "HardLinker.h"
+#include "DirectoryHandleCache.h"
+#include "ThreadPriority.h"
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <filesystem>
+#include <system_error>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+HardLinker::HardLinker(const QString &sourceRoot, const QString &targetRoot)
+    : HardLinker(sourceRoot, targetRoot, Options())
+{
+}
+
+HardLinker::HardLinker(const QString &sourceRoot, const QString &targetRoot, const Options &options)
+    : m_sourceRoot(QDir::cleanPath(sourceRoot)),
+      m_targetRoot(QDir::cleanPath(targetRoot)),
+      m_options(options),
+      m_sourceFd(-1),
+      m_targetFd(-1),
+      m_linked(0)
+{
+    if (m_options.threads <= 0)
+    {
+        m_options.threads = qBound(1, QThread::idealThreadCount(), 16);
+    }
+    m_options.batchSize = qMax(1, m_options.batchSize);
+#ifdef Q_OS_LINUX
+    m_sourceFd = ::open(QFile::encodeName(m_sourceRoot).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    m_targetFd = ::open(QFile::encodeName(m_targetRoot).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#endif
+}
+
+HardLinker::~HardLinker()
+{
+#ifdef Q_OS_LINUX
+    if (m_sourceFd >= 0)
+    {
+        ::close(m_sourceFd);
+    }
+    if (m_targetFd >= 0)
+    {
+        ::close(m_targetFd);
+    }
+#endif
+}
+
+int HardLinker::openDirectory(int rootFd, const QByteArray &relativeDir)
+{
+#ifdef Q_OS_LINUX
+    if (rootFd < 0)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+    if (relativeDir.isEmpty())
+    {
+        return rootFd;
+    }
+    int fd = rootFd;
+    for (const QByteArray &component : relativeDir.split('/'))
+    {
+        const int next = ::openat(fd, component.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        const int error = errno;
+        if (fd != rootFd)
+        {
+            ::close(fd);
+        }
+        if (next < 0)
+        {
+            errno = error;
+            return -1;
+        }
+        fd = next;
+    }
+    return fd;
+#else
+    Q_UNUSED(rootFd);
+    Q_UNUSED(relativeDir);
+    return -1;
+#endif
+}
+
+void HardLinker::addFailure(const QByteArray &path, int errorCode, const QString &errorString)
+{
+    QMutexLocker locker(&m_mutex);
+    m_failures.append(Failure{path, errorCode, errorString});
+}
+
+void HardLinker::linkBatch(const QVector<QByteArray> &relativePaths, const Batch &batch)
+{
+    qint64 linked = 0;
+#ifdef Q_OS_LINUX
+    const int sourceDirFd = openDirectory(m_sourceFd, batch.directory);
+    const int sourceError = errno;
+    const int targetDirFd = sourceDirFd < 0 ? -1 : openDirectory(m_targetFd, batch.directory);
+    const int error = sourceDirFd < 0 ? sourceError : errno;
+    if (sourceDirFd < 0 || targetDirFd < 0)
+    {
+        const QString message = QString::fromLocal8Bit(strerror(error));
+        for (int i = batch.first; i < batch.first + batch.count; ++i)
+        {
+            addFailure(relativePaths.at(i), error, message);
+        }
+    }
+    else
+    {
+        const qsizetype nameOffset = batch.directory.isEmpty() ? 0 : batch.directory.size() + 1;
+        for (int i = batch.first; i < batch.first + batch.count; ++i)
+        {
+            const QByteArray &path = relativePaths.at(i);
+            const char *name = path.constData() + nameOffset;
+            if (::linkat(sourceDirFd, name, targetDirFd, name, 0) == 0)
+            {
+                linked++;
+            }
+            else
+            {
+                addFailure(path, errno, QString::fromLocal8Bit(strerror(errno)));
+            }
+        }
+    }
+    if (sourceDirFd >= 0 && sourceDirFd != m_sourceFd)
+    {
+        ::close(sourceDirFd);
+    }
+    if (targetDirFd >= 0 && targetDirFd != m_targetFd)
+    {
+        ::close(targetDirFd);
+    }
+#else
+    for (int i = batch.first; i < batch.first + batch.count; ++i)
+    {
+        const QByteArray &path = relativePaths.at(i);
+        const QString relative = QFile::decodeName(path);
+        std::error_code error;
+        std::filesystem::create_hard_link(std::filesystem::path((m_sourceRoot + QLatin1Char('/') + relative).toStdWString()),
+                                          std::filesystem::path((m_targetRoot + QLatin1Char('/') + relative).toStdWString()),
+                                          error);
+        if (!error)
+        {
+            linked++;
+        }
+        else
+        {
+            addFailure(path, 0, QString::fromStdString(error.message()));
+        }
+    }
+#endif
+    m_linked += linked;
+}
+
+void HardLinker::link(const QVector<QByteArray> &relativePaths)
+{
+    // 同じフォルダの並びを batchSize ずつに区切る
+    QVector<Batch> batches;
+    for (int i = 0; i < relativePaths.size(); ++i)
+    {
+        QByteArray directory;
+        DirectoryHandleCache::split(relativePaths.at(i), &directory, nullptr);
+        if (batches.isEmpty() || batches.last().directory != directory || batches.last().count >= m_options.batchSize)
+        {
+            batches.append(Batch{directory, i, 0});
+        }
+        batches.last().count++;
+    }
+
+    std::atomic<int> next{0};
+    auto work = [&]()
+    {
+        for (int i = next.fetch_add(1); i < batches.size(); i = next.fetch_add(1))
+        {
+            linkBatch(relativePaths, batches.at(i));
+        }
+    };
+
+    const int workers = qMin(m_options.threads, static_cast<int>(batches.size()));
+    QVector<QThread *> pool;
+    for (int i = 1; i < workers; ++i)
+    {
+        pool.append(QThread::create(ThreadPriority::inheritCurrent(work)));
+        pool.last()->start();
+    }
+    work();
+    for (QThread *thread : pool)
+    {
+        thread->wait();
+        delete thread;
+    }
+}
+
+qint64 HardLinker::linkedCount() const
+{
+    return m_linked;
+}
+
+QVector<HardLinker::Failure> HardLinker::failures() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failures;
+}
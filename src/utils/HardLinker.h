@@ -0,0 +1,67 @@
+#ifndef HARDLINKER_H
+#define HARDLINKER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+
+// sourceRoot 以下のファイルを targetRoot の同じ相対パスへハードリンクする（前の世代から変わっていない
+// ファイルをコピーせずに新しい世代へ入れる）。FileRemover と同じく、ファイルはフォルダごとのバッチに分けて
+// 両側のフォルダを1回ずつ開き、その fd から linkat する。バッチは複数スレッドで並列に処理する。
+// 保存先のフォルダは先に作っておくこと。パスはファイルシステムのバイト列、区切りは '/'。
+class HardLinker
+{
+public:
+    struct Options
+    {
+        int threads = 0;     // 0 なら CPU 数（最大 16）
+        int batchSize = 256; // 1バッチのファイル数の上限
+    };
+
+    struct Failure
+    {
+        QByteArray path; // ルートからの相対パス
+        int errorCode;   // errno（EXDEV や EMLINK ならコピーで代替できる）。不明なら 0
+        QString errorString;
+    };
+
+    HardLinker(const QString &sourceRoot, const QString &targetRoot);
+    HardLinker(const QString &sourceRoot, const QString &targetRoot, const Options &options);
+    ~HardLinker();
+
+    // relativePaths をリンクする。同じフォルダのファイルは並べて渡すこと
+    void link(const QVector<QByteArray> &relativePaths);
+
+    qint64 linkedCount() const;
+    QVector<Failure> failures() const;
+
+private:
+    HardLinker(const HardLinker &) = delete;
+    HardLinker &operator=(const HardLinker &) = delete;
+
+    struct Batch
+    {
+        QByteArray directory;
+        int first; // relativePaths の範囲
+        int count;
+    };
+
+    void linkBatch(const QVector<QByteArray> &relativePaths, const Batch &batch);
+    void addFailure(const QByteArray &path, int errorCode, const QString &errorString);
+    // rootFd から relativeDir をシンボリックリンクをたどらずに1段ずつ開く。失敗したら -1
+    static int openDirectory(int rootFd, const QByteArray &relativeDir);
+
+    QString m_sourceRoot;
+    QString m_targetRoot;
+    Options m_options;
+    int m_sourceFd;
+    int m_targetFd;
+    std::atomic<qint64> m_linked;
+
+    mutable QMutex m_mutex; // m_failures を守る
+    QVector<Failure> m_failures;
+};
+
+#endif // HARDLINKER_H
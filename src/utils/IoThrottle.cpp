@@ -0,0 +1,266 @@
+#include "IoThrottle.h"
+#include <QFile>
+#include <QThread>
+#include <cmath>
+
+namespace
+{
+    const double kMiB = 1024.0 * 1024.0;
+    // 待つときは長くてもこの間隔で起きて、制限の変更や中止を見る
+    const qint64 kMaxSleepMs = 100;
+    // adaptive で待ち時間を見る間隔
+    const qint64 kSampleIntervalMs = 500;
+    // adaptive で下げる下限（制限の 5%）と、下げていない速さがわからないときの最低限の速さ
+    const double kMinFactor = 0.05;
+    const double kMinAdaptiveBytesPerSecond = 1.0 * kMiB;
+}
+
+IoThrottle::IoThrottle()
+    : IoThrottle(Limits())
+{
+}
+
+IoThrottle::IoThrottle(const Limits &limits, IoThrottle *parent)
+    : m_limits(limits),
+      m_parent(parent),
+      m_lastRefillMs(0),
+      m_factor(1.0),
+      m_lastSampleMs(-1),
+      m_bytesSinceSample(0),
+      m_observedBytesPerSecond(0),
+      m_bypass(false),
+      m_waitedMs(0)
+{
+    m_clock.start();
+    applyRates();
+}
+
+IoThrottle &IoThrottle::global()
+{
+    static IoThrottle throttle;
+    return throttle;
+}
+
+IoThrottle::Limits IoThrottle::limits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limits;
+}
+
+void IoThrottle::setLimits(const Limits &limits)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits = limits;
+    m_limits.readMBps = qMax(0, m_limits.readMBps);
+    m_limits.writeMBps = qMax(0, m_limits.writeMBps);
+    m_limits.iops = qMax(0, m_limits.iops);
+    m_limits.latencyTargetMs = qMax(1, m_limits.latencyTargetMs);
+    if (!m_limits.adaptive)
+    {
+        m_factor = 1.0;
+        m_lastSampleMs = -1;
+    }
+    applyRates();
+}
+
+void IoThrottle::setParent(IoThrottle *parent)
+{
+    QMutexLocker locker(&m_mutex);
+    m_parent = parent;
+}
+
+void IoThrottle::setWatchedDevices(const QStringList &devices)
+{
+    QMutexLocker locker(&m_mutex);
+    m_devices = devices;
+    m_lastSampleMs = -1;
+}
+
+void IoThrottle::setBypass(bool bypass)
+{
+    m_bypass = bypass;
+}
+
+qint64 IoThrottle::waitedMs() const
+{
+    return m_waitedMs.load();
+}
+
+double IoThrottle::adaptiveFactor() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_factor;
+}
+
+void IoThrottle::resetStats()
+{
+    m_waitedMs = 0;
+}
+
+void IoThrottle::acquireRead(qint64 bytes)
+{
+    acquire(bytes, 0, m_bypass);
+}
+
+void IoThrottle::acquireWrite(qint64 bytes)
+{
+    acquire(0, bytes, m_bypass);
+}
+
+void IoThrottle::acquire(qint64 readBytes, qint64 writeBytes, const std::atomic<bool> &childBypass)
+{
+    QElapsedTimer waitTimer;
+    bool waited = false;
+    IoThrottle *parent = nullptr;
+
+    while (!m_bypass && !childBypass)
+    {
+        qint64 sleepMs = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            refill();
+            parent = m_parent;
+            sleepMs = qMax(shortfallMs(m_read, readBytes), qMax(shortfallMs(m_write, writeBytes), shortfallMs(m_ops, 1)));
+            if (sleepMs == 0)
+            {
+                // 残りが足りていれば、この読み書きで負になってもよい（大きなチャンクも通せるように、後の読み書きが待つ）
+                if (m_read.rate > 0)
+                {
+                    m_read.tokens -= readBytes;
+                }
+                if (m_write.rate > 0)
+                {
+                    m_write.tokens -= writeBytes;
+                }
+                if (m_ops.rate > 0)
+                {
+                    m_ops.tokens -= 1;
+                }
+                m_bytesSinceSample += readBytes + writeBytes;
+                break;
+            }
+        }
+        if (!waited)
+        {
+            waitTimer.start();
+            waited = true;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMin(sleepMs, kMaxSleepMs)));
+    }
+    if (waited)
+    {
+        m_waitedMs += waitTimer.elapsed();
+    }
+
+    // 子が待たずに通すようになったら、親（全体の上限）でも待たせない
+    if (parent && !m_bypass && !childBypass)
+    {
+        parent->acquire(readBytes, writeBytes, childBypass);
+    }
+}
+
+qint64 IoThrottle::shortfallMs(const Bucket &bucket, double amount)
+{
+    if (bucket.rate <= 0 || amount <= 0 || bucket.tokens >= 0)
+    {
+        return 0;
+    }
+    return qMax<qint64>(1, static_cast<qint64>(std::ceil(-bucket.tokens * 1000.0 / bucket.rate)));
+}
+
+void IoThrottle::refill()
+{
+    const qint64 now = m_clock.elapsed();
+    const double seconds = (now - m_lastRefillMs) / 1000.0;
+    m_lastRefillMs = now;
+    // 貯められるのは1秒分まで（しばらく止まっていた後に一気に読み書きしないように）
+    for (Bucket *bucket : {&m_read, &m_write, &m_ops})
+    {
+        if (bucket->rate > 0)
+        {
+            bucket->tokens = qMin(bucket->rate, bucket->tokens + bucket->rate * seconds);
+        }
+    }
+
+    if (m_limits.adaptive && !m_devices.isEmpty() && (m_lastSampleMs < 0 || now - m_lastSampleMs >= kSampleIntervalMs))
+    {
+        updateAdaptive(now);
+    }
+}
+
+void IoThrottle::updateAdaptive(qint64 nowMs)
+{
+    DiskStats current;
+    for (const QString &device : m_devices)
+    {
+        DiskStats stats;
+        if (readDiskStats(device, &stats))
+        {
+            current.completedIos += stats.completedIos;
+            current.ioMs += stats.ioMs;
+        }
+    }
+
+    if (m_lastSampleMs >= 0 && nowMs > m_lastSampleMs)
+    {
+        const quint64 ios = current.completedIos - m_lastStats.completedIos;
+        const quint64 ioMs = current.ioMs - m_lastStats.ioMs;
+        if (m_factor >= 1.0)
+        {
+            // 下げ始めるときの基準にするので、制限していない間の速さだけを覚える
+            m_observedBytesPerSecond = m_bytesSinceSample * 1000.0 / (nowMs - m_lastSampleMs);
+        }
+        if (ios > 0 && ioMs > ios * static_cast<quint64>(m_limits.latencyTargetMs))
+        {
+            m_factor = qMax(kMinFactor, m_factor * 0.5);
+        }
+        else
+        {
+            m_factor = qMin(1.0, m_factor + 0.1);
+        }
+        applyRates();
+    }
+
+    m_lastStats = current;
+    m_lastSampleMs = nowMs;
+    m_bytesSinceSample = 0;
+}
+
+void IoThrottle::applyRates()
+{
+    // 制限がない項目も、adaptive で下げている間は最近の速さを基準にして下げる
+    const double adaptiveBase = qMax(kMinAdaptiveBytesPerSecond, m_observedBytesPerSecond);
+    const bool backingOff = m_limits.adaptive && m_factor < 1.0;
+
+    m_read.rate = m_limits.readMBps > 0 ? m_limits.readMBps * kMiB * m_factor : (backingOff ? adaptiveBase * m_factor : 0);
+    m_write.rate = m_limits.writeMBps > 0 ? m_limits.writeMBps * kMiB * m_factor : (backingOff ? adaptiveBase * m_factor : 0);
+    m_ops.rate = m_limits.iops > 0 ? qMax(1.0, m_limits.iops * m_factor) : 0;
+
+    for (Bucket *bucket : {&m_read, &m_write, &m_ops})
+    {
+        bucket->tokens = bucket->rate > 0 ? qMin(bucket->tokens, bucket->rate) : 0;
+    }
+}
+
+bool IoThrottle::readDiskStats(const QString &device, DiskStats *stats, const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    const QByteArray name = device.toUtf8();
+    for (const QByteArray &line : file.readAll().split('\n'))
+    {
+        // major minor name reads merged sectors ms_reading writes merged sectors ms_writing ...
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() < 11 || fields[2] != name)
+        {
+            continue;
+        }
+        stats->completedIos = fields[3].toULongLong() + fields[7].toULongLong();
+        stats->ioMs = fields[6].toULongLong() + fields[10].toULongLong();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+#ifndef IOTHROTTLE_H
+#define IOTHROTTLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <atomic>
+
+// 読み込み・書き込みの速さ（MB/s）と I/O 回数（IOPS）をトークンバケットで制限する。
+// コピーの各ワーカーが読み書きの前に acquireRead/acquireWrite を呼び、足りなければ貯まるまで待つ。
+// 制限はいつでも変えられ（実行中でも次の読み書きから効く）、親を設定すると親の制限も同時に守る
+// （設定ごとの制限の親を全体の制限にする）。
+// adaptive を有効にすると、見張っているディスクの /proc/diskstats から I/O 1回あたりの待ち時間を
+// 求め、目安を超えたら制限を半分ずつ下げ、収まったら少しずつ戻す（ほかのアプリの読み書きを優先する）。
+class IoThrottle
+{
+public:
+    struct Limits
+    {
+        int readMBps = 0;  // 0 なら制限しない
+        int writeMBps = 0;
+        int iops = 0;
+        bool adaptive = false;
+        int latencyTargetMs = 20; // adaptive でこれを超えたら下げる
+
+        bool isEnabled() const { return readMBps > 0 || writeMBps > 0 || iops > 0 || adaptive; }
+    };
+
+    // /proc/diskstats の1行のうち、待ち時間の計算に使う値
+    struct DiskStats
+    {
+        quint64 completedIos = 0; // 読み込みと書き込みの完了数
+        quint64 ioMs = 0;         // それらにかかった時間の合計（ミリ秒）
+    };
+
+    IoThrottle();
+    explicit IoThrottle(const Limits &limits, IoThrottle *parent = nullptr);
+
+    Limits limits() const;
+    void setLimits(const Limits &limits);
+
+    // 親の制限（全体の制限など）。親はこのオブジェクトより長く生きること
+    void setParent(IoThrottle *parent);
+
+    // adaptive で待ち時間を見るディスク（sda, nvme0n1 など）
+    void setWatchedDevices(const QStringList &devices);
+
+    // bytes を読み書きする前に呼ぶ。制限を超えていれば待つ（I/O 1回として数える）
+    void acquireRead(qint64 bytes);
+    void acquireWrite(qint64 bytes);
+
+    // 待たずに通す（実行の中止時に、待っているワーカーを早く終わらせる）。親の制限でも待たなくなる
+    void setBypass(bool bypass);
+
+    // 待った時間の合計（ミリ秒）と、adaptive で今かけている倍率（1.0 なら下げていない）
+    qint64 waitedMs() const;
+    double adaptiveFactor() const;
+    void resetStats();
+
+    // アプリ全体で共有する制限
+    static IoThrottle &global();
+
+    // diskstats（/proc/diskstats の形式）から device の値を読む。テスト用にパスを変えられる
+    static bool readDiskStats(const QString &device, DiskStats *stats,
+                              const QString &path = QStringLiteral("/proc/diskstats"));
+
+private:
+    struct Bucket
+    {
+        double tokens = 0;
+        double rate = 0; // 1秒に貯まる量。0 なら制限しない
+    };
+
+    IoThrottle(const IoThrottle &) = delete;
+    IoThrottle &operator=(const IoThrottle &) = delete;
+
+    // childBypass は呼び出し元（子）の setBypass。親で待っている間に立っても抜ける
+    void acquire(qint64 readBytes, qint64 writeBytes, const std::atomic<bool> &childBypass);
+    // ロックを持ったまま呼ぶ。バケットを今の時刻まで貯め、adaptive の倍率を見直す
+    void refill();
+    void updateAdaptive(qint64 nowMs);
+    void applyRates();
+    // 足りない分が貯まるまでの時間（ミリ秒）。足りていれば 0
+    static qint64 shortfallMs(const Bucket &bucket, double amount);
+
+    mutable QMutex m_mutex;
+    Limits m_limits;
+    IoThrottle *m_parent;
+    QStringList m_devices;
+    Bucket m_read;
+    Bucket m_write;
+    Bucket m_ops;
+    QElapsedTimer m_clock;
+    qint64 m_lastRefillMs;
+
+    // adaptive
+    double m_factor;
+    qint64 m_lastSampleMs;
+    DiskStats m_lastStats;
+    qint64 m_bytesSinceSample;
+    double m_observedBytesPerSecond; // 制限がないときに下げる基準にする、最近の読み書きの速さ
+
+    std::atomic<bool> m_bypass;
+    std::atomic<qint64> m_waitedMs;
+};
+
+#endif // IOTHROTTLE_H
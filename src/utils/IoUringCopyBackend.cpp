@@ -0,0 +1,742 @@
+#include "IoUringCopyBackend.h"
+
+#ifdef SBS_HAVE_LIBURING
+
+#include "FileSystem.h"
+#include "BufferPool.h"
+#include "IoThrottle.h"
+#include "ThreadPriority.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QVector>
+#include <QFile>
+#include <QFileInfo>
+#include <QDeadlineTimer>
+#include <liburing.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+    // user_data の下位4ビットに操作の種類を入れる（FileOp は16バイト境界に置く）
+    enum OpTag : quintptr
+    {
+        TagOpenSrc,
+        TagStatx,
+        TagOpenDst,
+        TagRead,
+        TagWrite,
+        TagFsync,
+        TagLink,
+        TagCloseSrc,
+        TagCloseDst,
+        TagRename,
+        TagMask = 0xf
+    };
+
+    struct Job
+    {
+        QString source;
+        QString destination;
+        bool syncFile;
+        CopyBackend::Completion completion;
+        // submitAt のとき: 各ディレクトリの fd と、その中での名前（fd が AT_FDCWD ならパスを使う）
+        int srcDirFd = AT_FDCWD;
+        int dstDirFd = AT_FDCWD;
+        QByteArray srcName;
+        QByteArray dstName;
+    };
+
+    // 1ファイル分の状態。リングのスレッドだけが触る
+    struct alignas(16) FileOp
+    {
+        Job job;
+        QByteArray srcPath; // srcDirFd からの相対パス
+        QByteArray dstPath; // dstDirFd からの相対パス
+        QByteArray dirPath; // 出力先ディレクトリ（dstDirFd からの相対パス）
+        QByteArray tmpPrefix;
+        QByteArray baseName;
+        QByteArray tmpPath; // 名前付きの一時ファイル（失敗時に削除する）
+        QByteArray procPath;
+        struct statx stx;
+        int srcFd = -1;
+        int dstFd = -1;
+        bool anonymous = true; // O_TMPFILE を使っているか
+        char *buffer = nullptr;
+        quint64 size = 0;
+        quint64 offset = 0;
+        unsigned chunkLength = 0;
+        int lastRead = 0;
+        int inflight = 0;
+        int pendingInit = 0;
+        int pendingCloses = 0;
+        bool closing = false;
+        bool failed = false;
+        QString errorString;
+    };
+
+    QString errnoMessage(const char *what, int err)
+    {
+        return QString("%1: %2").arg(QString::fromLatin1(what), QString::fromLocal8Bit(strerror(err)));
+    }
+}
+
+struct IoUringCopyBackend::Private
+{
+    Options options;
+    io_uring ring;
+    QThread *thread = nullptr;
+
+    QMutex mutex;
+    QWaitCondition jobAvailable;
+    QWaitCondition allDone;
+    QQueue<Job> jobs;
+    int pending = 0;
+    bool stopping = false;
+
+    std::unique_ptr<BufferPool> ownedPool;
+    BufferPool *pool = nullptr;
+
+    // 以下はリングのスレッドだけが触る
+    int active = 0;
+    quint64 tempCounter = 0;
+
+    void run();
+    void enqueue(const Job &job);
+    io_uring_sqe *nextSqe();
+    void track(io_uring_sqe *sqe, FileOp *op, OpTag tag);
+    void fail(FileOp *op, const char *what, int res);
+
+    void startFile(FileOp *op);
+    void openDestination(FileOp *op);
+    void nextChunk(FileOp *op);
+    void writeTail(FileOp *op);
+    void finishData(FileOp *op);
+    void commitName(FileOp *op);
+    void beginClose(FileOp *op);
+    void afterClose(FileOp *op);
+    void finishFile(FileOp *op, bool success);
+    void handle(FileOp *op, OpTag tag, int res);
+};
+
+IoUringCopyBackend::IoUringCopyBackend()
+    : IoUringCopyBackend(Options())
+{
+}
+
+IoUringCopyBackend::IoUringCopyBackend(const Options &options)
+    : d(new Private)
+{
+    d->options = options;
+    d->options.maxFilesInFlight = qMax(1, d->options.maxFilesInFlight);
+    d->options.bufferSize = qMax<qint64>(4096, d->options.bufferSize);
+    // 1ファイルあたり同時に投入する要求は最大2つ（read+write、close×2）
+    d->options.queueDepth = qMax<unsigned>(d->options.queueDepth, static_cast<unsigned>(d->options.maxFilesInFlight) * 2);
+
+    if (io_uring_queue_init(d->options.queueDepth, &d->ring, 0) != 0)
+    {
+        qFatal("IoUringCopyBackend: io_uring_queue_init failed");
+    }
+
+    if (options.pool && options.pool->bufferSizeFor(d->options.bufferSize) > 0)
+    {
+        d->pool = options.pool;
+    }
+    else
+    {
+        BufferPool::Options poolOptions;
+        poolOptions.sizeClasses = {d->options.bufferSize};
+        poolOptions.bytesPerClass = d->options.bufferSize * d->options.maxFilesInFlight;
+        d->ownedPool.reset(new BufferPool(poolOptions));
+        d->pool = d->ownedPool.get();
+    }
+    if (d->pool->bufferSizeFor(d->options.bufferSize) == 0)
+    {
+        qFatal("IoUringCopyBackend: failed to allocate copy buffers");
+    }
+
+    Private *p = d.get();
+    d->thread = QThread::create(ThreadPriority::inheritCurrent([p]()
+                                                               { p->run(); }));
+    d->thread->start();
+}
+
+IoUringCopyBackend::~IoUringCopyBackend()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopping = true;
+        d->jobAvailable.wakeAll();
+    }
+    d->thread->wait();
+    delete d->thread;
+
+    io_uring_queue_exit(&d->ring);
+}
+
+bool IoUringCopyBackend::isSupported()
+{
+    static const bool supported = []()
+    {
+        io_uring ring;
+        if (io_uring_queue_init(8, &ring, 0) != 0)
+        {
+            return false;
+        }
+
+        bool ok = false;
+        io_uring_probe *probe = io_uring_get_probe_ring(&ring);
+        if (probe)
+        {
+            const int required[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE,
+                                    IORING_OP_FSYNC, IORING_OP_CLOSE, IORING_OP_RENAMEAT, IORING_OP_LINKAT};
+            ok = true;
+            for (int op : required)
+            {
+                ok = ok && io_uring_opcode_supported(probe, op);
+            }
+            io_uring_free_probe(probe);
+        }
+
+        io_uring_queue_exit(&ring);
+        return ok;
+    }();
+    return supported;
+}
+
+QString IoUringCopyBackend::name() const
+{
+    return QStringLiteral("io_uring (%1 files in flight)").arg(d->options.maxFilesInFlight);
+}
+
+void IoUringCopyBackend::submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion)
+{
+    d->enqueue(Job{source, destination, syncFile, completion});
+}
+
+void IoUringCopyBackend::submitAt(const DirectoryHandle &sourceDir, const QByteArray &sourceName,
+                                  const DirectoryHandle &destinationDir, const QByteArray &destinationName,
+                                  bool syncFile, const Completion &completion)
+{
+    Job job{sourceDir.filePath(sourceName), destinationDir.filePath(destinationName), syncFile, completion};
+    if (sourceDir.fd >= 0)
+    {
+        job.srcDirFd = sourceDir.fd;
+        job.srcName = sourceName;
+    }
+    if (destinationDir.fd >= 0)
+    {
+        job.dstDirFd = destinationDir.fd;
+        job.dstName = destinationName;
+    }
+    d->enqueue(job);
+}
+
+void IoUringCopyBackend::Private::enqueue(const Job &job)
+{
+    QMutexLocker locker(&mutex);
+    jobs.enqueue(job);
+    pending++;
+    jobAvailable.wakeOne();
+}
+
+bool IoUringCopyBackend::waitForDone(int timeoutMs)
+{
+    QDeadlineTimer deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeoutMs);
+
+    QMutexLocker locker(&d->mutex);
+    while (d->pending > 0)
+    {
+        if (!d->allDone.wait(&d->mutex, deadline))
+        {
+            return d->pending == 0;
+        }
+    }
+    return true;
+}
+
+void IoUringCopyBackend::Private::run()
+{
+    QVector<io_uring_cqe> completed;
+
+    for (;;)
+    {
+        // 空いている枠の分だけ新しいファイルを始める
+        QList<Job> started;
+        {
+            QMutexLocker locker(&mutex);
+            while (active == 0 && jobs.isEmpty() && !stopping)
+            {
+                jobAvailable.wait(&mutex);
+            }
+            if (active == 0 && jobs.isEmpty())
+            {
+                return;
+            }
+            while (active + started.size() < options.maxFilesInFlight && !jobs.isEmpty())
+            {
+                started.append(jobs.dequeue());
+            }
+        }
+
+        // プールは他のバックエンドと共有していることがあるので、空きがなければ残りは後回しにする。
+        // 何も進行していないときだけ返却を待つ
+        for (int i = 0; i < started.size(); ++i)
+        {
+            char *buffer = active == 0 ? pool->acquire(options.bufferSize) : pool->tryAcquire(options.bufferSize);
+            if (!buffer)
+            {
+                QMutexLocker locker(&mutex);
+                for (int j = started.size() - 1; j >= i; --j)
+                {
+                    jobs.prepend(started.at(j));
+                }
+                break;
+            }
+
+            FileOp *op = new FileOp;
+            op->job = started.at(i);
+            op->buffer = buffer;
+            active++;
+            startFile(op);
+        }
+
+        // 溜まった要求をまとめて投入し、少なくとも1つの完了を待つ
+        io_uring_submit_and_wait(&ring, 1);
+
+        completed.clear();
+        io_uring_cqe *cqe;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&ring, head, cqe)
+        {
+            completed.append(*cqe);
+            count++;
+        }
+        io_uring_cq_advance(&ring, count);
+
+        for (const io_uring_cqe &entry : completed)
+        {
+            const quintptr data = static_cast<quintptr>(entry.user_data);
+            FileOp *op = reinterpret_cast<FileOp *>(data & ~static_cast<quintptr>(TagMask));
+            handle(op, static_cast<OpTag>(data & TagMask), entry.res);
+        }
+    }
+}
+
+io_uring_sqe *IoUringCopyBackend::Private::nextSqe()
+{
+    io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+    while (!sqe)
+    {
+        io_uring_submit(&ring);
+        sqe = io_uring_get_sqe(&ring);
+    }
+    return sqe;
+}
+
+void IoUringCopyBackend::Private::track(io_uring_sqe *sqe, FileOp *op, OpTag tag)
+{
+    io_uring_sqe_set_data64(sqe, static_cast<__u64>(reinterpret_cast<quintptr>(op) | tag));
+    op->inflight++;
+}
+
+void IoUringCopyBackend::Private::fail(FileOp *op, const char *what, int res)
+{
+    // 最初のエラーだけを残す
+    if (!op->failed)
+    {
+        op->failed = true;
+        op->errorString = errnoMessage(what, -res);
+    }
+}
+
+void IoUringCopyBackend::Private::startFile(FileOp *op)
+{
+    const Job &job = op->job;
+    op->srcPath = job.srcDirFd != AT_FDCWD ? job.srcName : QFile::encodeName(job.source);
+    if (job.dstDirFd != AT_FDCWD)
+    {
+        // 一時ファイルも rename も同じディレクトリの fd からの相対名で済む
+        op->dstPath = job.dstName;
+        op->dirPath = ".";
+        op->baseName = job.dstName;
+    }
+    else
+    {
+        const QFileInfo destInfo(job.destination);
+        op->dstPath = QFile::encodeName(job.destination);
+        op->dirPath = QFile::encodeName(destInfo.absolutePath());
+        op->tmpPrefix = op->dirPath + "/";
+        op->baseName = QFile::encodeName(destInfo.fileName());
+    }
+#ifndef O_TMPFILE
+    op->anonymous = false;
+#endif
+
+    // openat と statx は互いに依存しないので同時に投入する
+    io_uring_sqe *sqe = nextSqe();
+    io_uring_prep_openat(sqe, job.srcDirFd, op->srcPath.constData(), O_RDONLY | O_CLOEXEC, 0);
+    track(sqe, op, TagOpenSrc);
+
+    sqe = nextSqe();
+    io_uring_prep_statx(sqe, job.srcDirFd, op->srcPath.constData(), 0, STATX_SIZE | STATX_MODE, &op->stx);
+    track(sqe, op, TagStatx);
+
+    op->pendingInit = 2;
+}
+
+void IoUringCopyBackend::Private::openDestination(FileOp *op)
+{
+    const mode_t mode = op->stx.stx_mode & 07777;
+    io_uring_sqe *sqe = nextSqe();
+#ifdef O_TMPFILE
+    if (op->anonymous)
+    {
+        io_uring_prep_openat(sqe, op->job.dstDirFd, op->dirPath.constData(), O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+        track(sqe, op, TagOpenDst);
+        return;
+    }
+#endif
+    op->tmpPath = op->tmpPrefix + "." + op->baseName + ".sbs-" + QByteArray::number(::getpid()) + "-" + QByteArray::number(++tempCounter);
+    io_uring_prep_openat(sqe, op->job.dstDirFd, op->tmpPath.constData(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, mode);
+    track(sqe, op, TagOpenDst);
+}
+
+void IoUringCopyBackend::Private::nextChunk(FileOp *op)
+{
+    op->chunkLength = static_cast<unsigned>(qMin<quint64>(static_cast<quint64>(options.bufferSize), op->size - op->offset));
+    op->lastRead = static_cast<int>(op->chunkLength);
+    if (options.throttle)
+    {
+        options.throttle->acquireRead(op->chunkLength);
+        options.throttle->acquireWrite(op->chunkLength);
+    }
+
+    // read と write をリンクして1回で投入する。2つが別々の submit に分かれないよう空きを確保する
+    if (io_uring_sq_space_left(&ring) < 2)
+    {
+        io_uring_submit(&ring);
+    }
+
+    io_uring_sqe *sqe = nextSqe();
+    io_uring_prep_read(sqe, op->srcFd, op->buffer, op->chunkLength, op->offset);
+    io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+    track(sqe, op, TagRead);
+
+    sqe = nextSqe();
+    io_uring_prep_write(sqe, op->dstFd, op->buffer, op->chunkLength, op->offset);
+    track(sqe, op, TagWrite);
+}
+
+void IoUringCopyBackend::Private::writeTail(FileOp *op)
+{
+    op->chunkLength = static_cast<unsigned>(op->lastRead);
+    io_uring_sqe *sqe = nextSqe();
+    io_uring_prep_write(sqe, op->dstFd, op->buffer, op->chunkLength, op->offset);
+    track(sqe, op, TagWrite);
+}
+
+void IoUringCopyBackend::Private::finishData(FileOp *op)
+{
+    if (op->job.syncFile)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        io_uring_prep_fsync(sqe, op->dstFd, 0);
+        track(sqe, op, TagFsync);
+        return;
+    }
+    commitName(op);
+}
+
+void IoUringCopyBackend::Private::commitName(FileOp *op)
+{
+    if (!op->anonymous)
+    {
+        beginClose(op);
+        return;
+    }
+
+    // O_TMPFILE には /proc 経由で一時名を付けてから rename する
+    op->tmpPath = op->tmpPrefix + "." + op->baseName + ".sbs-" + QByteArray::number(::getpid()) + "-" + QByteArray::number(++tempCounter);
+    op->procPath = "/proc/self/fd/" + QByteArray::number(op->dstFd);
+    io_uring_sqe *sqe = nextSqe();
+    io_uring_prep_linkat(sqe, AT_FDCWD, op->procPath.constData(), op->job.dstDirFd, op->tmpPath.constData(), AT_SYMLINK_FOLLOW);
+    track(sqe, op, TagLink);
+}
+
+void IoUringCopyBackend::Private::beginClose(FileOp *op)
+{
+    op->closing = true;
+    op->pendingCloses = 0;
+
+    if (op->dstFd >= 0)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        io_uring_prep_close(sqe, op->dstFd);
+        track(sqe, op, TagCloseDst);
+        op->pendingCloses++;
+    }
+    if (op->srcFd >= 0)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        io_uring_prep_close(sqe, op->srcFd);
+        track(sqe, op, TagCloseSrc);
+        op->pendingCloses++;
+    }
+
+    if (op->pendingCloses == 0)
+    {
+        afterClose(op);
+    }
+}
+
+void IoUringCopyBackend::Private::afterClose(FileOp *op)
+{
+    if (op->failed)
+    {
+        if (!op->tmpPath.isEmpty())
+        {
+            ::unlinkat(op->job.dstDirFd, op->tmpPath.constData(), 0);
+        }
+        finishFile(op, false);
+        return;
+    }
+
+    io_uring_sqe *sqe = nextSqe();
+    io_uring_prep_renameat(sqe, op->job.dstDirFd, op->tmpPath.constData(), op->job.dstDirFd, op->dstPath.constData(), 0);
+    track(sqe, op, TagRename);
+}
+
+void IoUringCopyBackend::Private::finishFile(FileOp *op, bool success)
+{
+    pool->release(op->buffer);
+    active--;
+
+    if (op->job.completion)
+    {
+        op->job.completion(success, op->errorString);
+    }
+    delete op;
+
+    QMutexLocker locker(&mutex);
+    if (--pending == 0)
+    {
+        allDone.wakeAll();
+    }
+}
+
+void IoUringCopyBackend::Private::handle(FileOp *op, OpTag tag, int res)
+{
+    op->inflight--;
+
+    switch (tag)
+    {
+    case TagOpenSrc:
+        if (res < 0)
+            fail(op, "openat", res);
+        else
+            op->srcFd = res;
+        if (--op->pendingInit == 0 && !op->failed)
+            openDestination(op);
+        break;
+
+    case TagStatx:
+        if (res < 0)
+            fail(op, "statx", res);
+        else
+            op->size = op->stx.stx_size;
+        if (--op->pendingInit == 0 && !op->failed)
+            openDestination(op);
+        break;
+
+    case TagOpenDst:
+        if (res < 0 && op->anonymous && (res == -EOPNOTSUPP || res == -EISDIR || res == -EINVAL))
+        {
+            // O_TMPFILE 非対応のファイルシステムでは名前付き一時ファイルでやり直す
+            op->anonymous = false;
+            openDestination(op);
+            break;
+        }
+        if (res == -EEXIST && !op->anonymous)
+        {
+            // 以前のプロセスの一時ファイルと名前がぶつかった
+            openDestination(op);
+            break;
+        }
+        if (res < 0)
+        {
+            op->tmpPath.clear();
+            fail(op, "openat", res);
+            break;
+        }
+        op->dstFd = res;
+        // umask の影響を受けないように元ファイルと同じ権限にする（io_uring に fchmod はない）
+        ::fchmod(op->dstFd, op->stx.stx_mode & 07777);
+        if (op->size == 0)
+            finishData(op);
+        else
+            nextChunk(op);
+        break;
+
+    case TagRead:
+        op->lastRead = res;
+        if (res < 0)
+            fail(op, "read", res);
+        break;
+
+    case TagWrite:
+        if (op->failed)
+            break;
+        if (op->lastRead >= 0 && static_cast<unsigned>(op->lastRead) < op->chunkLength && (res >= 0 || res == -ECANCELED))
+        {
+            // 読み込みが短かった（コピー中にファイルが縮んだ）。読めた分だけで終わる
+            op->size = op->offset + static_cast<quint64>(op->lastRead);
+            if (res == -ECANCELED && op->lastRead > 0)
+            {
+                writeTail(op);
+                break;
+            }
+            if (res >= 0 && ::ftruncate(op->dstFd, static_cast<off_t>(op->size)) != 0)
+            {
+                fail(op, "ftruncate", -errno);
+                break;
+            }
+            finishData(op);
+            break;
+        }
+        if (res < 0)
+        {
+            fail(op, "write", res);
+            break;
+        }
+        if (static_cast<unsigned>(res) != op->chunkLength)
+        {
+            fail(op, "write", -EIO);
+            break;
+        }
+        op->offset += static_cast<quint64>(res);
+        if (op->offset >= op->size)
+            finishData(op);
+        else
+            nextChunk(op);
+        break;
+
+    case TagFsync:
+        if (res < 0)
+            fail(op, "fsync", res);
+        else
+            commitName(op);
+        break;
+
+    case TagLink:
+        if (res < 0)
+        {
+            op->tmpPath.clear();
+            fail(op, "linkat", res);
+        }
+        else
+        {
+            beginClose(op);
+            return; // 閉じるファイルがなければ op はここで解放されている
+        }
+        break;
+
+    case TagCloseDst:
+    case TagCloseSrc:
+        if (res < 0 && tag == TagCloseDst)
+            fail(op, "close", res);
+        if (tag == TagCloseDst)
+            op->dstFd = -1;
+        else
+            op->srcFd = -1;
+        if (--op->pendingCloses == 0)
+            afterClose(op);
+        return; // afterClose で op が解放されることがある
+
+    case TagRename:
+        if (res < 0)
+        {
+            fail(op, "renameat", res);
+            ::unlinkat(op->job.dstDirFd, op->tmpPath.constData(), 0);
+        }
+        else if (op->job.syncFile)
+        {
+            // rename 自体を永続化するためにディレクトリも同期する
+            if (op->job.dstDirFd != AT_FDCWD)
+                ::fsync(op->job.dstDirFd);
+            else
+                FileSystem::syncPath(QFile::decodeName(op->dirPath));
+        }
+        finishFile(op, !op->failed);
+        return;
+
+    default:
+        break;
+    }
+
+    // 失敗したら、実行中の要求がすべて返ってきてからファイルを閉じる
+    if (op->failed && op->inflight == 0 && !op->closing)
+    {
+        beginClose(op);
+    }
+}
+
+#else // SBS_HAVE_LIBURING
+
+struct IoUringCopyBackend::Private
+{
+    Options options;
+};
+
+IoUringCopyBackend::IoUringCopyBackend()
+    : IoUringCopyBackend(Options())
+{
+}
+
+IoUringCopyBackend::IoUringCopyBackend(const Options &options)
+    : d(new Private)
+{
+    d->options = options;
+}
+
+IoUringCopyBackend::~IoUringCopyBackend()
+{
+}
+
+bool IoUringCopyBackend::isSupported()
+{
+    return false;
+}
+
+void IoUringCopyBackend::submit(const QString &, const QString &, bool, const Completion &completion)
+{
+    if (completion)
+    {
+        completion(false, QStringLiteral("io_uring support is not built in"));
+    }
+}
+
+void IoUringCopyBackend::submitAt(const DirectoryHandle &, const QByteArray &, const DirectoryHandle &, const QByteArray &,
+                                  bool, const Completion &completion)
+{
+    submit(QString(), QString(), false, completion);
+}
+
+bool IoUringCopyBackend::waitForDone(int)
+{
+    return true;
+}
+
+QString IoUringCopyBackend::name() const
+{
+    return QStringLiteral("io_uring (unavailable)");
+}
+
+#endif // SBS_HAVE_LIBURING
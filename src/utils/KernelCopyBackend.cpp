@@ -0,0 +1,220 @@
+#include "KernelCopyBackend.h"
+#include "FileSystem.h"
+#include "IoThrottle.h"
+#include "ThreadPriority.h"
+#include <QThread>
+#include <QFile>
+#include <QDeadlineTimer>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace
+{
+#ifdef Q_OS_LINUX
+    QFileDevice::Permissions toPermissions(mode_t mode)
+    {
+        QFileDevice::Permissions permissions;
+        if (mode & S_IRUSR)
+            permissions |= QFileDevice::ReadOwner | QFileDevice::ReadUser;
+        if (mode & S_IWUSR)
+            permissions |= QFileDevice::WriteOwner | QFileDevice::WriteUser;
+        if (mode & S_IXUSR)
+            permissions |= QFileDevice::ExeOwner | QFileDevice::ExeUser;
+        if (mode & S_IRGRP)
+            permissions |= QFileDevice::ReadGroup;
+        if (mode & S_IWGRP)
+            permissions |= QFileDevice::WriteGroup;
+        if (mode & S_IXGRP)
+            permissions |= QFileDevice::ExeGroup;
+        if (mode & S_IROTH)
+            permissions |= QFileDevice::ReadOther;
+        if (mode & S_IWOTH)
+            permissions |= QFileDevice::WriteOther;
+        if (mode & S_IXOTH)
+            permissions |= QFileDevice::ExeOther;
+        return permissions;
+    }
+#endif
+}
+
+KernelCopyBackend::KernelCopyBackend()
+    : KernelCopyBackend(Options())
+{
+}
+
+KernelCopyBackend::KernelCopyBackend(const Options &options)
+    : m_options(options),
+      m_pending(0),
+      m_stopping(false)
+{
+    if (m_options.threads <= 0)
+    {
+        m_options.threads = qBound(1, QThread::idealThreadCount(), 16);
+    }
+    for (int i = 0; i < m_options.threads; ++i)
+    {
+        m_threads.append(QThread::create(ThreadPriority::inheritCurrent([this]()
+                                                                        { workerLoop(); })));
+        m_threads.last()->start();
+    }
+}
+
+KernelCopyBackend::~KernelCopyBackend()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobAvailable.wakeAll();
+    }
+    // ワーカーはキューが空になるまで処理してから終了する
+    for (QThread *thread : m_threads)
+    {
+        thread->wait();
+        delete thread;
+    }
+}
+
+bool KernelCopyBackend::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString KernelCopyBackend::name() const
+{
+    return QStringLiteral("copy_file_range (%1 threads%2)")
+        .arg(m_options.threads)
+        .arg(m_options.dropCache ? QStringLiteral(", drop cache") : QString());
+}
+
+void KernelCopyBackend::submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion)
+{
+    enqueue(Job{-1, QFile::encodeName(source), destination, syncFile, completion});
+}
+
+void KernelCopyBackend::submitAt(const DirectoryHandle &sourceDir, const QByteArray &sourceName,
+                                 const DirectoryHandle &destinationDir, const QByteArray &destinationName,
+                                 bool syncFile, const Completion &completion)
+{
+    const QString destination = destinationDir.filePath(destinationName);
+    if (sourceDir.fd >= 0)
+    {
+        enqueue(Job{sourceDir.fd, sourceName, destination, syncFile, completion});
+    }
+    else
+    {
+        enqueue(Job{-1, QFile::encodeName(sourceDir.filePath(sourceName)), destination, syncFile, completion});
+    }
+}
+
+void KernelCopyBackend::enqueue(const Job &job)
+{
+    QMutexLocker locker(&m_mutex);
+    m_jobs.enqueue(job);
+    m_pending++;
+    m_jobAvailable.wakeOne();
+}
+
+bool KernelCopyBackend::waitForDone(int timeoutMs)
+{
+    QDeadlineTimer deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeoutMs);
+
+    QMutexLocker locker(&m_mutex);
+    while (m_pending > 0)
+    {
+        if (!m_allDone.wait(&m_mutex, deadline))
+        {
+            return m_pending == 0;
+        }
+    }
+    return true;
+}
+
+void KernelCopyBackend::workerLoop()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_jobs.isEmpty() && !m_stopping)
+            {
+                m_jobAvailable.wait(&m_mutex);
+            }
+            if (m_jobs.isEmpty())
+            {
+                return;
+            }
+            job = m_jobs.dequeue();
+        }
+
+        QString errorString;
+        const bool success = copyOne(job, &errorString);
+        if (job.completion)
+        {
+            job.completion(success, errorString);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (--m_pending == 0)
+        {
+            m_allDone.wakeAll();
+        }
+    }
+}
+
+bool KernelCopyBackend::copyOne(const Job &job, QString *errorString)
+{
+#ifdef Q_OS_LINUX
+    const int sourceFd = job.sourceDirFd >= 0 ? ::openat(job.sourceDirFd, job.source.constData(), O_RDONLY | O_CLOEXEC)
+                                              : ::open(job.source.constData(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0)
+    {
+        *errorString = QStringLiteral("open: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(sourceFd, &st) != 0)
+    {
+        *errorString = QStringLiteral("fstat: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        ::close(sourceFd);
+        return false;
+    }
+
+    // カーネル内コピーでも、1回に進める量ごとに読み込みと書き込みの両方として数える
+    IoThrottle *throttle = m_options.throttle;
+    FileSystem::AtomicFileWriter::ChunkCallback beforeChunk;
+    if (throttle)
+    {
+        beforeChunk = [throttle](qint64 bytes)
+        {
+            throttle->acquireRead(bytes);
+            throttle->acquireWrite(bytes);
+        };
+    }
+
+    FileSystem::AtomicFileWriter writer(job.destination);
+    writer.setDropCache(m_options.dropCache);
+    const bool success = writer.open(toPermissions(st.st_mode)) && writer.copyFrom(sourceFd, beforeChunk) && writer.commit(job.syncFile);
+    ::close(sourceFd);
+    if (!success)
+    {
+        *errorString = writer.errorString();
+    }
+    return success;
+#else
+    Q_UNUSED(job);
+    *errorString = QStringLiteral("copy_file_range is not supported on this platform");
+    return false;
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef KERNELCOPYBACKEND_H
+#define KERNELCOPYBACKEND_H
+
+#include <QString>
+#include <QQueue>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include "CopyBackend.h"
+
+class QThread;
+class IoThrottle;
+
+// copy_file_range でデータをユーザー空間に持ち込まずにコピーするバックエンド（Linux のみ）。
+// 同じファイルシステム上なら reflink（ブロックの共有）になることもあり、
+// 復元のように大きなファイルをまとめて書き戻す処理で読み込み/書き込みスレッドの往復をなくす。
+// 各ワーカーが1ファイルずつ開いて一時ファイルへコピーし、原子的に置き換える。
+class KernelCopyBackend : public CopyBackend
+{
+public:
+    struct Options
+    {
+        int threads = 0; // 0 なら CPU 数（最大 16）
+        IoThrottle *throttle = nullptr; // 読み書きの速さの制限（呼び出し側が所有する）
+        bool dropCache = false; // 読み書きした範囲をページキャッシュから外す
+    };
+
+    KernelCopyBackend();
+    explicit KernelCopyBackend(const Options &options);
+    ~KernelCopyBackend() override;
+
+    // この環境で使えるか（Linux でなければ false）
+    static bool isSupported();
+
+    void submit(const QString &source, const QString &destination, bool syncFile, const Completion &completion) override;
+    void submitAt(const DirectoryHandle &sourceDir, const QByteArray &sourceName,
+                  const DirectoryHandle &destinationDir, const QByteArray &destinationName,
+                  bool syncFile, const Completion &completion) override;
+    bool waitForDone(int timeoutMs = -1) override;
+    QString name() const override;
+
+private:
+    struct Job
+    {
+        int sourceDirFd; // -1 なら source はパス
+        QByteArray source;
+        QString destination;
+        bool syncFile;
+        Completion completion;
+    };
+
+    KernelCopyBackend(const KernelCopyBackend &) = delete;
+    KernelCopyBackend &operator=(const KernelCopyBackend &) = delete;
+
+    void enqueue(const Job &job);
+    void workerLoop();
+    bool copyOne(const Job &job, QString *errorString);
+
+    Options m_options;
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QWaitCondition m_allDone;
+    QQueue<Job> m_jobs;
+    QList<QThread *> m_threads;
+    int m_pending;
+    bool m_stopping;
+};
+
+#endif // KERNELCOPYBACKEND_H
@@ -5,6 +5,12 @@
 #include <QMutex>
 #include <QStringList>
 
+namespace
+{
+    const int MAX_LOG_ENTRIES = 1000;
+    const qint64 MAX_LOG_FILE_SIZE = 4 * 1024 * 1024;
+}
+
 Logger &Logger::instance()
 {
     static Logger instance;
@@ -27,14 +33,77 @@ void Logger::log(const QString &message)
     QString timestamp = QDateTime::currentDateTime().toString("[yyyy/MM/dd HH:mm:ss] ");
     m_logEntries.append(timestamp + message);
 
+    if (m_logFile.isOpen())
+    {
+        m_logFile.write((timestamp + message + "\n").toUtf8());
+        m_logFile.flush();
+    }
+
     // ログが多すぎる場合は古いものから削除（オプション）
-    const int MAX_LOG_ENTRIES = 1000;
     while (m_logEntries.size() > MAX_LOG_ENTRIES)
     {
         m_logEntries.removeFirst();
     }
 }
 
+bool Logger::setLogFile(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_logFile.close();
+    m_logFile.setFileName(filePath);
+
+    // 大きくなりすぎたファイルは1世代だけ残して新しく始める
+    if (m_logFile.size() > MAX_LOG_FILE_SIZE)
+    {
+        const QString oldPath = filePath + ".old";
+        QFile::remove(oldPath);
+        QFile::rename(filePath, oldPath);
+    }
+
+    // 前回までのログの末尾を、今回のログより前に並べる
+    QStringList previous;
+    if (m_logFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        while (!m_logFile.atEnd())
+        {
+            QString line = QString::fromUtf8(m_logFile.readLine());
+            if (line.endsWith('\n'))
+            {
+                line.chop(1);
+            }
+            if (line.isEmpty())
+            {
+                continue;
+            }
+            previous.append(line);
+            if (previous.size() > MAX_LOG_ENTRIES)
+            {
+                previous.removeFirst();
+            }
+        }
+        m_logFile.close();
+    }
+
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        return false;
+    }
+    // まだファイルに書いていない今回のログを書き出す
+    for (const QString &entry : m_logEntries)
+    {
+        m_logFile.write((entry + "\n").toUtf8());
+    }
+    m_logFile.flush();
+
+    m_logEntries = previous + m_logEntries;
+    while (m_logEntries.size() > MAX_LOG_ENTRIES)
+    {
+        m_logEntries.removeFirst();
+    }
+    return true;
+}
+
 QStringList Logger::getAllLogs() const
 {
     QMutexLocker locker(&m_mutex);
@@ -45,5 +114,10 @@ void Logger::clearLogs()
 {
     QMutexLocker locker(&m_mutex);
     m_logEntries.clear();
+    if (m_logFile.isOpen())
+    {
+        m_logFile.resize(0);
+    }
+    locker.unlock();
     log(QStringLiteral("ログをクリア"));
 }
\ No newline at end of file
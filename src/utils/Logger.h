@@ -5,6 +5,7 @@
 #include <QStringList>
 #include <QDateTime>
 #include <QMutex>
+#include <QFile>
 
 class Logger
 {
@@ -21,12 +22,17 @@ public:
     // ログをクリア
     void clearLogs();
 
+    // ログをファイルにも追記して、次に起動したときにも見られるようにする。
+    // 既存のファイルの末尾をメモリに読み込み、大きくなりすぎていれば .old に退避してから始める
+    bool setLogFile(const QString &filePath);
+
 private:
     Logger();                                   // シングルトンなのでプライベートコンストラクタ
     Logger(const Logger &) = delete;            // コピーコンストラクタ禁止
     Logger &operator=(const Logger &) = delete; // 代入演算子禁止
 
     QStringList m_logEntries; // ログエントリの保存
+    QFile m_logFile;          // 追記先（setLogFile するまでは開かない）
     mutable QMutex m_mutex;   // マルチスレッド保護用
 };
 
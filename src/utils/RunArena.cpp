@@ -0,0 +1,70 @@
+#include "RunArena.h"
+
+RunArena::CountingUpstream::CountingUpstream(Stats &stats)
+    : m_stats(stats)
+{
+}
+
+void *RunArena::CountingUpstream::do_allocate(size_t bytes, size_t alignment)
+{
+    // 呼ばれるのは RunArena のロック中だけ
+    void *pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    m_stats.blocks++;
+    m_stats.reservedBytes += static_cast<qint64>(bytes);
+    m_stats.peakReservedBytes = qMax(m_stats.peakReservedBytes, m_stats.reservedBytes);
+    return pointer;
+}
+
+void RunArena::CountingUpstream::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    m_stats.reservedBytes -= static_cast<qint64>(bytes);
+}
+
+bool RunArena::CountingUpstream::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+RunArena::RunArena(qint64 initialBlockSize)
+    : m_upstream(m_stats),
+      m_resource(static_cast<size_t>(initialBlockSize), &m_upstream)
+{
+}
+
+RunArena::~RunArena()
+{
+}
+
+void RunArena::release()
+{
+    QMutexLocker locker(&m_mutex);
+    m_resource.release();
+}
+
+RunArena::Stats RunArena::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void *RunArena::do_allocate(size_t bytes, size_t alignment)
+{
+    QMutexLocker locker(&m_mutex);
+    m_stats.allocations++;
+    m_stats.allocatedBytes += static_cast<qint64>(bytes);
+    return m_resource.allocate(bytes, alignment);
+}
+
+void RunArena::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+    // 個別には返さない（release() でまとめて返す）
+    Q_UNUSED(pointer);
+    Q_UNUSED(bytes);
+    Q_UNUSED(alignment);
+}
+
+bool RunArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
@@ -0,0 +1,63 @@
+#ifndef RUNARENA_H
+#define RUNARENA_H
+
+#include <QtGlobal>
+#include <QMutex>
+#include <memory_resource>
+
+// 1回の実行の間だけ使うメモリ領域（std::pmr のリソース）。
+// 小さな確保はまとめて取ったブロックからポインタを進めるだけで行い、個別には解放しない。
+// 実行の終わり（release() かデストラクタ）で全部まとめて返す。
+// ファイル一覧・差分・コピー結果のバッチなど、実行中に増える一方のデータに使う。
+// 確保はロックで保護しているので、複数のスレッドから使ってよい。
+class RunArena : public std::pmr::memory_resource
+{
+public:
+    struct Stats
+    {
+        qint64 allocations = 0;       // アリーナからの確保回数
+        qint64 allocatedBytes = 0;    // 確保の合計（要求サイズ）
+        qint64 blocks = 0;            // ヒープから取ったブロック数
+        qint64 reservedBytes = 0;     // 現在ヒープから取っているバイト数
+        qint64 peakReservedBytes = 0; // reservedBytes の最大値（release をまたいで保持）
+    };
+
+    explicit RunArena(qint64 initialBlockSize = 1024 * 1024);
+    ~RunArena() override;
+
+    // 確保したメモリを全部返す（このアリーナを使うコンテナは先に破棄しておくこと）
+    void release();
+
+    Stats stats() const;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    RunArena(const RunArena &) = delete;
+    RunArena &operator=(const RunArena &) = delete;
+
+    // ヒープからのブロック取得を数える上流のリソース
+    class CountingUpstream : public std::pmr::memory_resource
+    {
+    public:
+        explicit CountingUpstream(Stats &stats);
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    private:
+        Stats &m_stats;
+    };
+
+    mutable QMutex m_mutex;
+    Stats m_stats;
+    CountingUpstream m_upstream;
+    std::pmr::monotonic_buffer_resource m_resource;
+};
+
+#endif // RUNARENA_H
@@ -0,0 +1,160 @@
+#include "ThreadPriority.h"
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace
+{
+    thread_local ThreadPriority::Class t_currentClass = ThreadPriority::Normal;
+
+#ifdef Q_OS_LINUX
+    // <linux/ioprio.h> はディストリビューションによってないので、必要な値だけ定義する
+    const int kIoprioWhoProcess = 1;
+    const int kIoprioClassShift = 13;
+    const int kIoprioClassBestEffort = 2;
+    const int kIoprioClassIdle = 3;
+    const int kLowNice = 10;
+
+    QString errnoString(const char *what)
+    {
+        return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(errno)));
+    }
+
+    // who = 0 は呼び出したスレッド
+    bool setIoPriority(int ioClass, int level)
+    {
+        return ::syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, (ioClass << kIoprioClassShift) | level) == 0;
+    }
+
+    // Linux の nice はスレッドごとの値なので、スレッド ID を指定する
+    bool setNice(int nice)
+    {
+        return ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), nice) == 0;
+    }
+#endif
+}
+
+ThreadPriority::Class ThreadPriority::currentClass()
+{
+    return t_currentClass;
+}
+
+std::function<void()> ThreadPriority::inheritCurrent(std::function<void()> fn)
+{
+    const Class cls = t_currentClass;
+    return [cls, fn]()
+    {
+        applyToCurrentThread(cls);
+        fn();
+    };
+}
+
+QString ThreadPriority::className(Class cls)
+{
+    switch (cls)
+    {
+    case Low:
+        return QStringLiteral("low");
+    case Idle:
+        return QStringLiteral("idle");
+    case Normal:
+        break;
+    }
+    return QStringLiteral("normal");
+}
+
+bool ThreadPriority::applyToCurrentThread(Class cls, QString *description)
+{
+    if (cls == Normal)
+    {
+        if (description)
+        {
+            *description = className(cls);
+        }
+        return true;
+    }
+
+    QStringList applied;
+    QStringList failures;
+    // 一部しか設定できなくても、このスレッドから作るワーカーには同じクラスを試させる
+    t_currentClass = cls;
+
+#if defined(Q_OS_LINUX)
+    if (setIoPriority(cls == Idle ? kIoprioClassIdle : kIoprioClassBestEffort, cls == Idle ? 0 : 7))
+    {
+        applied << (cls == Idle ? QStringLiteral("I/O idle") : QStringLiteral("I/O best-effort 7"));
+    }
+    else
+    {
+        failures << errnoString("ioprio_set");
+    }
+
+    if (cls == Idle)
+    {
+        struct sched_param param = {};
+        if (::sched_setscheduler(0, SCHED_IDLE, &param) == 0)
+        {
+            applied << QStringLiteral("CPU SCHED_IDLE");
+        }
+        else
+        {
+            // SCHED_IDLE が使えない環境では nice の最低にする
+            failures << errnoString("sched_setscheduler");
+            if (setNice(19))
+            {
+                applied << QStringLiteral("CPU nice 19");
+            }
+        }
+    }
+    else if (setNice(kLowNice))
+    {
+        applied << QStringLiteral("CPU nice %1").arg(kLowNice);
+    }
+    else
+    {
+        failures << errnoString("setpriority");
+    }
+#elif defined(Q_OS_WIN)
+    // バックグラウンド処理モードは I/O とメモリの優先度も下げる
+    if (cls == Idle && ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN))
+    {
+        applied << QStringLiteral("background mode");
+    }
+    else if (::SetThreadPriority(::GetCurrentThread(), cls == Idle ? THREAD_PRIORITY_IDLE : THREAD_PRIORITY_BELOW_NORMAL))
+    {
+        applied << (cls == Idle ? QStringLiteral("CPU idle") : QStringLiteral("CPU below normal"));
+    }
+    else
+    {
+        failures << QStringLiteral("SetThreadPriority failed (%1)").arg(::GetLastError());
+    }
+#else
+    failures << QStringLiteral("thread priority classes are not supported on this platform");
+#endif
+
+    if (description)
+    {
+        QString text = className(cls);
+        if (!applied.isEmpty())
+        {
+            text += QStringLiteral(" (%1)").arg(applied.join(QStringLiteral(", ")));
+        }
+        if (!failures.isEmpty())
+        {
+            text += QStringLiteral(" [%1]").arg(failures.join(QStringLiteral("; ")));
+        }
+        *description = text;
+    }
+    return failures.isEmpty();
+}
@@ -0,0 +1,38 @@
+#ifndef THREADPRIORITY_H
+#define THREADPRIORITY_H
+
+#include <QString>
+#include <functional>
+
+// 呼び出したスレッドの I/O と CPU の優先度を下げる。Linux では ioprio_set（I/O）と
+// SCHED_IDLE / nice（CPU）、Windows ではバックグラウンド処理モードを使う。
+// Linux では優先度はその後にそのスレッドが作るスレッドにも引き継がれるが、Windows のバックグラウンド
+// 処理モードはスレッドごとなので、ワーカースレッドの本体は inheritCurrent で包んで同じクラスを設定する。
+// 元に戻せない（SCHED_IDLE や nice は権限なしでは戻せない）ので、使い捨てのスレッドで呼ぶこと。
+class ThreadPriority
+{
+public:
+    enum Class
+    {
+        Normal = 0, // 変えない
+        Low = 1,    // I/O は best-effort の最低、CPU は nice 10
+        Idle = 2    // I/O は idle クラス、CPU は SCHED_IDLE（ほかに使う処理がないときだけ動く）
+    };
+
+    // 呼び出したスレッドに cls を設定する。description には実際に設定できた内容が入る。
+    // 一部でも設定できなければ false（設定できた分はそのまま）
+    static bool applyToCurrentThread(Class cls, QString *description = nullptr);
+
+    // 呼び出したスレッドに applyToCurrentThread（inheritCurrent を含む）で設定したクラス。
+    // 設定していなければ Normal
+    static Class currentClass();
+
+    // 呼び出したスレッドのクラスを、fn を動かすスレッドにも設定してから fn を呼ぶ関数を返す
+    // （QThread::create に渡すワーカーの本体を包む）
+    static std::function<void()> inheritCurrent(std::function<void()> fn);
+
+    // 表示用の名前
+    static QString className(Class cls);
+};
+
+#endif // THREADPRIORITY_H
@@ -0,0 +1,335 @@
+#include "TreeWalker.h"
+#include "FileIndex.h"
+#include "ThreadPriority.h"
+#include <QThread>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+namespace
+{
+    // '/' を最も小さい文字として比べ、ディレクトリの中身が親の直後に並ぶようにする
+    bool pathLess(const QString &a, const QString &b)
+    {
+        const int length = qMin(a.size(), b.size());
+        for (int i = 0; i < length; ++i)
+        {
+            const QChar ca = a.at(i);
+            const QChar cb = b.at(i);
+            if (ca == cb)
+            {
+                continue;
+            }
+            if (ca == QLatin1Char('/'))
+            {
+                return true;
+            }
+            if (cb == QLatin1Char('/'))
+            {
+                return false;
+            }
+            return ca < cb;
+        }
+        return a.size() < b.size();
+    }
+}
+
+TreeWalker::TreeWalker()
+    : TreeWalker(Options())
+{
+}
+
+TreeWalker::TreeWalker(const Options &options)
+    : m_options(options),
+      m_collect(true),
+      m_index(nullptr)
+{
+    if (m_options.threads <= 0)
+    {
+        m_options.threads = qBound(1, QThread::idealThreadCount(), 16);
+    }
+}
+
+TreeWalker::~TreeWalker()
+{
+}
+
+int TreeWalker::threadCount() const
+{
+    return m_options.threads;
+}
+
+qint64 TreeWalker::stealCount() const
+{
+    return m_steals.load();
+}
+
+QVector<TreeWalker::Entry> TreeWalker::walk(const QString &root)
+{
+    run(root, true);
+
+    QVector<Entry> result;
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker> &worker : m_workers)
+    {
+        total += worker->entries.size();
+    }
+    result.reserve(total);
+    for (const std::unique_ptr<Worker> &worker : m_workers)
+    {
+        result.append(worker->entries);
+    }
+    m_workers.clear();
+
+    if (m_options.sorted)
+    {
+        std::sort(result.begin(), result.end(), [](const Entry &a, const Entry &b)
+                  { return pathLess(a.relativePath, b.relativePath); });
+    }
+    return result;
+}
+
+void TreeWalker::walk(const QString &root, FileIndex &index)
+{
+    m_index = &index;
+    run(root, false);
+    m_index = nullptr;
+    m_workers.clear();
+
+    if (m_options.sorted)
+    {
+        index.sort();
+    }
+}
+
+qint64 TreeWalker::count(const QString &root)
+{
+    run(root, false);
+
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker> &worker : m_workers)
+    {
+        total += worker->count;
+    }
+    m_workers.clear();
+    return total;
+}
+
+void TreeWalker::run(const QString &root, bool collect)
+{
+    m_collect = collect;
+    m_steals = 0;
+    m_workers.clear();
+    for (int i = 0; i < m_options.threads; ++i)
+    {
+        m_workers.emplace_back(new Worker);
+    }
+
+    if (!QFileInfo(root).isDir())
+    {
+        return;
+    }
+    push(0, Task{QDir::cleanPath(root), QString(), 0, 0});
+
+    QVector<QThread *> threads;
+    for (int i = 0; i < m_options.threads; ++i)
+    {
+        threads.append(QThread::create(ThreadPriority::inheritCurrent([this, i]()
+                                                                      { workerLoop(i); })));
+        threads.last()->start();
+    }
+
+    for (QThread *thread : threads)
+    {
+        while (!thread->wait(50))
+        {
+            if (m_options.onWait)
+            {
+                m_options.onWait();
+            }
+        }
+        delete thread;
+    }
+}
+
+void TreeWalker::push(int index, Task task)
+{
+    // 取り出される前に数えておかないと、他のワーカーが終了と誤判定する
+    m_outstanding.fetch_add(1);
+    {
+        Worker &worker = *m_workers[index];
+        QMutexLocker locker(&worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    if (m_idle.load() > 0)
+    {
+        QMutexLocker locker(&m_idleMutex);
+        m_workAvailable.wakeOne();
+    }
+}
+
+bool TreeWalker::popLocal(int index, Task &task)
+{
+    // 自分のタスクは末尾から（深さ優先で局所性を保つ）
+    Worker &worker = *m_workers[index];
+    QMutexLocker locker(&worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool TreeWalker::steal(int thief, Task &task)
+{
+    // 他のワーカーからは先頭（浅い＝大きい部分木）を盗む
+    const int count = static_cast<int>(m_workers.size());
+    for (int offset = 1; offset < count; ++offset)
+    {
+        Worker &victim = *m_workers[(thief + offset) % count];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TreeWalker::workerLoop(int index)
+{
+    for (;;)
+    {
+        Task task;
+        if (popLocal(index, task) || steal(index, task))
+        {
+            processDirectory(index, task);
+            if (m_outstanding.fetch_sub(1) == 1)
+            {
+                // 最後のタスクが終わったので待機中のワーカーを起こして終了させる
+                QMutexLocker locker(&m_idleMutex);
+                m_workAvailable.wakeAll();
+                return;
+            }
+            continue;
+        }
+
+        QMutexLocker locker(&m_idleMutex);
+        if (m_outstanding.load() == 0)
+        {
+            return;
+        }
+        m_idle.fetch_add(1);
+        // 起こし損ねても短い間隔で盗みに行く
+        m_workAvailable.wait(&m_idleMutex, 2);
+        m_idle.fetch_sub(1);
+    }
+}
+
+void TreeWalker::processDirectory(int index, const Task &task)
+{
+    Worker &worker = *m_workers[index];
+
+    // Linux では getdents64 で読むので、種類が d_type で分かるエントリは stat しない
+    DirectoryScanner::Options scanOptions;
+    scanOptions.includeHidden = m_options.includeHidden;
+    scanOptions.needSize = m_options.needSize;
+    scanOptions.needMetadata = m_options.needMetadata;
+    DirectoryScanner scanner(task.path, scanOptions);
+
+    QVector<DirectoryScanner::Entry> accepted;
+    DirectoryScanner::Entry child;
+    while (scanner.next(child))
+    {
+        if (child.type != DirectoryScanner::File && child.type != DirectoryScanner::Directory)
+        {
+            continue;
+        }
+
+        Entry entry;
+        entry.name = child.fileName();
+        entry.path = task.path.endsWith(QLatin1Char('/')) ? task.path + entry.name : task.path + QLatin1Char('/') + entry.name;
+        entry.relativePath = task.relativePath.isEmpty() ? entry.name : task.relativePath + QLatin1Char('/') + entry.name;
+        entry.isDir = child.type == DirectoryScanner::Directory;
+        entry.size = qMax<qint64>(0, child.size);
+        entry.depth = task.depth + 1;
+
+        if (m_options.filter && !m_options.filter(entry))
+        {
+            continue;
+        }
+
+        if (m_index)
+        {
+            // ロックはディレクトリごとに1回で済むよう、まとめて追加する
+            accepted.append(child);
+            continue;
+        }
+
+        if (entry.isDir)
+        {
+            if (m_options.maxDepth < 0 || entry.depth < m_options.maxDepth)
+            {
+                push(index, Task{entry.path, entry.relativePath, entry.depth, 0});
+            }
+            if (!m_options.includeDirectories)
+            {
+                continue;
+            }
+        }
+        else if (!m_options.includeFiles)
+        {
+            continue;
+        }
+
+        if (m_collect)
+        {
+            worker.entries.append(std::move(entry));
+        }
+        worker.count++;
+    }
+
+    if (m_index && !accepted.isEmpty())
+    {
+        addToIndex(index, task, accepted);
+    }
+}
+
+void TreeWalker::addToIndex(int index, const Task &task, const QVector<DirectoryScanner::Entry> &children)
+{
+    const int depth = task.depth + 1;
+    const bool descend = m_options.maxDepth < 0 || depth < m_options.maxDepth;
+
+    QVector<Task> subdirectories;
+    {
+        QMutexLocker locker(&m_indexMutex);
+        for (const DirectoryScanner::Entry &child : children)
+        {
+            if (child.type == DirectoryScanner::Directory)
+            {
+                const FileIndex::Id id = m_index->addDirectory(task.directory, child.name);
+                if (descend)
+                {
+                    const QString name = child.fileName();
+                    const QString path = task.path.endsWith(QLatin1Char('/')) ? task.path + name : task.path + QLatin1Char('/') + name;
+                    subdirectories.append(Task{path, task.relativePath.isEmpty() ? name : task.relativePath + QLatin1Char('/') + name, depth, id});
+                }
+            }
+            else if (m_options.includeFiles)
+            {
+                m_index->addFile(task.directory, child.name, qMax<qint64>(0, child.size), child.mtimeNs, child.mode);
+                m_workers[index]->count++;
+            }
+        }
+    }
+
+    for (Task &subdirectory : subdirectories)
+    {
+        push(index, std::move(subdirectory));
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef TREEWALKER_H
+#define TREEWALKER_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include "DirectoryScanner.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class FileIndex;
+
+// ディレクトリツリーを複数スレッドで走査する。
+// ディレクトリ1つを1タスクとし、各ワーカーは自分のデックの末尾から取り出し、
+// 空になったら他のワーカーのデックの先頭から盗む（ワークスティーリング）。
+// メタデータの待ち時間が支配的なネットワークドライブや SSD アレイで効果がある。
+// 1つのインスタンスで同時に walk() を呼ばないこと。
+class TreeWalker
+{
+public:
+    struct Entry
+    {
+        QString path;         // 絶対パス
+        QString relativePath; // ルートからの相対パス（区切りは '/'）
+        QString name;
+        bool isDir = false;
+        qint64 size = 0; // needSize のときのみ
+        int depth = 0;   // ルート直下が 1
+    };
+
+    // false を返したエントリは出力せず、ディレクトリなら中にも入らない。
+    // 複数のワーカーから同時に呼ばれる
+    using Filter = std::function<bool(const Entry &entry)>;
+
+    struct Options
+    {
+        int threads = 0; // 0 なら CPU 数（最大16）
+        bool sorted = false; // 相対パス順に並べて返す（ディレクトリの中身は親の直後）
+        int maxDepth = -1;   // この深さのディレクトリには入らない。-1 なら無制限
+        bool includeFiles = true;
+        bool includeDirectories = false;
+        bool includeHidden = true;
+        bool needSize = false;     // ファイルサイズを取得する（そのぶん stat が増える）
+        bool needMetadata = false; // サイズに加えて更新時刻とパーミッションも取得する
+        Filter filter;
+        std::function<void()> onWait; // 呼び出し元スレッドで完了を待つ間に定期的に呼ばれる
+    };
+
+    TreeWalker();
+    explicit TreeWalker(const Options &options);
+    ~TreeWalker();
+
+    // root 以下のエントリを返す（root 自身は含まない）
+    QVector<Entry> walk(const QString &root);
+
+    // root 以下のファイルとディレクトリを index に追加する（Entry は作らない）。
+    // sorted なら最後に index.sort() する。includeDirectories は無視される
+    void walk(const QString &root, FileIndex &index);
+
+    // エントリを保持せずに数だけ数える
+    qint64 count(const QString &root);
+
+    // 直前の walk()/count() で他のワーカーから盗んだタスクの数
+    qint64 stealCount() const;
+
+    int threadCount() const;
+
+private:
+    struct Task
+    {
+        QString path;
+        QString relativePath;
+        int depth;
+        quint32 directory; // FileIndex に追加する場合の親ディレクトリの番号
+    };
+
+    struct Worker
+    {
+        QMutex mutex;
+        std::deque<Task> tasks;
+        QVector<Entry> entries;
+        qint64 count = 0;
+    };
+
+    TreeWalker(const TreeWalker &) = delete;
+    TreeWalker &operator=(const TreeWalker &) = delete;
+
+    void run(const QString &root, bool collect);
+    void addToIndex(int index, const Task &task, const QVector<DirectoryScanner::Entry> &children);
+    void workerLoop(int index);
+    bool popLocal(int index, Task &task);
+    bool steal(int thief, Task &task);
+    void push(int index, Task task);
+    void processDirectory(int index, const Task &task);
+
+    Options m_options;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    bool m_collect;
+    FileIndex *m_index;
+    QMutex m_indexMutex;
+
+    std::atomic<qint64> m_outstanding{0};
+    std::atomic<qint64> m_steals{0};
+    std::atomic<int> m_idle{0};
+    QMutex m_idleMutex;
+    QWaitCondition m_workAvailable;
+};
+
+#endif // TREEWALKER_H
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include "../src/backup/BackupJobScheduler.h"
+
+TEST(BackupJobSchedulerTest, DevicesForConfigAreUnique) {
+    QTemporaryDir dir;
+    BackupConfig config("test", dir.filePath("source"), dir.filePath("destination"));
+    EXPECT_EQ(BackupJobScheduler::devicesFor(config).size(), 1);
+}
+
+TEST(BackupJobSchedulerTest, EnqueueRejectsDuplicateJob) {
+    QTemporaryDir dir;
+    BackupJobScheduler scheduler;
+    scheduler.setMaxConcurrentJobs(1);
+    // 元がないので実行はすぐ終わるが、終了の知らせはイベントループを回すまで届かない
+    BackupConfig config("test", dir.filePath("missing"), dir.filePath("destination"));
+    EXPECT_TRUE(scheduler.enqueue(0, config));
+    EXPECT_TRUE(scheduler.isJobActive(0));
+    EXPECT_FALSE(scheduler.enqueue(0, config));
+    EXPECT_TRUE(scheduler.enqueue(1, config));
+    EXPECT_EQ(scheduler.runningJobs(), 1);
+    EXPECT_EQ(scheduler.pendingJobs(), 1);
+}
+
+TEST(BackupJobSchedulerTest, JobsOnSameDeviceWaitForLimit) {
+    QTemporaryDir dir;
+    BackupJobScheduler scheduler;
+    scheduler.setMaxConcurrentJobs(4);
+    scheduler.setJobsPerSsd(1);
+    BackupConfig config("test", dir.filePath("missing"), dir.filePath("destination"));
+    EXPECT_TRUE(scheduler.enqueue(0, config));
+    EXPECT_TRUE(scheduler.enqueue(1, config));
+    EXPECT_EQ(scheduler.runningJobs(), 1);
+    EXPECT_EQ(scheduler.pendingJobs(), 1);
+}
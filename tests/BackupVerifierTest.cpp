@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "../src/backup/BackupVerifier.h"
+#include "../src/backup/Manifest.h"
+#include "../src/utils/FileSystem.h"
+
+class BackupVerifierTest : public ::testing::Test {
+protected:
+    QTemporaryDir sourceDir;
+    QTemporaryDir backupDir;
+    const qint64 mtimeNs = 1704164645123456789LL;
+    const QStringList paths = {"a.txt", "dir/b.txt", "dir/sub/c.txt"};
+
+    void SetUp() override {
+        for (const QString &path : paths) {
+            writeFile(sourceDir.path(), path, path.toUtf8().repeated(1000));
+            writeFile(backupDir.path(), path, path.toUtf8().repeated(1000));
+            FileSystem().setModificationTime(sourceDir.filePath(path), mtimeNs);
+        }
+    }
+
+    void writeFile(const QString &root, const QString &relativePath, const QByteArray &data) {
+        QDir(root).mkpath(QFileInfo(relativePath).path());
+        QFile file(QDir(root).filePath(relativePath));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    void writeManifest() {
+        ManifestWriter writer(manifestFilePath(backupDir.path()));
+        ASSERT_TRUE(writer.open());
+        for (const QString &path : paths) {
+            ManifestEntry entry;
+            entry.path = path.toUtf8();
+            entry.size = QFileInfo(sourceDir.filePath(path)).size();
+            entry.mtimeNs = mtimeNs;
+            entry.mode = 0644;
+            writer.write(entry);
+        }
+        ASSERT_TRUE(writer.commit());
+    }
+
+    BackupVerifier::Request request(BackupVerifier::Mode mode) const {
+        BackupVerifier::Request request;
+        request.sourceRoot = sourceDir.path();
+        request.backupRoot = backupDir.path();
+        request.mode = mode;
+        request.threads = 2;
+        return request;
+    }
+};
+
+TEST_F(BackupVerifierTest, MetadataDetectsMissingAndResizedFiles) {
+    writeManifest();
+    QFile::remove(backupDir.filePath("dir/b.txt"));
+    writeFile(backupDir.path(), "dir/sub/c.txt", "short");
+
+    BackupVerifier verifier;
+    EXPECT_FALSE(verifier.verify(request(BackupVerifier::Metadata)));
+
+    const BackupVerifier::Statistics statistics = verifier.lastStatistics();
+    EXPECT_TRUE(statistics.usedManifest);
+    EXPECT_EQ(statistics.checkedFiles, 3);
+    EXPECT_EQ(statistics.matchedFiles, 1);
+    ASSERT_EQ(statistics.mismatches.size(), 2);
+    EXPECT_EQ(statistics.mismatches[0].path, QByteArray("dir/b.txt"));
+    EXPECT_EQ(statistics.mismatches[0].kind, BackupVerifier::Mismatch::Missing);
+    EXPECT_EQ(statistics.mismatches[1].path, QByteArray("dir/sub/c.txt"));
+    EXPECT_EQ(statistics.mismatches[1].kind, BackupVerifier::Mismatch::SizeDiffers);
+    EXPECT_EQ(statistics.bytesHashed, 0);
+}
+
+TEST_F(BackupVerifierTest, ContentRecordsHashesAndReusesThem) {
+    writeManifest();
+    BackupVerifier verifier;
+    ASSERT_TRUE(verifier.verify(request(BackupVerifier::Content)));
+    EXPECT_EQ(verifier.lastStatistics().hashesRecorded, 3);
+
+    // 元を消しても、記録したハッシュと比べられる
+    for (const QString &path : paths) QFile::remove(sourceDir.filePath(path));
+    // サイズを変えずに保存先を壊す
+    writeFile(backupDir.path(), "dir/b.txt", QByteArray("X") + QByteArray("dir/b.txt").repeated(1000).mid(1));
+
+    EXPECT_FALSE(verifier.verify(request(BackupVerifier::Content)));
+    const BackupVerifier::Statistics statistics = verifier.lastStatistics();
+    EXPECT_EQ(statistics.hashesReused, 3);
+    EXPECT_EQ(statistics.matchedFiles, 2);
+    ASSERT_EQ(statistics.mismatches.size(), 1);
+    EXPECT_EQ(statistics.mismatches[0].path, QByteArray("dir/b.txt"));
+    EXPECT_EQ(statistics.mismatches[0].kind, BackupVerifier::Mismatch::ContentDiffers);
+}
+
+TEST_F(BackupVerifierTest, ContentSkipsSourcesChangedAfterBackup) {
+    writeManifest();
+    writeFile(sourceDir.path(), "a.txt", "edited after the backup");
+
+    BackupVerifier verifier;
+    EXPECT_TRUE(verifier.verify(request(BackupVerifier::Content)));
+    const BackupVerifier::Statistics statistics = verifier.lastStatistics();
+    EXPECT_EQ(statistics.sourceChanged, 1);
+    EXPECT_EQ(statistics.matchedFiles, 2);
+    EXPECT_EQ(statistics.hashesRecorded, 2);
+}
+
+TEST_F(BackupVerifierTest, WalksBackupWithoutManifest) {
+    writeFile(backupDir.path(), "a.txt", QByteArray("Y") + QByteArray("a.txt").repeated(1000).mid(1));
+
+    BackupVerifier verifier;
+    EXPECT_FALSE(verifier.verify(request(BackupVerifier::Content)));
+    const BackupVerifier::Statistics statistics = verifier.lastStatistics();
+    EXPECT_FALSE(statistics.usedManifest);
+    EXPECT_EQ(statistics.checkedFiles, 3);
+    ASSERT_EQ(statistics.mismatches.size(), 1);
+    EXPECT_EQ(statistics.mismatches[0].kind, BackupVerifier::Mismatch::ContentDiffers);
+    EXPECT_EQ(statistics.hashesRecorded, 0);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <QVector>
+#include <QThread>
+#include <cstdint>
+#include "../src/utils/BufferPool.h"
+
+class BufferPoolTest : public ::testing::Test {
+protected:
+    BufferPool::Options smallPool() {
+        BufferPool::Options options;
+        options.sizeClasses = {64 * 1024, 1024 * 1024};
+        options.bytesPerClass = 4 * 1024 * 1024;
+        return options;
+    }
+};
+
+TEST_F(BufferPoolTest, BuffersArePageAligned) {
+    BufferPool pool(smallPool());
+    qint64 size = 0;
+    char *buffer = pool.acquire(1000, &size);
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(reinterpret_cast<quintptr>(buffer) % BufferPool::kAlignment, 0u);
+    EXPECT_EQ(size, 64 * 1024);
+    pool.release(buffer);
+}
+
+TEST_F(BufferPoolTest, TryAcquireFallsBackToLargerClassThenFails) {
+    BufferPool pool(smallPool());
+    QVector<char *> held;
+    while (char *buffer = pool.tryAcquire(64 * 1024)) {
+        held.append(buffer);
+    }
+    // 64 KiB x 64 + 1 MiB x 4
+    EXPECT_EQ(held.size(), 68);
+    EXPECT_EQ(pool.tryAcquire(2 * 1024 * 1024), nullptr);
+    for (char *buffer : held) {
+        pool.release(buffer);
+    }
+    EXPECT_EQ(pool.stats().inUseBytes, 0);
+}
+
+TEST_F(BufferPoolTest, ReportsPeakUsage) {
+    BufferPool pool(smallPool());
+    char *a = pool.acquire(1024 * 1024);
+    char *b = pool.acquire(1024 * 1024);
+    pool.release(a);
+    pool.release(b);
+
+    BufferPool::Stats stats = pool.stats();
+    EXPECT_EQ(stats.peakInUseBytes, 2 * 1024 * 1024);
+    EXPECT_EQ(stats.acquisitions, 2);
+
+    pool.resetStats();
+    EXPECT_EQ(pool.stats().peakInUseBytes, 0);
+}
+
+TEST_F(BufferPoolTest, AcquireWaitsForRelease) {
+    BufferPool pool(smallPool());
+    QVector<char *> held;
+    while (char *buffer = pool.tryAcquire(1024 * 1024)) {
+        held.append(buffer);
+    }
+
+    QThread *releaser = QThread::create([&]() {
+        QThread::msleep(50);
+        pool.release(held.takeLast());
+    });
+    releaser->start();
+    char *buffer = pool.acquire(1024 * 1024);
+    releaser->wait();
+    delete releaser;
+
+    EXPECT_NE(buffer, nullptr);
+    EXPECT_EQ(pool.stats().waits, 1);
+    pool.release(buffer);
+    for (char *remaining : held) {
+        pool.release(remaining);
+    }
+}
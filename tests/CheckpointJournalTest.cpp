@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include "../src/backup/CheckpointJournal.h"
+
+namespace {
+
+CheckpointJournal::Header makeHeader() {
+    CheckpointJournal::Header header;
+    header.sourcePath = "/data/source";
+    header.updateMode = 1;
+    header.baseManifestSize = 4096;
+    header.baseManifestMtimeMs = 1700000000000;
+    header.startedMs = 1700000100000;
+    return header;
+}
+
+}
+
+TEST(CheckpointJournalTest, RecordsCompletedFilesAndPosition) {
+    QTemporaryDir dir;
+    const QString path = CheckpointJournal::filePath(dir.path());
+    {
+        CheckpointJournal journal(path);
+        ASSERT_TRUE(journal.begin(makeHeader()));
+        journal.add("a/one.txt", CheckpointJournal::Entry{10, 111});
+        journal.add("a/two.txt", CheckpointJournal::Entry{20, 222});
+        journal.setPosition(2, "b/three.txt");
+        ASSERT_TRUE(journal.flush());
+    }
+
+    CheckpointJournal loaded(path);
+    ASSERT_TRUE(loaded.load());
+    EXPECT_TRUE(loaded.header().matches(makeHeader()));
+    EXPECT_EQ(loaded.header().startedMs, makeHeader().startedMs);
+    EXPECT_EQ(loaded.completedCount(), 2);
+    CheckpointJournal::Entry entry;
+    ASSERT_TRUE(loaded.completed("a/two.txt", &entry));
+    EXPECT_EQ(entry.size, 20);
+    EXPECT_EQ(entry.mtimeNs, 222);
+    EXPECT_FALSE(loaded.completed("b/three.txt"));
+    EXPECT_EQ(loaded.positionDone(), 2);
+    EXPECT_EQ(loaded.positionPath(), QByteArray("b/three.txt"));
+}
+
+TEST(CheckpointJournalTest, HeaderMatchIgnoresStartTime) {
+    CheckpointJournal::Header other = makeHeader();
+    other.startedMs += 1000;
+    EXPECT_TRUE(makeHeader().matches(other));
+
+    // 前回のマニフェストが書き換わっていたら（間に別の実行が終わっていたら）再開しない
+    other.baseManifestMtimeMs += 1;
+    EXPECT_FALSE(makeHeader().matches(other));
+    other = makeHeader();
+    other.updateMode = 2;
+    EXPECT_FALSE(makeHeader().matches(other));
+}
+
+TEST(CheckpointJournalTest, TruncatedTailIsDroppedAndResumeAppendsAfterIt) {
+    QTemporaryDir dir;
+    const QString path = CheckpointJournal::filePath(dir.path());
+    {
+        CheckpointJournal journal(path);
+        ASSERT_TRUE(journal.begin(makeHeader()));
+        journal.add("first", CheckpointJournal::Entry{1, 1});
+        journal.add("second", CheckpointJournal::Entry{2, 2});
+        ASSERT_TRUE(journal.flush());
+    }
+    // 2件目を書いている途中で止まったことにする
+    ASSERT_TRUE(QFile::resize(path, QFileInfo(path).size() - 3));
+
+    {
+        CheckpointJournal journal(path);
+        ASSERT_TRUE(journal.load());
+        EXPECT_EQ(journal.completedCount(), 1);
+        EXPECT_TRUE(journal.completed("first"));
+        EXPECT_FALSE(journal.completed("second"));
+        ASSERT_TRUE(journal.resume());
+        journal.add("third", CheckpointJournal::Entry{3, 3});
+        ASSERT_TRUE(journal.flush());
+    }
+
+    CheckpointJournal loaded(path);
+    ASSERT_TRUE(loaded.load());
+    EXPECT_EQ(loaded.completedCount(), 2);
+    EXPECT_TRUE(loaded.completed("first"));
+    EXPECT_TRUE(loaded.completed("third"));
+}
+
+TEST(CheckpointJournalTest, RejectsOtherFilesAndRemoves) {
+    QTemporaryDir dir;
+    const QString path = CheckpointJournal::filePath(dir.path());
+    CheckpointJournal missing(path);
+    EXPECT_FALSE(missing.load());
+
+    QFile other(path);
+    ASSERT_TRUE(other.open(QIODevice::WriteOnly));
+    other.write("not a journal");
+    other.close();
+    CheckpointJournal invalid(path);
+    EXPECT_FALSE(invalid.load());
+
+    CheckpointJournal journal(path);
+    ASSERT_TRUE(journal.begin(makeHeader()));
+    EXPECT_TRUE(journal.remove());
+    EXPECT_FALSE(QFile::exists(path));
+}
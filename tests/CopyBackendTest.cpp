@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <iostream>
+#include "../src/utils/CopyBackend.h"
+#include "../src/utils/IoUringCopyBackend.h"
+#include "../src/utils/KernelCopyBackend.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    // path のうちページキャッシュに載っているページの割合（mincore）
+    double residentFraction(const QString &path) {
+        const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return -1;
+        struct stat st;
+        ::fstat(fd, &st);
+        if (st.st_size == 0) {
+            ::close(fd);
+            return 0;
+        }
+        void *map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) return -1;
+        const long pageSize = ::sysconf(_SC_PAGESIZE);
+        std::vector<unsigned char> pages((st.st_size + pageSize - 1) / pageSize);
+        ::mincore(map, st.st_size, pages.data());
+        ::munmap(map, st.st_size);
+        size_t resident = 0;
+        for (unsigned char page : pages) resident += page & 1;
+        return double(resident) / pages.size();
+    }
+}
+#endif
+
+class CopyBackendTest : public ::testing::Test {
+protected:
+    QTemporaryDir sourceDir;
+    QTemporaryDir destDir;
+    QStringList relativePaths;
+
+    // 100ファイルずつのサブフォルダに小さなファイルを作る
+    void createSmallFileTree(int fileCount, int fileSize) {
+        QByteArray content(fileSize, 'x');
+        for (int i = 0; i < fileCount; ++i) {
+            QString relativePath = QString("dir%1/file%2.dat").arg(i / 100).arg(i);
+            QDir(sourceDir.path()).mkpath(QString("dir%1").arg(i / 100));
+            QDir(destDir.path()).mkpath(QString("dir%1").arg(i / 100));
+            QFile file(sourceDir.filePath(relativePath));
+            ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+            content[0] = static_cast<char>(i);
+            file.write(content);
+            relativePaths.append(relativePath);
+        }
+    }
+
+    int copyAll(CopyBackend &backend) {
+        QMutex mutex;
+        int failures = 0;
+        for (const QString &relativePath : relativePaths) {
+            backend.submit(sourceDir.filePath(relativePath), destDir.filePath(relativePath), false,
+                           [&](bool success, const QString &) {
+                               QMutexLocker locker(&mutex);
+                               if (!success) failures++;
+                           });
+        }
+        backend.waitForDone();
+        return failures;
+    }
+
+    void expectSameContents() {
+        for (const QString &relativePath : relativePaths) {
+            QFile source(sourceDir.filePath(relativePath));
+            QFile dest(destDir.filePath(relativePath));
+            ASSERT_TRUE(source.open(QIODevice::ReadOnly));
+            ASSERT_TRUE(dest.open(QIODevice::ReadOnly));
+            EXPECT_EQ(source.readAll(), dest.readAll()) << relativePath.toStdString();
+        }
+    }
+};
+
+TEST_F(CopyBackendTest, ThreadPoolCopiesFiles) {
+    createSmallFileTree(300, 3000);
+    std::unique_ptr<CopyBackend> backend = CopyBackend::create(CopyBackend::ThreadPool);
+    EXPECT_EQ(copyAll(*backend), 0);
+    expectSameContents();
+}
+
+TEST_F(CopyBackendTest, IoUringCopiesFiles) {
+    if (!IoUringCopyBackend::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    createSmallFileTree(300, 3000);
+    IoUringCopyBackend backend;
+    EXPECT_EQ(copyAll(backend), 0);
+    expectSameContents();
+}
+
+TEST_F(CopyBackendTest, KernelCopyCopiesFiles) {
+    if (!KernelCopyBackend::isSupported()) {
+        GTEST_SKIP() << "copy_file_range is not available";
+    }
+    // 1ファイルは copy_file_range の1回分（64 MiB）を超える大きさにする
+    createSmallFileTree(300, 3000);
+    relativePaths.append("large.dat");
+    QFile large(sourceDir.filePath("large.dat"));
+    ASSERT_TRUE(large.open(QIODevice::WriteOnly));
+    ASSERT_TRUE(large.resize(65 * 1024 * 1024 + 17));
+    large.close();
+
+    KernelCopyBackend backend;
+    EXPECT_EQ(copyAll(backend), 0);
+    expectSameContents();
+}
+
+TEST_F(CopyBackendTest, DropCacheCopiesFiles) {
+    createSmallFileTree(100, 3000);
+    // 書き出しの区切り（8 MiB）をまたぐ大きさのファイルも含める
+    relativePaths.append("large.dat");
+    QFile large(sourceDir.filePath("large.dat"));
+    ASSERT_TRUE(large.open(QIODevice::WriteOnly));
+    QByteArray block(1024 * 1024, 'y');
+    for (int i = 0; i < 20; ++i) {
+        block[0] = static_cast<char>(i);
+        large.write(block);
+    }
+    large.write("tail");
+    large.close();
+
+    QList<CopyBackend::Kind> kinds = {CopyBackend::ThreadPool, CopyBackend::Auto};
+    if (KernelCopyBackend::isSupported()) {
+        kinds.append(CopyBackend::KernelCopy);
+    }
+    for (CopyBackend::Kind kind : kinds) {
+        std::unique_ptr<CopyBackend> backend = CopyBackend::create(kind, nullptr, 0, nullptr, true);
+        EXPECT_TRUE(backend->name().contains("drop cache")) << backend->name().toStdString();
+        EXPECT_EQ(copyAll(*backend), 0);
+        expectSameContents();
+    }
+}
+
+TEST_F(CopyBackendTest, OverwritesExistingFile) {
+    createSmallFileTree(1, 10);
+    QFile existing(destDir.filePath(relativePaths.first()));
+    ASSERT_TRUE(existing.open(QIODevice::WriteOnly));
+    existing.write("old contents that are longer than the source");
+    existing.close();
+
+    std::unique_ptr<CopyBackend> backend = CopyBackend::create();
+    EXPECT_EQ(copyAll(*backend), 0);
+    expectSameContents();
+}
+
+// 小さなファイル 20,000 個でスレッドプールと io_uring を比較する。
+// 手動実行: --gtest_also_run_disabled_tests --gtest_filter=*SmallFileTreeBenchmark
+TEST_F(CopyBackendTest, DISABLED_SmallFileTreeBenchmark) {
+    createSmallFileTree(20000, 4096);
+
+    QList<CopyBackend::Kind> kinds = {CopyBackend::ThreadPool};
+    if (IoUringCopyBackend::isSupported()) {
+        kinds.append(CopyBackend::IoUring);
+    }
+
+    for (CopyBackend::Kind kind : kinds) {
+        std::unique_ptr<CopyBackend> backend = CopyBackend::create(kind);
+        QElapsedTimer timer;
+        timer.start();
+        EXPECT_EQ(copyAll(*backend), 0);
+        const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+        std::cout << backend->name().toStdString() << ": " << relativePaths.size() << " files in "
+                  << elapsed << " ms (" << (relativePaths.size() * 1000 / elapsed) << " files/s)" << std::endl;
+    }
+}
+
+#ifdef Q_OS_LINUX
+// 大きなファイルのコピーの前後で、ほかのアプリが使っているファイル（foreground）と元・先のファイルが
+// ページキャッシュにどれだけ残っているかを、通常のコピーとキャッシュを汚さないコピーで比べる。
+// メモリに収まらない量をコピーすると foreground が追い出される違いが見える（SBS_BENCH_MIB で量を変えられる）。
+// 手動実行: --gtest_also_run_disabled_tests --gtest_filter=*PageCacheResidencyBenchmark
+TEST_F(CopyBackendTest, DISABLED_PageCacheResidencyBenchmark) {
+    const qint64 totalMiB = qEnvironmentVariableIsSet("SBS_BENCH_MIB") ? qEnvironmentVariableIntValue("SBS_BENCH_MIB") : 2048;
+    const qint64 fileMiB = 256;
+    QByteArray block(1024 * 1024, 'z');
+    for (qint64 i = 0; i * fileMiB < totalMiB; ++i) {
+        const QString relativePath = QString("large%1.dat").arg(i);
+        QFile file(sourceDir.filePath(relativePath));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        for (qint64 j = 0; j < fileMiB; ++j) {
+            block[0] = static_cast<char>(j);
+            file.write(block);
+        }
+        file.close();
+        relativePaths.append(relativePath);
+    }
+
+    QTemporaryDir foregroundDir;
+    const QString foreground = foregroundDir.filePath("foreground.dat");
+    {
+        QFile file(foreground);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        for (int j = 0; j < 64; ++j) file.write(block);
+    }
+
+    auto averageResidency = [&](const QTemporaryDir &dir) {
+        double sum = 0;
+        for (const QString &relativePath : relativePaths) sum += residentFraction(dir.filePath(relativePath));
+        return sum / relativePaths.size();
+    };
+
+    for (bool dropCache : {false, true}) {
+        // 元と先のキャッシュを空にし、foreground を読み込んでおく
+        for (const QString &relativePath : relativePaths) {
+            for (const QTemporaryDir *dir : {&sourceDir, &destDir}) {
+                const int fd = ::open(QFile::encodeName(dir->filePath(relativePath)).constData(), O_RDONLY);
+                if (fd >= 0) {
+                    ::fdatasync(fd);
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                    ::close(fd);
+                }
+            }
+        }
+        QFile file(foreground);
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        while (!file.read(1024 * 1024).isEmpty()) {
+        }
+        file.close();
+        const double before = residentFraction(foreground);
+
+        std::unique_ptr<CopyBackend> backend = CopyBackend::create(CopyBackend::Auto, nullptr, 0, nullptr, dropCache);
+        QElapsedTimer timer;
+        timer.start();
+        EXPECT_EQ(copyAll(*backend), 0);
+        const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+
+        std::cout << backend->name().toStdString() << ": " << totalMiB << " MiB in " << elapsed << " ms ("
+                  << totalMiB * 1000 / elapsed << " MiB/s), foreground resident " << int(before * 100) << "% -> "
+                  << int(residentFraction(foreground) * 100) << "%, source " << int(averageResidency(sourceDir) * 100)
+                  << "%, destination " << int(averageResidency(destDir) * 100) << "%" << std::endl;
+    }
+}
+#endif
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "../src/utils/DeviceInfo.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace {
+    QString deviceNumber(const QString &path) {
+        struct stat st;
+        ::stat(QFile::encodeName(path).constData(), &st);
+        return QString("%1:%2").arg(major(st.st_dev)).arg(minor(st.st_dev));
+    }
+
+    void writeFile(const QString &path, const QByteArray &data) {
+        QDir().mkpath(QFileInfo(path).path());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    // /sys/dev/block/<number> がディスク disk のパーティション partition を指す偽の sysfs を作る
+    void makeFakeSys(const QString &sysRoot, const QString &number, const QString &disk,
+                     const QString &partition, const QByteArray &rotational) {
+        const QString diskDir = sysRoot + "/devices/virtual/block/" + disk;
+        writeFile(diskDir + "/queue/rotational", rotational + "\n");
+        writeFile(diskDir + "/" + partition + "/partition", "1\n");
+        QDir().mkpath(sysRoot + "/dev/block");
+        QFile::link(diskDir + "/" + partition, sysRoot + "/dev/block/" + number);
+    }
+}
+
+TEST(DeviceInfoTest, PartitionMapsToRotationalDisk) {
+    QTemporaryDir dir;
+    const QString sysRoot = dir.filePath("sys");
+    makeFakeSys(sysRoot, deviceNumber(dir.path()), "sdz", "sdz1", "1");
+
+    const DeviceInfo::Device device = DeviceInfo::forPath(dir.path(), sysRoot);
+    EXPECT_TRUE(device.known);
+    EXPECT_TRUE(device.rotational);
+    EXPECT_EQ(device.name, "sdz");
+    EXPECT_EQ(device.key, "sdz");
+    EXPECT_EQ(device.typeName(), "HDD");
+    EXPECT_EQ(DeviceInfo::jobLimit(device, 4), 1);
+    EXPECT_EQ(DeviceInfo::fileStreamLimit(device, DeviceInfo::Device()), 1);
+}
+
+TEST(DeviceInfoTest, SolidStateDiskAllowsParallelJobs) {
+    QTemporaryDir dir;
+    const QString sysRoot = dir.filePath("sys");
+    makeFakeSys(sysRoot, deviceNumber(dir.path()), "nvme9n1", "nvme9n1p2", "0");
+
+    const DeviceInfo::Device device = DeviceInfo::forPath(dir.path(), sysRoot);
+    EXPECT_TRUE(device.known);
+    EXPECT_FALSE(device.rotational);
+    EXPECT_EQ(device.typeName(), "SSD");
+    EXPECT_EQ(DeviceInfo::jobLimit(device, 4), 4);
+    EXPECT_EQ(DeviceInfo::fileStreamLimit(device, device), 0);
+}
+
+TEST(DeviceInfoTest, UnknownDeviceFallsBackToDeviceNumber) {
+    QTemporaryDir dir;
+    const DeviceInfo::Device device = DeviceInfo::forPath(dir.path(), dir.filePath("no-sys"));
+    EXPECT_FALSE(device.known);
+    EXPECT_EQ(device.key, deviceNumber(dir.path()));
+    EXPECT_EQ(device.typeName(), "unknown");
+}
+#endif
+
+TEST(DeviceInfoTest, PathsOnSameFileSystemShareDevice) {
+    QTemporaryDir dir;
+    QDir(dir.path()).mkpath("a/b");
+    EXPECT_EQ(DeviceInfo::forPath(dir.filePath("a/b")).key, DeviceInfo::forPath(dir.path()).key);
+}
+
+TEST(DeviceInfoTest, MissingPathUsesExistingParent) {
+    QTemporaryDir dir;
+    EXPECT_EQ(DeviceInfo::forPath(dir.filePath("not/yet/created")).key, DeviceInfo::forPath(dir.path()).key);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <iostream>
+#include "../src/utils/FileIndex.h"
+#include "../src/utils/TreeWalker.h"
+#ifdef Q_OS_LINUX
+#include <malloc.h>
+#endif
+
+TEST(FileIndexTest, BuildsPathsAndSortsByDirectory) {
+    FileIndex index;
+    const FileIndex::Id b = index.addDirectory(FileIndex::kRootDirectory, "b");
+    const FileIndex::Id a = index.addDirectory(FileIndex::kRootDirectory, "a");
+    const FileIndex::Id ab = index.addDirectory(a, "b");
+    const FileIndex::Id ax = index.addDirectory(FileIndex::kRootDirectory, "a-x");
+
+    index.addFile(b, "z.txt", 10, 0, 0644);
+    index.addFile(ab, "index.js", 5, 0, 0600);
+    index.addFile(a, "index.js", 7, 0, 0644);
+    index.addFile(ax, "q", 2, 0, 0644);
+    index.addFile(FileIndex::kRootDirectory, "root.txt", 1, 0, 0644);
+    index.addFile(a, "c", 3, 0, 0644);
+
+    EXPECT_EQ(index.directoryCount(), 5);
+    EXPECT_EQ(index.fileCount(), 6);
+    EXPECT_EQ(index.totalSize(), 28);
+    EXPECT_EQ(index.directoryPath(ab), QByteArray("a/b"));
+    EXPECT_TRUE(index.directoryPath(FileIndex::kRootDirectory).isEmpty());
+
+    index.sort();
+    QList<QByteArray> paths;
+    for (int i = 0; i < index.fileCount(); ++i) {
+        paths.append(index.filePath(i));
+    }
+    // "a/b" は "a-x" より前（'/' を最小の文字として比較する）
+    const QList<QByteArray> expected = {"root.txt", "a/c", "a/index.js", "a/b/index.js", "a-x/q", "b/z.txt"};
+    EXPECT_EQ(paths, expected);
+    // 並べ替えで属性の列も一緒に入れ替わる
+    EXPECT_EQ(index.fileSize(3), 5);
+    EXPECT_EQ(index.fileMode(3), 0600u);
+}
+
+TEST(FileIndexTest, InternsRepeatedNames) {
+    FileIndex index;
+    const qint64 empty = index.memoryUsage();
+    for (int i = 0; i < 1000; ++i) {
+        const FileIndex::Id dir = index.addDirectory(FileIndex::kRootDirectory, QByteArray::number(i));
+        index.addFile(dir, "index.html", 1, 0, 0644);
+    }
+    // 同じ名前は同じバイト列を指す
+    EXPECT_EQ(index.fileName(0).data(), index.fileName(999).data());
+    EXPECT_LT(index.memoryUsage() - empty, 1000 * 64);
+}
+
+TEST(FileIndexTest, TreeWalkerFillsIndex) {
+    QTemporaryDir rootDir;
+    QDir root(rootDir.path());
+    ASSERT_TRUE(root.mkpath("sub/deep"));
+    for (const QString &name : {QString("top.txt"), QString("sub/a.txt"), QString("sub/deep/b.txt")}) {
+        QFile file(root.filePath(name));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("abc");
+    }
+
+    TreeWalker::Options options;
+    options.sorted = true;
+    options.needSize = true;
+    options.needMetadata = true;
+    FileIndex index;
+    TreeWalker(options).walk(rootDir.path(), index);
+
+    QList<QByteArray> paths;
+    for (int i = 0; i < index.fileCount(); ++i) {
+        paths.append(index.filePath(i));
+        EXPECT_EQ(index.fileSize(i), 3);
+        EXPECT_GT(index.fileMtime(i), 0);
+    }
+    const QList<QByteArray> expected = {"top.txt", "sub/a.txt", "sub/deep/b.txt"};
+    EXPECT_EQ(paths, expected);
+}
+
+#ifdef Q_OS_LINUX
+static qint64 heapInUse() {
+    return static_cast<qint64>(mallinfo2().uordblks);
+}
+
+// QFileInfoList と FileIndex の1件あたりのメモリ量を比べる
+TEST(FileIndexTest, DISABLED_MemoryPerEntryBenchmark) {
+    QTemporaryDir rootDir;
+    QDir root(rootDir.path());
+    const int dirs = 200;
+    const int filesPerDir = 500;
+    for (int d = 0; d < dirs; ++d) {
+        const QString dirName = QString("project/src/module%1").arg(d);
+        ASSERT_TRUE(root.mkpath(dirName));
+        for (int f = 0; f < filesPerDir; ++f) {
+            QFile file(root.filePath(QString("%1/source_file_%2.cpp").arg(dirName).arg(f)));
+            ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        }
+    }
+    const int entries = dirs * filesPerDir;
+
+    qint64 before = heapInUse();
+    {
+        QFileInfoList list;
+        QDirIterator it(rootDir.path(), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            QFileInfo info = it.fileInfo();
+            info.size(); // 属性をキャッシュさせる
+            list.append(info);
+        }
+        const qint64 used = heapInUse() - before;
+        std::cout << "QFileInfoList: " << used / entries << " bytes/entry" << std::endl;
+    }
+
+    before = heapInUse();
+    {
+        TreeWalker::Options options;
+        options.needSize = true;
+        options.needMetadata = true;
+        FileIndex index;
+        TreeWalker(options).walk(rootDir.path(), index);
+        const qint64 used = heapInUse() - before;
+        std::cout << "FileIndex: " << used / entries << " bytes/entry (memoryUsage "
+                  << index.memoryUsage() / entries << ")" << std::endl;
+    }
+}
+#endif
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include "../src/utils/FileRemover.h"
+
+class FileRemoverTest : public ::testing::Test {
+protected:
+    QTemporaryDir rootDir;
+
+    void touch(const QString &relativePath) {
+        QDir(rootDir.path()).mkpath(QFileInfo(rootDir.filePath(relativePath)).path());
+        QFile file(rootDir.filePath(relativePath));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    }
+
+    bool exists(const QString &relativePath) const {
+        return QFileInfo::exists(rootDir.filePath(relativePath));
+    }
+};
+
+TEST_F(FileRemoverTest, RemovesFilesInBatchesAndPrunesEmptyDirectories) {
+    QVector<QByteArray> paths;
+    for (int i = 0; i < 500; ++i) {
+        touch(QString("a/b/f%1").arg(i));
+        paths.append("a/b/f" + QByteArray::number(i));
+    }
+    touch("c/x");
+    touch("c/keep");
+    paths.append("c/x");
+    paths.append("c/missing"); // 既にないファイルは削除済みとして数える
+
+    FileRemover::Options options;
+    options.threads = 4;
+    options.batchSize = 64;
+    FileRemover remover(rootDir.path(), options);
+    remover.removeFiles(paths);
+    EXPECT_EQ(remover.removedCount(), 502);
+    EXPECT_TRUE(remover.failures().isEmpty());
+
+    EXPECT_EQ(remover.removeEmptyDirectories({"a/b", "c"}), 2);
+    EXPECT_FALSE(exists("a"));
+    EXPECT_TRUE(exists("c/keep"));
+}
+
+TEST_F(FileRemoverTest, RemovesDeepAndWideTreesBottomUp) {
+    // 再帰ではスタックが気になる深さと、並列に配られる幅の両方を持つ木
+    QString deep = "tree";
+    for (int i = 0; i < 200; ++i) deep += "/d";
+    touch(deep + "/leaf");
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 20; ++j) touch(QString("tree/w%1/f%2").arg(i).arg(j));
+    }
+    touch("other/keep");
+
+    FileRemover::Options options;
+    options.threads = 4;
+    int progressCalls = 0;
+    options.onProgress = [&progressCalls](const FileRemover::Progress &) { ++progressCalls; return true; };
+    FileRemover remover(rootDir.path(), options);
+    EXPECT_TRUE(remover.removeTree("tree"));
+    EXPECT_FALSE(exists("tree"));
+    EXPECT_TRUE(exists("other/keep"));
+    EXPECT_EQ(remover.progress().files, 1001);
+    EXPECT_EQ(remover.progress().directories, 251);
+    EXPECT_GE(progressCalls, 1);
+
+    // 空のパスならルートの中身だけを消す
+    FileRemover all(rootDir.path());
+    EXPECT_TRUE(all.removeTree());
+    EXPECT_TRUE(QDir(rootDir.path()).isEmpty(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot));
+    EXPECT_TRUE(QFileInfo::exists(rootDir.path()));
+}
+
+TEST_F(FileRemoverTest, StopsWhenProgressCallbackCancels) {
+    for (int i = 0; i < 200; ++i) touch(QString("t/f%1").arg(i));
+
+    FileRemover::Options options;
+    options.threads = 1;
+    options.maxOperationsPerSecond = 100; // 200件で約2秒かかるので、最初の通知で止まる
+    options.onProgress = [](const FileRemover::Progress &) { return false; };
+    FileRemover remover(rootDir.path(), options);
+    QElapsedTimer timer;
+    timer.start();
+    EXPECT_FALSE(remover.removeTree("t"));
+    EXPECT_TRUE(remover.isCancelled());
+    EXPECT_LT(timer.elapsed(), 1500);
+    EXPECT_LT(remover.progress().files, 200);
+    EXPECT_TRUE(exists("t"));
+}
+
+#ifdef Q_OS_LINUX
+TEST_F(FileRemoverTest, DoesNotFollowSymlinkedDirectories) {
+    QTemporaryDir outside;
+    QFile target(outside.filePath("keep"));
+    ASSERT_TRUE(target.open(QIODevice::WriteOnly));
+    target.close();
+    ASSERT_TRUE(QFile::link(outside.path(), rootDir.filePath("link")));
+
+    FileRemover remover(rootDir.path());
+    remover.removeFiles({"link/keep"});
+    EXPECT_EQ(remover.removedCount(), 0);
+    ASSERT_EQ(remover.failures().size(), 1);
+    EXPECT_EQ(remover.failures().first().path, QByteArray("link/keep"));
+    EXPECT_TRUE(QFileInfo::exists(outside.filePath("keep")));
+}
+
+TEST_F(FileRemoverTest, RemoveTreeUnlinksSymlinksWithoutDescending) {
+    QTemporaryDir outside;
+    QFile target(outside.filePath("keep"));
+    ASSERT_TRUE(target.open(QIODevice::WriteOnly));
+    target.close();
+    touch("t/file");
+    ASSERT_TRUE(QFile::link(outside.path(), rootDir.filePath("t/link")));
+
+    FileRemover remover(rootDir.path());
+    EXPECT_TRUE(remover.removeTree("t"));
+    EXPECT_FALSE(exists("t"));
+    EXPECT_TRUE(QFileInfo::exists(outside.filePath("keep")));
+}
+#endif
@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#include "FileSystem.h"
+#include "../src/utils/FileSystem.h"
 
 class FileSystemTest : public ::testing::Test {
 protected:
@@ -14,24 +14,20 @@ protected:
 
 TEST_F(FileSystemTest, TestCopyFile) {
     // ファイルコピーのテストを実装
-    FileSystem fs;
     // ここにファイルコピーのテストコードを書く
 }
 
 TEST_F(FileSystemTest, TestDeleteFile) {
     // ファイル削除のテストを実装
-    FileSystem fs;
     // ここにファイル削除のテストコードを書く
 }
 
 TEST_F(FileSystemTest, TestCreateDirectory) {
     // ディレクトリ作成のテストを実装
-    FileSystem fs;
     // ここにディレクトリ作成のテストコードを書く
 }
 
 TEST_F(FileSystemTest, TestDeleteDirectory) {
     // ディレクトリ削除のテストを実装
-    FileSystem fs;
     // ここにディレクトリ削除のテストコードを書く
 }
\ No newline at end of file
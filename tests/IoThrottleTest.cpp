@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include "../src/utils/IoThrottle.h"
+
+namespace {
+    const qint64 kMiB = 1024 * 1024;
+
+    IoThrottle::Limits readLimit(int megabytesPerSecond) {
+        IoThrottle::Limits limits;
+        limits.readMBps = megabytesPerSecond;
+        return limits;
+    }
+}
+
+TEST(IoThrottleTest, UnlimitedDoesNotWait) {
+    IoThrottle throttle;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 1000; ++i) {
+        throttle.acquireRead(kMiB);
+        throttle.acquireWrite(kMiB);
+    }
+    EXPECT_LT(timer.elapsed(), 100);
+    EXPECT_EQ(throttle.waitedMs(), 0);
+}
+
+TEST(IoThrottleTest, ReadLimitPacesBytes) {
+    IoThrottle throttle(readLimit(20));
+    QElapsedTimer timer;
+    timer.start();
+    // 20 MB/s で 6 MiB。最初の1回は通り、残りの 5 MiB ぶん（約 250 ms）待つ
+    for (int i = 0; i < 6; ++i) {
+        throttle.acquireRead(kMiB);
+    }
+    EXPECT_GE(timer.elapsed(), 200);
+    EXPECT_GT(throttle.waitedMs(), 0);
+    // 書き込みは制限していない
+    timer.restart();
+    throttle.acquireWrite(100 * kMiB);
+    EXPECT_LT(timer.elapsed(), 50);
+}
+
+TEST(IoThrottleTest, IopsLimitCountsOperations) {
+    IoThrottle::Limits limits;
+    limits.iops = 50;
+    IoThrottle throttle(limits);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 11; ++i) {
+        throttle.acquireWrite(4096);
+    }
+    EXPECT_GE(timer.elapsed(), 150);
+}
+
+TEST(IoThrottleTest, ParentLimitApplies) {
+    IoThrottle parent(readLimit(20));
+    IoThrottle child(IoThrottle::Limits(), &parent);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 6; ++i) {
+        child.acquireRead(kMiB);
+    }
+    EXPECT_GE(timer.elapsed(), 200);
+}
+
+TEST(IoThrottleTest, LimitChangeTakesEffectWhileWaiting) {
+    IoThrottle throttle(readLimit(1));
+    // 1 MB/s で 4 MiB 借りたので、次は約 4 秒待つはず
+    throttle.acquireRead(4 * kMiB);
+    QThread *thread = QThread::create([&throttle]() {
+        QThread::msleep(100);
+        throttle.setLimits(IoThrottle::Limits());
+    });
+    thread->start();
+    QElapsedTimer timer;
+    timer.start();
+    throttle.acquireRead(kMiB);
+    EXPECT_LT(timer.elapsed(), 1000);
+    thread->wait();
+    delete thread;
+}
+
+TEST(IoThrottleTest, BypassSkipsWait) {
+    IoThrottle throttle(readLimit(1));
+    throttle.acquireRead(4 * kMiB);
+    throttle.setBypass(true);
+    QElapsedTimer timer;
+    timer.start();
+    throttle.acquireRead(kMiB);
+    EXPECT_LT(timer.elapsed(), 100);
+}
+
+TEST(IoThrottleTest, BypassAlsoSkipsParentWait) {
+    IoThrottle parent(readLimit(1));
+    IoThrottle child(IoThrottle::Limits(), &parent);
+    // 親（全体の上限）で約 4 秒待つところで、子を待たずに通すようにする
+    child.acquireRead(4 * kMiB);
+    QThread *thread = QThread::create([&child]() {
+        QThread::msleep(100);
+        child.setBypass(true);
+    });
+    thread->start();
+    QElapsedTimer timer;
+    timer.start();
+    child.acquireRead(kMiB);
+    EXPECT_LT(timer.elapsed(), 1000);
+    thread->wait();
+    delete thread;
+
+    timer.restart();
+    child.acquireRead(kMiB);
+    EXPECT_LT(timer.elapsed(), 100);
+}
+
+TEST(IoThrottleTest, ReadDiskStatsParsesDevice) {
+    QTemporaryDir dir;
+    const QString path = dir.filePath("diskstats");
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("   8       0 sda 100 0 800 250 40 0 320 150 0 300 400 0 0 0 0\n"
+               "   8       1 sda1 90 0 700 200 30 0 240 100 0 250 300 0 0 0 0\n"
+               " 259       0 nvme0n1 1000 5 8000 120 500 3 4000 80 0 150 200\n");
+    file.close();
+
+    IoThrottle::DiskStats stats;
+    ASSERT_TRUE(IoThrottle::readDiskStats("sda", &stats, path));
+    EXPECT_EQ(stats.completedIos, 140u);
+    EXPECT_EQ(stats.ioMs, 400u);
+    ASSERT_TRUE(IoThrottle::readDiskStats("nvme0n1", &stats, path));
+    EXPECT_EQ(stats.completedIos, 1500u);
+    EXPECT_EQ(stats.ioMs, 200u);
+    EXPECT_FALSE(IoThrottle::readDiskStats("sdb", &stats, path));
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QList>
+#include <cstdio>
+#include <iostream>
+#include "../src/backup/Manifest.h"
+#include "../src/backup/ManifestDiff.h"
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// テスト用: 用意した配列を順に返す
+class ListSource : public ManifestSource {
+public:
+    explicit ListSource(const QList<ManifestEntry> &entries) : m_entries(entries) {}
+
+    bool next(ManifestEntry &entry) override {
+        if (m_position >= m_entries.size()) return false;
+        entry = m_entries.at(m_position++);
+        return true;
+    }
+
+private:
+    QList<ManifestEntry> m_entries;
+    int m_position = 0;
+};
+
+ManifestEntry makeEntry(const QByteArray &path, qint64 size, qint64 mtime = 1, const QByteArray &hash = QByteArray()) {
+    ManifestEntry entry;
+    entry.path = path;
+    entry.size = size;
+    entry.mtimeNs = mtime;
+    entry.mode = 0644;
+    entry.hash = hash;
+    return entry;
+}
+
+struct Event {
+    ManifestDiff::Change change;
+    QByteArray path;
+};
+
+QList<Event> runDiff(ManifestSource &current, ManifestSource &previous, bool *ok = nullptr) {
+    QList<Event> events;
+    ManifestDiff diff;
+    const bool result = diff.run(current, previous, [&events](ManifestDiff::Change change, const ManifestEntry &cur, const ManifestEntry &prev) {
+        events.append({change, change == ManifestDiff::Deleted ? prev.path : cur.path});
+    });
+    if (ok) *ok = result;
+    return events;
+}
+
+}
+
+TEST(ManifestDiffTest, OrderMatchesSortedFileIndex) {
+    FileIndex index;
+    const FileIndex::Id a = index.addDirectory(FileIndex::kRootDirectory, "a");
+    const FileIndex::Id ab = index.addDirectory(a, "b");
+    const FileIndex::Id ax = index.addDirectory(FileIndex::kRootDirectory, "a-x");
+    index.addFile(ax, "q", 1, 0, 0644);
+    index.addFile(ab, "index.js", 1, 0, 0644);
+    index.addFile(a, "zzz", 1, 0, 0644);
+    index.addFile(FileIndex::kRootDirectory, "root", 1, 0, 0644);
+    index.sort();
+
+    FileIndexManifestSource source(index);
+    ManifestEntry entry;
+    QByteArray previous;
+    int count = 0;
+    while (source.next(entry)) {
+        if (!previous.isEmpty()) {
+            EXPECT_LT(ManifestDiff::comparePaths(previous, entry.path), 0) << previous.constData() << " / " << entry.path.constData();
+        }
+        previous = entry.path;
+        ++count;
+    }
+    EXPECT_EQ(count, 4);
+}
+
+TEST(ManifestDiffTest, EmitsAddedModifiedDeletedAndUnchanged) {
+    ListSource current({makeEntry("a.txt", 1), makeEntry("e.txt", 5), makeEntry("b/c.txt", 2), makeEntry("b/d.txt", 3),
+                        makeEntry("b/h.txt", 4, 1, "new")});
+    ListSource previous({makeEntry("a.txt", 1), makeEntry("b/c.txt", 9), makeEntry("b/d.txt", 3), makeEntry("b/h.txt", 4, 1, "old"),
+                         makeEntry("b/old.txt", 7)});
+
+    bool ok = false;
+    const QList<Event> events = runDiff(current, previous, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(events.size(), 6);
+    EXPECT_EQ(events[0].change, ManifestDiff::Unchanged);
+    EXPECT_EQ(events[0].path, QByteArray("a.txt"));
+    EXPECT_EQ(events[1].change, ManifestDiff::Added);
+    EXPECT_EQ(events[1].path, QByteArray("e.txt"));
+    EXPECT_EQ(events[2].change, ManifestDiff::Modified);
+    EXPECT_EQ(events[3].change, ManifestDiff::Unchanged);
+    // サイズと日時が同じでも、両方にハッシュがあって違えば変更
+    EXPECT_EQ(events[4].change, ManifestDiff::Modified);
+    EXPECT_EQ(events[4].path, QByteArray("b/h.txt"));
+    EXPECT_EQ(events[5].change, ManifestDiff::Deleted);
+    EXPECT_EQ(events[5].path, QByteArray("b/old.txt"));
+}
+
+TEST(ManifestDiffTest, RejectsUnsortedInput) {
+    ListSource current({makeEntry("b.txt", 1), makeEntry("a.txt", 1)});
+    ListSource previous({});
+    bool ok = true;
+    runDiff(current, previous, &ok);
+    EXPECT_FALSE(ok);
+}
+
+TEST(ManifestDiffTest, ManifestRoundTripAndTruncation) {
+    QTemporaryDir dir;
+    const QString path = manifestFilePath(dir.path());
+    const QList<ManifestEntry> entries = {makeEntry("a.txt", 1, 10, "h1"), makeEntry("dir/file1", 2, 20, "h2"),
+                                          makeEntry("dir/file2", 3, 30), makeEntry("dir/sub/x", 4, 40, "h4")};
+    {
+        ManifestWriter writer(path, true);
+        ASSERT_TRUE(writer.open());
+        for (const ManifestEntry &entry : entries) writer.write(entry);
+        ASSERT_TRUE(writer.commit());
+        EXPECT_EQ(writer.count(), 4);
+    }
+
+    ManifestReader reader(path);
+    ASSERT_TRUE(reader.open());
+    EXPECT_TRUE(reader.hasHashes());
+    ManifestEntry entry;
+    for (const ManifestEntry &expected : entries) {
+        ASSERT_TRUE(reader.next(entry));
+        EXPECT_EQ(entry.path, expected.path);
+        EXPECT_EQ(entry.size, expected.size);
+        EXPECT_EQ(entry.mtimeNs, expected.mtimeNs);
+        EXPECT_EQ(entry.hash, expected.hash);
+    }
+    EXPECT_FALSE(reader.next(entry));
+    EXPECT_FALSE(reader.hasError());
+    reader.close();
+
+    // 終端の印がないものは壊れているとみなす
+    QFile file(path);
+    ASSERT_TRUE(file.resize(file.size() - 1));
+    ManifestReader truncated(path);
+    ASSERT_TRUE(truncated.open());
+    while (truncated.next(entry)) {
+    }
+    EXPECT_TRUE(truncated.hasError());
+}
+
+namespace {
+
+// ベンチマーク用: "d000123/f0456" 形式のパスを順に作る。
+// 前回側には 103 の倍数がなく（今回で追加）、今回側には 101 の倍数がない（削除）。
+// 97 の倍数は前回側の更新日時がずれている（変更）
+class SyntheticSource : public ManifestSource {
+public:
+    SyntheticSource(qint64 count, bool previous) : m_count(count), m_previous(previous) {}
+
+    bool next(ManifestEntry &entry) override {
+        while (m_position < m_count) {
+            const qint64 i = m_position++;
+            if ((m_previous && i % 103 == 0) || (!m_previous && i % 101 == 0)) continue;
+            char path[32];
+            const int length = std::snprintf(path, sizeof(path), "d%06lld/f%04lld", i / 1000, i % 1000);
+            entry.path.resize(0);
+            entry.path.append(path, length);
+            entry.size = i;
+            entry.mtimeNs = (m_previous && i % 97 == 0) ? i + 1 : i;
+            entry.mode = 0644;
+            entry.file = static_cast<FileIndex::Id>(i);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    qint64 m_count;
+    bool m_previous;
+    qint64 m_position = 0;
+};
+
+long maxResidentKilobytes() {
+#ifdef Q_OS_LINUX
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+}
+
+TEST(ManifestDiffTest, DISABLED_TenMillionEntryBenchmark) {
+    const qint64 count = 10 * 1000 * 1000;
+    qint64 expectedAdded = 0, expectedDeleted = 0, expectedModified = 0;
+    for (qint64 i = 0; i < count; ++i) {
+        const bool inCurrent = i % 101 != 0, inPrevious = i % 103 != 0;
+        if (inCurrent && !inPrevious) ++expectedAdded;
+        if (!inCurrent && inPrevious) ++expectedDeleted;
+        if (inCurrent && inPrevious && i % 97 == 0) ++expectedModified;
+    }
+
+    // 生成した2つの並びをそのままマージする
+    {
+        SyntheticSource current(count, false);
+        SyntheticSource previous(count, true);
+        const long rssBefore = maxResidentKilobytes();
+        QElapsedTimer timer;
+        timer.start();
+        ManifestDiff diff;
+        ASSERT_TRUE(diff.run(current, previous, [](ManifestDiff::Change, const ManifestEntry &, const ManifestEntry &) {}));
+        const ManifestDiff::Stats stats = diff.stats();
+        std::cout << "in memory: " << timer.elapsed() << " ms, max RSS +" << (maxResidentKilobytes() - rssBefore) << " KiB" << std::endl;
+        EXPECT_EQ(stats.added, expectedAdded);
+        EXPECT_EQ(stats.deleted, expectedDeleted);
+        EXPECT_EQ(stats.modified, expectedModified);
+    }
+
+    // 前回側をマニフェストファイルに書き、読みながらマージする
+    QTemporaryDir dir;
+    const QString path = manifestFilePath(dir.path());
+    {
+        QElapsedTimer timer;
+        timer.start();
+        ManifestWriter writer(path);
+        ASSERT_TRUE(writer.open());
+        SyntheticSource previous(count, true);
+        ManifestEntry entry;
+        while (previous.next(entry)) writer.write(entry);
+        ASSERT_TRUE(writer.commit());
+        std::cout << "write manifest: " << timer.elapsed() << " ms, " << QFile(path).size() / writer.count() << " bytes/entry" << std::endl;
+    }
+    {
+        SyntheticSource current(count, false);
+        ManifestReader previous(path);
+        ASSERT_TRUE(previous.open());
+        const long rssBefore = maxResidentKilobytes();
+        QElapsedTimer timer;
+        timer.start();
+        ManifestDiff diff;
+        ASSERT_TRUE(diff.run(current, previous, [](ManifestDiff::Change, const ManifestEntry &, const ManifestEntry &) {}));
+        std::cout << "from file: " << timer.elapsed() << " ms, max RSS +" << (maxResidentKilobytes() - rssBefore) << " KiB" << std::endl;
+        EXPECT_EQ(diff.stats().added, expectedAdded);
+        EXPECT_EQ(diff.stats().deleted, expectedDeleted);
+        EXPECT_EQ(diff.stats().modified, expectedModified);
+    }
+}
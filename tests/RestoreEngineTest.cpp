@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include "../src/backup/RestoreEngine.h"
+#include "../src/backup/Manifest.h"
+
+class RestoreEngineTest : public ::testing::Test {
+protected:
+    QTemporaryDir backupDir;
+    QTemporaryDir targetDir;
+    // マニフェストに書く更新時刻（2024-01-02 03:04:05.123456789 UTC）
+    const qint64 mtimeNs = 1704164645123456789LL;
+
+    void SetUp() override {
+        // マニフェストと同じパス順（フォルダのパス順、同じフォルダ内は名前順）
+        for (const char *path : {"a.txt", "dir/b.txt", "dir/sub/c.txt", "other/d.txt"}) createFile(path);
+    }
+
+    void createFile(const QString &relativePath) {
+        QDir(backupDir.path()).mkpath(QFileInfo(relativePath).path());
+        QFile file(backupDir.filePath(relativePath));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(relativePath.toUtf8().repeated(100));
+    }
+
+    void writeManifest() {
+        ManifestWriter writer(manifestFilePath(backupDir.path()));
+        ASSERT_TRUE(writer.open());
+        for (const char *path : {"a.txt", "dir/b.txt", "dir/sub/c.txt", "other/d.txt"}) {
+            ManifestEntry entry;
+            entry.path = path;
+            entry.size = QFileInfo(backupDir.filePath(path)).size();
+            entry.mtimeNs = mtimeNs;
+            entry.mode = 0644;
+            writer.write(entry);
+        }
+        ASSERT_TRUE(writer.commit());
+    }
+
+    RestoreEngine::Request request(const QStringList &paths) const {
+        RestoreEngine::Request request;
+        request.backupRoot = backupDir.path();
+        request.targetRoot = targetDir.path();
+        request.paths = paths;
+        return request;
+    }
+
+    bool sameContents(const QString &relativePath) const {
+        QFile source(backupDir.filePath(relativePath));
+        QFile restored(targetDir.filePath(relativePath));
+        return source.open(QIODevice::ReadOnly) && restored.open(QIODevice::ReadOnly) && source.readAll() == restored.readAll();
+    }
+};
+
+TEST_F(RestoreEngineTest, RestoresSelectedPathsFromManifest) {
+    writeManifest();
+    RestoreEngine engine;
+    EXPECT_TRUE(engine.runRestore(request({"dir", "/a.txt"})));
+
+    const RestoreEngine::Statistics statistics = engine.lastStatistics();
+    EXPECT_TRUE(statistics.usedManifest);
+    EXPECT_EQ(statistics.selectedFiles, 3);
+    EXPECT_EQ(statistics.restoredFiles, 3);
+    EXPECT_TRUE(sameContents("a.txt"));
+    EXPECT_TRUE(sameContents("dir/b.txt"));
+    EXPECT_TRUE(sameContents("dir/sub/c.txt"));
+    EXPECT_FALSE(QFileInfo::exists(targetDir.filePath("other/d.txt")));
+    // マニフェストも復元しない
+    EXPECT_FALSE(QFileInfo::exists(manifestFilePath(targetDir.path())));
+    // 元の更新時刻に戻っている
+    EXPECT_EQ(QFileInfo(targetDir.filePath("dir/sub/c.txt")).lastModified().toMSecsSinceEpoch(), mtimeNs / 1000000);
+}
+
+TEST_F(RestoreEngineTest, RerunSkipsFilesAlreadyRestored) {
+    writeManifest();
+    RestoreEngine engine;
+    ASSERT_TRUE(engine.runRestore(request({})));
+    EXPECT_EQ(engine.lastStatistics().restoredFiles, 4);
+
+    // 途中で止まった復元を想定して1つ消し、1つ書き換える
+    QFile::remove(targetDir.filePath("dir/b.txt"));
+    QFile changed(targetDir.filePath("other/d.txt"));
+    ASSERT_TRUE(changed.open(QIODevice::WriteOnly));
+    changed.write("partial");
+    changed.close();
+
+    ASSERT_TRUE(engine.runRestore(request({})));
+    const RestoreEngine::Statistics statistics = engine.lastStatistics();
+    EXPECT_EQ(statistics.skippedFiles, 2);
+    EXPECT_EQ(statistics.restoredFiles, 2);
+    EXPECT_TRUE(sameContents("dir/b.txt"));
+    EXPECT_TRUE(sameContents("other/d.txt"));
+}
+
+TEST_F(RestoreEngineTest, WalksBackupWithoutManifest) {
+    RestoreEngine engine;
+    EXPECT_TRUE(engine.runRestore(request({"dir/sub/c.txt"})));
+
+    const RestoreEngine::Statistics statistics = engine.lastStatistics();
+    EXPECT_FALSE(statistics.usedManifest);
+    EXPECT_EQ(statistics.restoredFiles, 1);
+    EXPECT_TRUE(sameContents("dir/sub/c.txt"));
+    EXPECT_FALSE(QFileInfo::exists(targetDir.filePath("dir/b.txt")));
+}
+
+TEST_F(RestoreEngineTest, ReportsMissingPaths) {
+    writeManifest();
+    RestoreEngine engine;
+    EXPECT_FALSE(engine.runRestore(request({"missing"})));
+    EXPECT_EQ(engine.lastStatistics().selectedFiles, 0);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <algorithm>
+#include <iostream>
+#include "../src/backup/RetentionPolicy.h"
+#include "../src/backup/SnapshotPruner.h"
+#include "../src/backup/SnapshotStore.h"
+
+namespace {
+
+BackupConfig::Retention makeRetention(int hourly, int daily, int weekly) {
+    BackupConfig::Retention retention;
+    retention.hourly = hourly;
+    retention.daily = daily;
+    retention.weekly = weekly;
+    return retention;
+}
+
+int keptCount(const QVector<bool> &keep) {
+    return static_cast<int>(std::count(keep.begin(), keep.end(), true));
+}
+
+// root/name の下に files 個のファイルを作る
+void fillDirectory(const QString &root, const QString &name, int files) {
+    QDir(root).mkpath(name + "/sub");
+    for (int i = 0; i < files; ++i) {
+        QFile file(QString("%1/%2/%3/f%4").arg(root, name, i % 2 ? "sub" : ".").arg(i));
+        file.open(QIODevice::WriteOnly);
+    }
+}
+
+}
+
+TEST(RetentionPolicyTest, DisabledKeepsEverything) {
+    const RetentionPolicy policy(makeRetention(0, 0, 0));
+    EXPECT_FALSE(policy.isEnabled());
+    const QDateTime now(QDate(2024, 3, 1), QTime(12, 0));
+    EXPECT_EQ(keptCount(policy.keep({now, now.addDays(-1), now.addDays(-30)})), 3);
+}
+
+TEST(RetentionPolicyTest, KeepsNewestPerBucket) {
+    // 3月1日から10日まで、1日に4回（0, 6, 12, 18時）作った世代
+    QVector<QDateTime> times;
+    for (int day = 1; day <= 10; ++day) {
+        for (int hour = 0; hour < 24; hour += 6) times.append(QDateTime(QDate(2024, 3, day), QTime(hour, 0)));
+    }
+
+    // 毎時 3: 最新の3世代だけ
+    QVector<bool> keep = RetentionPolicy(makeRetention(3, 0, 0)).keep(times);
+    EXPECT_EQ(keptCount(keep), 3);
+    EXPECT_TRUE(keep.last());
+    EXPECT_TRUE(keep[times.size() - 3]);
+
+    // 毎日 4: 直近4日の各日の最後（18時）の世代
+    keep = RetentionPolicy(makeRetention(0, 4, 0)).keep(times);
+    EXPECT_EQ(keptCount(keep), 4);
+    for (int day = 7; day <= 10; ++day) EXPECT_TRUE(keep[(day - 1) * 4 + 3]) << day;
+
+    // 規則は重ねて使え、どれかで残るものは残す。週は 3月4日（月）で切り替わる
+    keep = RetentionPolicy(makeRetention(2, 2, 3)).keep(times);
+    EXPECT_TRUE(keep[(3 - 1) * 4 + 3]);  // 3月3日（日）18時 = 前の週の最後
+    EXPECT_FALSE(keep[(5 - 1) * 4 + 3]); // 3月5日はどの規則でも残らない
+    EXPECT_TRUE(keep[(9 - 1) * 4 + 3]);  // 3月9日 18時 = 毎日の2つ目
+    EXPECT_EQ(keptCount(keep), 4);       // 10日の 18時と 12時 / 9日 18時 / 3日 18時
+}
+
+TEST(RetentionPolicyTest, PrunerRemovesRetiredSnapshotsInBackground) {
+    QTemporaryDir root;
+    SnapshotStore store(root.path());
+    fillDirectory(root.path(), "2024-03-01_000000", 200);
+    fillDirectory(root.path(), "2024-03-02_000000", 10);
+    ASSERT_EQ(store.snapshots().size(), 2);
+
+    const QString retired = store.retire(store.snapshots().first().path);
+    ASSERT_FALSE(retired.isEmpty());
+    // 名前を変えた時点で一覧から外れる
+    EXPECT_EQ(store.snapshots().size(), 1);
+    EXPECT_EQ(store.retiredSnapshots(), QStringList{retired});
+
+    SnapshotPruner pruner;
+    pruner.remove(retired);
+    pruner.remove(retired); // 同じものを重ねて予約しても1回だけ消す
+    ASSERT_TRUE(pruner.waitForIdle(10000));
+    EXPECT_FALSE(QFileInfo::exists(retired));
+    EXPECT_TRUE(store.retiredSnapshots().isEmpty());
+    const SnapshotPruner::Statistics statistics = pruner.statistics();
+    EXPECT_EQ(statistics.directories, 1);
+    EXPECT_EQ(statistics.files, 200);
+    EXPECT_EQ(statistics.failures, 0);
+}
+
+// 削除の速さを、バックアップ実行中（抑制あり）とそうでないときで比べる
+TEST(RetentionPolicyTest, DISABLED_PruneThroughputBenchmark) {
+    QTemporaryDir root;
+    const int files = 20000;
+    fillDirectory(root.path(), "idle", files);
+    fillDirectory(root.path(), "active", files);
+
+    SnapshotPruner::Options options;
+    options.throttledOperationsPerSecond = 5000;
+    SnapshotPruner pruner(options);
+
+    QElapsedTimer timer;
+    timer.start();
+    pruner.remove(root.filePath("idle"));
+    ASSERT_TRUE(pruner.waitForIdle());
+    const qint64 idleMs = timer.elapsed();
+
+    pruner.setBackupActive(true);
+    timer.restart();
+    pruner.remove(root.filePath("active"));
+    ASSERT_TRUE(pruner.waitForIdle());
+    const qint64 activeMs = timer.elapsed();
+    pruner.setBackupActive(false);
+
+    std::cout << "idle: " << idleMs << " ms (" << files * 1000 / qMax<qint64>(1, idleMs) << " files/s), "
+              << "during backup: " << activeMs << " ms (" << files * 1000 / qMax<qint64>(1, activeMs) << " files/s)" << std::endl;
+    EXPECT_GE(activeMs, files * 1000 / options.throttledOperationsPerSecond / 2);
+    EXPECT_GT(pruner.statistics().overlappedMs, 0);
+}
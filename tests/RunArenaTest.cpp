@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <QByteArray>
+#include <memory_resource>
+#include <vector>
+#include "../src/utils/RunArena.h"
+#include "../src/utils/FileIndex.h"
+
+TEST(RunArenaTest, CountsAllocationsAndReleasesAtOnce) {
+    RunArena arena(4096);
+    {
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 10000; ++i) {
+            values.push_back(i);
+        }
+        EXPECT_EQ(values.back(), 9999);
+    }
+
+    RunArena::Stats stats = arena.stats();
+    EXPECT_GT(stats.allocations, 0);
+    EXPECT_GE(stats.allocatedBytes, qint64(10000 * sizeof(int)));
+    EXPECT_GT(stats.blocks, 0);
+    EXPECT_GE(stats.reservedBytes, stats.allocatedBytes);
+
+    // 個別の解放ではメモリは戻らず、release() でまとめて戻る
+    arena.release();
+    stats = arena.stats();
+    EXPECT_EQ(stats.reservedBytes, 0);
+    EXPECT_GT(stats.peakReservedBytes, 0);
+}
+
+TEST(RunArenaTest, FileIndexNeedsFewHeapBlocksPerFile) {
+    RunArena arena;
+    const int files = 100000;
+    {
+        FileIndex index(&arena);
+        FileIndex::Id dir = FileIndex::kRootDirectory;
+        for (int i = 0; i < files; ++i) {
+            if (i % 100 == 0) {
+                dir = index.addDirectory(FileIndex::kRootDirectory, QByteArray::number(i));
+            }
+            const QByteArray name = QByteArray("file") + QByteArray::number(i % 100);
+            index.addFile(dir, name, i, 0, 0644);
+        }
+        index.sort();
+        EXPECT_EQ(index.fileCount(), files);
+    }
+
+    const RunArena::Stats stats = arena.stats();
+    EXPECT_LT(stats.blocks, 64);
+    EXPECT_LT(double(stats.blocks) / files, 0.001);
+}
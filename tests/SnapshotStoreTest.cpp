@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "../src/backup/SnapshotStore.h"
+#include "../src/utils/HardLinker.h"
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+TEST(SnapshotStoreTest, ParsesOnlySnapshotNames) {
+    QDateTime time;
+    EXPECT_TRUE(SnapshotStore::parseSnapshotName("2024-03-01_101500", &time));
+    EXPECT_EQ(time, QDateTime(QDate(2024, 3, 1), QTime(10, 15, 0)));
+    EXPECT_TRUE(SnapshotStore::parseSnapshotName("2024-03-01_101500_2", nullptr));
+    EXPECT_FALSE(SnapshotStore::parseSnapshotName("2024-03-01_101500.partial", nullptr));
+    EXPECT_FALSE(SnapshotStore::parseSnapshotName("documents", nullptr));
+}
+
+TEST(SnapshotStoreTest, PartialSnapshotsAreHiddenUntilFinished) {
+    QTemporaryDir root;
+    SnapshotStore store(root.path());
+    const QDateTime time(QDate(2024, 3, 1), QTime(10, 15, 0));
+
+    const QString first = store.begin(time);
+    ASSERT_FALSE(first.isEmpty());
+    EXPECT_TRUE(store.snapshots().isEmpty());
+    EXPECT_EQ(store.partialSnapshots().size(), 1);
+    ASSERT_TRUE(store.finish(first));
+
+    // 同じ秒にもう一度作っても別の世代になり、後に作ったものが最新になる
+    const QString second = store.begin(time);
+    ASSERT_TRUE(store.finish(second));
+    const QVector<SnapshotStore::Snapshot> all = store.snapshots();
+    ASSERT_EQ(all.size(), 2);
+    EXPECT_EQ(all[0].name, QString("2024-03-01_101500"));
+    EXPECT_EQ(store.latest().name, QString("2024-03-01_101500_2"));
+    EXPECT_TRUE(store.partialSnapshots().isEmpty());
+}
+
+TEST(SnapshotStoreTest, HardLinkerSharesInodesWithPreviousGeneration) {
+    QTemporaryDir previous;
+    QTemporaryDir target;
+    QVector<QByteArray> paths;
+    for (int i = 0; i < 300; ++i) {
+        const QString relative = QString("d%1/f%2").arg(i / 100).arg(i);
+        QDir(previous.path()).mkpath(QFileInfo(previous.filePath(relative)).path());
+        QFile file(previous.filePath(relative));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("data");
+        paths.append(relative.toUtf8());
+    }
+    for (int d = 0; d < 3; ++d) QDir(target.path()).mkpath(QString("d%1").arg(d));
+    paths.append("d0/missing");
+
+    HardLinker::Options options;
+    options.threads = 4;
+    options.batchSize = 32;
+    HardLinker linker(previous.path(), target.path(), options);
+    linker.link(paths);
+    EXPECT_EQ(linker.linkedCount(), 300);
+    ASSERT_EQ(linker.failures().size(), 1);
+    EXPECT_EQ(linker.failures().first().path, QByteArray("d0/missing"));
+
+#ifdef Q_OS_LINUX
+    struct stat a, b;
+    ASSERT_EQ(stat(QFile::encodeName(previous.filePath("d2/f250")).constData(), &a), 0);
+    ASSERT_EQ(stat(QFile::encodeName(target.filePath("d2/f250")).constData(), &b), 0);
+    EXPECT_EQ(a.st_ino, b.st_ino);
+    EXPECT_EQ(b.st_nlink, 2u);
+#endif
+}
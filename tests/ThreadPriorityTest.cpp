@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <QThread>
+#include "../src/utils/ThreadPriority.h"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    // 使い捨てのスレッドで cls を設定し、そのスレッドで check を呼ぶ
+    template <typename Check>
+    void runInThread(ThreadPriority::Class cls, Check check) {
+        QThread *thread = QThread::create([cls, check]() {
+            QString description;
+            ThreadPriority::applyToCurrentThread(cls, &description);
+            check(description);
+        });
+        thread->start();
+        thread->wait();
+        delete thread;
+    }
+
+    int currentIoClass() {
+        const int value = static_cast<int>(::syscall(SYS_ioprio_get, 1, 0));
+        return value >> 13;
+    }
+}
+
+TEST(ThreadPriorityTest, IdleUsesIdleSchedulingClasses) {
+    runInThread(ThreadPriority::Idle, [](const QString &description) {
+        EXPECT_TRUE(description.startsWith("idle"));
+        EXPECT_EQ(currentIoClass(), 3);
+        EXPECT_EQ(::sched_getscheduler(0), SCHED_IDLE);
+    });
+}
+
+TEST(ThreadPriorityTest, LowRaisesNice) {
+    runInThread(ThreadPriority::Low, [](const QString &description) {
+        EXPECT_TRUE(description.startsWith("low"));
+        EXPECT_EQ(currentIoClass(), 2);
+        EXPECT_GE(::getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid))), 10);
+    });
+}
+
+TEST(ThreadPriorityTest, ChildThreadsInheritPriority) {
+    runInThread(ThreadPriority::Idle, [](const QString &) {
+        int policy = -1;
+        QThread *child = QThread::create([&policy]() { policy = ::sched_getscheduler(0); });
+        child->start();
+        child->wait();
+        delete child;
+        EXPECT_EQ(policy, SCHED_IDLE);
+    });
+}
+
+TEST(ThreadPriorityTest, OtherThreadsAreUnaffected) {
+    const int policy = ::sched_getscheduler(0);
+    runInThread(ThreadPriority::Idle, [](const QString &) {});
+    EXPECT_EQ(::sched_getscheduler(0), policy);
+}
+#endif
+
+TEST(ThreadPriorityTest, NormalChangesNothing) {
+    QString description;
+    EXPECT_TRUE(ThreadPriority::applyToCurrentThread(ThreadPriority::Normal, &description));
+    EXPECT_EQ(description, "normal");
+}
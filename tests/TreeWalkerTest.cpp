@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <iostream>
+#include "../src/utils/TreeWalker.h"
+
+class TreeWalkerTest : public ::testing::Test {
+protected:
+    QTemporaryDir rootDir;
+
+    // depth 段のディレクトリに fanout 個ずつ枝分かれさせ、各ディレクトリに filesPerDir 個のファイルを置く
+    void createTree(const QString &path, int depth, int fanout, int filesPerDir) {
+        QDir dir(path);
+        for (int i = 0; i < filesPerDir; ++i) {
+            QFile file(dir.filePath(QString("file%1.txt").arg(i)));
+            ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+            file.write("x");
+        }
+        if (depth == 0) return;
+        for (int i = 0; i < fanout; ++i) {
+            QString name = QString("dir%1").arg(i);
+            ASSERT_TRUE(dir.mkdir(name));
+            createTree(dir.filePath(name), depth - 1, fanout, filesPerDir);
+        }
+    }
+
+    QStringList expectedFiles() {
+        QStringList result;
+        QDirIterator it(rootDir.path(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            result.append(QDir(rootDir.path()).relativeFilePath(it.next()));
+        }
+        result.sort();
+        return result;
+    }
+};
+
+TEST_F(TreeWalkerTest, FindsSameFilesAsQDirIterator) {
+    createTree(rootDir.path(), 3, 4, 3);
+
+    TreeWalker::Options options;
+    options.threads = 4;
+    options.sorted = true;
+    QStringList actual;
+    for (const TreeWalker::Entry &entry : TreeWalker(options).walk(rootDir.path())) {
+        actual.append(entry.relativePath);
+    }
+
+    QStringList expected = expectedFiles();
+    QStringList sortedActual = actual;
+    sortedActual.sort();
+    EXPECT_EQ(sortedActual, expected);
+    // sorted 指定時は何度走査しても同じ順序になる
+    QStringList again;
+    for (const TreeWalker::Entry &entry : TreeWalker(options).walk(rootDir.path())) {
+        again.append(entry.relativePath);
+    }
+    EXPECT_EQ(actual, again);
+}
+
+TEST_F(TreeWalkerTest, FilterSkipsExcludedDirectories) {
+    createTree(rootDir.path(), 2, 3, 2);
+
+    TreeWalker::Options options;
+    options.filter = [](const TreeWalker::Entry &entry) {
+        return !(entry.isDir && entry.name == "dir1");
+    };
+    for (const TreeWalker::Entry &entry : TreeWalker(options).walk(rootDir.path())) {
+        EXPECT_FALSE(entry.relativePath.startsWith("dir1/")) << entry.relativePath.toStdString();
+        EXPECT_FALSE(entry.relativePath.contains("/dir1/")) << entry.relativePath.toStdString();
+    }
+}
+
+TEST_F(TreeWalkerTest, RespectsMaxDepthAndCounts) {
+    createTree(rootDir.path(), 3, 2, 1);
+
+    TreeWalker::Options options;
+    options.maxDepth = 2;
+    options.includeDirectories = true;
+    // depth1: file + 2 dirs, depth2: 2 * (file + 2 dirs)
+    EXPECT_EQ(TreeWalker(options).count(rootDir.path()), 9);
+}
+
+// 1〜32スレッドでの走査時間を比べる。通常の実行では無効
+// （--gtest_also_run_disabled_tests で実行）
+TEST_F(TreeWalkerTest, DISABLED_ThreadScalingBenchmark) {
+    createTree(rootDir.path(), 4, 8, 4);
+
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        TreeWalker::Options options;
+        options.threads = threads;
+        TreeWalker walker(options);
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 count = walker.count(rootDir.path());
+        std::cout << threads << " threads: " << count << " entries in " << timer.elapsed()
+                  << " ms (" << walker.stealCount() << " steals)" << std::endl;
+    }
+}